@@ -12,8 +12,11 @@
 #include "class_runtime_interface.h"
 #include "dynamic_properties.h"
 #include "function_address_patching.h"
+#include "gc_stack_maps.h"
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
+#include <cmath>
 #include <cstring>
 #include <cstdlib>
 #include <stdexcept>
@@ -361,9 +364,7 @@ void emit_scope_enter(CodeGenerator& gen, LexicalScopeNode* scope_node) {
     if (scope_size > 0) {
         std::cout << "[NEW_SCOPE_SYSTEM] Allocating " << scope_size << " bytes for scope" << std::endl;
         
-        x86_gen->emit_mov_reg_imm(7, scope_size); // RDI = size
-        x86_gen->emit_call("malloc"); // Returns allocated memory in RAX
-        x86_gen->emit_mov_reg_reg(15, 0); // R15 = allocated scope memory
+        x86_gen->emit_scope_alloc(scope_size); // R15 = allocated scope memory
         
         // Zero-initialize the scope
         if (scope_size <= 32) {
@@ -381,11 +382,12 @@ void emit_scope_enter(CodeGenerator& gen, LexicalScopeNode* scope_node) {
         }
     } else {
         // Even empty scopes get a minimal allocation
-        x86_gen->emit_mov_reg_imm(7, 8); // RDI = 8 bytes minimum
-        x86_gen->emit_call("malloc");
-        x86_gen->emit_mov_reg_reg(15, 0); // R15 = allocated scope memory
+        x86_gen->emit_scope_alloc(8); // R15 = allocated scope memory
     }
     
+    // Zeroed, so the collector may see it now
+    x86_gen->emit_gc_scope_link(gc_stack_map_for_scope(scope_node));
+    
     // DISABLED: Scope registration violates FUNCTION.md compile-time design
     // Register this scope address with the runtime for parent scope access
     // x86_gen->emit_mov_reg_imm(7, scope_node->scope_depth); // RDI = scope depth
@@ -422,9 +424,8 @@ void emit_scope_exit(CodeGenerator& gen, LexicalScopeNode* scope_node) {
         throw std::runtime_error("New scope system requires X86CodeGenV2");
     }
     
-    // Free the heap-allocated scope memory
-    x86_gen->emit_mov_reg_reg(7, 15); // RDI = current scope memory (R15)
-    x86_gen->emit_call("free"); // Free the heap memory
+    // Free the heap-allocated scope memory and go back to the enclosing scope
+    x86_gen->emit_scope_free(true);
     std::cout << "[NEW_SCOPE_SYSTEM] Freed heap memory for scope at depth " << scope_node->scope_depth << std::endl;
     
     // DISABLED: Runtime scope unregistration violates FUNCTION.md
@@ -515,6 +516,40 @@ void emit_variable_load(CodeGenerator& gen, const std::string& var_name) {
     }
 }
 
+// Stores of these types need the GC write barrier when the target is a heap object
+static bool may_hold_gc_reference(DataType type) {
+    switch (type) {
+        case DataType::INT8: case DataType::INT16: case DataType::INT32: case DataType::INT64:
+        case DataType::UINT8: case DataType::UINT16: case DataType::UINT32: case DataType::UINT64:
+        case DataType::FLOAT32: case DataType::FLOAT64: case DataType::BOOLEAN:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Whether a scope variable may hold a reference into the GC heap; never
+// while script values live outside it (gc_scope_roots_enabled)
+static bool scope_slot_holds_gc_reference(LexicalScopeNode* scope_node, const std::string& name) {
+    if (!gc_scope_roots_enabled()) {
+        return false;
+    }
+    auto decl_it = scope_node->variable_declarations.find(name);
+    return decl_it == scope_node->variable_declarations.end() || may_hold_gc_reference(decl_it->second.data_type);
+}
+
+// Fields of the scope object that the collector must treat as references
+const GCStackMap* gc_stack_map_for_scope(LexicalScopeNode* scope_node) {
+    std::vector<uint32_t> slots;
+    for (const auto& entry : scope_node->variable_offsets) {
+        if (scope_slot_holds_gc_reference(scope_node, entry.first)) {
+            slots.push_back(static_cast<uint32_t>(entry.second));
+        }
+    }
+    return GCStackMapRegistry::instance().intern(static_cast<uint32_t>(scope_node->total_scope_frame_size),
+                                                 std::move(slots));
+}
+
 // Generate variable store code using new function system (no r12/r13/r14)
 void emit_variable_store(CodeGenerator& gen, const std::string& var_name) {
     if (!g_scope_context.current_scope || !g_scope_context.scope_analyzer) {
@@ -573,7 +608,14 @@ void emit_variable_store(CodeGenerator& gen, const std::string& var_name) {
             x86_gen->emit_push_reg(0);                                // push rax (save value)
             x86_gen->emit_mov_reg_reg_offset(10, 5, stack_offset);    // r10 = [rbp+stack_offset] (scope address)
             x86_gen->emit_pop_reg(0);                                 // pop rax (restore value)
+            bool reference_store = scope_slot_holds_gc_reference(def_scope, var_name);
+            if (reference_store) {
+                x86_gen->emit_gc_satb_barrier(10, var_offset);
+            }
             x86_gen->emit_mov_reg_offset_reg(10, var_offset, 0);      // [r10+var_offset] = rax
+            if (reference_store) {
+                x86_gen->emit_gc_write_barrier(10, var_offset);       // Parent scopes outlive this frame
+            }
         } else {
             std::cerr << "ERROR: Required parent scope depth " << required_depth 
                       << " not available in current function's hidden parameters" << std::endl;
@@ -841,7 +883,7 @@ void Identifier::generate_code(CodeGenerator& gen) {
             
             // STEP 1: Allocate memory for function instance on heap
             x86_gen->emit_mov_reg_imm(7, function_instance_size); // RDI = size
-            x86_gen->emit_call("malloc");
+            x86_gen->emit_call("__closure_pool_alloc");
             x86_gen->emit_mov_reg_reg(10, 0); // R10 = allocated memory address
             
             // STEP 2: Initialize FunctionInstance header with placeholder address
@@ -1165,11 +1207,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
         // Push left operand result onto stack to protect it during right operand evaluation
         gen.emit_sub_reg_imm(4, 8);   // sub rsp, 8 (allocate stack space)
         // Store to RSP-relative location to match the RSP-relative load later
-        if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-            x86_gen->emit_mov_mem_reg(0, 0);   // mov [rsp], rax (save left operand on stack)
-        } else {
-            gen.emit_mov_mem_reg(0, 0);   // fallback for other backends
-        }
+        gen.emit_mov_mem_rsp_reg(0, 0);   // mov [rsp], rax (save left operand on stack)
     }
     
     if (right) {
@@ -1198,7 +1236,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
                     
                     // Pop left operand from stack
                     auto* x86_gen = static_cast<X86CodeGenV2*>(&gen);
-                    x86_gen->emit_mov_reg_mem(7, 0);   // mov rdi, [rsp] (left operand -> first argument)
+                    x86_gen->emit_mov_reg_mem_rsp(7, 0);   // mov rdi, [rsp] (left operand -> first argument)
                     gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                     
                     // Robust string concatenation with proper type handling
@@ -1215,17 +1253,14 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
                         // Neither operand is a string - fallback to regular concatenation
                         gen.emit_call("__string_concat");
                     }
-                    // Result (new GoTSString*) is now in RAX
+                    // Result (new GoTSString*) is now in RAX, null past the heap's hard limit
+                    x86_gen->emit_out_of_memory_check();
                 }
             } else {
                 result_type = get_cast_type(left_type, right_type);
                 if (left) {
                     // Pop left operand from stack and add to right operand (in RAX)
-                    if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                        x86_gen->emit_mov_reg_mem(3, 0);   // mov rbx, [rsp] (load left operand from stack)
-                    } else {
-                        gen.emit_mov_reg_mem(3, 0);   // fallback for other backends
-                    }
+                    gen.emit_mov_reg_mem_rsp(3, 0);   // mov rbx, [rsp] (load left operand from stack)
                     gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                     
                     // SMART TYPE HANDLING: Check if operands are DynamicValues that need unpacking
@@ -1238,23 +1273,23 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
                         
                         // Save both DynamicValue pointers to stack before function calls
                         gen.emit_sub_reg_imm(4, 16);  // rsp -= 16 (allocate space)
-                        gen.emit_mov_mem_reg(0, 3);   // save left operand (RBX) at [rsp]
-                        gen.emit_mov_mem_reg(8, 0);   // save right operand (RAX) at [rsp+8]
+                        gen.emit_mov_mem_rsp_reg(0, 3);   // save left operand (RBX) at [rsp]
+                        gen.emit_mov_mem_rsp_reg(8, 0);   // save right operand (RAX) at [rsp+8]
 
                         // Extract numeric value from left operand
-                        gen.emit_mov_reg_mem(7, 0);   // RDI = left DynamicValue pointer
+                        gen.emit_mov_reg_mem_rsp(7, 0);   // RDI = left DynamicValue pointer
                         gen.emit_call("__dynamic_value_get_number");
                         // RAX now contains double value as bit pattern
-                        gen.emit_mov_mem_reg(0, 0);   // save left result on stack at [rsp]
+                        gen.emit_mov_mem_rsp_reg(0, 0);   // save left result on stack at [rsp]
                         
                         // Extract numeric value from right operand  
-                        gen.emit_mov_reg_mem(7, 8);   // RDI = right DynamicValue pointer
+                        gen.emit_mov_reg_mem_rsp(7, 8);   // RDI = right DynamicValue pointer
                         gen.emit_call("__dynamic_value_get_number");
                         // RAX now contains double value as bit pattern
                         
                         // Now RAX has right number (as bits), left number (as bits) is at [rsp]
                         gen.emit_mov_reg_reg(6, 0);   // RSI = right number (as bit pattern)
-                        gen.emit_mov_reg_mem(7, 0);   // RDI = left number (as bit pattern)
+                        gen.emit_mov_reg_mem_rsp(7, 0);   // RDI = left number (as bit pattern)
                         gen.emit_call("__dynamic_value_add_bits");
 
                         gen.emit_add_reg_imm(4, 16);  // rsp += 16 (deallocate space)
@@ -1271,11 +1306,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
             result_type = get_cast_type(left_type, right_type);
             if (left) {
                 // Binary minus: Pop left operand from stack and subtract right operand from it
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(3, 0);   // mov rbx, [rsp] (load left operand from stack)
-                } else {
-                    gen.emit_mov_reg_mem(3, 0);   // fallback for other backends
-                }
+                gen.emit_mov_reg_mem_rsp(3, 0);   // mov rbx, [rsp] (load left operand from stack)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 gen.emit_sub_reg_reg(3, 0);   // sub rbx, rax (subtract right from left)
                 gen.emit_mov_reg_reg(0, 3);   // mov rax, rbx (result in rax)
@@ -1292,11 +1323,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
             result_type = get_cast_type(left_type, right_type);
             if (left) {
                 // Pop left operand from stack and multiply with right operand
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(3, 0);   // mov rbx, [rsp] (load left operand from stack)
-                } else {
-                    gen.emit_mov_reg_mem(3, 0);   // fallback for other backends
-                }
+                gen.emit_mov_reg_mem_rsp(3, 0);   // mov rbx, [rsp] (load left operand from stack)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 gen.emit_mul_reg_reg(3, 0);   // imul rbx, rax (multiply left with right)
                 gen.emit_mov_reg_reg(0, 3);   // mov rax, rbx (result in rax)
@@ -1311,11 +1338,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
                 gen.emit_mov_reg_reg(6, 0);   // mov rsi, rax (exponent -> second argument)
                 
                 // Pop left operand from stack (base)
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(7, 0);   // mov rdi, [rsp] (base -> first argument)
-                } else {
-                    gen.emit_mov_reg_mem(7, 0);   // fallback for other backends
-                }
+                gen.emit_mov_reg_mem_rsp(7, 0);   // mov rdi, [rsp] (base -> first argument)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 
                 // Call the power function: __runtime_pow(base, exponent)
@@ -1328,11 +1351,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
             result_type = get_cast_type(left_type, right_type);
             if (left) {
                 // Pop left operand from stack and divide by right operand
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(1, 0);   // mov rcx, [rsp] (load left operand from stack)
-                } else {
-                    gen.emit_mov_reg_mem(1, 0);   // fallback for other backends
-                }
+                gen.emit_mov_reg_mem_rsp(1, 0);   // mov rcx, [rsp] (load left operand from stack)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 gen.emit_div_reg_reg(1, 0);   // div rcx by rax (divide left by right)
                 gen.emit_mov_reg_reg(0, 1);   // mov rax, rcx (result in rax)
@@ -1347,11 +1366,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
                 gen.emit_mov_reg_reg(6, 0);   // RSI = right operand (from RAX)
                 
                 // Pop left operand from stack directly to RDI (first argument)
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(7, 0);   // RDI = left operand from [rsp]
-                } else {
-                    gen.emit_mov_reg_mem(7, 0);   // fallback for other backends
-                }
+                gen.emit_mov_reg_mem_rsp(7, 0);   // RDI = left operand from [rsp]
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 
                 // Call __runtime_modulo(left, right)
@@ -1370,11 +1385,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
             result_type = DataType::BOOLEAN;
             if (left) {
                 // Pop left operand from stack and compare with right operand (in RAX)
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(1, 0);   // mov rcx, [rsp] (load left operand from stack)
-                } else {
-                    gen.emit_mov_reg_mem(1, 0);   // fallback for other backends
-                }
+                gen.emit_mov_reg_mem_rsp(1, 0);   // mov rcx, [rsp] (load left operand from stack)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 
                 // Optimized comparison logic with string-specific handling
@@ -1467,11 +1478,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
             if (left) {
                 // Short-circuit evaluation: if left is falsy, don't evaluate right
                 // Left operand result is on stack, right operand result is in RAX
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(1, 0);   // mov rcx, [rsp] (load left operand)
-                } else {
-                    gen.emit_mov_reg_mem(1, 0);   // fallback
-                }
+                gen.emit_mov_reg_mem_rsp(1, 0);   // mov rcx, [rsp] (load left operand)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 
                 // Test left operand for truthiness (simplified - just check if zero)
@@ -1497,11 +1504,7 @@ void BinaryOp::generate_code(CodeGenerator& gen) {
             if (left) {
                 // Short-circuit evaluation: if left is truthy, don't use right
                 // Left operand result is on stack, right operand result is in RAX
-                if (auto x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
-                    x86_gen->emit_mov_reg_mem(1, 0);   // mov rcx, [rsp] (load left operand)
-                } else {
-                    gen.emit_mov_reg_mem(1, 0);   // fallback
-                }
+                gen.emit_mov_reg_mem_rsp(1, 0);   // mov rcx, [rsp] (load left operand)
                 gen.emit_add_reg_imm(4, 8);   // add rsp, 8 (restore stack)
                 
                 // Test left operand for truthiness
@@ -2071,6 +2074,33 @@ void MethodCall::generate_code(CodeGenerator& gen) {
             gen.emit_mov_reg_reg(7, 0); // RDI = array pointer
             gen.emit_call("__simple_array_min");
             result_type = DataType::FLOAT64;
+        } else if (method_name == "indexOf" || method_name == "includes" ||
+                   method_name == "startsWith" || method_name == "split") {
+            // String search methods: string_search.h kernels behind __string_*
+            gen.emit_sub_reg_imm(4, 16);        // Keep the string across the argument, stack aligned
+            gen.emit_mov_mem_rsp_reg(0, 0);     // [rsp] = string pointer
+            if (arguments.size() > 0) {
+                arguments[0]->generate_code(gen);
+                gen.emit_mov_reg_reg(6, 0);     // RSI = search string
+            } else {
+                gen.emit_mov_reg_imm(6, 0);     // RSI = null
+            }
+            gen.emit_mov_reg_mem_rsp(7, 0);     // RDI = string pointer
+            gen.emit_add_reg_imm(4, 16);
+
+            if (method_name == "indexOf") {
+                gen.emit_call("__string_index_of");
+                result_type = DataType::INT64;
+            } else if (method_name == "includes") {
+                gen.emit_call("__string_includes");
+                result_type = DataType::BOOLEAN;
+            } else if (method_name == "startsWith") {
+                gen.emit_call("__string_starts_with");
+                result_type = DataType::BOOLEAN;
+            } else {
+                gen.emit_call("__string_split");
+                result_type = DataType::ARRAY;
+            }
         } else if (method_name == "test") {
             // Assume this is a regex test method
             gen.emit_mov_reg_reg(12, 0); // R12 = regex pointer (save in callee-saved register)
@@ -2108,8 +2138,60 @@ void MethodCall::generate_code(CodeGenerator& gen) {
 void ExpressionMethodCall::generate_code(CodeGenerator& gen) {
     std::cout << "[NEW_CODEGEN] ExpressionMethodCall::generate_code - method: " << method_name << std::endl;
     
-    // Check for runtime.x.y() patterns (optimized direct calls)
-    // TODO: Add proper AST analysis to detect runtime property access patterns
+    // runtime.x.y(...) calls registered in runtime_method_registry go straight
+    // to the registered entry point; anything else takes the generic path
+    if (auto* property = dynamic_cast<ExpressionPropertyAccess*>(object.get())) {
+        auto* root = dynamic_cast<Identifier*>(property->object.get());
+        const RuntimeMethodInfo* method = nullptr;
+        if (root && root->name == "runtime") {
+            initialize_runtime_object();  // Fills the registry
+            auto entry = runtime_method_registry.find(property->property_name + "." + method_name);
+            if (entry != runtime_method_registry.end() && entry->second.function_pointer && !entry->second.is_async) {
+                method = &entry->second;
+            }
+        }
+        if (method) {
+            if (arguments.size() != method->arg_types.size()) {
+                throw std::runtime_error("runtime." + property->property_name + "." + method_name + "() expects " +
+                                         std::to_string(method->arg_types.size()) + " argument(s)");
+            }
+            static const int arg_registers[] = {7, 6, 2, 1, 8, 9};  // RDI, RSI, RDX, RCX, R8, R9
+            int64_t arg_space = ((arguments.size() * 8) + 15) & ~15;
+            
+            // Evaluate into stack slots first so nested calls cannot clobber argument registers
+            if (arg_space > 0) gen.emit_sub_reg_imm(4, arg_space);
+            auto* x86_gen = dynamic_cast<X86CodeGenV2*>(&gen);
+            for (size_t i = 0; i < arguments.size(); i++) {
+                arguments[i]->generate_code(gen);
+                // Number literals arrive as float64 bits; truncate only for integer parameters
+                if (method->arg_types[i] == RuntimeValueType::INT64 &&
+                    arguments[i]->result_type == DataType::FLOAT64 && x86_gen) {
+                    x86_gen->emit_movq_xmm_gpr(0, 0);
+                    x86_gen->emit_cvtsd2si(0, 0);
+                }
+                gen.emit_mov_mem_rsp_reg(i * 8, 0);
+            }
+            for (size_t i = 0; i < arguments.size(); i++) {
+                gen.emit_mov_reg_mem_rsp(arg_registers[i], i * 8);
+            }
+            if (arg_space > 0) gen.emit_add_reg_imm(4, arg_space);
+            
+            gen.emit_mov_reg_imm(0, reinterpret_cast<int64_t>(method->function_pointer));
+            gen.emit_call_reg(0);
+            switch (method->return_type) {
+                case RuntimeValueType::VOID:    result_type = DataType::VOID; break;
+                case RuntimeValueType::INT64:   result_type = DataType::INT64; break;
+                case RuntimeValueType::BOOLEAN:
+                    gen.emit_and_reg_imm(0, 0xFF);  // bool is returned in AL only
+                    result_type = DataType::BOOLEAN;
+                    break;
+                case RuntimeValueType::STRING:  result_type = DataType::STRING; break;
+                case RuntimeValueType::POINTER: result_type = DataType::ANY; break;
+            }
+            std::cout << "[NEW_CODEGEN] ExpressionMethodCall: registered runtime call " << method->object_path << std::endl;
+            return;
+        }
+    }
     
     // For now, generate the object expression and call the method on it
     object->generate_code(gen);
@@ -2212,6 +2294,9 @@ void ObjectLiteral::generate_code(CodeGenerator& gen) {
     gen.emit_mov_reg_imm(7, reinterpret_cast<int64_t>(object_literal_class)); // RDI = class_name
     gen.emit_mov_reg_imm(6, properties.size()); // RSI = property count
     gen.emit_call("__object_create");
+    if (auto* x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
+        x86_gen->emit_out_of_memory_check(); // Null past the heap's hard limit
+    }
     
     // RAX now contains the object_id
     // Store it temporarily while we add properties
@@ -2787,20 +2872,39 @@ void ThrowStatement::generate_code(CodeGenerator& gen) {
     if (value) {
         value->generate_code(gen);
         
-        // Store the exception value in a standard location for runtime exception handling
-        gen.emit_mov_mem_reg(-272, 0); // Store exception value at stack location
+        // Catch parameters are untyped, so box typed values the way untyped
+        // declarations do
+        switch (value->result_type) {
+            case DataType::STRING:
+                gen.emit_mov_reg_reg(7, 0);
+                gen.emit_call("__dynamic_value_create_from_string");
+                break;
+            case DataType::FLOAT64:
+                gen.emit_mov_reg_reg(7, 0);
+                gen.emit_call("__dynamic_value_create_from_double");
+                break;
+            case DataType::INT8:
+            case DataType::INT16:
+            case DataType::INT32:
+            case DataType::INT64:
+                gen.emit_mov_reg_reg(7, 0);
+                gen.emit_call("__dynamic_value_create_from_int64");
+                break;
+            case DataType::BOOLEAN:
+                gen.emit_mov_reg_reg(7, 0);
+                gen.emit_call("__dynamic_value_create_from_bool");
+                break;
+            default:
+                break;
+        }
         
-        // Set up the exception throw with the runtime system
-        gen.emit_mov_reg_mem(7, -272); // RDI = exception value
+        // Hand the value to the unwinder. It walks the exception tables for the
+        // innermost protected region and resumes at its landing pad with the
+        // value in RAX, or terminates the program if there is none.
+        gen.emit_mov_reg_reg(7, 0); // RDI = exception value
         gen.emit_call("__runtime_throw_exception");
         
-        // The __runtime_throw_exception function should handle:
-        // 1. Stack unwinding to find the nearest catch handler
-        // 2. Proper cleanup of resources in unwound scopes
-        // 3. Jumping to the appropriate catch block or program termination
-        
-        // This call should not return normally - it either jumps to a catch handler
-        // or terminates the program. We add a safety return instruction just in case.
+        // Never reached - the throw stub does not return
         gen.emit_ret();
         
         result_type = DataType::VOID; // throw statements don't produce values
@@ -2817,12 +2921,18 @@ void ThrowStatement::generate_code(CodeGenerator& gen) {
 void CatchClause::generate_code(CodeGenerator& gen) {
     std::cout << "[NEW_CODEGEN] CatchClause::generate_code - catch(" << parameter << ")" << std::endl;
     
-    // TODO: Set up scope-aware exception variable access
-    // For now, the exception value should be available in a runtime-defined location
-    
-    // Store exception value in a temporary location for the catch block
-    // The runtime exception handling system should have placed the exception in RAX
-    gen.emit_mov_mem_reg(-200, 0); // Store exception value for catch block access
+    // The landing pad resumes with the thrown value in RAX; bind it to the
+    // catch parameter
+    VariableDeclarationInfo* var_info = variable_declaration_info;
+    if (!var_info) {
+        throw std::runtime_error("Catch parameter not declared: " + parameter);
+    }
+    int current_scope_depth = g_scope_context.current_scope ? g_scope_context.current_scope->scope_depth : 1;
+    if (var_info->depth != current_scope_depth) {
+        throw std::runtime_error("Catch parameter '" + parameter + "' is not in the current scope");
+    }
+    var_info->data_type = DataType::ANY;
+    gen.emit_mov_reg_offset_reg(15, var_info->offset, 0); // [r15 + offset] = rax
     
     // Generate catch block body
     for (const auto& stmt : body) {
@@ -2843,16 +2953,22 @@ void TryStatement::generate_code(CodeGenerator& gen) {
               << (catch_clause ? "catch" : "no catch") 
               << (finally_body.empty() ? "" : " and finally") << std::endl;
     
-    // Set up exception handling (simplified approach)
-    // TODO: Integrate with proper exception handling system
+    // Zero-cost: entering the try block emits nothing. The protected range is
+    // recorded in the exception tables and the unwinder resumes at a landing pad.
+    // Exceptions escaping the catch block (or a try without catch) go through
+    // the finally landing pad, which runs the finally body and rethrows.
+    std::string finally_rethrow_label = "try_finally_rethrow_" + std::to_string(try_counter - 1);
+    bool has_finally = !finally_body.empty();
     
     // Generate try block
+    gen.begin_exception_region(catch_clause ? catch_label : finally_rethrow_label);
     for (const auto& stmt : try_body) {
         stmt->generate_code(gen);
     }
+    gen.end_exception_region();
     
     // If no exception occurred, jump to finally (or end if no finally)
-    if (!finally_body.empty()) {
+    if (has_finally) {
         gen.emit_jump(finally_label);
     } else {
         gen.emit_jump(end_label);
@@ -2860,11 +2976,17 @@ void TryStatement::generate_code(CodeGenerator& gen) {
     
     // Generate catch block if present
     if (catch_clause) {
-        gen.emit_label(catch_label);
+        gen.emit_landing_pad(catch_label);
+        if (has_finally) {
+            gen.begin_exception_region(finally_rethrow_label);
+        }
         catch_clause->generate_code(gen);
+        if (has_finally) {
+            gen.end_exception_region();
+        }
         
         // After catch, go to finally (or end if no finally)
-        if (!finally_body.empty()) {
+        if (has_finally) {
             gen.emit_jump(finally_label);
         } else {
             gen.emit_jump(end_label);
@@ -2872,7 +2994,17 @@ void TryStatement::generate_code(CodeGenerator& gen) {
     }
     
     // Generate finally block if present
-    if (!finally_body.empty()) {
+    if (has_finally) {
+        // Exceptional path: run finally, then keep unwinding with the saved
+        // exception - a try/catch run by the finally body replaces the current one
+        gen.emit_landing_pad(finally_rethrow_label);
+        gen.emit_save_pending_exception();
+        for (const auto& stmt : finally_body) {
+            stmt->generate_code(gen);
+        }
+        gen.emit_throw_pending_exception();
+        
+        // Normal path
         gen.emit_label(finally_label);
         for (const auto& stmt : finally_body) {
             stmt->generate_code(gen);
@@ -2927,10 +3059,140 @@ void CaseClause::generate_code(CodeGenerator& gen) {
     std::cout << "[NEW_CODEGEN] CaseClause::generate_code complete" << std::endl;
 }
 
+// Constant case values that can be dispatched without evaluating each case expression
+static bool get_integral_case_value(const ExpressionNode* expr, int64_t& out) {
+    // Unary minus parses as BinaryOp(nullptr, MINUS, operand)
+    if (auto* negation = dynamic_cast<const BinaryOp*>(expr)) {
+        if (negation->left || negation->op != TokenType::MINUS) return false;
+        if (!get_integral_case_value(negation->right.get(), out)) return false;
+        out = -out;
+        return true;
+    }
+    
+    auto* literal = dynamic_cast<const NumberLiteral*>(expr);
+    if (!literal || literal->raw_value.empty()) return false;
+    
+    char* end = nullptr;
+    double value = std::strtod(literal->raw_value.c_str(), &end);
+    if (*end != '\0' || !std::isfinite(value) || value != std::trunc(value)) return false;
+    if (std::fabs(value) > 9007199254740992.0) return false;  // Beyond exact double integers
+    out = static_cast<int64_t>(value);
+    return true;
+}
+
+static bool is_integer_switch_type(DataType type) {
+    switch (type) {
+        case DataType::INT8: case DataType::INT16: case DataType::INT32: case DataType::INT64:
+        case DataType::UINT8: case DataType::UINT16: case DataType::UINT32: case DataType::UINT64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Integer cases go through CodeGenerator::emit_switch_dispatch, which picks jump
+// tables or a binary decision tree. Returns false if the cases are not all constants.
+static bool emit_integer_switch_dispatch(CodeGenerator& gen, SwitchStatement& node, DataType discriminant_type,
+                                         const std::vector<std::string>& case_labels, const std::string& no_match) {
+    bool is_float = discriminant_type == DataType::FLOAT64;
+    if (!is_float && !is_integer_switch_type(discriminant_type)) return false;
+    
+    std::vector<std::pair<int64_t, std::string>> keys;
+    std::unordered_set<int64_t> seen;
+    for (size_t i = 0; i < node.cases.size(); i++) {
+        if (node.cases[i]->is_default) continue;
+        int64_t key;
+        if (!get_integral_case_value(node.cases[i]->value.get(), key)) return false;
+        if (seen.insert(key).second) {  // First matching case wins
+            keys.emplace_back(key, case_labels[i]);
+        }
+    }
+    
+    std::cout << "[NEW_CODEGEN] SwitchStatement: constant dispatch over " << keys.size() << " integer cases" << std::endl;
+    gen.emit_mov_reg_mem(0, -150);
+    gen.emit_switch_dispatch(0, is_float, keys, no_match);
+    return true;
+}
+
+// String cases: a seed is chosen at compile time so every case string hashes to
+// its own slot, the slot is dispatched like an integer switch, and a single
+// __string_equals confirms the match.
+static bool emit_string_switch_dispatch(CodeGenerator& gen, SwitchStatement& node, DataType discriminant_type,
+                                        const std::vector<std::string>& case_labels, const std::string& no_match,
+                                        int switch_id) {
+    if (discriminant_type != DataType::STRING) return false;
+    
+    std::vector<size_t> case_indices;
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < node.cases.size(); i++) {
+        if (node.cases[i]->is_default) continue;
+        auto* literal = dynamic_cast<StringLiteral*>(node.cases[i]->value.get());
+        if (!literal) return false;
+        if (seen.insert(literal->value).second) {
+            case_indices.push_back(i);
+        }
+    }
+    if (case_indices.size() < 2) return false;
+    
+    // Smallest power-of-two table with a collision-free seed
+    uint64_t table_size = 1;
+    while (table_size < case_indices.size()) table_size <<= 1;
+    uint64_t seed = 0;
+    std::vector<uint64_t> slots;
+    for (bool found = false; !found; table_size <<= 1) {
+        for (seed = 1; seed <= 256 && !found; seed++) {
+            std::unordered_set<uint64_t> used;
+            slots.clear();
+            for (size_t index : case_indices) {
+                const std::string& text = static_cast<StringLiteral*>(node.cases[index]->value.get())->value;
+                uint64_t slot = __string_switch_hash_bytes(text.data(), text.size(), seed) & (table_size - 1);
+                if (!used.insert(slot).second) break;
+                slots.push_back(slot);
+            }
+            found = slots.size() == case_indices.size();
+        }
+        if (found) {
+            seed--;
+            break;
+        }
+    }
+    
+    std::cout << "[NEW_CODEGEN] SwitchStatement: perfect hash over " << case_indices.size()
+              << " string cases (table " << table_size << ", seed " << seed << ")" << std::endl;
+    
+    gen.emit_mov_reg_mem(7, -150);                          // RDI = discriminant string
+    gen.emit_mov_reg_imm(6, static_cast<int64_t>(seed));   // RSI = seed
+    gen.emit_call("__string_switch_hash");
+    gen.emit_and_reg_imm(0, static_cast<int64_t>(table_size - 1));
+    
+    std::vector<std::pair<int64_t, std::string>> slot_targets;
+    for (size_t k = 0; k < case_indices.size(); k++) {
+        slot_targets.emplace_back(static_cast<int64_t>(slots[k]),
+                                  "switch_hash_" + std::to_string(switch_id) + "_" + std::to_string(slots[k]));
+    }
+    gen.emit_switch_dispatch(0, false, slot_targets, no_match);
+    
+    // One confirmation per occupied slot
+    for (size_t k = 0; k < case_indices.size(); k++) {
+        gen.emit_label(slot_targets[k].second);
+        node.cases[case_indices[k]]->value->generate_code(gen);
+        gen.emit_mov_reg_reg(6, 0);     // RSI = case string
+        gen.emit_mov_reg_mem(7, -150);  // RDI = discriminant string
+        gen.emit_call("__string_equals");
+        gen.emit_and_reg_imm(0, 0xFF);  // bool return
+        gen.emit_mov_reg_imm(1, 0);
+        gen.emit_compare(0, 1);
+        gen.emit_jump_if_not_zero(case_labels[case_indices[k]]);
+        gen.emit_jump(no_match);
+    }
+    return true;
+}
+
 void SwitchStatement::generate_code(CodeGenerator& gen) {
     static int switch_counter = 0;
-    std::string switch_end = "switch_end_" + std::to_string(switch_counter);
-    switch_counter++;
+    int switch_id = switch_counter++;
+    std::string switch_end = "switch_end_" + std::to_string(switch_id);
+    std::string default_label = "case_default_" + std::to_string(switch_id);
     
     std::cout << "[NEW_CODEGEN] SwitchStatement::generate_code - generating switch with " 
               << cases.size() << " cases" << std::endl;
@@ -2944,77 +3206,75 @@ void SwitchStatement::generate_code(CodeGenerator& gen) {
     gen.emit_mov_reg_imm(0, static_cast<int64_t>(discriminant_type));
     gen.emit_mov_mem_reg(-158, 0); // Store discriminant type
     
-    // Generate code for each case
-    std::vector<std::string> case_labels;
-    std::string default_label;
+    // One label per case clause, indexed like `cases`
+    std::vector<std::string> case_labels(cases.size());
     bool has_default = false;
-    
-    // First pass: create labels and generate comparison jumps
     for (size_t i = 0; i < cases.size(); i++) {
-        const auto& case_clause = cases[i];
-        
-        if (case_clause->is_default) {
-            default_label = "case_default_" + std::to_string(switch_counter - 1);
+        if (cases[i]->is_default) {
+            case_labels[i] = default_label;
             has_default = true;
         } else {
-            std::string case_label = "case_" + std::to_string(switch_counter - 1) + "_" + std::to_string(i);
-            case_labels.push_back(case_label);
-            
-            // Generate case value and compare with discriminant
-            case_clause->value->generate_code(gen);
-            DataType case_type = case_clause->value->result_type;
-            
-            // Fast path for same known types
-            if (discriminant_type != DataType::ANY && case_type != DataType::ANY && discriminant_type == case_type) {
-                // Direct comparison for same types
-                gen.emit_mov_reg_mem(3, -150); // RBX = discriminant value from stack
-                gen.emit_sub_reg_reg(3, 0); // SUB sets zero flag if values are equal
-                gen.emit_jump_if_zero(case_label); // Jump if equal (zero flag set)
-            } else if (discriminant_type != DataType::ANY && case_type != DataType::ANY && discriminant_type != case_type) {
-                // Different known types - never equal, skip this case
-                continue;
-            } else {
-                // At least one operand is ANY - use runtime comparison
-                gen.emit_mov_reg_mem(7, -150); // RDI = discriminant value
-                gen.emit_mov_reg_mem(6, -158); // RSI = discriminant type
-                gen.emit_mov_reg_reg(2, 0);   // RDX = case value (currently in RAX)
-                gen.emit_mov_reg_imm(1, static_cast<int64_t>(case_type)); // RCX = case type
-                gen.emit_call("__runtime_js_equal");
-                
-                // Jump to case if equal (RAX != 0)
-                gen.emit_mov_reg_imm(1, 0);
-                gen.emit_compare(0, 1);
-                gen.emit_jump_if_not_zero(case_label);
-            }
+            case_labels[i] = "case_" + std::to_string(switch_id) + "_" + std::to_string(i);
         }
     }
+    std::string no_match = has_default ? default_label : switch_end;
     
-    // If no case matched and there's a default, jump to it
-    if (has_default) {
-        gen.emit_jump(default_label);
-    } else {
-        // No default case - jump to end
-        gen.emit_jump(switch_end);
-    }
+    // Constant cases are dispatched in one step; anything else is compared in order
+    bool dispatched = emit_integer_switch_dispatch(gen, *this, discriminant_type, case_labels, no_match) ||
+                      emit_string_switch_dispatch(gen, *this, discriminant_type, case_labels, no_match, switch_id);
     
-    // Second pass: generate case bodies
-    for (size_t i = 0; i < cases.size(); i++) {
+    for (size_t i = 0; i < cases.size() && !dispatched; i++) {
         const auto& case_clause = cases[i];
-        
-        if (case_clause->is_default) {
-            gen.emit_label(default_label);
+        if (case_clause->is_default) continue;
+        const std::string& case_label = case_labels[i];
+        
+        // Generate case value and compare with discriminant
+        case_clause->value->generate_code(gen);
+        DataType case_type = case_clause->value->result_type;
+        
+        // Fast path for same known types
+        if (discriminant_type != DataType::ANY && case_type != DataType::ANY && discriminant_type == case_type) {
+            // Direct comparison for same types
+            gen.emit_mov_reg_mem(3, -150); // RBX = discriminant value from stack
+            gen.emit_sub_reg_reg(3, 0); // SUB sets zero flag if values are equal
+            gen.emit_jump_if_zero(case_label); // Jump if equal (zero flag set)
+        } else if (discriminant_type != DataType::ANY && case_type != DataType::ANY && discriminant_type != case_type) {
+            // Different known types - never equal, skip this case
+            continue;
         } else {
-            gen.emit_label(case_labels[i]);
+            // At least one operand is ANY - use runtime comparison
+            gen.emit_mov_reg_mem(7, -150); // RDI = discriminant value
+            gen.emit_mov_reg_mem(6, -158); // RSI = discriminant type
+            gen.emit_mov_reg_reg(2, 0);   // RDX = case value (currently in RAX)
+            gen.emit_mov_reg_imm(1, static_cast<int64_t>(case_type)); // RCX = case type
+            gen.emit_call("__runtime_js_equal");
+            
+            // Jump to case if equal (RAX != 0)
+            gen.emit_mov_reg_imm(1, 0);
+            gen.emit_compare(0, 1);
+            gen.emit_jump_if_not_zero(case_label);
         }
+    }
+    
+    // If no case matched, go to default (or the end)
+    if (!dispatched) {
+        gen.emit_jump(no_match);
+    }
+    
+    // Case bodies, in source order; `break` jumps to the end of the switch
+    std::string saved_break_target = current_break_target;
+    current_break_target = switch_end;
+    for (size_t i = 0; i < cases.size(); i++) {
+        gen.emit_label(case_labels[i]);
         
         // Generate case body
-        for (const auto& stmt : case_clause->body) {
+        for (const auto& stmt : cases[i]->body) {
             stmt->generate_code(gen);
         }
         
         // Note: JavaScript switch cases fall through by default unless there's a break
-        // The break statement implementation should jump to switch_end
     }
+    current_break_target = saved_break_target;
     
     gen.emit_label(switch_end);
     std::cout << "[NEW_CODEGEN] SwitchStatement::generate_code complete" << std::endl;
@@ -3614,6 +3874,9 @@ void NewExpression::generate_code(CodeGenerator& gen) {
     gen.emit_mov_reg_imm(7, reinterpret_cast<int64_t>(it->second)); // RDI = class_name
     gen.emit_mov_reg_imm(6, property_count); // RSI = property_count
     gen.emit_call("__object_create");
+    if (auto* x86_gen = dynamic_cast<X86CodeGenV2*>(&gen)) {
+        x86_gen->emit_out_of_memory_check(); // Null past the heap's hard limit
+    }
     
     // __object_create returns object_id in RAX
     // Store object_id temporarily for constructor call
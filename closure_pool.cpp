@@ -0,0 +1,257 @@
+#include "closure_pool.h"
+#include <sys/mman.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+struct ClosurePool::ThreadCache {
+    FreeBlock* free_lists[SIZE_CLASS_COUNT] = {};
+    char* bump[SIZE_CLASS_COUNT] = {};
+    char* bump_end[SIZE_CLASS_COUNT] = {};
+    std::atomic<FreeBlock*> remote_frees[SIZE_CLASS_COUNT];
+
+    // Written only by the owning thread; relaxed loads elsewhere are for stats
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> remote_frees_received{0};
+
+    ThreadCache* next_abandoned = nullptr;
+    ThreadCache* next_cache = nullptr;
+
+    ThreadCache() {
+        for (auto& list : remote_frees) {
+            list.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Hands the cache back to the pool when its thread exits
+struct ThreadCacheHolder {
+    ClosurePool::ThreadCache* cache = nullptr;
+    ~ThreadCacheHolder();
+};
+
+static thread_local ClosurePool::ThreadCache* tls_cache __attribute__((tls_model("initial-exec"))) = nullptr;
+static thread_local bool tls_cache_released = false;
+static thread_local ThreadCacheHolder tls_cache_holder;
+
+ThreadCacheHolder::~ThreadCacheHolder() {
+    if (!cache) return;
+    ClosurePool& pool = ClosurePool::instance();
+    std::lock_guard<std::mutex> lock(pool.abandoned_mutex_);
+    cache->next_abandoned = pool.abandoned_;
+    pool.abandoned_ = cache;
+    tls_cache = nullptr;
+    tls_cache_released = true;
+    cache = nullptr;
+}
+
+// ============================================================================
+// POOL SETUP
+// ============================================================================
+
+ClosurePool& ClosurePool::instance() {
+    // Leaked: blocks may still be freed by other threads' destructors during exit
+    static ClosurePool* pool = new ClosurePool();
+    return *pool;
+}
+
+ClosurePool::ClosurePool() {
+    // Reserve address space only; pages are committed by the kernel on first touch
+    size_t length = RESERVATION_SIZE + SLAB_SIZE;
+    void* mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[CLOSURE_POOL] Address space reservation failed, using malloc" << std::endl;
+        return;
+    }
+    uintptr_t start = (reinterpret_cast<uintptr_t>(mem) + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1);
+    region_start_ = start;
+    region_end_ = start + RESERVATION_SIZE;
+    region_cursor_.store(start, std::memory_order_relaxed);
+}
+
+ClosurePool::ThreadCache* ClosurePool::create_cache() {
+    ThreadCache* cache = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(abandoned_mutex_);
+        if (abandoned_) {
+            cache = abandoned_;
+            abandoned_ = cache->next_abandoned;
+            cache->next_abandoned = nullptr;
+        }
+    }
+    if (!cache) {
+        cache = new ThreadCache();
+        std::lock_guard<std::mutex> lock(caches_mutex_);
+        cache->next_cache = all_caches_;
+        all_caches_ = cache;
+    }
+    return cache;
+}
+
+int64_t ClosurePool::cache_tls_offset() {
+    uintptr_t thread_pointer;
+    asm("mov %%fs:0, %0" : "=r"(thread_pointer));
+    return static_cast<int64_t>(reinterpret_cast<uintptr_t>(&tls_cache) - thread_pointer);
+}
+
+size_t ClosurePool::free_list_offset(size_t size_class) {
+    return offsetof(ThreadCache, free_lists) + size_class * sizeof(FreeBlock*);
+}
+
+size_t ClosurePool::bump_offset(size_t size_class) {
+    return offsetof(ThreadCache, bump) + size_class * sizeof(char*);
+}
+
+size_t ClosurePool::bump_end_offset(size_t size_class) {
+    return offsetof(ThreadCache, bump_end) + size_class * sizeof(char*);
+}
+
+size_t ClosurePool::allocations_offset() {
+    return offsetof(ThreadCache, allocations);
+}
+
+ClosurePool::ThreadCache* ClosurePool::current_cache() {
+    if (tls_cache) return tls_cache;
+    if (tls_cache_released) return nullptr;  // Thread is exiting
+    tls_cache = create_cache();
+    tls_cache_holder.cache = tls_cache;
+    return tls_cache;
+}
+
+ClosurePool::SlabHeader* ClosurePool::new_slab(ThreadCache* cache, size_t size_class) {
+    uintptr_t slab = region_cursor_.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+    if (slab + SLAB_SIZE > region_end_) {
+        return nullptr;
+    }
+
+    SlabHeader* header = reinterpret_cast<SlabHeader*>(slab);
+    header->owner = cache;
+    header->size_class = static_cast<uint32_t>(size_class);
+    header->block_size = static_cast<uint32_t>(block_size_of(size_class));
+    slab_count_.fetch_add(1, std::memory_order_relaxed);
+
+    // Blocks start after the header, 16-byte aligned
+    size_t first_block = (sizeof(SlabHeader) + SIZE_CLASS_GRANULE - 1) & ~(SIZE_CLASS_GRANULE - 1);
+    cache->bump[size_class] = reinterpret_cast<char*>(slab + first_block);
+    cache->bump_end[size_class] = reinterpret_cast<char*>(slab + SLAB_SIZE);
+    return header;
+}
+
+// ============================================================================
+// ALLOCATION
+// ============================================================================
+
+void* ClosurePool::refill(ThreadCache* cache, size_t size_class) {
+    // Blocks other threads returned to us since the last refill
+    FreeBlock* remote = cache->remote_frees[size_class].exchange(nullptr, std::memory_order_acquire);
+    if (remote) {
+        cache->free_lists[size_class] = remote->next;
+        return remote;
+    }
+
+    if (!new_slab(cache, size_class)) {
+        return nullptr;
+    }
+    char* block = cache->bump[size_class];
+    cache->bump[size_class] = block + block_size_of(size_class);
+    return block;
+}
+
+void* ClosurePool::allocate(size_t size) {
+    if (size == 0) size = 1;
+    ThreadCache* cache = size <= MAX_POOLED_SIZE ? current_cache() : nullptr;
+    if (!cache) {
+        fallback_allocations_.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size);
+    }
+
+    size_t size_class = size_class_of(size);
+    cache->allocations.store(cache->allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // Fast paths: pop the local free list, else bump the slab cursor
+    FreeBlock* block = cache->free_lists[size_class];
+    if (block) {
+        cache->free_lists[size_class] = block->next;
+        return block;
+    }
+    char* bump = cache->bump[size_class];
+    size_t block_size = block_size_of(size_class);
+    if (bump && bump + block_size <= cache->bump_end[size_class]) {
+        cache->bump[size_class] = bump + block_size;
+        return bump;
+    }
+
+    void* refilled = refill(cache, size_class);
+    if (!refilled) {
+        fallback_allocations_.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size);
+    }
+    return refilled;
+}
+
+void ClosurePool::deallocate(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        std::free(ptr);
+        return;
+    }
+
+    SlabHeader* slab = slab_of(ptr);
+    ThreadCache* owner = slab->owner;
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+
+    if (owner == tls_cache) {
+        block->next = owner->free_lists[slab->size_class];
+        owner->free_lists[slab->size_class] = block;
+        owner->frees.store(owner->frees.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Cross-thread return: push onto the owner's remote list
+    std::atomic<FreeBlock*>& remote = owner->remote_frees[slab->size_class];
+    FreeBlock* head = remote.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!remote.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    owner->remote_frees_received.fetch_add(1, std::memory_order_relaxed);
+}
+
+ClosurePool::Stats ClosurePool::stats() const {
+    Stats result;
+    std::lock_guard<std::mutex> lock(caches_mutex_);
+    for (ThreadCache* cache = all_caches_; cache; cache = cache->next_cache) {
+        result.allocations += cache->allocations.load(std::memory_order_relaxed);
+        result.frees += cache->frees.load(std::memory_order_relaxed);
+        result.remote_frees += cache->remote_frees_received.load(std::memory_order_relaxed);
+    }
+    result.frees += result.remote_frees;
+    result.fallback_allocations = fallback_allocations_.load(std::memory_order_relaxed);
+    result.slabs = slab_count_.load(std::memory_order_relaxed);
+    return result;
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+void* __closure_pool_alloc(size_t size) {
+    return ClosurePool::instance().allocate(size);
+}
+
+void* __closure_pool_alloc_zeroed(size_t size) {
+    void* ptr = ClosurePool::instance().allocate(size);
+    if (ptr) {
+        std::memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void __closure_pool_free(void* ptr) {
+    ClosurePool::instance().deallocate(ptr);
+}
+
+}
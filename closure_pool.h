@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// ============================================================================
+// CLOSURE POOL - Size-class pools for FunctionInstances and lexical scopes
+// ============================================================================
+//
+// Closures and escaping scopes are small, short-lived and allocated in loops.
+// Instead of going through malloc, they come from 64 KiB slabs carved out of
+// one reserved address range. Each slab serves a single size class and is
+// owned by one thread:
+//
+//   - the owning thread allocates by popping its local free list or bumping
+//     the slab cursor - no locks, no atomics
+//   - frees from the owner go back on the local free list
+//   - frees from other threads (a closure handed to another goroutine worker)
+//     are pushed onto the owner's per-class remote list with a CAS; the owner
+//     takes the whole list when its local one runs dry
+//
+// Blocks larger than the biggest size class, and anything allocated after the
+// reservation is exhausted, fall back to malloc. Ownership of a pointer is a
+// range check, so no per-block header is needed.
+
+class ClosurePool {
+public:
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+    static constexpr size_t SIZE_CLASS_GRANULE = 16;
+    static constexpr size_t SIZE_CLASS_COUNT = 32;  // 16 .. 512 bytes
+    static constexpr size_t MAX_POOLED_SIZE = SIZE_CLASS_GRANULE * SIZE_CLASS_COUNT;
+    static constexpr size_t RESERVATION_SIZE = size_t(1) << 30;
+
+    struct Stats {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t remote_frees = 0;
+        uint64_t fallback_allocations = 0;  // Served by malloc
+        uint64_t slabs = 0;
+    };
+
+    static ClosurePool& instance();
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr);
+
+    bool owns(const void* ptr) const {
+        uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        return address >= region_start_ && address < region_end_;
+    }
+
+    static size_t size_class_of(size_t size) { return (size + SIZE_CLASS_GRANULE - 1) / SIZE_CLASS_GRANULE - 1; }
+    static size_t block_size_of(size_t size_class) { return (size_class + 1) * SIZE_CLASS_GRANULE; }
+
+    Stats stats() const;
+
+    // Layout used by JIT code to allocate without a call. The cache pointer
+    // sits at the same offset from %fs in every thread (initial-exec TLS) and
+    // is null until the thread's first allocation; the other offsets are into
+    // the cache for one size class.
+    static int64_t cache_tls_offset();
+    static size_t free_list_offset(size_t size_class);
+    static size_t bump_offset(size_t size_class);
+    static size_t bump_end_offset(size_t size_class);
+    static size_t allocations_offset();
+
+    struct ThreadCache;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SlabHeader {
+        ThreadCache* owner;
+        uint32_t size_class;
+        uint32_t block_size;
+    };
+
+    uintptr_t region_start_ = 0;
+    uintptr_t region_end_ = 0;
+    std::atomic<uintptr_t> region_cursor_{0};
+
+    // Caches of exited threads, adopted by the next thread that needs one
+    std::mutex abandoned_mutex_;
+    ThreadCache* abandoned_ = nullptr;
+
+    std::atomic<uint64_t> slab_count_{0};
+    std::atomic<uint64_t> fallback_allocations_{0};
+
+    // Registry of every cache for stats aggregation
+    mutable std::mutex caches_mutex_;
+    ThreadCache* all_caches_ = nullptr;
+
+    ClosurePool();
+    ThreadCache* current_cache();
+    ThreadCache* create_cache();
+    void* refill(ThreadCache* cache, size_t size_class);
+    SlabHeader* new_slab(ThreadCache* cache, size_t size_class);
+    static SlabHeader* slab_of(const void* ptr) {
+        return reinterpret_cast<SlabHeader*>(reinterpret_cast<uintptr_t>(ptr) & ~(SLAB_SIZE - 1));
+    }
+
+    friend struct ThreadCacheHolder;
+};
+
+extern "C" {
+    void* __closure_pool_alloc(size_t size);
+    void* __closure_pool_alloc_zeroed(size_t size);
+    void __closure_pool_free(void* ptr);
+}
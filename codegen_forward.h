@@ -95,6 +95,41 @@ public:
     // Runtime function call resolution
     virtual void resolve_runtime_function_calls() = 0;
     
+    // Zero-cost exception handling: protected ranges are recorded in tables,
+    // nothing is emitted on try entry. Landing pads restore the frame's stack.
+    virtual void begin_exception_region(const std::string& landing_pad_label) { (void)landing_pad_label; }
+    virtual void end_exception_region() {}
+    virtual void emit_landing_pad(const std::string& label) { emit_label(label); }
+    // A finally landing pad keeps the exception it resumed with (RAX) in its
+    // frame while the finally body runs, then throws that value again
+    virtual void emit_save_pending_exception() {}
+    virtual void emit_throw_pending_exception() { emit_call("__runtime_rethrow_exception"); }
+    
+    // Multiway branch on a constant key set. The value in value_reg is compared
+    // against each case key (keys are distinct); float64 values match the double
+    // with the same integral value. Backends may lower this to jump tables or
+    // decision trees - the default is a linear compare chain.
+    virtual void emit_switch_dispatch(int value_reg, bool value_is_float64,
+                                      const std::vector<std::pair<int64_t, std::string>>& cases,
+                                      const std::string& default_label) {
+        for (const auto& c : cases) {
+            int64_t key = c.first;
+            if (value_is_float64) {
+                double as_double = static_cast<double>(c.first);
+                __builtin_memcpy(&key, &as_double, sizeof(key));
+            }
+            emit_mov_reg_imm(1, key);
+            emit_compare(value_reg, 1);
+            emit_jump_if_zero(c.second);
+            if (value_is_float64 && c.first == 0) {
+                emit_mov_reg_imm(1, INT64_MIN);  // -0.0 === 0
+                emit_compare(value_reg, 1);
+                emit_jump_if_zero(c.second);
+            }
+        }
+        emit_jump(default_label);
+    }
+    
     // Get offset for a specific label
     virtual int64_t get_label_offset(const std::string& label) const {
         const auto& offsets = get_label_offsets();
@@ -6,6 +6,11 @@
 #include "goroutine_system_v2.h"
 #include "function_compilation_manager.h"
 #include "function_address_patching.h"
+#include "jit_code_heap.h"
+#include "exception_unwinder.h"
+#include "jit_symbols.h"
+#include "sampling_profiler.h"
+#include "gc_heap.h"
 #include "ffi_syscalls.h"  // FFI integration
 #include "static_analyzer.h"  // NEW static analysis pass
 
@@ -291,6 +296,9 @@ void GoTSCompiler::compile(const std::string& source) {
             
             // CRITICAL: Actually allocate memory for global scope and set up r15
             std::cout << "[MAIN_SCOPE_DEBUG] Allocating memory for global scope and setting up r15" << std::endl;
+            // The global scope has no enclosing scope; the unwinder stops its
+            // scope walk for __main (which does not save r15) at null
+            codegen->emit_mov_reg_imm(15, 0);
             emit_scope_enter(*codegen, global_scope);
         } else {
             std::cerr << "[ERROR] No global scope found for main function code generation" << std::endl;
@@ -507,51 +515,35 @@ void GoTSCompiler::execute() {
             return;
         }
         
-        size_t code_size = machine_code.size();
-        // Round up to page size for better memory management
-        size_t page_size = sysconf(_SC_PAGESIZE);
-        size_t aligned_size = (code_size + page_size - 1) & ~(page_size - 1);
-        
-        // Use MAP_PRIVATE for proper JIT memory isolation
-        void* exec_mem = mmap(nullptr, aligned_size, PROT_READ | PROT_WRITE,
-                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-        
-        if (exec_mem == MAP_FAILED) {
-            std::cerr << "Failed to allocate executable memory" << std::endl;
-            return;
-        }
-        
-        memcpy(exec_mem, machine_code.data(), code_size);
-        
-        // Store the executable memory info globally for thread access
-        __set_executable_memory(exec_mem, aligned_size);
-        
         __runtime_init();
         
         // Runtime registration happens automatically in new system
         
         // PRODUCTION FIX: Resolve any unresolved runtime function calls now that the registry is populated
-        // We need to patch the code while it's still writable
         codegen->resolve_runtime_function_calls();
 
-        // Apply the patches to the executable memory
-        auto updated_code = codegen->get_code();
-        memcpy(exec_mem, updated_code.data(), updated_code.size());
-
         // PRODUCTION FIX: Compile all deferred function expressions AFTER stubs are generated
         // This ensures function expressions are placed after stubs at the correct offset
         compile_deferred_function_expressions(*codegen, type_system);
 
-        // Update the executable memory with the function expressions
-        updated_code = codegen->get_code();
-        memcpy(exec_mem, updated_code.data(), updated_code.size());
-        
-        // Make memory executable and readable, but not writable for security
-        if (mprotect(exec_mem, aligned_size, PROT_READ | PROT_EXEC) != 0) {
-            std::cerr << "Failed to make memory executable" << std::endl;
-            munmap(exec_mem, aligned_size);
+        // Place the finished program in the JIT code heap. The chunk is sized after
+        // deferred function expressions are appended so nothing spills past it.
+        auto updated_code = codegen->get_code();
+        JITCodeHeap& code_heap = JITCodeHeap::instance();
+        JITCodeChunk* program_chunk = code_heap.allocate(updated_code.size(), "__program");
+        if (!program_chunk) {
+            std::cerr << "Failed to allocate executable memory" << std::endl;
             return;
         }
+        void* exec_mem = program_chunk->exec_base;
+        size_t aligned_size = program_chunk->size;
+        
+        // Store the executable memory info globally for thread access
+        __set_executable_memory(exec_mem, aligned_size);
+        
+        // Writes go through the RW alias; the RX view is never writable (W^X)
+        code_heap.begin_write(program_chunk);
+        memcpy(program_chunk->write_base, updated_code.data(), updated_code.size());
         
         // PHASE 2.5: ASSIGN FUNCTION ADDRESSES
         // Now that we have executable memory, assign addresses to all functions
@@ -596,27 +588,52 @@ void GoTSCompiler::execute() {
         // PATCH ALL FUNCTION ADDRESSES: Use the new zero-cost patching system
         std::cout << "[EXECUTION] Patching all function addresses using new patching system..." << std::endl;
         
-        // Temporarily make memory writable for patching
-        if (mprotect(exec_mem, aligned_size, PROT_READ | PROT_WRITE) != 0) {
-            std::cerr << "Failed to make memory writable for patching" << std::endl;
-            munmap(exec_mem, aligned_size);
-            return;
-        }
-        
-        patch_all_function_addresses(exec_mem);
+        patch_all_function_addresses(exec_mem, program_chunk->write_base);
         
-        // Make memory executable again after patching
-        if (mprotect(exec_mem, aligned_size, PROT_READ | PROT_EXEC) != 0) {
-            std::cerr << "Failed to make memory executable after patching" << std::endl;
-            munmap(exec_mem, aligned_size);
-            return;
+        // Register the zero-cost exception tables for this code block
+        if (auto* x86_gen = dynamic_cast<X86CodeGenV2*>(codegen.get())) {
+            uintptr_t code_base = reinterpret_cast<uintptr_t>(exec_mem);
+            std::vector<ExceptionRegion> regions;
+            for (const auto& region : x86_gen->get_exception_regions()) {
+                auto pad_it = label_offsets.find(region.landing_pad_label);
+                if (pad_it == label_offsets.end()) {
+                    throw std::runtime_error("Landing pad label not found: " + region.landing_pad_label);
+                }
+                regions.push_back({code_base + region.start_offset, code_base + region.end_offset,
+                                   code_base + static_cast<uintptr_t>(pad_it->second), region.scope_depth});
+            }
+            std::vector<FrameUnwindInfo> frames;
+            for (const auto& record : x86_gen->get_frame_unwind_records()) {
+                FrameUnwindInfo info{code_base + record.start_offset, {}, record.allocates_scopes};
+                for (X86Reg reg : record.saved_registers) {
+                    info.saved_registers.push_back(static_cast<uint8_t>(reg));
+                }
+                frames.push_back(std::move(info));
+            }
+            std::cout << "[EXECUTION] Registering " << regions.size() << " exception regions and "
+                      << frames.size() << " frame records" << std::endl;
+            ExceptionTableRegistry::instance().register_code(code_base, program_chunk->size,
+                                                             std::move(regions), std::move(frames));
+            
+            // Function symbols for profilers and debuggers
+            std::vector<size_t> function_starts;
+            for (const auto& record : x86_gen->get_frame_unwind_records()) {
+                function_starts.push_back(record.start_offset);
+            }
+            auto symbols = JITSymbolTable::symbols_from_labels(code_base, updated_code.size(), label_offsets,
+                                                               std::move(function_starts));
+            JITSymbolTable::instance().add_code(code_base, program_chunk->size, symbols, program_chunk->exec_base);
+            SamplingProfiler::instance().note_code_mapped();
         }
         
+        // Publish the finished code - no-op protection change when dual mapped
+        code_heap.end_write(program_chunk);
+        
         // Find and execute main function
         auto main_it = label_offsets.find("__main");
         if (main_it == label_offsets.end()) {
             std::cerr << "Error: __main label not found" << std::endl;
-            munmap(exec_mem, aligned_size);
+            code_heap.release(program_chunk);
             return;
         }
         
@@ -653,12 +670,20 @@ void GoTSCompiler::execute() {
         std::cout << "DEBUG: About to call function..." << std::endl;
         std::cout.flush();
         
+        // Collections must stop this thread and scan the scopes __main links
+        GCHeap::instance().attach_current_thread();
+        
         // Spawn the main function as the main goroutine - ALL JS runs in goroutines  
         int result = 0;
         try {
             std::cout << "DEBUG: Calling function at address 0x" << std::hex << calculated_addr << std::dec << std::endl;
             std::cout.flush();
-            result = func();
+            int64_t main_result = 0;
+            if (!jit_call_guarded("the main program", reinterpret_cast<void*>(func), 0, 0, &main_result)) {
+                std::cout.flush();
+                std::_Exit(1);
+            }
+            result = static_cast<int>(main_result);
             std::cout << "DEBUG: Function returned " << result << std::endl;
             {
                 std::lock_guard<std::mutex> lock(g_console_mutex);
@@ -693,8 +718,7 @@ void GoTSCompiler::execute() {
         
         // DON'T FREE THE EXECUTABLE MEMORY - it's needed for goroutine function calls
         // The registered functions in the function registry depend on this memory
-        // This memory will be freed when the process terminates
-        // munmap(exec_mem, aligned_size);
+        // The program chunk stays live in the JIT code heap until process exit
         
     } else {
         throw std::runtime_error("Unsupported backend");
@@ -924,8 +924,9 @@ struct ThrowStatement : ASTNode {
 struct CatchClause : ASTNode {
     std::string parameter;  // catch parameter name (e.g., "error" in catch(error))
     std::vector<std::unique_ptr<ASTNode>> body;
+    VariableDeclarationInfo* variable_declaration_info;  // Direct pointer to the parameter's declaration info
     
-    CatchClause(const std::string& param) : parameter(param) {}
+    CatchClause(const std::string& param) : parameter(param), variable_declaration_info(nullptr) {}
     void generate_code(CodeGenerator& gen) override;
 };
 
@@ -1369,6 +1370,7 @@ void set_current_scope(LexicalScopeNode* scope);
 LexicalScopeNode* get_current_scope();
 void emit_scope_enter(CodeGenerator& gen, LexicalScopeNode* scope_node);
 void emit_scope_exit(CodeGenerator& gen, LexicalScopeNode* scope_node);
+const struct GCStackMap* gc_stack_map_for_scope(LexicalScopeNode* scope_node);
 
 // Function hoisting support
 void initialize_hoisted_function_variable(X86CodeGenV2* gen, FunctionDecl* func_decl, 
@@ -0,0 +1,262 @@
+#include "cycle_collector.h"
+#include "object_refcount.h"
+#include "gc_heap.h"
+#include "runtime.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+
+// Colors in the low bits of ObjectRefCountPrefix::cycle_state, the trial
+// count above them. Every object starts and ends a collection black.
+static constexpr int64_t CYCLE_BLACK = 0;     // In use, or not looked at
+static constexpr int64_t CYCLE_GRAY = 1;      // Possible member of a garbage cycle
+static constexpr int64_t CYCLE_WHITE = 2;     // Member of a garbage cycle
+static constexpr int64_t CYCLE_GARBAGE = 3;   // Collected: freed after the world resumes
+static constexpr int64_t CYCLE_COLOR_MASK = 3;
+static constexpr int CYCLE_TRIAL_SHIFT = 2;
+
+// Trial count of objects the collector must not free: dying, or queued on
+// an owner that has yet to merge them
+static constexpr int64_t CYCLE_PINNED_COUNT = int64_t(1) << 40;
+
+static inline int64_t cycle_color(void* object) {
+    return object_ref_count_prefix(object)->cycle_state & CYCLE_COLOR_MASK;
+}
+
+static inline void set_cycle_color(void* object, int64_t color) {
+    int64_t& state = object_ref_count_prefix(object)->cycle_state;
+    state = (state & ~CYCLE_COLOR_MASK) | color;
+}
+
+static inline int64_t trial_count(void* object) {
+    return object_ref_count_prefix(object)->cycle_state >> CYCLE_TRIAL_SHIFT;
+}
+
+static inline void add_trial_count(void* object, int64_t delta) {
+    object_ref_count_prefix(object)->cycle_state += delta * (int64_t(1) << CYCLE_TRIAL_SHIFT);
+}
+
+// Gray, with the trial count starting at the object's real count; exact
+// while the world is stopped
+static void start_trial(void* object) {
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    int64_t shared = prefix->shared.load(std::memory_order_acquire);
+    int64_t count = object_ref_count_total(object);
+    if (count <= 0 || (shared & ObjectRefCountPrefix::QUEUED)) {
+        count = CYCLE_PINNED_COUNT;
+    }
+    prefix->cycle_state = count * (int64_t(1) << CYCLE_TRIAL_SHIFT) | CYCLE_GRAY;
+}
+
+static uint64_t cycle_micros_since(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+CycleCollector& CycleCollector::instance() {
+    static CycleCollector* collector = new CycleCollector();
+    return *collector;
+}
+
+CycleCollector::CycleCollector() {
+    if (const char* threshold = std::getenv("ULTRASCRIPT_CYCLE_ROOT_THRESHOLD")) {
+        root_threshold_.store(std::max(1, std::atoi(threshold)), std::memory_order_relaxed);
+    }
+}
+
+void CycleCollector::set_root_threshold(size_t roots) {
+    root_threshold_.store(std::max<size_t>(1, roots), std::memory_order_relaxed);
+}
+
+// ============================================================================
+// CANDIDATE ROOTS
+// ============================================================================
+
+void CycleCollector::possible_root(void* object) {
+    size_t buffered;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+        if (prefix->shared.fetch_or(ObjectRefCountPrefix::BUFFERED, std::memory_order_acq_rel) &
+            ObjectRefCountPrefix::BUFFERED) {
+            return;
+        }
+        roots_.insert(object);
+        buffered = roots_.size();
+    }
+    // Threads filling the buffer while another collects keep buffering
+    if (buffered >= root_threshold() && !collecting_.load(std::memory_order_relaxed)) {
+        collect();
+    }
+}
+
+void CycleCollector::forget(void* object) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    roots_.erase(object);
+}
+
+// ============================================================================
+// TRIAL DELETION
+// ============================================================================
+
+// Subtracts the counts internal references contribute to everything reachable
+void CycleCollector::mark_gray(void* root, std::vector<void*>& stack) {
+    if (cycle_color(root) == CYCLE_GRAY) return;
+    start_trial(root);
+    stack.push_back(root);
+    while (!stack.empty()) {
+        void* object = stack.back();
+        stack.pop_back();
+        object_ref_count_for_each_reference(object, [&stack](void* child) {
+            if (cycle_color(child) != CYCLE_GRAY) {
+                start_trial(child);
+                stack.push_back(child);
+            }
+            add_trial_count(child, -1);
+        });
+    }
+}
+
+// Gray objects still referenced from outside turn black with everything they
+// reach; the others are white
+void CycleCollector::scan(void* root, std::vector<void*>& stack) {
+    std::vector<void*> black_stack;
+    stack.push_back(root);
+    while (!stack.empty()) {
+        void* object = stack.back();
+        stack.pop_back();
+        if (cycle_color(object) != CYCLE_GRAY) continue;
+        if (trial_count(object) > 0) {
+            scan_black(object, black_stack);
+            continue;
+        }
+        set_cycle_color(object, CYCLE_WHITE);
+        object_ref_count_for_each_reference(object, [&stack](void* child) {
+            stack.push_back(child);
+        });
+    }
+}
+
+// Puts back the counts mark_gray took from what the object reaches
+void CycleCollector::scan_black(void* root, std::vector<void*>& stack) {
+    set_cycle_color(root, CYCLE_BLACK);
+    stack.push_back(root);
+    while (!stack.empty()) {
+        void* object = stack.back();
+        stack.pop_back();
+        object_ref_count_for_each_reference(object, [&stack](void* child) {
+            add_trial_count(child, 1);
+            if (cycle_color(child) != CYCLE_BLACK) {
+                set_cycle_color(child, CYCLE_BLACK);
+                stack.push_back(child);
+            }
+        });
+    }
+}
+
+void CycleCollector::collect_white(void* root, std::vector<void*>& stack, std::vector<void*>& garbage) {
+    stack.push_back(root);
+    while (!stack.empty()) {
+        void* object = stack.back();
+        stack.pop_back();
+        if (cycle_color(object) != CYCLE_WHITE) continue;
+        set_cycle_color(object, CYCLE_GARBAGE);
+        garbage.push_back(object);
+        object_ref_count_for_each_reference(object, [&stack](void* child) {
+            stack.push_back(child);
+        });
+    }
+}
+
+size_t CycleCollector::collect() {
+    if (collecting_.exchange(true, std::memory_order_acq_rel)) return 0;
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<void*> garbage;
+    {
+        // Held through the trial: buffered objects cannot be freed meanwhile
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<void*> roots(roots_.begin(), roots_.end());
+        roots_.clear();
+        std::vector<void*> stack;
+        stack.reserve(256);
+
+        // No output or runtime locks until the world resumes: a parked
+        // thread may hold them
+        auto pause_start = std::chrono::steady_clock::now();
+        GCHeap& heap = GCHeap::instance();
+        heap.stop_the_world();
+        for (void* root : roots) {
+            object_ref_count_prefix(root)->shared.fetch_and(~ObjectRefCountPrefix::BUFFERED, std::memory_order_acq_rel);
+        }
+        for (void* root : roots) mark_gray(root, stack);
+        for (void* root : roots) scan(root, stack);
+        for (void* root : roots) collect_white(root, stack, garbage);
+        heap.resume_the_world();
+        uint64_t pause_us = cycle_micros_since(pause_start);
+
+        stats_.collections++;
+        stats_.roots_scanned += roots.size();
+        stats_.last_pause_us = pause_us;
+        stats_.total_pause_us += pause_us;
+        stats_.max_pause_us = std::max(stats_.max_pause_us, pause_us);
+    }
+
+    // Nothing outside the garbage reaches it. References between garbage
+    // objects are dropped without counting, so destroying one does not
+    // destroy another; references out of it are released as each one dies.
+    for (void* object : garbage) {
+        ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+        uint64_t slots = prefix->references.load(std::memory_order_acquire);
+        while (slots) {
+            size_t slot = __builtin_ctzll(slots);
+            slots &= slots - 1;
+            void** field = GET_OBJECT_PROPERTY_PTR(object, slot);
+            if (*field && cycle_color(*field) == CYCLE_GARBAGE) {
+                *field = nullptr;
+                prefix->references.fetch_and(~(uint64_t(1) << slot), std::memory_order_acq_rel);
+            }
+        }
+    }
+    for (void* object : garbage) {
+        __object_destruct(object);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t collection_us = cycle_micros_since(start_time);
+        stats_.objects_freed += garbage.size();
+        stats_.last_collection_us = collection_us;
+        stats_.total_collection_us += collection_us;
+    }
+    collecting_.store(false, std::memory_order_release);
+    return garbage.size();
+}
+
+// ============================================================================
+// STATISTICS
+// ============================================================================
+
+CycleCollector::Stats CycleCollector::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.buffered_roots = roots_.size();
+    stats.root_threshold = root_threshold();
+    return stats;
+}
+
+std::string CycleCollector::to_json() const {
+    Stats stats = this->stats();
+    std::ostringstream out;
+    out << "{\"collections\":" << stats.collections
+        << ",\"roots_scanned\":" << stats.roots_scanned
+        << ",\"objects_freed\":" << stats.objects_freed
+        << ",\"buffered_roots\":" << stats.buffered_roots
+        << ",\"root_threshold\":" << stats.root_threshold
+        << ",\"last_pause_us\":" << stats.last_pause_us
+        << ",\"total_pause_us\":" << stats.total_pause_us
+        << ",\"max_pause_us\":" << stats.max_pause_us
+        << ",\"last_collection_us\":" << stats.last_collection_us
+        << ",\"total_collection_us\":" << stats.total_collection_us << "}";
+    return out.str();
+}
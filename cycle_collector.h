@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// ============================================================================
+// CYCLE COLLECTOR - Trial deletion for reference-counted class instances
+// ============================================================================
+//
+// Reference counts (object_refcount.h) never reach zero on a cycle, so class
+// instances that point at each other through counted property slots
+// (__object_set_reference) would leak. This is the synchronous collector of
+// Bacon and Rajan, "Concurrent Cycle Collection in Reference Counted Systems":
+//
+//   - a decrement that leaves an object holding counted references alive
+//     buffers it as a candidate root (BUFFERED in its shared count)
+//   - once the buffer reaches the root threshold, the thread that fills it
+//     collects: MarkGray subtracts the counts contributed by internal
+//     references, Scan turns what is still referenced from outside black
+//     again, and CollectWhite frees the rest
+//
+// Colors and trial counts live in the object's prefix. The trial runs with
+// the GC heap's world stopped, so threads registered with the heap cannot
+// change counts or slots under it; objects queued on an owner for merging
+// are left alone until the owner merges them.
+//
+//   ULTRASCRIPT_CYCLE_ROOT_THRESHOLD=<n>   collect once n roots are buffered (default 10000)
+//   runtime.gc.collectCycles() / runtime.gc.cycleStats()
+
+class CycleCollector {
+public:
+    static constexpr size_t DEFAULT_ROOT_THRESHOLD = 10000;
+
+    struct Stats {
+        uint64_t collections = 0;
+        uint64_t roots_scanned = 0;
+        uint64_t objects_freed = 0;
+        uint64_t last_pause_us = 0;      // World stopped for the trial
+        uint64_t total_pause_us = 0;
+        uint64_t max_pause_us = 0;
+        uint64_t last_collection_us = 0; // Trial plus freeing the garbage
+        uint64_t total_collection_us = 0;
+        size_t buffered_roots = 0;
+        size_t root_threshold = 0;
+    };
+
+    static CycleCollector& instance();
+
+    // Called before or after a decrement that may leave a cycle behind; the
+    // object must still be alive
+    void possible_root(void* object);
+    // Called when a buffered object is freed
+    void forget(void* object);
+
+    // Returns the number of objects freed
+    size_t collect();
+
+    void set_root_threshold(size_t roots);
+    size_t root_threshold() const { return root_threshold_.load(std::memory_order_relaxed); }
+
+    Stats stats() const;
+    std::string to_json() const;
+
+private:
+    mutable std::mutex mutex_;           // Guards roots_ and stats_; held through the trial
+    std::unordered_set<void*> roots_;
+    std::atomic<size_t> root_threshold_{DEFAULT_ROOT_THRESHOLD};
+    std::atomic<bool> collecting_{false};
+    Stats stats_;
+
+    CycleCollector();
+
+    void mark_gray(void* root, std::vector<void*>& stack);
+    void scan(void* root, std::vector<void*>& stack);
+    void scan_black(void* root, std::vector<void*>& stack);
+    void collect_white(void* root, std::vector<void*>& stack, std::vector<void*>& garbage);
+};
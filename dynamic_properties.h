@@ -110,11 +110,14 @@ struct DynamicPropertyMap {
  * Offsets:
  * - 0:  class_name_ptr (GoTSString*)
  * - 8:  property_count (int64_t) 
- * - 16: ref_count (std::atomic<int64_t>)
+ * - 16: ref_count (int64_t, biased: written only by the creating thread)
  * - 24: dynamic_map_ptr (DynamicPropertyMap*)
  * - 32: property0 (first static property)
  * - 40: property1 (second static property)
  * - ...
+ *
+ * An ObjectRefCountPrefix (owner thread, shared count) sits in the 16 bytes
+ * before the object; see object_refcount.h.
  */
 
 // Runtime functions for dynamic property access
@@ -173,7 +176,7 @@ extern "C" {
     (*reinterpret_cast<int64_t*>(reinterpret_cast<char*>(obj) + OBJECT_PROPERTY_COUNT_OFFSET))
 
 #define GET_OBJECT_REF_COUNT(obj) \
-    (*reinterpret_cast<std::atomic<int64_t>*>(reinterpret_cast<char*>(obj) + OBJECT_REF_COUNT_OFFSET))
+    (*reinterpret_cast<int64_t*>(reinterpret_cast<char*>(obj) + OBJECT_REF_COUNT_OFFSET))
 
 #define GET_OBJECT_DYNAMIC_MAP(obj) \
     (*reinterpret_cast<DynamicPropertyMap**>(reinterpret_cast<char*>(obj) + OBJECT_DYNAMIC_MAP_OFFSET))
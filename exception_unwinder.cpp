@@ -0,0 +1,334 @@
+#include "exception_unwinder.h"
+#include "closure_pool.h"
+#include "jit_code_heap.h"
+#include "gc_stack_maps.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// Exception being propagated/handled on this thread (read by catch blocks and rethrow)
+static thread_local void* g_current_exception = nullptr;
+
+// Guard against corrupted frame chains
+static constexpr int MAX_UNWIND_DEPTH = 100000;
+static constexpr size_t MAX_FRAME_SCOPES = 4096;
+
+// ============================================================================
+// THROW / RESUME STUBS
+// ============================================================================
+//
+// On entry to the throw stubs [rsp] is the return address into the throwing
+// JIT frame and rbx/rbp/r12-r15 still hold that frame's values. The stubs
+// snapshot them into an UnwindContext on an aligned stack slot and hand off to
+// the C++ unwinder, which never returns.
+
+__asm__(
+    ".text\n"
+    ".globl __runtime_throw_exception\n"
+    ".type __runtime_throw_exception, @function\n"
+    "__runtime_throw_exception:\n"
+    "    jmp __runtime_throw_common\n"
+    ".size __runtime_throw_exception, .-__runtime_throw_exception\n"
+
+    ".globl __runtime_rethrow_exception\n"
+    ".type __runtime_rethrow_exception, @function\n"
+    "__runtime_rethrow_exception:\n"
+    "    push %rdi\n"                       // realign for the C call; [rsp] is the return address again after pop
+    "    call __runtime_current_exception\n"
+    "    pop %rdi\n"
+    "    mov %rax, %rdi\n"
+    "    jmp __runtime_throw_common\n"
+    ".size __runtime_rethrow_exception, .-__runtime_rethrow_exception\n"
+
+    ".type __runtime_throw_common, @function\n"
+    "__runtime_throw_common:\n"
+    "    mov %rsp, %rax\n"                  // rax -> return address slot
+    "    sub $64, %rsp\n"
+    "    and $-16, %rsp\n"
+    "    mov %rbx, 0(%rsp)\n"
+    "    mov %rbp, 8(%rsp)\n"
+    "    mov %r12, 16(%rsp)\n"
+    "    mov %r13, 24(%rsp)\n"
+    "    mov %r14, 32(%rsp)\n"
+    "    mov %r15, 40(%rsp)\n"
+    "    lea 8(%rax), %rcx\n"
+    "    mov %rcx, 48(%rsp)\n"              // caller's rsp once the call returns
+    "    mov (%rax), %rcx\n"
+    "    mov %rcx, 56(%rsp)\n"              // return address inside the JIT frame
+    "    mov %rsp, %rsi\n"
+    "    call __runtime_unwind_exception\n"
+    "    ud2\n"
+    ".size __runtime_throw_common, .-__runtime_throw_common\n"
+
+    ".globl __runtime_resume_context\n"
+    ".type __runtime_resume_context, @function\n"
+    "__runtime_resume_context:\n"
+    "    mov %rsi, %rax\n"                  // landing pads receive the exception in rax
+    "    mov 56(%rdi), %r11\n"
+    "    mov 0(%rdi), %rbx\n"
+    "    mov 8(%rdi), %rbp\n"
+    "    mov 16(%rdi), %r12\n"
+    "    mov 24(%rdi), %r13\n"
+    "    mov 32(%rdi), %r14\n"
+    "    mov 40(%rdi), %r15\n"
+    "    mov 48(%rdi), %rsp\n"
+    "    jmp *%r11\n"
+    ".size __runtime_resume_context, .-__runtime_resume_context\n"
+
+    // Keeps the native caller's callee-saved registers in its own frame: JIT
+    // frames are not required to save every register they use
+    ".globl __runtime_call_jit\n"
+    ".type __runtime_call_jit, @function\n"
+    "__runtime_call_jit:\n"
+    "    push %rbp\n"
+    "    mov %rsp, %rbp\n"
+    "    push %rbx\n"
+    "    push %r12\n"
+    "    push %r13\n"
+    "    push %r14\n"
+    "    push %r15\n"
+    "    push %rcx\n"                      // value out-parameter; rsp is 16-byte aligned
+    "    mov %rdi, %rax\n"
+    "    mov %rsi, %rdi\n"
+    "    mov %rdx, %rsi\n"
+    ".globl __runtime_call_jit_protected\n"
+    "__runtime_call_jit_protected:\n"
+    "    call *%rax\n"
+    ".globl __runtime_call_jit_returned\n"
+    "__runtime_call_jit_returned:\n"
+    "    mov -48(%rbp), %rcx\n"
+    "    mov %rax, (%rcx)\n"
+    "    xor %eax, %eax\n"
+    "    jmp 1f\n"
+    ".globl __runtime_call_jit_landing_pad\n"
+    "__runtime_call_jit_landing_pad:\n"
+    "    mov -48(%rbp), %rcx\n"
+    "    mov %rax, (%rcx)\n"
+    "    mov $1, %eax\n"
+    "1:\n"
+    "    mov -8(%rbp), %rbx\n"
+    "    mov -16(%rbp), %r12\n"
+    "    mov -24(%rbp), %r13\n"
+    "    mov -32(%rbp), %r14\n"
+    "    mov -40(%rbp), %r15\n"
+    "    leave\n"
+    "    ret\n"
+    ".globl __runtime_call_jit_end\n"
+    "__runtime_call_jit_end:\n"
+    ".size __runtime_call_jit, .-__runtime_call_jit\n"
+);
+
+extern "C" char __runtime_call_jit_protected[];
+extern "C" char __runtime_call_jit_returned[];
+extern "C" char __runtime_call_jit_landing_pad[];
+extern "C" char __runtime_call_jit_end[];
+
+// ============================================================================
+// EXCEPTION TABLE REGISTRY
+// ============================================================================
+
+ExceptionTableRegistry& ExceptionTableRegistry::instance() {
+    static ExceptionTableRegistry registry;
+    return registry;
+}
+
+ExceptionTableRegistry::ExceptionTableRegistry() {
+    uintptr_t start = reinterpret_cast<uintptr_t>(&__runtime_call_jit);
+    uintptr_t end = reinterpret_cast<uintptr_t>(__runtime_call_jit_end);
+    ExceptionRegion region{reinterpret_cast<uintptr_t>(__runtime_call_jit_protected),
+                           reinterpret_cast<uintptr_t>(__runtime_call_jit_returned),
+                           reinterpret_cast<uintptr_t>(__runtime_call_jit_landing_pad)};
+    FrameUnwindInfo frame{start, {3, 12, 13, 14, 15}};
+    blocks_.push_back({start, end - start, {region}, {frame}});
+}
+
+void ExceptionTableRegistry::register_code(uintptr_t code_start, size_t code_size,
+                                           std::vector<ExceptionRegion> regions,
+                                           std::vector<FrameUnwindInfo> frames) {
+    // Nested try blocks can start at the same address; order the outer
+    // (longer) region first so the inner one is found first when searching back
+    std::sort(regions.begin(), regions.end(),
+              [](const ExceptionRegion& a, const ExceptionRegion& b) {
+                  return a.start != b.start ? a.start < b.start : a.end > b.end;
+              });
+    std::sort(frames.begin(), frames.end(),
+              [](const FrameUnwindInfo& a, const FrameUnwindInfo& b) { return a.start < b.start; });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Re-registration (recompiled code at the same address) replaces the old tables
+    blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(),
+                                 [code_start](const CodeBlock& block) { return block.start == code_start; }),
+                  blocks_.end());
+    blocks_.push_back({code_start, code_size, std::move(regions), std::move(frames)});
+}
+
+void ExceptionTableRegistry::unregister_code(uintptr_t code_start) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.erase(std::remove_if(blocks_.begin(), blocks_.end(),
+                                 [code_start](const CodeBlock& block) { return block.start == code_start; }),
+                  blocks_.end());
+}
+
+const ExceptionTableRegistry::CodeBlock* ExceptionTableRegistry::find_block(uintptr_t pc) const {
+    for (const CodeBlock& block : blocks_) {
+        if (pc >= block.start && pc < block.start + block.size) {
+            return &block;
+        }
+    }
+    return nullptr;
+}
+
+bool ExceptionTableRegistry::is_jit_code(uintptr_t pc) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_block(pc) != nullptr;
+}
+
+const ExceptionRegion* ExceptionTableRegistry::find_region(uintptr_t return_address) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const CodeBlock* block = find_block(return_address);
+    if (!block) return nullptr;
+
+    // A return address sits just past its call, so a call that ends the
+    // protected range yields return_address == end. Regions are sorted so
+    // that a nested region always comes after its parent, so the last match
+    // is the innermost.
+    auto it = std::upper_bound(block->regions.begin(), block->regions.end(), return_address,
+                               [](uintptr_t pc, const ExceptionRegion& r) { return pc <= r.start; });
+    while (it != block->regions.begin()) {
+        --it;
+        if (return_address > it->start && return_address <= it->end) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+const FrameUnwindInfo* ExceptionTableRegistry::find_frame(uintptr_t pc) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const CodeBlock* block = find_block(pc);
+    if (!block) return nullptr;
+
+    auto it = std::upper_bound(block->frames.begin(), block->frames.end(), pc,
+                               [](uintptr_t value, const FrameUnwindInfo& f) { return value < f.start; });
+    if (it == block->frames.begin()) return nullptr;
+    return &*std::prev(it);
+}
+
+// ============================================================================
+// UNWINDER
+// ============================================================================
+
+static void restore_saved_register(UnwindContext& context, uint8_t reg, uint64_t value) {
+    switch (reg) {
+        case 3:  context.rbx = value; break;
+        case 12: context.r12 = value; break;
+        case 13: context.r13 = value; break;
+        case 14: context.r14 = value; break;
+        case 15: context.r15 = value; break;
+        default: break;  // Caller-saved registers need no restoring
+    }
+}
+
+// Frees the scopes `frame` entered beyond the first `keep`, innermost first,
+// and points its r15 at the innermost scope left. Scopes are unpublished
+// from the collector's chain before their memory is returned.
+static void release_frame_scopes(UnwindContext& frame, const FrameUnwindInfo& info, size_t keep) {
+    if (!info.allocates_scopes) return;
+
+    // The frame's outermost scope encloses its caller's r15, saved by the
+    // prologue - or nothing, for a frame that does not save r15
+    void* base = nullptr;
+    const uint64_t* rbp = reinterpret_cast<const uint64_t*>(frame.rbp);
+    for (size_t i = 0; i < info.saved_registers.size(); i++) {
+        if (info.saved_registers[i] == 15) {
+            base = reinterpret_cast<void*>(rbp[-static_cast<int64_t>(i + 1)]);
+        }
+    }
+
+    std::vector<void*> scopes;  // Innermost first
+    void* scope = reinterpret_cast<void*>(frame.r15);
+    while (scope != base) {
+        if (!scope || scopes.size() == MAX_FRAME_SCOPES) return;  // Not this frame's chain - leave it alone
+        scopes.push_back(scope);
+        scope = gc_scope_header(scope)->enclosing;
+    }
+    if (scopes.size() <= keep) return;
+
+    size_t released = scopes.size() - keep;
+    void* chain = gc_scope_chain_save();
+    while (chain && std::find(scopes.begin(), scopes.begin() + released, chain) != scopes.begin() + released) {
+        chain = gc_scope_header(chain)->previous;
+    }
+    gc_scope_chain_restore(chain);
+    for (size_t i = 0; i < released; i++) {
+        __closure_pool_free(gc_scope_header(scopes[i]));
+    }
+    frame.r15 = reinterpret_cast<uint64_t>(released < scopes.size() ? scopes[released] : base);
+}
+
+bool jit_call_guarded(const char* context, void* function, int64_t arg0, int64_t arg1, int64_t* result) {
+    int64_t value = 0;
+    int threw;
+    {
+        JITCodeRegion code_region;
+        threw = __runtime_call_jit(function, arg0, arg1, &value);
+    }
+    if (threw) {
+        std::fflush(stdout);
+        std::cout.flush();
+        std::cerr << "Uncaught exception in " << context << " (value 0x" << std::hex
+                  << static_cast<uint64_t>(value) << std::dec << ")" << std::endl;
+        return false;
+    }
+    if (result) *result = value;
+    return true;
+}
+
+extern "C" {
+
+void* __runtime_current_exception() {
+    return g_current_exception;
+}
+
+void __runtime_unwind_exception(void* value, UnwindContext* context) {
+    g_current_exception = value;
+    ExceptionTableRegistry& registry = ExceptionTableRegistry::instance();
+
+    // `frame` describes the JIT frame that made the call at frame.rip
+    UnwindContext frame = *context;
+    for (int depth = 0; depth < MAX_UNWIND_DEPTH; depth++) {
+        if (!registry.is_jit_code(frame.rip) || frame.rbp == 0) {
+            break;
+        }
+
+        const FrameUnwindInfo* info = registry.find_frame(frame.rip);
+        if (const ExceptionRegion* region = registry.find_region(frame.rip)) {
+            if (info) release_frame_scopes(frame, *info, region->scope_depth);
+            frame.rip = region->landing_pad;
+            __runtime_resume_context(&frame, value);
+        }
+
+        // No handler here - free its scopes, undo its prologue and continue in its caller
+        const uint64_t* rbp = reinterpret_cast<const uint64_t*>(frame.rbp);
+        if (info) {
+            release_frame_scopes(frame, *info, 0);
+            for (size_t i = 0; i < info->saved_registers.size(); i++) {
+                restore_saved_register(frame, info->saved_registers[i], rbp[-static_cast<int64_t>(i + 1)]);
+            }
+        }
+        frame.rsp = frame.rbp + 16;
+        frame.rip = rbp[1];
+        frame.rbp = rbp[0];
+    }
+
+    // Foreign (C++) frames carry no JIT tables, so the exception cannot cross
+    // them; native code that calls JIT code goes through __runtime_call_jit
+    std::fflush(stdout);
+    std::cout.flush();
+    std::cerr << "Uncaught exception (value 0x" << std::hex << reinterpret_cast<uintptr_t>(value)
+              << std::dec << ")" << std::endl;
+    std::_Exit(1);
+}
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// ZERO-COST EXCEPTION HANDLING - Table-driven unwinding for JIT code
+// ============================================================================
+//
+// Entering a try block emits no code. Instead the code generator records the
+// protected code range and its landing pad, plus the frame layout of every
+// JIT function (callee-saved registers pushed after RBP). A throw captures the
+// callee-saved registers of the throwing frame, then walks the RBP chain:
+// for each return address it looks for an enclosing protected range, and if
+// none is found it restores that frame's saved registers and moves on to the
+// caller. The landing pad itself re-establishes RSP for its frame.
+//
+// Lexical scopes entered by the frames being abandoned are freed on the way:
+// every frame that allocates scopes saves r15 (its caller's scope) or starts
+// its chain at a null enclosing scope, and each protected range records how
+// many of its frame's scopes are live at the landing pad.
+//
+// Native code enters JIT code through __runtime_call_jit, whose own frame is
+// registered as JIT code with a catch-all range. An exception no script frame
+// catches ends there and is handed back to the native caller instead of
+// unwinding into frames that have no tables.
+
+// Register snapshot shared with the assembly throw/resume stubs - layout is ABI
+struct UnwindContext {
+    uint64_t rbx;
+    uint64_t rbp;
+    uint64_t r12;
+    uint64_t r13;
+    uint64_t r14;
+    uint64_t r15;
+    uint64_t rsp;
+    uint64_t rip;
+};
+
+// Protected code range [start, end) with absolute addresses
+struct ExceptionRegion {
+    uintptr_t start;
+    uintptr_t end;
+    uintptr_t landing_pad;
+    size_t scope_depth = 0;  // Scopes of the frame kept live for the landing pad
+};
+
+// Frame layout of one JIT function: push rbp; mov rbp, rsp; push saved_registers...
+struct FrameUnwindInfo {
+    uintptr_t start;
+    std::vector<uint8_t> saved_registers;  // x86 register numbers in push order
+    bool allocates_scopes = false;          // r15 holds scopes this frame entered
+};
+
+class ExceptionTableRegistry {
+public:
+    static ExceptionTableRegistry& instance();
+
+    // Register the tables for one block of JIT code. Regions and frames may be
+    // in any order; they are sorted on registration.
+    void register_code(uintptr_t code_start, size_t code_size,
+                       std::vector<ExceptionRegion> regions,
+                       std::vector<FrameUnwindInfo> frames);
+    void unregister_code(uintptr_t code_start);
+
+    // Innermost protected region containing a return address, or nullptr
+    const ExceptionRegion* find_region(uintptr_t return_address) const;
+    const FrameUnwindInfo* find_frame(uintptr_t pc) const;
+    bool is_jit_code(uintptr_t pc) const;
+
+private:
+    struct CodeBlock {
+        uintptr_t start;
+        size_t size;
+        std::vector<ExceptionRegion> regions;  // Sorted by start, outer before inner
+        std::vector<FrameUnwindInfo> frames;   // Sorted by start
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<CodeBlock> blocks_;
+
+    ExceptionTableRegistry();  // Registers the __runtime_call_jit frame
+    const CodeBlock* find_block(uintptr_t pc) const;
+};
+
+// Calls JIT code from native code. Returns false if a script exception
+// escaped it, after reporting the exception with `context` on stderr.
+bool jit_call_guarded(const char* context, void* function, int64_t arg0 = 0, int64_t arg1 = 0,
+                      int64_t* result = nullptr);
+
+extern "C" {
+    // Called from JIT code. Both capture the caller's registers and never return.
+    void __runtime_throw_exception(void* value);
+    void __runtime_rethrow_exception();
+
+    // Value of the exception currently being handled on this thread
+    void* __runtime_current_exception();
+
+    // Unwinder entry used by the assembly stubs
+    [[noreturn]] void __runtime_unwind_exception(void* value, UnwindContext* context);
+    [[noreturn]] void __runtime_resume_context(UnwindContext* context, void* value);
+
+    // Runtime-to-JIT boundary: stores function(arg0, arg1) in *value and
+    // returns 0, or stores the exception that escaped and returns 1
+    int __runtime_call_jit(void* function, int64_t arg0, int64_t arg1, int64_t* value);
+}
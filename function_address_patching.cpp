@@ -20,7 +20,11 @@ void register_function_patch(size_t patch_offset, void* function_ast, size_t add
               << " and instruction_length " << instruction_length << std::endl;
 }
 
-void patch_all_function_addresses(void* executable_memory_base) {
+void patch_all_function_addresses(void* executable_memory_base, void* writable_memory_base) {
+    if (!writable_memory_base) {
+        writable_memory_base = executable_memory_base;
+    }
+    
     std::cout << "[PATCH_SYSTEM] Patching " << g_function_patches.size() 
               << " function addresses in executable memory at " << executable_memory_base << std::endl;
               
@@ -44,6 +48,11 @@ void patch_all_function_addresses(void* executable_memory_base) {
         
         std::cout << "[PATCH_DEBUG]   calculated patch location: " << patch_location << std::endl;
         
+        // The RW alias of the patch location - the RX view itself is never writable
+        void* patch_write_location = reinterpret_cast<void*>(
+            reinterpret_cast<uintptr_t>(writable_memory_base) + patch_info.patch_offset + patch_info.additional_offset
+        );
+        
         // Verify patch location is within executable memory bounds
         // Assuming typical executable memory size, let's add a basic bounds check
         uintptr_t base_addr = reinterpret_cast<uintptr_t>(executable_memory_base);
@@ -77,13 +86,13 @@ void patch_all_function_addresses(void* executable_memory_base) {
         
         // Check placeholder value for debugging (optional warning)
         if (is_32bit_immediate) {
-            uint32_t current_value = *reinterpret_cast<uint32_t*>(patch_location);
+            uint32_t current_value = *reinterpret_cast<uint32_t*>(patch_write_location);
             if (current_value != 0x00000000) {
                 std::cout << "[PATCH_NOTE] Non-zero placeholder found: " 
                           << std::hex << current_value << std::dec << std::endl;
             }
         } else {
-            uint64_t current_value = *reinterpret_cast<uint64_t*>(patch_location);
+            uint64_t current_value = *reinterpret_cast<uint64_t*>(patch_write_location);
             if (current_value != 0x0000000000000000ULL) {
                 std::cout << "[PATCH_NOTE] Non-zero placeholder found: " 
                           << std::hex << current_value << std::dec << std::endl;
@@ -92,7 +101,7 @@ void patch_all_function_addresses(void* executable_memory_base) {
         
         // Debug: Show bytes before patching
         std::cout << "[PATCH_DEBUG] Bytes before patching (" << immediate_size << " bytes): ";
-        unsigned char* bytes = reinterpret_cast<unsigned char*>(patch_location);
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(patch_write_location);
         for (size_t i = 0; i < immediate_size; i++) {
             printf("%02x ", bytes[i]);
         }
@@ -109,11 +118,11 @@ void patch_all_function_addresses(void* executable_memory_base) {
                     continue;
                 }
                 uint32_t addr_32 = static_cast<uint32_t>(addr_value);
-                *reinterpret_cast<uint32_t*>(patch_location) = addr_32;
+                *reinterpret_cast<uint32_t*>(patch_write_location) = addr_32;
                 std::cout << "[PATCH_SUCCESS] Patched with 32-bit immediate: " << std::hex << addr_32 << std::dec << std::endl;
             } else {
                 // For 64-bit immediate, write 8 bytes
-                *reinterpret_cast<void**>(patch_location) = actual_function_address;
+                *reinterpret_cast<void**>(patch_write_location) = actual_function_address;
                 std::cout << "[PATCH_SUCCESS] Patched with 64-bit immediate" << std::endl;
             }
         } catch (...) {
@@ -45,8 +45,11 @@ extern std::vector<FunctionPatchInfo> g_function_patches;
 // Register a location that needs function address patching
 void register_function_patch(size_t patch_offset, void* function_ast, size_t additional_offset = 0, size_t instruction_length = 10);
 
-// Patch all function addresses in executable memory
-void patch_all_function_addresses(void* executable_memory_base);
+// Patch all function addresses in executable memory. Addresses are computed
+// against executable_memory_base (the RX view); writes go through
+// writable_memory_base, the RW alias from the JIT code heap (defaults to the
+// executable base when code is not dual mapped).
+void patch_all_function_addresses(void* executable_memory_base, void* writable_memory_base = nullptr);
 
 // Clear all registered patches (for cleanup)
 void clear_function_patches();
@@ -1,5 +1,6 @@
 #include "function_runtime.h"
 #include "function_instance.h"
+#include "closure_pool.h"
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
@@ -31,7 +32,7 @@ extern "C" void* __runtime_copy_function_to_heap(void* local_function_var) {
     std::cout << "[RUNTIME] Copying function instance to heap (size: " << instance_size << " bytes)" << std::endl;
     
     // Allocate heap memory for type tag + pointer + instance data
-    void* heap_copy = malloc(16 + instance_size);
+    void* heap_copy = ClosurePool::instance().allocate(16 + instance_size);
     if (!heap_copy) {
         std::cerr << "[RUNTIME] ERROR: Failed to allocate heap memory for function copy" << std::endl;
         return nullptr;
@@ -61,23 +62,18 @@ extern "C" void __throw_type_error(const char* message) {
     throw std::runtime_error(error_msg);
 }
 
-// Function instance allocation
+// Function instance allocation - served from the closure pool (see closure_pool.h)
 extern "C" void* __allocate_function_instance(size_t total_size) {
-    void* instance = malloc(total_size);
+    void* instance = ClosurePool::instance().allocate(total_size);
     if (!instance) {
         std::cerr << "[RUNTIME] ERROR: Failed to allocate function instance (" << total_size << " bytes)" << std::endl;
         return nullptr;
     }
-    
-    std::cout << "[RUNTIME] Allocated function instance: " << total_size << " bytes at " << instance << std::endl;
     return instance;
 }
 
 extern "C" void __deallocate_function_instance(void* instance) {
-    if (instance) {
-        std::cout << "[RUNTIME] Deallocating function instance at " << instance << std::endl;
-        free(instance);
-    }
+    ClosurePool::instance().deallocate(instance);
 }
 
 // Lexical scope allocation for function execution
@@ -86,7 +82,7 @@ extern "C" void* __allocate_lexical_scope_heap_object(size_t scope_size) {
         return nullptr; // No allocation needed for empty scopes
     }
     
-    void* scope = malloc(scope_size);
+    void* scope = ClosurePool::instance().allocate(scope_size);
     if (!scope) {
         std::cerr << "[RUNTIME] ERROR: Failed to allocate lexical scope (" << scope_size << " bytes)" << std::endl;
         return nullptr;
@@ -94,16 +90,11 @@ extern "C" void* __allocate_lexical_scope_heap_object(size_t scope_size) {
     
     // Zero-initialize the scope memory
     memset(scope, 0, scope_size);
-    
-    std::cout << "[RUNTIME] Allocated lexical scope: " << scope_size << " bytes at " << scope << std::endl;
     return scope;
 }
 
 extern "C" void __deallocate_lexical_scope_heap_object(void* scope) {
-    if (scope) {
-        std::cout << "[RUNTIME] Deallocating lexical scope at " << scope << std::endl;
-        free(scope);
-    }
+    ClosurePool::instance().deallocate(scope);
 }
 
 //=============================================================================
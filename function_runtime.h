@@ -33,7 +33,7 @@ inline FunctionInstance* create_function_instance(void* function_code_addr,
                                                  size_t scope_count,
                                                  void** captured_scopes = nullptr) {
     size_t total_size = 16 + (scope_count * 8);
-    FunctionInstance* instance = static_cast<FunctionInstance*>(malloc(total_size));
+    FunctionInstance* instance = static_cast<FunctionInstance*>(__allocate_function_instance(total_size));
     
     if (!instance) {
         return nullptr;
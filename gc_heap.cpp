@@ -0,0 +1,1311 @@
+#include "gc_heap.h"
+#include "simd_optimizations.h"
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef MREMAP_DONTUNMAP
+#define MREMAP_DONTUNMAP 4
+#endif
+
+// Initial-exec keeps the buffer at the same %fs offset in every thread, which
+// is what the JIT fast path relies on
+static thread_local GCThreadLocalBuffer gc_tlab __attribute__((tls_model("initial-exec")));
+
+// Retires the buffer when its thread exits
+struct GCThreadLocalBufferHolder {
+    bool attached = false;
+    ~GCThreadLocalBufferHolder();
+};
+
+static thread_local bool tls_tlab_released = false;
+static thread_local GCThreadLocalBufferHolder tls_tlab_holder;
+
+GCThreadLocalBufferHolder::~GCThreadLocalBufferHolder() {
+    if (!attached) return;
+    GCHeap::instance().retire_tlab(gc_tlab);
+    tls_tlab_released = true;
+    attached = false;
+}
+
+GCThreadLocalBuffer& gc_current_tlab() {
+    return gc_tlab;
+}
+
+// SIGPWR is otherwise unused on Linux (Boehm GC makes the same choice)
+static constexpr int GC_STOP_SIGNAL = SIGPWR;
+static std::atomic<bool> gc_world_stopped{false};
+static std::atomic<int> gc_threads_parked{0};
+
+static void gc_stop_signal_handler(int) {
+    int saved_errno = errno;
+    gc_threads_parked.fetch_add(1);
+    while (gc_world_stopped.load(std::memory_order_acquire)) {
+        sched_yield();
+    }
+    gc_threads_parked.fetch_sub(1);
+    errno = saved_errno;
+}
+
+// ============================================================================
+// HEAP SETUP
+// ============================================================================
+
+GCHeap& GCHeap::instance() {
+    // Leaked: exiting threads retire their buffers after static destructors run
+    static GCHeap* heap = new GCHeap();
+    return *heap;
+}
+
+GCHeap::GCHeap() {
+    // Reserve address space only; pages are committed by the kernel on first touch
+    size_t length = GC_HEAP_RESERVATION + GC_LARGE_SPACE_RESERVATION + GC_PAGE_SIZE;
+    void* mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[GC] Heap reservation failed" << std::endl;
+        return;
+    }
+    base_ = (reinterpret_cast<uintptr_t>(mem) + GC_PAGE_SIZE - 1) & ~(GC_PAGE_SIZE - 1);
+    reserved_ = GC_HEAP_RESERVATION + GC_LARGE_SPACE_RESERVATION;
+    page_count_ = reserved_ / GC_PAGE_SIZE;
+    paged_page_count_ = GC_HEAP_RESERVATION / GC_PAGE_SIZE;
+    large_floor_ = page_count_;
+    pages_.resize(page_count_);
+    const char* huge_pages = std::getenv("ULTRASCRIPT_GC_HUGE_PAGES");
+    large_huge_pages_ = huge_pages && huge_pages[0] == '1';
+    
+    // One byte per card, committed as cards are first dirtied
+    void* cards = mmap(nullptr, reserved_ >> GC_CARD_SHIFT, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (cards == MAP_FAILED) {
+        std::cerr << "[GC] Card table reservation failed" << std::endl;
+        base_ = 0;
+        reserved_ = 0;
+        return;
+    }
+    card_table_ = static_cast<uint8_t*>(cards);
+    promotion_tlab_.old_space = true;
+    gc_reserve_page(free_pages_);
+    gc_reserve_page(large_free_spans_);
+    for (int space = 0; space < 2; space++) {
+        for (size_t size_class = 0; size_class < GC_SIZE_CLASS_COUNT; size_class++) {
+            gc_reserve_page(available_pages_[space][size_class]);
+            gc_reserve_page(unswept_pages_[space][size_class]);
+        }
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = gc_stop_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigfillset(&action.sa_mask);
+    if (sigaction(GC_STOP_SIGNAL, &action, nullptr) != 0) {
+        std::cerr << "[GC] sigaction(SIGPWR) failed: " << std::strerror(errno) << std::endl;
+    }
+    use_avx2_ = SIMDOptimizations::is_avx2_supported();
+}
+
+int64_t GCHeap::tlab_tls_offset() {
+    uintptr_t thread_pointer;
+    asm("mov %%fs:0, %0" : "=r"(thread_pointer));
+    return static_cast<int64_t>(reinterpret_cast<uintptr_t>(&gc_tlab) - thread_pointer);
+}
+
+void* GCHeap::init_cell(char* cell, size_t payload_size, uint32_t type_id) {
+    GCObjectHeader* header = gc_cell_header(cell);
+    header->size = static_cast<uint32_t>(payload_size);
+    header->type_id = type_id;
+    return cell + GC_CELL_HEADER_SIZE;
+}
+
+// ============================================================================
+// BITMAPS
+// ============================================================================
+
+static inline bool test_bit(const uint64_t* bits, size_t index) {
+    return bits[index / 64] & (uint64_t(1) << (index % 64));
+}
+
+static void set_bit_range(uint64_t* bits, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        bits[i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+// First index >= from (and < limit) whose bit equals value, or limit
+static size_t find_bit(const uint64_t* bits, size_t from, size_t limit, bool value) {
+    while (from < limit) {
+        uint64_t word = value ? bits[from / 64] : ~bits[from / 64];
+        word &= ~uint64_t(0) << (from % 64);
+        if (word) {
+            return std::min(limit, (from & ~size_t(63)) + __builtin_ctzll(word));
+        }
+        from = (from & ~size_t(63)) + 64;
+    }
+    return limit;
+}
+
+// Both bitmaps share one mapping, kept for the life of the heap. Collections
+// take fresh pages for survivors with the world stopped, so not malloc.
+void GCHeap::map_bitmaps(Page& page) {
+    if (page.alloc_bits) return;
+    void* bits = mmap(nullptr, gc_mmap_length(2 * GC_PAGE_BITMAP_WORDS * sizeof(uint64_t)), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bits == MAP_FAILED) throw std::bad_alloc();
+    page.alloc_bits = static_cast<uint64_t*>(bits);
+    page.mark_bits = page.alloc_bits + GC_PAGE_BITMAP_WORDS;
+}
+
+static size_t scan_dirty_cards_scalar(const uint8_t* card_table, size_t card_count, uint32_t* dirty_indices, size_t max_indices) {
+    size_t found = 0;
+    for (size_t i = 0; i < card_count && found < max_indices; i++) {
+        if (card_table[i]) dirty_indices[found++] = static_cast<uint32_t>(i);
+    }
+    return found;
+}
+
+static size_t sweep_bitmaps_scalar(uint64_t* alloc_bits, const uint64_t* mark_bits, uint64_t* dead_bits, size_t words) {
+    size_t live = 0;
+    for (size_t i = 0; i < words; i++) {
+        dead_bits[i] = alloc_bits[i] & ~mark_bits[i];
+        alloc_bits[i] &= mark_bits[i];
+        live += __builtin_popcountll(alloc_bits[i]);
+    }
+    return live;
+}
+
+void GCHeap::set_alloc_bits(Page& page, size_t first_cell, size_t count) {
+    set_bit_range(page.alloc_bits, first_cell, count);
+    // Allocate black while a collection is running, or the pending sweep
+    // would take the new cells for dead ones
+    if (collecting_ || page.needs_sweep) {
+        set_bit_range(page.mark_bits, first_cell, count);
+    }
+}
+
+// ============================================================================
+// PAGES
+// ============================================================================
+
+size_t GCHeap::take_page() {
+    size_t index;
+    if (!free_pages_.empty()) {
+        index = free_pages_.back();
+        free_pages_.pop_back();
+    } else if (frontier_page_ < paged_page_count_) {
+        index = frontier_page_++;
+    } else {
+        return SIZE_MAX;
+    }
+    Page& page = pages_[index];
+    map_bitmaps(page);
+    committed_pages_.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+bool GCHeap::within_commit_limit(size_t pages) const {
+    size_t limit = commit_limit_.load(std::memory_order_relaxed);
+    return limit == 0 || (committed_pages_.load(std::memory_order_relaxed) + pages) * GC_PAGE_SIZE +
+                                 external_bytes_.load(std::memory_order_relaxed) <= limit;
+}
+
+bool GCHeap::try_reserve_external_bytes(size_t bytes) {
+    size_t limit = commit_limit_.load(std::memory_order_relaxed);
+    size_t external = external_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    if (limit == 0 || committed_bytes() + external <= limit) return true;
+    external_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    return false;
+}
+
+bool GCHeap::reserve_external_bytes(size_t bytes) {
+    if (try_reserve_external_bytes(bytes)) return true;
+    bool (*handler)(size_t, int) = limit_handler_.load(std::memory_order_acquire);
+    for (int attempt = 0; handler && handler(bytes, attempt); attempt++) {
+        if (try_reserve_external_bytes(bytes)) return true;
+    }
+    return false;
+}
+
+size_t GCHeap::take_small_page(size_t size_class, Space space, bool limited) {
+    // Prefer pages a sweep left with free cells, sweeping queued pages of
+    // this class until one has some
+    GCVector<size_t>& available = available_pages_[static_cast<int>(space)][size_class];
+    GCVector<size_t>& unswept = unswept_pages_[static_cast<int>(space)][size_class];
+    while (!available.empty() || !unswept.empty()) {
+        if (available.empty()) {
+            size_t index = unswept.back();
+            unswept.pop_back();
+            if (pages_[index].needs_sweep) {
+                sweep_small_page(index, false);
+            }
+            continue;
+        }
+        size_t index = available.back();
+        available.pop_back();
+        Page& page = pages_[index];
+        if (page.evacuating) {
+            page.available = false;  // end_compaction makes it available again
+            continue;
+        }
+        if (page.available && page.state == PageState::SMALL && page.needs_sweep) {
+            // Made available by free_object before its sweep
+            sweep_small_page(index, false);
+        }
+        if (page.available && page.state == PageState::SMALL && page.size_class == size_class &&
+            page.space == space && !page.owner) {
+            page.available = false;
+            page.scan_cell = 0;
+            return index;
+        }
+    }
+
+    if (limited && !within_commit_limit(1)) return SIZE_MAX;
+    size_t index = take_page();
+    if (index == SIZE_MAX) return SIZE_MAX;
+    Page& page = pages_[index];
+    page.state = PageState::SMALL;
+    page.space = space;
+    page.size_class = static_cast<uint8_t>(size_class);
+    page.cell_size = gc_size_classes.cells[size_class];
+    page.cell_count = static_cast<uint32_t>(GC_PAGE_SIZE / page.cell_size);
+    page.span_pages = 1;
+    page.scan_cell = 0;
+    page.available = false;
+    return index;
+}
+
+char* GCHeap::allocate_large_span(size_t cell_size) {
+    size_t count = (cell_size + GC_PAGE_SIZE - 1) / GC_PAGE_SIZE;
+    if (frontier_page_ + count > paged_page_count_) {
+        return nullptr;
+    }
+    size_t first = frontier_page_;
+    frontier_page_ += count;
+    init_span(first, count);
+    return page_start(first);
+}
+
+void GCHeap::init_span(size_t first, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        Page& page = pages_[first + i];
+        page.state = i == 0 ? PageState::LARGE_HEAD : PageState::LARGE_TAIL;
+        page.space = Space::YOUNG;  // Large objects age in place; the header holds the generation
+        page.span_pages = i == 0 ? static_cast<uint32_t>(count) : static_cast<uint32_t>(i);  // Tails: distance to the head
+        page.cell_size = 0;
+        page.cell_count = 1;
+    }
+    Page& head = pages_[first];
+    map_bitmaps(head);
+    set_alloc_bits(head, 0, 1);
+    committed_pages_.fetch_add(count, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// LARGE OBJECT SPACE
+// ============================================================================
+
+void GCHeap::set_large_object_huge_pages(bool enable) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    large_huge_pages_ = enable;
+}
+
+char* GCHeap::allocate_large_object(size_t cell_size) {
+    size_t count = (cell_size + GC_PAGE_SIZE - 1) / GC_PAGE_SIZE;
+    size_t first = take_large_space(count);
+    if (first == SIZE_MAX) {
+        return nullptr;
+    }
+    if (!map_large_object(first, count)) {
+        return_large_space(first, count);
+        return nullptr;
+    }
+    init_span(first, count);
+    return page_start(first);
+}
+
+// Best fit among the freed spans, else below everything handed out so far
+size_t GCHeap::take_large_space(size_t count) {
+    auto best = large_free_spans_.end();
+    for (auto it = large_free_spans_.begin(); it != large_free_spans_.end(); ++it) {
+        if (it->second >= count && (best == large_free_spans_.end() || it->second < best->second)) {
+            best = it;
+        }
+    }
+    if (best != large_free_spans_.end()) {
+        size_t first = best->first;
+        size_t left = best->second - count;
+        large_free_spans_.erase(best);
+        if (left > 0) {
+            add_free_span(first + count, left);
+        }
+        return first;
+    }
+    if (large_floor_ - paged_page_count_ < count) {
+        return SIZE_MAX;
+    }
+    large_floor_ -= count;
+    return large_floor_;
+}
+
+void GCHeap::return_large_space(size_t first, size_t count) {
+    auto next = free_span_from(first + count);
+    if (next != large_free_spans_.end() && next->first == first + count) {
+        count += next->second;
+        large_free_spans_.erase(next);
+    }
+    auto previous = free_span_from(first);
+    if (previous != large_free_spans_.begin()) {
+        --previous;
+        if (previous->first + previous->second == first) {
+            first = previous->first;
+            count += previous->second;
+            large_free_spans_.erase(previous);
+        }
+    }
+    if (first == large_floor_) {
+        large_floor_ += count;  // Walks stop short of it again
+    } else {
+        add_free_span(first, count);
+    }
+}
+
+// First span starting at or above page. Sweeps free spans with the world
+// stopped, so they are a sorted array rather than a map with malloc'd nodes.
+GCVector<std::pair<size_t, size_t>>::iterator GCHeap::free_span_from(size_t page) {
+    return std::lower_bound(large_free_spans_.begin(), large_free_spans_.end(), page,
+                            [](const std::pair<size_t, size_t>& span, size_t first) { return span.first < first; });
+}
+
+void GCHeap::add_free_span(size_t first, size_t count) {
+    large_free_spans_.insert(free_span_from(first), {first, count});
+}
+
+// The object's own mapping replaces the reservation under it, so it is a
+// separate VMA: huge page advice applies to it alone and mremap can move it
+bool GCHeap::map_large_object(size_t first, size_t count) {
+    size_t length = count * GC_PAGE_SIZE;
+    void* mem = mmap(page_start(first), length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+    if (large_huge_pages_ && length >= GC_HUGE_PAGE_SIZE) {
+        madvise(mem, length, MADV_HUGEPAGE);
+    }
+    return true;
+}
+
+void* GCHeap::grow_large_object(size_t index, size_t payload_size) {
+    size_t count = pages_[index].span_pages;
+    size_t new_count = (gc_cell_size_for(payload_size) + GC_PAGE_SIZE - 1) / GC_PAGE_SIZE;
+    char* payload = page_start(index) + GC_CELL_HEADER_SIZE;
+    size_t old_cell = gc_cell_size_for(header_of(payload)->size);
+
+    if (new_count > count) {
+        auto above = free_span_from(index + count);
+        if (above != large_free_spans_.end() && above->first == index + count && above->second >= new_count - count) {
+            // In place: map the free pages above onto the end of the object
+            size_t left = above->second - (new_count - count);
+            large_free_spans_.erase(above);
+            if (!map_large_object(index + count, new_count - count)) {
+                return_large_space(index + count, new_count - count + left);
+                return nullptr;
+            }
+            if (left > 0) {
+                add_free_span(index + new_count, left);
+            }
+            for (size_t i = count; i < new_count; i++) {
+                Page& page = pages_[index + i];
+                page.state = PageState::LARGE_TAIL;
+                page.space = Space::YOUNG;
+                page.span_pages = static_cast<uint32_t>(i);
+                page.cell_size = 0;
+                page.cell_count = 1;
+            }
+            pages_[index].span_pages = static_cast<uint32_t>(new_count);
+            committed_pages_.fetch_add(new_count - count, std::memory_order_relaxed);
+        } else {
+            size_t first = take_large_space(new_count);
+            if (first == SIZE_MAX) return nullptr;
+            if (!map_large_object(first, new_count)) {
+                return_large_space(first, new_count);
+                return nullptr;
+            }
+            // Move the page tables rather than the bytes; the old range stays
+            // mapped (empty) until release_span replaces it
+            size_t length = count * GC_PAGE_SIZE;
+            if (mremap(page_start(index), length, length, MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP,
+                       page_start(first)) == MAP_FAILED) {
+                std::memcpy(page_start(first), page_start(index), old_cell);
+            }
+            bool marked = test_bit(pages_[index].mark_bits, 0);
+            init_span(first, new_count);
+            if (marked) {
+                set_bit_range(pages_[first].mark_bits, 0, 1);
+            }
+            release_span(index, count);
+            index = first;
+            payload = page_start(first) + GC_CELL_HEADER_SIZE;
+        }
+    }
+
+    header_of(payload)->size = static_cast<uint32_t>(payload_size);
+    retired_bytes_ += gc_cell_size_for(payload_size) - old_cell;
+    if (gc_is_old(header_of(payload))) {
+        // Its references may point at young objects
+        dirty_object_cards(payload);
+    }
+    return payload;
+}
+
+void GCHeap::release_span(size_t first, size_t count) {
+    bool large_space = first >= paged_page_count_;
+    if (large_space) {
+        // A fresh reservation over the object's mapping returns its memory
+        // and drops its huge page advice
+        mmap(page_start(first), count * GC_PAGE_SIZE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    } else {
+        madvise(page_start(first), count * GC_PAGE_SIZE, MADV_DONTNEED);
+    }
+    for (size_t i = 0; i < count; i++) {
+        Page& page = pages_[first + i];
+        page.state = PageState::FREE;
+        page.space = Space::YOUNG;
+        page.available = false;
+        page.needs_sweep = false;
+        page.evacuating = false;
+        page.owner = nullptr;
+        page.span_pages = 0;
+        if (page.alloc_bits) {
+            std::memset(page.alloc_bits, 0, 2 * GC_PAGE_BITMAP_WORDS * sizeof(uint64_t));
+        }
+        if (!large_space) {
+            free_pages_.push_back(first + i);
+        }
+    }
+    committed_pages_.fetch_sub(count, std::memory_order_relaxed);
+    if (large_space) {
+        return_large_space(first, count);
+    }
+}
+
+// ============================================================================
+// ALLOCATION RUNS
+// ============================================================================
+
+void GCHeap::register_tlab(GCThreadLocalBuffer& tlab) {
+    tlab.next_registered = tlabs_;
+    tlabs_ = &tlab;
+    tlab.registered = true;
+}
+
+// Record the cells bumped since the last flush in the alloc bitmap
+void GCHeap::flush_run(GCThreadLocalBuffer& tlab, size_t size_class) {
+    char* cursor = tlab.runs[size_class].cursor.load(std::memory_order_acquire);
+    char* start = tlab.run_start[size_class];
+    if (!cursor || !start || cursor <= start) return;
+
+    size_t index = page_index(start);
+    Page& page = pages_[index];
+    size_t first = (start - page_start(index)) / page.cell_size;
+    set_alloc_bits(page, first, (cursor - start) / page.cell_size);
+    retired_bytes_ += cursor - start;
+    tlab.run_start[size_class] = cursor;
+}
+
+void GCHeap::make_available(size_t index) {
+    Page& page = pages_[index];
+    if (page.available) return;
+    page.scan_cell = 0;
+    page.available = true;
+    available_pages_[static_cast<int>(page.space)][page.size_class].push_back(index);
+}
+
+void GCHeap::disown_page(GCThreadLocalBuffer& tlab, size_t size_class) {
+    if (!tlab.owned_page[size_class]) return;
+    size_t index = tlab.owned_page[size_class] - 1;
+    tlab.owned_page[size_class] = 0;
+    Page& page = pages_[index];
+    page.owner = nullptr;
+    // Whatever is left past the scan point can serve another thread
+    if (page.scan_cell < page.cell_count) {
+        make_available(index);
+    }
+}
+
+bool GCHeap::next_run(GCThreadLocalBuffer& tlab, size_t size_class) {
+    for (;;) {
+        if (tlab.owned_page[size_class]) {
+            size_t index = tlab.owned_page[size_class] - 1;
+            Page& page = pages_[index];
+            if (page.needs_sweep) {
+                sweep_small_page(index, false);
+            }
+            size_t first = find_bit(page.alloc_bits, page.scan_cell, page.cell_count, false);
+            if (first < page.cell_count) {
+                size_t max_cells = std::max<size_t>(1, GC_RUN_SIZE / page.cell_size);
+                size_t end = find_bit(page.alloc_bits, first, std::min<size_t>(page.cell_count, first + max_cells), true);
+                char* run = page_start(index) + first * page.cell_size;
+                tlab.run_start[size_class] = run;
+                tlab.runs[size_class].limit = run + (end - first) * page.cell_size;
+                tlab.runs[size_class].cursor.store(run, std::memory_order_release);
+                page.scan_cell = static_cast<uint32_t>(end);
+                return true;
+            }
+            page.scan_cell = page.cell_count;
+            disown_page(tlab, size_class);
+        }
+
+        // The collector's own buffers may go past the commit limit
+        bool limited = &tlab != &survivor_tlab_ && &tlab != &promotion_tlab_;
+        size_t index = take_small_page(size_class, tlab.old_space ? Space::OLD : Space::YOUNG, limited);
+        if (index == SIZE_MAX) return false;
+        pages_[index].owner = &tlab;
+        tlab.owned_page[size_class] = index + 1;
+    }
+}
+
+void* GCHeap::allocate_slow(GCThreadLocalBuffer& tlab, size_t payload_size, uint32_t type_id) {
+    if (!base_ || payload_size > UINT32_MAX) {
+        return nullptr;
+    }
+    size_t cell_size = gc_cell_size_for(payload_size);
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+    // Large cells get their own span of pages
+    if (cell_size > GC_MAX_SMALL_CELL) {
+        if (!within_commit_limit((cell_size + GC_PAGE_SIZE - 1) / GC_PAGE_SIZE)) return nullptr;
+        char* cell = cell_size > GC_LARGE_OBJECT_THRESHOLD ? allocate_large_object(cell_size)
+                                                           : allocate_large_span(cell_size);
+        if (!cell) return nullptr;
+        retired_bytes_ += cell_size;
+        void* payload = init_cell(cell, payload_size, type_id);
+        header_of(payload)->flags |= GCObjectHeader::LARGE_OBJECT;
+        return payload;
+    }
+
+    GCThreadLocalBuffer* buffer = &tlab;
+    if (&tlab == &gc_tlab && tls_tlab_released) {
+        // Past TLS teardown: share one buffer, only ever bumped under the lock
+        if (!exiting_tlab_) {
+            exiting_tlab_ = new GCThreadLocalBuffer();
+            register_tlab(*exiting_tlab_);
+        }
+        buffer = exiting_tlab_;
+        if (void* payload = gc_tlab_try_allocate(*buffer, payload_size, type_id)) {
+            return payload;
+        }
+    } else if (!tlab.registered) {
+        if (&tlab == &gc_tlab) {
+            attach_current_thread();
+        } else {
+            register_tlab(tlab);
+        }
+    }
+
+    size_t size_class = gc_size_class_for(cell_size);
+    flush_run(*buffer, size_class);
+    if (!next_run(*buffer, size_class)) {
+        return nullptr;
+    }
+    return gc_tlab_try_allocate(*buffer, payload_size, type_id);
+}
+
+void GCHeap::retire_tlab(GCThreadLocalBuffer& tlab) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (size_t size_class = 0; size_class < GC_SIZE_CLASS_COUNT; size_class++) {
+        flush_run(tlab, size_class);
+        GCAllocationRun& run = tlab.runs[size_class];
+        char* cursor = run.cursor.load(std::memory_order_relaxed);
+        if (cursor && tlab.owned_page[size_class]) {
+            // Hand the unused end of the run back to the page
+            size_t index = tlab.owned_page[size_class] - 1;
+            Page& page = pages_[index];
+            page.scan_cell = std::min<uint32_t>(page.scan_cell, (cursor - page_start(index)) / page.cell_size);
+        }
+        run.cursor.store(nullptr, std::memory_order_release);
+        run.limit = nullptr;
+        tlab.run_start[size_class] = nullptr;
+        disown_page(tlab, size_class);
+    }
+
+    if (!tlab.registered) return;
+    for (GCThreadLocalBuffer** link = &tlabs_; *link; link = &(*link)->next_registered) {
+        if (*link == &tlab) {
+            *link = tlab.next_registered;
+            break;
+        }
+    }
+    tlab.next_registered = nullptr;
+    tlab.registered = false;
+    tlab.mutator = false;
+}
+
+void GCHeap::attach_current_thread() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (gc_tlab.registered || tls_tlab_released) return;
+    tls_tlab_holder.attached = true;
+    gc_tlab.mutator = true;
+    gc_tlab.thread = pthread_self();
+    register_tlab(gc_tlab);
+}
+
+void GCHeap::for_each_scope_chain(const std::function<void(void*)>& visit) {
+    for (GCThreadLocalBuffer* tlab = tlabs_; tlab; tlab = tlab->next_registered) {
+        if (tlab->mutator && tlab->scope_chain) {
+            visit(tlab->scope_chain);
+        }
+    }
+    if (!gc_tlab.registered && gc_tlab.scope_chain) {
+        visit(gc_tlab.scope_chain);
+    }
+}
+
+void GCHeap::stop_the_world() {
+    // Held until resume: no thread is parked inside the heap, and the
+    // registry cannot change underneath us
+    mutex_.lock();
+    gc_world_stopped.store(true, std::memory_order_release);
+
+    int signalled = 0;
+    pthread_t self = pthread_self();
+    for (GCThreadLocalBuffer* tlab = tlabs_; tlab; tlab = tlab->next_registered) {
+        if (tlab->mutator && !pthread_equal(tlab->thread, self) &&
+            pthread_kill(tlab->thread, GC_STOP_SIGNAL) == 0) {
+            signalled++;
+        }
+    }
+    while (gc_threads_parked.load(std::memory_order_acquire) < signalled) {
+        sched_yield();
+    }
+}
+
+void GCHeap::resume_the_world() {
+    gc_world_stopped.store(false, std::memory_order_release);
+    // Wait for everyone to leave the handler so the next stop counts afresh
+    while (gc_threads_parked.load(std::memory_order_acquire) > 0) {
+        sched_yield();
+    }
+    mutex_.unlock();
+}
+
+bool GCHeap::world_stopped() {
+    return gc_world_stopped.load(std::memory_order_acquire);
+}
+
+size_t GCHeap::allocated_bytes() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    size_t total = retired_bytes_;
+    for (GCThreadLocalBuffer* tlab = tlabs_; tlab; tlab = tlab->next_registered) {
+        for (size_t size_class = 0; size_class < GC_SIZE_CLASS_COUNT; size_class++) {
+            char* cursor = tlab->runs[size_class].cursor.load(std::memory_order_acquire);
+            char* start = tlab->run_start[size_class];
+            if (cursor && start && cursor > start) {
+                total += cursor - start;
+            }
+        }
+    }
+    return total;
+}
+
+// ============================================================================
+// COLLECTION SUPPORT
+// ============================================================================
+
+void GCHeap::snapshot_objects() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    // Pending sweeps still need the previous collection's mark bits
+    finish_sweeping();
+
+    // Owners keep bumping while we read their cursors; cells past the cursor
+    // we see here are flushed later, marked, and so survive this collection
+    collecting_ = false;
+    flush_allocation_runs();
+
+    for (size_t index = first_used_page(); index < page_count_; index = next_used_page(index)) {
+        Page& page = pages_[index];
+        if (page.state == PageState::SMALL) {
+            std::memset(page.mark_bits, 0, (page.cell_count + 63) / 64 * sizeof(uint64_t));
+        } else if (page.state == PageState::LARGE_HEAD) {
+            page.mark_bits[0] = 0;
+        }
+    }
+    collecting_ = true;
+}
+
+// Allocated, and not a dead cell waiting for its lazy sweep
+bool GCHeap::cell_live(const Page& page, size_t cell) const {
+    return test_bit(page.alloc_bits, cell) && (!page.needs_sweep || test_bit(page.mark_bits, cell));
+}
+
+bool GCHeap::is_object_start(const void* payload) const {
+    if (!contains(payload)) return false;
+    size_t index = page_index(payload);
+    const Page& page = pages_[index];
+    size_t offset = static_cast<const char*>(payload) - page_start(index);
+    if (page.state == PageState::SMALL) {
+        size_t cell = offset / page.cell_size;
+        return offset % page.cell_size == GC_CELL_HEADER_SIZE && cell < page.cell_count &&
+               cell_live(page, cell);
+    }
+    if (page.state == PageState::LARGE_HEAD) {
+        return offset == GC_CELL_HEADER_SIZE && test_bit(page.alloc_bits, 0);
+    }
+    return false;
+}
+
+void* GCHeap::find_object(const void* ptr) const {
+    if (!contains(ptr)) return nullptr;
+    size_t index = page_index(ptr);
+    const Page* page = &pages_[index];
+    if (page->state == PageState::SMALL) {
+        size_t cell = (static_cast<const char*>(ptr) - page_start(index)) / page->cell_size;
+        if (cell >= page->cell_count || !cell_live(*page, cell)) return nullptr;
+        return page_start(index) + cell * page->cell_size + GC_CELL_HEADER_SIZE;
+    }
+    if (page->state == PageState::LARGE_TAIL) {
+        index -= page->span_pages;
+        page = &pages_[index];
+    }
+    if (page->state == PageState::LARGE_HEAD && test_bit(page->alloc_bits, 0)) {
+        char* payload = page_start(index) + GC_CELL_HEADER_SIZE;
+        if (static_cast<const char*>(ptr) < payload + header_of(payload)->size) {
+            return payload;
+        }
+    }
+    return nullptr;
+}
+
+bool GCHeap::mark(const void* payload) {
+    size_t index = page_index(payload);
+    Page& page = pages_[index];
+    size_t cell = page.state == PageState::SMALL
+        ? (static_cast<const char*>(payload) - page_start(index)) / page.cell_size : 0;
+    uint64_t bit = uint64_t(1) << (cell % 64);
+    uint64_t previous = __atomic_fetch_or(&page.mark_bits[cell / 64], bit, __ATOMIC_RELAXED);
+    return !(previous & bit);
+}
+
+bool GCHeap::is_marked(const void* payload) const {
+    size_t index = page_index(payload);
+    const Page& page = pages_[index];
+    size_t cell = page.state == PageState::SMALL
+        ? (static_cast<const char*>(payload) - page_start(index)) / page.cell_size : 0;
+    return test_bit(page.mark_bits, cell);
+}
+
+void GCHeap::flush_allocation_runs() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (GCThreadLocalBuffer* tlab = tlabs_; tlab; tlab = tlab->next_registered) {
+        for (size_t size_class = 0; size_class < GC_SIZE_CLASS_COUNT; size_class++) {
+            flush_run(*tlab, size_class);
+        }
+    }
+}
+
+void GCHeap::for_each_object(const std::function<void(char* payload, GCObjectHeader* header)>& visit) {
+    walk_objects(visit, false);
+}
+
+void GCHeap::for_each_young_object(const std::function<void(char* payload, GCObjectHeader* header)>& visit) {
+    walk_objects(visit, true);
+}
+
+void GCHeap::walk_objects(const std::function<void(char* payload, GCObjectHeader* header)>& visit, bool young_only) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (size_t index = first_used_page(); index < page_count_; index = next_used_page(index)) {
+        Page& page = pages_[index];
+        if (page.state != PageState::SMALL && page.state != PageState::LARGE_HEAD) continue;
+        if (young_only && page.space == Space::OLD) continue;
+        char* start = page_start(index);
+        size_t words = (page.cell_count + 63) / 64;
+        for (size_t word = 0; word < words; word++) {
+            // Copy: the visitor may free objects and clear their bits
+            uint64_t bits = page.alloc_bits[word];
+            if (page.needs_sweep) bits &= page.mark_bits[word];
+            while (bits) {
+                size_t cell = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                char* payload = start + cell * page.cell_size + GC_CELL_HEADER_SIZE;
+                if (young_only && gc_is_old(header_of(payload))) continue;
+                visit(payload, header_of(payload));
+            }
+            if (page.state == PageState::FREE) break;  // Released by the visitor
+        }
+    }
+}
+
+GCHeap::SweepResult GCHeap::sweep() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SweepResult result;
+
+    for (size_t index = first_used_page(); index < page_count_; index = next_used_page(index)) {
+        Page& page = pages_[index];
+        if (page.state == PageState::LARGE_HEAD) {
+            if (test_bit(page.alloc_bits, 0) && !test_bit(page.mark_bits, 0)) {
+                size_t cell_size = gc_cell_size_for(header_of(page_start(index) + GC_CELL_HEADER_SIZE)->size);
+                result.freed_objects++;
+                result.freed_bytes += cell_size;
+                result.released_bytes += page.span_pages * GC_PAGE_SIZE;
+                freed_bytes_.fetch_add(cell_size, std::memory_order_relaxed);
+                release_span(index, page.span_pages);
+            }
+            continue;
+        }
+        if (page.state != PageState::SMALL) continue;
+
+        // Count the dead cells now and free them when the page is swept
+        size_t dead = 0;
+        for (size_t word = 0; word < (page.cell_count + 63) / 64; word++) {
+            dead += __builtin_popcountll(page.alloc_bits[word] & ~page.mark_bits[word]);
+        }
+        if (dead == 0) continue;
+        result.freed_objects += dead;
+        result.freed_bytes += dead * page.cell_size;
+        page.needs_sweep = true;
+        unswept_pages_[static_cast<int>(page.space)][page.size_class].push_back(index);
+    }
+
+    collecting_ = false;
+    return result;
+}
+
+GCHeap::SweepResult GCHeap::sweep_young() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    SweepResult result;
+
+    for (size_t index = first_used_page(); index < page_count_; index = next_used_page(index)) {
+        Page& page = pages_[index];
+        if (page.space == Space::OLD) continue;
+
+        if (page.state == PageState::LARGE_HEAD) {
+            GCObjectHeader* header = header_of(page_start(index) + GC_CELL_HEADER_SIZE);
+            if (test_bit(page.alloc_bits, 0) && !test_bit(page.mark_bits, 0) && !gc_is_old(header)) {
+                size_t cell_size = gc_cell_size_for(header->size);
+                result.freed_objects++;
+                result.freed_bytes += cell_size;
+                result.released_bytes += page.span_pages * GC_PAGE_SIZE;
+                freed_bytes_.fetch_add(cell_size, std::memory_order_relaxed);
+                release_span(index, page.span_pages);
+            }
+        } else if (page.state == PageState::SMALL) {
+            SweepResult swept = sweep_small_page(index, true);
+            result.freed_objects += swept.freed_objects;
+            result.freed_bytes += swept.freed_bytes;
+            result.released_bytes += swept.released_bytes;
+        }
+    }
+
+    collecting_ = false;
+    return result;
+}
+
+bool GCHeap::sweep_next_page() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (auto& space : unswept_pages_) {
+        for (GCVector<size_t>& unswept : space) {
+            while (!unswept.empty()) {
+                size_t index = unswept.back();
+                unswept.pop_back();
+                // Entries go stale when an allocator got to the page first
+                if (pages_[index].needs_sweep) {
+                    sweep_small_page(index, false);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void GCHeap::finish_sweeping() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    while (sweep_next_page()) {}
+}
+
+GCHeap::SweepResult GCHeap::sweep_small_page(size_t index, bool young_only) {
+    Page& page = pages_[index];
+    SweepResult result;
+    uint64_t dead_bits[GC_PAGE_BITMAP_WORDS];
+    page.needs_sweep = false;
+
+    // dead = alloc & ~mark; alloc &= mark
+    size_t words = (page.cell_count + 63) / 64;
+    size_t live = use_avx2_
+        ? SIMDOptimizations::sweep_bitmaps_avx2(page.alloc_bits, page.mark_bits, dead_bits, words)
+        : sweep_bitmaps_scalar(page.alloc_bits, page.mark_bits, dead_bits, words);
+
+    // Keep free cells zero so allocation never has to clear them
+    char* start = page_start(index);
+    for (size_t word = 0; word < words; word++) {
+        uint64_t bits = dead_bits[word];
+        while (bits) {
+            size_t cell = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            // Old objects promoted in place are not traced by minor collections
+            if (young_only && gc_is_old(gc_cell_header(start + cell * page.cell_size))) {
+                page.alloc_bits[word] |= uint64_t(1) << (cell % 64);
+                live++;
+                continue;
+            }
+            std::memset(start + cell * page.cell_size, 0, page.cell_size);
+            result.freed_objects++;
+            result.freed_bytes += page.cell_size;
+        }
+    }
+
+    if (page.owner) {
+        page.scan_cell = 0;  // The owner picks up the freed cells
+    } else if (live == 0) {
+        result.released_bytes += GC_PAGE_SIZE;
+        release_span(index, 1);
+    } else if (live < page.cell_count) {
+        make_available(index);
+    }
+    freed_bytes_.fetch_add(result.freed_bytes, std::memory_order_relaxed);
+    return result;
+}
+
+void GCHeap::free_object(void* payload) {
+    if (!contains(payload)) return;
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+    size_t index = page_index(payload);
+    Page& page = pages_[index];
+    // The object may still sit in its owner's unflushed run
+    if (page.state == PageState::SMALL && page.owner) {
+        flush_run(*page.owner, page.size_class);
+    }
+    if (!is_object_start(payload)) return;
+
+    if (page.state == PageState::LARGE_HEAD) {
+        freed_bytes_.fetch_add(gc_cell_size_for(header_of(payload)->size), std::memory_order_relaxed);
+        release_span(index, page.span_pages);
+        return;
+    }
+
+    size_t cell = (static_cast<char*>(payload) - page_start(index)) / page.cell_size;
+    page.alloc_bits[cell / 64] &= ~(uint64_t(1) << (cell % 64));
+    std::memset(page_start(index) + cell * page.cell_size, 0, page.cell_size);
+    freed_bytes_.fetch_add(page.cell_size, std::memory_order_relaxed);
+    if (page.owner) {
+        page.scan_cell = std::min<uint32_t>(page.scan_cell, static_cast<uint32_t>(cell));
+    } else {
+        make_available(index);
+    }
+}
+
+void* GCHeap::grow_object(void* payload, size_t payload_size) {
+    if (!contains(payload) || payload_size > UINT32_MAX) return nullptr;
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    size_t index = page_index(payload);
+    Page& page = pages_[index];
+    GCObjectHeader* header = header_of(payload);
+    if (payload_size <= header->size) return payload;
+
+    // Room left in the cell or span: only the size changes
+    size_t capacity = page.state == PageState::SMALL ? page.cell_size : size_t(page.span_pages) * GC_PAGE_SIZE;
+    size_t cell_size = gc_cell_size_for(payload_size);
+    if (cell_size <= capacity) {
+        if (page.state == PageState::LARGE_HEAD) {
+            retired_bytes_ += cell_size - gc_cell_size_for(header->size);
+        }
+        header->size = static_cast<uint32_t>(payload_size);
+        return payload;
+    }
+    if (index >= paged_page_count_) {
+        size_t added = (cell_size + GC_PAGE_SIZE - 1) / GC_PAGE_SIZE - page.span_pages;
+        if (!within_commit_limit(added)) return nullptr;
+        return grow_large_object(index, payload_size);
+    }
+
+    void* copy = gc_tlab_try_allocate(gc_tlab, payload_size, header->type_id);
+    if (!copy) {
+        copy = allocate_slow(gc_tlab, payload_size, header->type_id);
+        if (!copy) return nullptr;
+    }
+    GCObjectHeader* moved = header_of(copy);
+    moved->flags |= header->flags & (GCObjectHeader::ESCAPED | GCObjectHeader::PINNED);
+    std::memcpy(copy, payload, header->size);
+    free_object(payload);
+    return copy;
+}
+
+// ============================================================================
+// GENERATIONS
+// ============================================================================
+
+void GCHeap::dirty_object_cards(void* payload) {
+    char* first = static_cast<char*>(payload);
+    char* last = first + std::max<uint32_t>(header_of(payload)->size, 1) - 1;
+    for (char* card = first; ; card += GC_CARD_SIZE) {
+        dirty_card(std::min(card, last));
+        if (card >= last) break;
+    }
+}
+
+size_t GCHeap::scan_dirty_cards(const CardVisitor& visit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!card_table_) return 0;
+
+    const size_t chunk = 4096;
+    uint32_t dirty[chunk];
+    // The paged space up to the frontier and the large object space above its floor
+    const size_t ranges[2][2] = {{0, frontier_page_}, {large_floor_, page_count_}};
+    size_t scanned = 0;
+    for (const auto& range : ranges) {
+        size_t from = (range[0] * GC_PAGE_SIZE) >> GC_CARD_SHIFT;
+        size_t card_end = (range[1] * GC_PAGE_SIZE) >> GC_CARD_SHIFT;
+        while (from < card_end) {
+            size_t count = std::min(card_end - from, size_t(1) << 20);
+            size_t found = use_avx2_
+                ? SIMDOptimizations::scan_dirty_cards_avx2(card_table_ + from, count, dirty, chunk)
+                : scan_dirty_cards_scalar(card_table_ + from, count, dirty, chunk);
+
+            for (size_t i = 0; i < found; i++) {
+                size_t card = from + dirty[i];
+                card_table_[card] = 0;
+                scanned++;
+                char* begin = reinterpret_cast<char*>(base_ + (card << GC_CARD_SHIFT));
+                char* end = begin + GC_CARD_SIZE;
+                size_t index = page_index(begin);
+                Page* page = &pages_[index];
+                bool young_refs = false;
+
+                if (page->state == PageState::SMALL) {
+                    char* start = page_start(index);
+                    size_t first = (begin - start) / page->cell_size;
+                    size_t last = std::min<size_t>((end - 1 - start) / page->cell_size, page->cell_count - 1);
+                    for (size_t cell = first; cell <= last && first < page->cell_count; cell++) {
+                        if (!test_bit(page->alloc_bits, cell)) continue;
+                        char* payload = start + cell * page->cell_size + GC_CELL_HEADER_SIZE;
+                        GCObjectHeader* header = header_of(payload);
+                        char* object_begin = std::max(begin, payload);
+                        char* object_end = std::min(end, payload + header->size);
+                        if (gc_is_old(header) && object_begin < object_end) {
+                            young_refs |= visit(payload, object_begin, object_end);
+                        }
+                    }
+                } else if (page->state == PageState::LARGE_HEAD || page->state == PageState::LARGE_TAIL) {
+                    if (page->state == PageState::LARGE_TAIL) {
+                        index -= page->span_pages;
+                        page = &pages_[index];
+                    }
+                    char* payload = page_start(index) + GC_CELL_HEADER_SIZE;
+                    if (test_bit(page->alloc_bits, 0) && gc_is_old(header_of(payload))) {
+                        char* object_begin = std::max(begin, payload);
+                        char* object_end = std::min(end, payload + header_of(payload)->size);
+                        if (object_begin < object_end) {
+                            young_refs = visit(payload, object_begin, object_end);
+                        }
+                    }
+                }
+
+                if (young_refs) {
+                    card_table_[card] = 1;
+                }
+            }
+            // A full index buffer means the range was not finished
+            from += found == chunk ? dirty[chunk - 1] + 1 : count;
+        }
+    }
+    return scanned;
+}
+
+void* GCHeap::evacuate(void* payload, bool promote) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    GCObjectHeader* header = header_of(payload);
+    GCThreadLocalBuffer& buffer = promote ? promotion_tlab_ : survivor_tlab_;
+
+    void* copy = gc_tlab_try_allocate(buffer, header->size, header->type_id);
+    if (!copy) {
+        copy = allocate_slow(buffer, header->size, header->type_id);
+        if (!copy) return nullptr;
+    }
+    // Fold the copy into the alloc bitmap right away so it is a valid object
+    // (and, while collecting, marked) before the collection ends
+    flush_run(buffer, gc_size_class_for(gc_cell_size_for(header->size)));
+
+    GCObjectHeader* moved = header_of(copy);
+    moved->flags = header->flags & ~GCObjectHeader::CONSERVATIVE_REF;
+    moved->generation = promote ? GC_PROMOTION_AGE : header->generation + 1;
+    std::memcpy(copy, payload, header->size);
+    if (promote) {
+        // Its slots may still refer to young objects
+        dirty_object_cards(copy);
+    }
+    free_object(payload);
+    return copy;
+}
+
+// ============================================================================
+// COMPACTION
+// ============================================================================
+
+GCHeap::Fragmentation GCHeap::fragmentation() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Fragmentation result;
+    for (size_t index = 0; index < frontier_page_; index++) {
+        const Page& page = pages_[index];
+        if (page.state != PageState::SMALL || page.owner) continue;
+        size_t used = 0;
+        for (size_t word = 0; word < (page.cell_count + 63) / 64; word++) {
+            used += __builtin_popcountll(page.alloc_bits[word]);
+        }
+        if (used == 0) continue;
+        result.small_bytes += size_t(page.cell_count) * page.cell_size;
+        result.free_bytes += (page.cell_count - used) * page.cell_size;
+    }
+    return result;
+}
+
+GCHeap::Occupancy GCHeap::occupancy() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    Occupancy result;
+    for (size_t index = first_used_page(); index < page_count_; index = next_used_page(index)) {
+        const Page& page = pages_[index];
+        if (page.state == PageState::LARGE_HEAD) {
+            if (!cell_live(page, 0)) continue;
+            const GCObjectHeader* header = header_of(page_start(index) + GC_CELL_HEADER_SIZE);
+            size_t space = gc_is_old(header) ? 1 : 0;
+            result.bytes[space] += gc_cell_size_for(header->size);
+            result.pages[space] += page.span_pages;
+            continue;
+        }
+        if (page.state != PageState::SMALL) continue;
+        size_t used = 0;
+        for (size_t word = 0; word < (page.cell_count + 63) / 64; word++) {
+            uint64_t bits = page.alloc_bits[word];
+            if (page.needs_sweep) bits &= page.mark_bits[word];
+            used += __builtin_popcountll(bits);
+        }
+        size_t space = static_cast<size_t>(page.space);
+        result.bytes[space] += used * page.cell_size;
+        result.pages[space]++;
+    }
+    return result;
+}
+
+void GCHeap::reserve_compaction(size_t max_pages) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    compaction_candidates_.reserve(max_pages);
+    evacuation_pages_.reserve(max_pages);
+}
+
+size_t GCHeap::begin_compaction(double max_occupancy, size_t max_pages) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    // Keep the sparsest max_pages candidates in place, without growing the buffers
+    max_pages = std::min({max_pages, compaction_candidates_.capacity(), evacuation_pages_.capacity()});
+    compaction_candidates_.clear();
+    if (max_pages == 0) return 0;
+    for (size_t index = 0; index < frontier_page_; index++) {
+        const Page& page = pages_[index];
+        if (page.state != PageState::SMALL || page.owner) continue;
+        size_t used = 0;
+        for (size_t word = 0; word < (page.cell_count + 63) / 64; word++) {
+            used += __builtin_popcountll(page.alloc_bits[word]);
+        }
+        double occupancy = static_cast<double>(used) / page.cell_count;
+        if (used == 0 || occupancy > max_occupancy) continue;
+        std::pair<double, size_t> candidate{occupancy, index};
+        if (compaction_candidates_.size() == max_pages) {
+            if (!(candidate < compaction_candidates_.back())) continue;
+            compaction_candidates_.pop_back();
+        }
+        compaction_candidates_.insert(std::upper_bound(compaction_candidates_.begin(), compaction_candidates_.end(), candidate),
+                                      candidate);
+    }
+
+    evacuation_pages_.clear();
+    for (const auto& candidate : compaction_candidates_) {
+        pages_[candidate.second].evacuating = true;
+        evacuation_pages_.push_back(candidate.second);
+    }
+    return evacuation_pages_.size();
+}
+
+void GCHeap::for_each_evacuating_object(const std::function<void(char* payload, GCObjectHeader* header)>& visit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (size_t index : evacuation_pages_) {
+        Page& page = pages_[index];
+        char* start = page_start(index);
+        for (size_t word = 0; word < (page.cell_count + 63) / 64; word++) {
+            uint64_t bits = page.alloc_bits[word];
+            while (bits) {
+                size_t cell = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                char* payload = start + cell * page.cell_size + GC_CELL_HEADER_SIZE;
+                visit(payload, header_of(payload));
+            }
+        }
+    }
+}
+
+void* GCHeap::relocate(void* payload) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    GCObjectHeader* header = header_of(payload);
+    bool old = pages_[page_index(payload)].space == Space::OLD;
+    GCThreadLocalBuffer& buffer = old ? promotion_tlab_ : survivor_tlab_;
+
+    void* copy = gc_tlab_try_allocate(buffer, header->size, header->type_id);
+    if (!copy) {
+        copy = allocate_slow(buffer, header->size, header->type_id);
+        if (!copy) return nullptr;
+    }
+    flush_run(buffer, gc_size_class_for(gc_cell_size_for(header->size)));
+
+    GCObjectHeader* moved = header_of(copy);
+    moved->flags = header->flags & ~GCObjectHeader::CONSERVATIVE_REF;
+    moved->generation = header->generation;
+    std::memcpy(copy, payload, header->size);
+    if (old) {
+        dirty_object_cards(copy);
+    }
+
+    *static_cast<void**>(payload) = copy;
+    header->flags |= GCObjectHeader::FORWARDED;
+    return copy;
+}
+
+void* GCHeap::forwarding_address(const void* ptr) const {
+    if (!is_evacuating(ptr) || !is_object_start(ptr)) return nullptr;
+    GCObjectHeader* header = header_of(const_cast<void*>(ptr));
+    if (!(header->flags & GCObjectHeader::FORWARDED)) return nullptr;
+    return *static_cast<void* const*>(ptr);
+}
+
+void GCHeap::end_compaction() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    for (size_t index : evacuation_pages_) {
+        Page& page = pages_[index];
+        page.evacuating = false;
+        char* start = page_start(index);
+        size_t used = 0;
+        for (size_t word = 0; word < (page.cell_count + 63) / 64; word++) {
+            uint64_t bits = page.alloc_bits[word];
+            while (bits) {
+                size_t cell = word * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                char* cell_start = start + cell * page.cell_size;
+                if (!(gc_cell_header(cell_start)->flags & GCObjectHeader::FORWARDED)) {
+                    used++;
+                    continue;
+                }
+                page.alloc_bits[word] &= ~(uint64_t(1) << (cell % 64));
+                std::memset(cell_start, 0, page.cell_size);
+                freed_bytes_.fetch_add(page.cell_size, std::memory_order_relaxed);
+            }
+        }
+        if (page.owner) continue;
+        if (used == 0) {
+            release_span(index, 1);
+        } else if (used < page.cell_count) {
+            make_available(index);
+        }
+    }
+    evacuation_pages_.clear();
+}
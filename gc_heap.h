@@ -0,0 +1,479 @@
+#pragma once
+
+#include "gc_mmap_allocator.h"
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// GC OBJECT HEADER - Minimal overhead tracking
+// ============================================================================
+
+struct GCObjectHeader {
+    enum Flags : uint8_t {
+        MARKED = 0x01,
+        ESCAPED = 0x02,
+        PINNED = 0x04,
+        LARGE_OBJECT = 0x08,
+        CONSERVATIVE_REF = 0x10,  // Reached through an imprecise slot in the current moving collection
+        FORWARDED = 0x20          // Moved by compaction; the payload's first word is the new address
+    };
+
+    uint32_t size;          // Object size in bytes
+    uint32_t type_id;       // Runtime type information
+    uint8_t flags;          // GC flags
+    uint8_t generation;     // Minor collections survived; GC_PROMOTION_AGE and up is old
+    uint16_t padding;       // Padding for alignment
+
+    void mark() { flags |= MARKED; }
+    void unmark() { flags &= ~MARKED; }
+    bool is_marked() const { return flags & MARKED; }
+
+    void set_escaped() { flags |= ESCAPED; }
+    bool has_escaped() const { return flags & ESCAPED; }
+
+    void pin() { flags |= PINNED; }
+    void unpin() { flags &= ~PINNED; }
+    bool is_pinned() const { return flags & PINNED; }
+};
+
+// ============================================================================
+// GC HEAP - Size-class pages with side bitmaps and thread-local allocation
+// ============================================================================
+//
+// The heap is one reserved address range divided into GC_PAGE_SIZE pages.
+// Each small page holds cells of a single size class, laid out back to back:
+//
+//   cell:  [4 bytes unused][GCObjectHeader (12)][payload, 16-byte aligned]
+//
+// so both the header and the cell of any address in a page follow from
+// page_base + (offset / cell_size) * cell_size. Which cells hold objects and
+// which are marked lives in two per-page side bitmaps (one bit per cell);
+// sweeping is an AND of the two. Cells too big for the largest class get a
+// span of whole pages. Free cells are always zero.
+//
+// Every thread owns an allocation run per size class: a range of contiguous
+// free cells in a page the thread owns. Allocation bumps the run cursor by
+// the class cell size - no lock, no atomic RMW. The heap lock is only taken
+// to find the next run. The runs live in static TLS at a fixed offset from
+// the thread pointer, so JIT code bumps them inline (see
+// X86CodeGenV2::emit_gc_alloc_inline).
+//
+// Program values do not live here yet. Class instances are reference
+// counted (object_refcount.h), and strings, arrays and closures are
+// malloc'd or pooled. All of them are held in runtime structures that the
+// collector cannot trace, so moving them in would let a collection free
+// live values. The code generator emits no GC allocations. Only the heap
+// limits reach program values, through the external byte count.
+//
+// Generations: pages belong to the young or the old space. Threads allocate
+// in young pages only. A minor collection traces young objects from the roots
+// and from dirty cards, then copies each survivor into a fresh young page -
+// or, once it reaches GC_PROMOTION_AGE, into an old page. Survivors reached
+// through an imprecise (conservatively scanned) slot cannot be moved; they age
+// and are promoted in place. Stores of references into heap objects go
+// through the write barrier, which dirties the slot's GC_CARD_SIZE card in a
+// byte-per-card table covering the whole reservation.
+//
+// Sweeping is lazy. A full sweep frees large objects, but only queues small
+// pages with dead cells. A queued page is swept on demand when an allocator
+// needs a page of its size class or its owner runs out of cells. The
+// collector's sweeper thread sweeps the rest in the background. Until a
+// page is swept, its unmarked cells count as dead, and cells allocated into
+// it are marked so the pending sweep keeps them. The next snapshot sweeps
+// whatever is still queued.
+//
+// Cells above GC_LARGE_OBJECT_THRESHOLD live in the large object space, a
+// second part of the reservation above the paged space. Each one gets a
+// page-aligned mapping of its own (huge pages on request), is never copied by
+// compaction or minor collections, and on death the mapping is replaced by a
+// fresh reservation, which gives its memory back. Growing one remaps it: in
+// place when the pages above are free, otherwise the page tables move to a
+// bigger span (mremap), so the bytes are not copied. The card table and
+// page metadata cover both parts, so barriers and lookups are the same.
+//
+// A commit limit caps the pages allocation may commit: past it, allocate_slow
+// returns nullptr instead of taking another page, and the caller decides
+// whether to collect or fail. Pages the collector takes for survivors and
+// promotion are exempt, so a collection started at the limit can finish.
+// Program values the runtime still mallocs (class instances, string buffers)
+// are counted as external bytes against the same limit.
+//
+// Compaction evacuates sparse pages during a full collection. The collector
+// chooses the pages before marking (begin_compaction). Marking pins every
+// object on them that is reached through an imprecise slot. relocate()
+// copies a live object off its page and leaves a forwarding pointer in the
+// original. The collector rewrites the precise slots, then
+// end_compaction() frees the originals.
+
+static constexpr size_t GC_PAGE_SIZE = 256 * 1024;
+static constexpr size_t GC_RUN_SIZE = 32 * 1024;          // Longest run handed out at once
+static constexpr size_t GC_CELL_ALIGNMENT = 16;
+static constexpr size_t GC_CELL_HEADER_SIZE = 16;
+static constexpr size_t GC_HEAP_RESERVATION = size_t(4) << 30;       // Paged space
+static constexpr size_t GC_LARGE_SPACE_RESERVATION = size_t(4) << 30;
+static constexpr size_t GC_LARGE_OBJECT_THRESHOLD = 1024 * 1024;  // Bigger cells get their own mapping
+static constexpr size_t GC_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+static constexpr size_t GC_SIZE_CLASS_COUNT = 44;
+static constexpr size_t GC_MAX_SMALL_CELL = 32 * 1024;    // Bigger cells get their own pages
+static constexpr size_t GC_PAGE_BITMAP_WORDS = GC_PAGE_SIZE / GC_CELL_ALIGNMENT / 64;
+static constexpr size_t GC_CARD_SHIFT = 9;
+static constexpr size_t GC_CARD_SIZE = size_t(1) << GC_CARD_SHIFT;
+static constexpr uint8_t GC_PROMOTION_AGE = 2;            // Minor collections survived before promotion
+static constexpr size_t GC_COMPACTION_MIN_FREE_BYTES = 4 * GC_PAGE_SIZE;  // Less is not worth a compaction
+static constexpr double GC_COMPACTION_MAX_OCCUPANCY = 0.5;  // Fullest page worth evacuating
+static constexpr size_t GC_COMPACTION_MAX_PAGES = 64;      // Evacuated per collection
+
+inline bool gc_is_old(const GCObjectHeader* header) {
+    return header->generation >= GC_PROMOTION_AGE;
+}
+
+inline size_t gc_cell_size_for(size_t payload_size) {
+    return GC_CELL_HEADER_SIZE + ((payload_size + GC_CELL_ALIGNMENT - 1) & ~(GC_CELL_ALIGNMENT - 1));
+}
+
+inline GCObjectHeader* gc_cell_header(char* cell) {
+    return reinterpret_cast<GCObjectHeader*>(cell + GC_CELL_HEADER_SIZE - sizeof(GCObjectHeader));
+}
+
+// Cell sizes: 16-byte steps up to 256, then four classes per power of two
+struct GCSizeClasses {
+    uint32_t cells[GC_SIZE_CLASS_COUNT] = {
+        16, 32, 48, 64, 80, 96, 112, 128, 144, 160, 176, 192, 208, 224, 240, 256,
+        320, 384, 448, 512, 640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+        2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192,
+        10240, 12288, 14336, 16384, 20480, 24576, 28672, 32768
+    };
+    uint8_t by_granule[GC_MAX_SMALL_CELL / GC_CELL_ALIGNMENT + 1] = {};
+
+    constexpr GCSizeClasses() {
+        size_t size_class = 0;
+        for (size_t granule = 0; granule <= GC_MAX_SMALL_CELL / GC_CELL_ALIGNMENT; granule++) {
+            while (cells[size_class] < granule * GC_CELL_ALIGNMENT) size_class++;
+            by_granule[granule] = static_cast<uint8_t>(size_class);
+        }
+    }
+};
+
+inline constexpr GCSizeClasses gc_size_classes{};
+
+// Only valid for cell sizes up to GC_MAX_SMALL_CELL
+inline size_t gc_size_class_for(size_t cell_size) {
+    return gc_size_classes.by_granule[cell_size / GC_CELL_ALIGNMENT];
+}
+
+// Layout is read by JIT code: the run of class c is at offset 16 * c,
+// cursor first and limit second
+struct GCAllocationRun {
+    std::atomic<char*> cursor;
+    char* limit;
+};
+
+struct GCThreadLocalBuffer {
+    GCAllocationRun runs[GC_SIZE_CLASS_COUNT];
+    char* run_start[GC_SIZE_CLASS_COUNT];      // Cells before the cursor not yet in the alloc bitmap start here
+    size_t owned_page[GC_SIZE_CLASS_COUNT];    // Page index + 1, 0 when none
+    GCThreadLocalBuffer* next_registered;
+    bool registered;
+    bool old_space;                            // Takes old pages: only the collector's promotion buffer
+    bool mutator;                              // A thread's own buffer: stop_the_world() stops the thread
+    pthread_t thread;
+    void* scope_chain;                         // Innermost live JIT scope (gc_stack_maps.h), read by JIT code
+};
+
+static_assert(sizeof(GCAllocationRun) == 16, "JIT code indexes runs by 16 * size class");
+static_assert(offsetof(GCThreadLocalBuffer, runs) == 0, "JIT code reads the runs at the buffer start");
+
+class GCHeap {
+public:
+    enum class Space : uint8_t { YOUNG = 0, OLD = 1 };
+
+    enum class PageState : uint8_t {
+        FREE,
+        SMALL,        // Cells of one size class
+        LARGE_HEAD,   // First page of a multi-page cell
+        LARGE_TAIL
+    };
+
+    // Free space stranded in partly used small pages
+    struct Fragmentation {
+        size_t small_bytes = 0;   // Cells in unowned small pages holding objects
+        size_t free_bytes = 0;    // Free cells among them
+    };
+
+    // Live cell bytes and the pages holding them, per generation. Cells that
+    // threads allocated since the last snapshot are not counted until the
+    // next one; large objects count towards their header's generation.
+    struct Occupancy {
+        size_t bytes[2] = {};   // Indexed by Space
+        size_t pages[2] = {};
+    };
+
+    struct SweepResult {
+        size_t freed_objects = 0;
+        size_t freed_bytes = 0;
+        size_t released_bytes = 0;   // Pages returned to the kernel
+    };
+
+    // Visit (object, begin, end) for the part of an old object inside a dirty
+    // card; return true if the range still refers to young objects
+    using CardVisitor = std::function<bool(char* payload, char* begin, char* end)>;
+
+    static GCHeap& instance();
+
+    bool contains(const void* ptr) const {
+        uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+        return address >= base_ && address < base_ + reserved_;
+    }
+
+    // Allocation slow path: moves the run to the next free cells or places
+    // big cells directly. The fast path is gc_tlab_try_allocate below and its
+    // JIT twin. Returns the zeroed payload, or nullptr when the reservation is full.
+    void* allocate_slow(GCThreadLocalBuffer& tlab, size_t payload_size, uint32_t type_id);
+
+    // Give up a buffer's runs and pages and drop it from the registry
+    void retire_tlab(GCThreadLocalBuffer& tlab);
+
+    // Register the calling thread's buffer before it allocates, for threads
+    // that hold references in JIT scopes and must be stopped for collection
+    void attach_current_thread();
+
+    // Innermost JIT scope of every registered thread, and of the caller.
+    // Only while the world is stopped.
+    void for_each_scope_chain(const std::function<void(void*)>& visit);
+
+    // Start a collection: clears the mark bitmaps and folds the cells that
+    // running threads allocated so far into the alloc bitmaps. Cells allocated
+    // afterwards are invisible to the collection and survive its sweep.
+    void snapshot_objects();
+    // Fold every thread's allocation runs into the alloc bitmaps so walks see
+    // all objects allocated so far; the world should be stopped
+    void flush_allocation_runs();
+    bool is_object_start(const void* payload) const;
+    // Payload of the object whose cell contains ptr, or nullptr
+    void* find_object(const void* ptr) const;
+
+    // Side mark bitmap; mark() returns true if the object was not yet marked
+    bool mark(const void* payload);
+    bool is_marked(const void* payload) const;
+
+    // Visit the objects of the last snapshot, in address order
+    void for_each_object(const std::function<void(char* payload, GCObjectHeader* header)>& visit);
+    // Same, restricted to young objects
+    void for_each_young_object(const std::function<void(char* payload, GCObjectHeader* header)>& visit);
+
+    // Free every unmarked object of the snapshot; empty pages go back to the
+    // kernel. Small pages are only queued; the result counts their dead cells
+    // and released_bytes only covers large objects.
+    SweepResult sweep();
+    // Sweep one queued page; false once none is left
+    bool sweep_next_page();
+    void finish_sweeping();
+    // Minor collection sweep: only unmarked young objects are freed
+    SweepResult sweep_young();
+
+    Fragmentation fragmentation() const;
+    Occupancy occupancy() const;
+
+    // Compaction. begin_compaction picks up to max_pages unowned pages at most
+    // max_occupancy full (sparsest first) and returns how many it picked.
+    // Allocation avoids them until end_compaction.
+    // It runs with the world stopped, and a parked thread may hold the malloc
+    // lock, so it only fills the buffers reserve_compaction() set aside before
+    // the stop and never picks more pages than they hold.
+    void reserve_compaction(size_t max_pages);
+    size_t begin_compaction(double max_occupancy, size_t max_pages);
+    bool is_evacuating(const void* ptr) const {
+        return contains(ptr) && pages_[page_index(ptr)].evacuating;
+    }
+    // Visit the objects on the pages being evacuated
+    void for_each_evacuating_object(const std::function<void(char* payload, GCObjectHeader* header)>& visit);
+    // Copy an object off its evacuating page, forwarding the original to the
+    // copy; returns the copy, or nullptr if out of space
+    void* relocate(void* payload);
+    // New address of a relocated object, or nullptr if ptr was not moved
+    void* forwarding_address(const void* ptr) const;
+    // Free the relocated originals; pages left empty go back to the kernel
+    void end_compaction();
+
+    // Card table. dirty_card is the write barrier; JIT code inlines the same
+    // range check and store (X86CodeGenV2::emit_gc_write_barrier)
+    void dirty_card(const void* slot) {
+        uintptr_t offset = reinterpret_cast<uintptr_t>(slot) - base_;
+        if (offset < reserved_) {
+            card_table_[offset >> GC_CARD_SHIFT] = 1;
+        }
+    }
+    void dirty_object_cards(void* payload);
+    // Clean every dirty card, visiting the old objects it covers; cards whose
+    // visit returns true are dirtied again
+    size_t scan_dirty_cards(const CardVisitor& visit);
+    uint8_t* card_table() const { return card_table_; }
+    uintptr_t base() const { return base_; }
+    size_t reserved_bytes() const { return reserved_; }
+
+    // Copy a young object into the young (or, promoting, the old) space and
+    // free the original; returns the new payload, or nullptr if out of space
+    void* evacuate(void* payload, bool promote);
+    // Free one object explicitly
+    void free_object(void* payload);
+    // Resize an object to at least payload_size bytes, keeping its contents.
+    // Large space objects are remapped, everything else copied like realloc;
+    // returns the payload's (possibly new) address, or nullptr when out of
+    // space. The caller must own every reference to the object.
+    void* grow_object(void* payload, size_t payload_size);
+    bool in_large_space(const void* ptr) const {
+        return contains(ptr) && page_index(ptr) >= paged_page_count_;
+    }
+    // Ask for transparent huge pages on large space mappings of 2MB and up
+    void set_large_object_huge_pages(bool enable);
+
+    static GCObjectHeader* header_of(void* payload) {
+        return reinterpret_cast<GCObjectHeader*>(static_cast<char*>(payload) - sizeof(GCObjectHeader));
+    }
+
+    // Bytes of cells handed out (headers included) and given back since startup
+    size_t allocated_bytes() const;
+    size_t freed_bytes() const { return freed_bytes_.load(std::memory_order_relaxed); }
+    size_t committed_bytes() const { return committed_pages_.load(std::memory_order_relaxed) * GC_PAGE_SIZE; }
+    // Most bytes allocation may commit, 0 for no limit
+    void set_commit_limit(size_t bytes) { commit_limit_.store(bytes, std::memory_order_relaxed); }
+    size_t commit_limit() const { return commit_limit_.load(std::memory_order_relaxed); }
+    
+    // Bytes malloc'd outside the heap for program values, which count against
+    // the commit limit with the committed pages. reserve fails at the limit,
+    // after asking the limit handler for room; add never fails.
+    bool reserve_external_bytes(size_t bytes);
+    void add_external_bytes(size_t bytes) { external_bytes_.fetch_add(bytes, std::memory_order_relaxed); }
+    void release_external_bytes(size_t bytes) { external_bytes_.fetch_sub(bytes, std::memory_order_relaxed); }
+    size_t external_bytes() const { return external_bytes_.load(std::memory_order_relaxed); }
+    // Called at the limit with attempt 0, 1, ... until it returns false; the
+    // reservation is retried after each attempt that made room
+    void set_limit_handler(bool (*handler)(size_t bytes, int attempt)) {
+        limit_handler_.store(handler, std::memory_order_release);
+    }
+    size_t page_count() const { return page_count_; }
+
+    // Offset of every thread's buffer from its thread pointer (%fs:0)
+    static int64_t tlab_tls_offset();
+
+    // Park every other thread that allocates from the heap in a signal
+    // handler and hold the heap lock until resume_the_world(). Parked threads
+    // may hold any lock they had (stdio included), so the caller must only
+    // take locks it acquired before stopping.
+    void stop_the_world();
+    void resume_the_world();
+    static bool world_stopped();
+
+private:
+    struct Page {
+        PageState state = PageState::FREE;
+        Space space = Space::YOUNG;
+        bool available = false;            // On its class's available list
+        bool needs_sweep = false;          // Queued by sweep(); mark bits still tell the dead cells
+        bool evacuating = false;           // Chosen by begin_compaction
+        uint8_t size_class = 0;
+        uint32_t cell_size = 0;
+        uint32_t cell_count = 0;
+        uint32_t span_pages = 0;           // LARGE_HEAD: pages in the span
+        uint32_t scan_cell = 0;            // Where the owner looks for its next run
+        GCThreadLocalBuffer* owner = nullptr;
+        uint64_t* alloc_bits = nullptr;    // GC_PAGE_BITMAP_WORDS each, mapped on first use
+        uint64_t* mark_bits = nullptr;
+    };
+
+    uintptr_t base_ = 0;
+    size_t reserved_ = 0;
+    size_t page_count_ = 0;
+    std::vector<Page> pages_;
+
+    mutable std::recursive_mutex mutex_;
+    // Collections push to these with the world stopped: see gc_mmap_allocator.h
+    GCVector<size_t> free_pages_;
+    GCVector<size_t> available_pages_[2][GC_SIZE_CLASS_COUNT];  // Unowned pages with free cells, per space
+    GCVector<size_t> unswept_pages_[2][GC_SIZE_CLASS_COUNT];    // Pages waiting for a lazy sweep
+    GCVector<size_t> evacuation_pages_;
+    GCVector<std::pair<double, size_t>> compaction_candidates_;  // Occupancy, page; sparsest first
+    size_t frontier_page_ = 0;               // Pages from here on were never handed out
+    size_t paged_page_count_ = 0;            // The large object space starts here
+    size_t large_floor_ = 0;                 // It grows down from the top; lowest page handed out
+    GCVector<std::pair<size_t, size_t>> large_free_spans_;  // First page, page count; sorted and coalesced
+    bool large_huge_pages_ = false;
+    GCThreadLocalBuffer* tlabs_ = nullptr;   // Registered buffers
+    GCThreadLocalBuffer* exiting_tlab_ = nullptr;  // Shared by threads past their TLS teardown
+    GCThreadLocalBuffer survivor_tlab_{};    // Evacuation targets of minor collections
+    GCThreadLocalBuffer promotion_tlab_{};
+    uint8_t* card_table_ = nullptr;
+    bool use_avx2_ = false;
+    bool collecting_ = false;                // Between snapshot_objects() and sweep()
+
+    std::atomic<size_t> committed_pages_{0};
+    std::atomic<size_t> commit_limit_{0};
+    std::atomic<size_t> external_bytes_{0};
+    std::atomic<bool (*)(size_t, int)> limit_handler_{nullptr};
+    size_t retired_bytes_ = 0;               // Bytes folded into alloc bitmaps and direct cells
+    std::atomic<size_t> freed_bytes_{0};
+
+    GCHeap();
+    size_t page_index(const void* ptr) const { return (reinterpret_cast<uintptr_t>(ptr) - base_) / GC_PAGE_SIZE; }
+    char* page_start(size_t index) const { return reinterpret_cast<char*>(base_ + index * GC_PAGE_SIZE); }
+
+    size_t take_page();
+    size_t take_small_page(size_t size_class, Space space, bool limited);
+    bool within_commit_limit(size_t pages) const;
+    bool try_reserve_external_bytes(size_t bytes);
+    void make_available(size_t index);
+    void walk_objects(const std::function<void(char* payload, GCObjectHeader* header)>& visit, bool young_only);
+    bool cell_live(const Page& page, size_t cell) const;
+    SweepResult sweep_small_page(size_t index, bool young_only);
+    char* allocate_large_span(size_t cell_size);
+    char* allocate_large_object(size_t cell_size);
+    void* grow_large_object(size_t index, size_t payload_size);
+    void init_span(size_t first, size_t count);
+    size_t take_large_space(size_t count);
+    void return_large_space(size_t first, size_t count);
+    bool map_large_object(size_t first, size_t count);
+    void release_span(size_t first, size_t count);
+    GCVector<std::pair<size_t, size_t>>::iterator free_span_from(size_t page);
+    void add_free_span(size_t first, size_t count);
+    // Pages ever handed out: the paged space from page 0 up, then the large space
+    size_t first_used_page() const { return frontier_page_ > 0 ? 0 : large_floor_; }
+    size_t next_used_page(size_t index) const { return ++index == frontier_page_ ? std::max(index, large_floor_) : index; }
+    bool next_run(GCThreadLocalBuffer& tlab, size_t size_class);
+    void flush_run(GCThreadLocalBuffer& tlab, size_t size_class);
+    void disown_page(GCThreadLocalBuffer& tlab, size_t size_class);
+    void register_tlab(GCThreadLocalBuffer& tlab);
+    void set_alloc_bits(Page& page, size_t first_cell, size_t count);
+    void map_bitmaps(Page& page);
+    static void* init_cell(char* cell, size_t payload_size, uint32_t type_id);
+};
+
+// The calling thread's allocation buffer
+GCThreadLocalBuffer& gc_current_tlab();
+
+// Bump allocation of a zeroed payload; nullptr when the run must be refilled
+inline char* gc_tlab_try_allocate(GCThreadLocalBuffer& tlab, size_t payload_size, uint32_t type_id) {
+    size_t cell_size = gc_cell_size_for(payload_size);
+    if (cell_size > GC_MAX_SMALL_CELL) {
+        return nullptr;
+    }
+    size_t size_class = gc_size_class_for(cell_size);
+    GCAllocationRun& run = tlab.runs[size_class];
+    char* cell = run.cursor.load(std::memory_order_relaxed);
+    size_t stride = gc_size_classes.cells[size_class];
+    if (!cell || stride > static_cast<size_t>(run.limit - cell)) {
+        return nullptr;
+    }
+    GCObjectHeader* header = gc_cell_header(cell);
+    header->size = static_cast<uint32_t>(payload_size);
+    header->type_id = type_id;
+    // Publishing the cursor makes the header visible to the collector
+    run.cursor.store(cell + stride, std::memory_order_release);
+    return cell + GC_CELL_HEADER_SIZE;
+}
@@ -0,0 +1,424 @@
+#include "gc_heap_profiler.h"
+#include "gc_system.h"
+#include "jit_symbols.h"
+#include "runtime.h"
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+std::atomic<uint8_t> gc_allocation_sampling_active{0};
+
+// Frames further apart than this are not trusted
+static constexpr uintptr_t MAX_FRAME_DISTANCE = 1 << 20;
+
+// ============================================================================
+// TYPE NAMES
+// ============================================================================
+
+std::string gc_type_name(uint32_t type_id) {
+    switch (type_id) {
+        case 0: return "(unknown)";
+        case 1: return "String";
+        case 2: return "Array";
+        case 3: return "TypedArray";
+        case 4: return "Object";
+    }
+    if (type_id >= 1000) {
+        if (ClassMetadata* metadata = GarbageCollector::instance().find_class_metadata_by_type_id(type_id)) {
+            return metadata->class_name;
+        }
+        return "(class " + std::to_string(type_id) + ")";
+    }
+    return "(builtin " + std::to_string(type_id) + ")";
+}
+
+// ============================================================================
+// HEAP SNAPSHOT
+// ============================================================================
+
+// An edge as recorded in the pause: names are copied once the world resumes
+struct GCSnapshotEdge {
+    size_t to;
+    const std::string* name;
+    uint32_t offset;
+};
+
+GCHeapSnapshot GCHeapSnapshot::capture() {
+    GCHeapSnapshot snapshot;
+    GarbageCollector& gc = GarbageCollector::instance();
+    GCHeap& heap = GCHeap::instance();
+
+    // Copied before the world stops: a parked thread may hold the registry lock
+    std::unordered_map<uint32_t, ClassMetadata*> classes = gc.registered_classes();
+
+    // A parked thread may also hold the malloc lock, so the walk fills mmap'd
+    // buffers and looks objects up by address in the sorted node array
+    GCVector<Node> nodes;
+    GCVector<GCSnapshotEdge> edges;
+    GCVector<size_t> roots;
+    gc.inspect_heap([&](const GCVector<void**>& root_slots) {
+        heap.for_each_object([&nodes](char* payload, GCObjectHeader* header) {
+            nodes.push_back({reinterpret_cast<uintptr_t>(payload), header->type_id,
+                             static_cast<uint32_t>(gc_cell_size_for(header->size)), 0, 0});
+        });
+        std::sort(nodes.begin(), nodes.end(), [](const Node& a, const Node& b) { return a.address < b.address; });
+
+        auto node_at = [&](void* candidate, size_t& out) {
+            uintptr_t address = reinterpret_cast<uintptr_t>(candidate);
+            auto it = std::lower_bound(nodes.begin(), nodes.end(), address,
+                                       [](const Node& node, uintptr_t value) { return node.address < value; });
+            if (it == nodes.end() || it->address != address) return false;
+            out = static_cast<size_t>(it - nodes.begin());
+            return true;
+        };
+
+        for (void** slot : root_slots) {
+            size_t target;
+            if (*slot && node_at(*slot, target)) {
+                roots.push_back(target);
+            }
+        }
+
+        for (Node& node : nodes) {
+            node.first_edge = edges.size();
+            char* payload = reinterpret_cast<char*>(node.address);
+            size_t payload_size = GCHeap::header_of(payload)->size;
+            auto add_edge = [&](uint32_t offset, const std::string* name) {
+                size_t target;
+                if (offset + sizeof(void*) <= payload_size &&
+                    node_at(*reinterpret_cast<void**>(payload + offset), target)) {
+                    edges.push_back({target, name, offset});
+                }
+            };
+
+            auto known = classes.find(node.type_id);
+            if (known != classes.end()) {
+                for (const PropertyDescriptor& property : known->second->properties) {
+                    if (property.type == PropertyType::OBJECT_PTR || property.type == PropertyType::STRING ||
+                        property.type == PropertyType::DYNAMIC) {
+                        add_edge(property.offset, &property.name);
+                    }
+                }
+            } else {
+                for (uint32_t offset = 0; offset + sizeof(void*) <= payload_size; offset += sizeof(void*)) {
+                    add_edge(offset, nullptr);
+                }
+            }
+            node.edge_count = edges.size() - node.first_edge;
+        }
+    });
+
+    snapshot.nodes.assign(nodes.begin(), nodes.end());
+    snapshot.roots.assign(roots.begin(), roots.end());
+    snapshot.edges.reserve(edges.size());
+    for (const GCSnapshotEdge& edge : edges) {
+        snapshot.edges.push_back({edge.to, edge.name ? *edge.name : std::string(), edge.offset});
+    }
+    return snapshot;
+}
+
+std::vector<GCHeapSnapshot::TypeSummary> GCHeapSnapshot::summarize() const {
+    std::map<uint32_t, TypeSummary> by_type;
+    std::unordered_map<uint32_t, std::string> names;
+    auto name_of = [&names](uint32_t type_id) -> const std::string& {
+        auto it = names.find(type_id);
+        if (it == names.end()) it = names.emplace(type_id, gc_type_name(type_id)).first;
+        return it->second;
+    };
+
+    for (const Node& node : nodes) {
+        TypeSummary& summary = by_type[node.type_id];
+        summary.type_id = node.type_id;
+        summary.name = name_of(node.type_id);
+        summary.count++;
+        summary.bytes += node.size;
+        for (size_t edge = node.first_edge; edge < node.first_edge + node.edge_count; edge++) {
+            by_type[nodes[edges[edge].to].type_id].retainers[summary.name]++;
+        }
+    }
+    for (size_t root : roots) {
+        by_type[nodes[root].type_id].root_references++;
+    }
+
+    std::vector<TypeSummary> result;
+    for (auto& entry : by_type) {
+        result.push_back(std::move(entry.second));
+    }
+    std::sort(result.begin(), result.end(), [](const TypeSummary& a, const TypeSummary& b) {
+        return a.bytes != b.bytes ? a.bytes > b.bytes : a.type_id < b.type_id;
+    });
+    return result;
+}
+
+static void write_json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+std::string GCHeapSnapshot::summary_json() const {
+    std::ostringstream out;
+    out << "[";
+    bool first = true;
+    for (const TypeSummary& summary : summarize()) {
+        out << (first ? "" : ",") << "{\"type\":";
+        first = false;
+        write_json_string(out, summary.name);
+        out << ",\"type_id\":" << summary.type_id << ",\"count\":" << summary.count
+            << ",\"bytes\":" << summary.bytes << ",\"roots\":" << summary.root_references << ",\"retainers\":{";
+        bool first_retainer = true;
+        for (const auto& retainer : summary.retainers) {
+            out << (first_retainer ? "" : ",");
+            first_retainer = false;
+            write_json_string(out, retainer.first);
+            out << ":" << retainer.second;
+        }
+        out << "}}";
+    }
+    out << "]";
+    return out.str();
+}
+
+bool GCHeapSnapshot::write_v8(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    // Node 0 is the synthetic root; object nodes follow in walk order
+    constexpr int NODE_FIELD_COUNT = 7;
+    constexpr int TYPE_ARRAY = 1, TYPE_STRING = 2, TYPE_OBJECT = 3, TYPE_SYNTHETIC = 9;
+    constexpr int EDGE_ELEMENT = 1, EDGE_PROPERTY = 2;
+
+    std::vector<std::string> strings = {"", "(GC roots)"};
+    std::unordered_map<std::string, size_t> string_index = {{"", 0}, {"(GC roots)", 1}};
+    auto intern = [&](const std::string& text) {
+        auto it = string_index.find(text);
+        if (it != string_index.end()) return it->second;
+        string_index.emplace(text, strings.size());
+        strings.push_back(text);
+        return strings.size() - 1;
+    };
+    std::unordered_map<uint32_t, size_t> type_strings;
+
+    out << "{\"snapshot\":{\"meta\":{"
+        << "\"node_fields\":[\"type\",\"name\",\"id\",\"self_size\",\"edge_count\",\"trace_node_id\",\"detachedness\"],"
+        << "\"node_types\":[[\"hidden\",\"array\",\"string\",\"object\",\"code\",\"closure\",\"regexp\",\"number\","
+        << "\"native\",\"synthetic\",\"concatenated string\",\"sliced string\",\"symbol\",\"bigint\",\"object shape\"],"
+        << "\"string\",\"number\",\"number\",\"number\",\"number\",\"number\"],"
+        << "\"edge_fields\":[\"type\",\"name_or_index\",\"to_node\"],"
+        << "\"edge_types\":[[\"context\",\"element\",\"property\",\"internal\",\"hidden\",\"shortcut\",\"weak\"],"
+        << "\"string_or_number\",\"node\"],"
+        << "\"trace_function_info_fields\":[\"function_id\",\"name\",\"script_name\",\"script_id\",\"line\",\"column\"],"
+        << "\"trace_node_fields\":[\"id\",\"function_info_index\",\"count\",\"size\",\"children\"],"
+        << "\"sample_fields\":[\"timestamp_us\",\"last_assigned_id\"],"
+        << "\"location_fields\":[\"object_index\",\"script_id\",\"line\",\"column\"]},"
+        << "\"node_count\":" << nodes.size() + 1 << ",\"edge_count\":" << edges.size() + roots.size()
+        << ",\"trace_function_count\":0},\n";
+
+    // Ids are odd, as V8 gives them to heap objects
+    out << "\"nodes\":[" << TYPE_SYNTHETIC << ",1,1,0," << roots.size() << ",0,0";
+    for (size_t index = 0; index < nodes.size(); index++) {
+        const Node& node = nodes[index];
+        auto name = type_strings.find(node.type_id);
+        if (name == type_strings.end()) {
+            name = type_strings.emplace(node.type_id, intern(gc_type_name(node.type_id))).first;
+        }
+        int type = node.type_id == 1 ? TYPE_STRING : node.type_id == 2 || node.type_id == 3 ? TYPE_ARRAY : TYPE_OBJECT;
+        out << ",\n" << type << "," << name->second << "," << 2 * index + 3 << "," << node.size << ","
+            << node.edge_count << ",0,0";
+    }
+
+    out << "],\n\"edges\":[";
+    bool first = true;
+    for (size_t index = 0; index < roots.size(); index++) {
+        out << (first ? "" : ",\n") << EDGE_ELEMENT << "," << index << "," << (roots[index] + 1) * NODE_FIELD_COUNT;
+        first = false;
+    }
+    for (const Edge& edge : edges) {
+        out << (first ? "" : ",\n");
+        first = false;
+        if (edge.name.empty()) {
+            out << EDGE_ELEMENT << "," << edge.offset / sizeof(void*);
+        } else {
+            out << EDGE_PROPERTY << "," << intern(edge.name);
+        }
+        out << "," << (edge.to + 1) * NODE_FIELD_COUNT;
+    }
+
+    out << "],\n\"trace_function_infos\":[],\"trace_tree\":[],\"samples\":[],\"locations\":[],\n\"strings\":[";
+    for (size_t index = 0; index < strings.size(); index++) {
+        out << (index ? ",\n" : "");
+        write_json_string(out, strings[index]);
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
+
+// ============================================================================
+// ALLOCATION SAMPLER
+// ============================================================================
+
+// Fault-free read of our own address space: frame chains through code
+// without frame pointers end in garbage
+static bool read_word(uintptr_t address, uintptr_t& out) {
+    struct iovec local = {&out, sizeof(out)};
+    struct iovec remote = {reinterpret_cast<void*>(address), sizeof(out)};
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == static_cast<ssize_t>(sizeof(out));
+}
+
+GCAllocationSampler& GCAllocationSampler::instance() {
+    // Leaked: allocations on other threads may still be sampled during exit
+    static GCAllocationSampler* sampler = new GCAllocationSampler();
+    return *sampler;
+}
+
+bool GCAllocationSampler::start(size_t interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_running()) return false;
+    sites_.clear();
+    samples_ = 0;
+    interval_.store(std::max<size_t>(interval, 1), std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_relaxed);
+    gc_allocation_sampling_active.store(1, std::memory_order_release);
+    return true;
+}
+
+__attribute__((noinline)) void GCAllocationSampler::on_allocation(size_t size, uint32_t type_id) {
+    thread_local size_t countdown = 0;
+    thread_local uint64_t seen_generation = 0;
+    uint64_t generation = generation_.load(std::memory_order_relaxed);
+    if (seen_generation != generation) {
+        seen_generation = generation;
+        countdown = interval_.load(std::memory_order_relaxed);
+    }
+    if (--countdown > 0) return;
+    countdown = interval_.load(std::memory_order_relaxed);
+
+    // Our frame returns into gc_alloc, whose frame returns into its caller
+    std::vector<uintptr_t> stack;
+    uintptr_t frame = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    for (size_t depth = 0; depth < MAX_STACK_DEPTH + 1; depth++) {
+        uintptr_t next = 0, pc = 0;
+        if (!read_word(frame, next) || !read_word(frame + sizeof(uintptr_t), pc) || pc == 0) break;
+        if (depth > 0) stack.push_back(pc);
+        if (next <= frame || next - frame > MAX_FRAME_DISTANCE || (next & (sizeof(uintptr_t) - 1))) break;
+        frame = next;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_running()) return;
+    Site& site = sites_[{std::move(stack), type_id}];
+    site.samples++;
+    site.bytes += gc_cell_size_for(size);
+    samples_++;
+}
+
+size_t GCAllocationSampler::stop(const std::string& output_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_running()) return 0;
+    gc_allocation_sampling_active.store(0, std::memory_order_release);
+
+    size_t interval = interval_.load(std::memory_order_relaxed);
+    std::unordered_map<uintptr_t, std::string> names;
+    std::map<std::string, size_t> folded;
+    for (const auto& entry : sites_) {
+        const std::vector<uintptr_t>& stack = entry.first.first;
+        std::string line;
+        for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+            // Return addresses point past the call
+            uintptr_t pc = *it - 1;
+            auto name = names.find(pc);
+            if (name == names.end()) {
+                name = names.emplace(pc, symbolize_code_address(pc)).first;
+            }
+            line += name->second;
+            line += ';';
+        }
+        line += gc_type_name(entry.first.second);
+        folded[line] += entry.second.bytes * interval;
+    }
+
+    last_stacks_.clear();
+    for (const auto& entry : folded) {
+        last_stacks_.push_back(entry.first + " " + std::to_string(entry.second));
+    }
+    if (!output_path.empty()) {
+        std::ofstream out(output_path);
+        for (const std::string& line : last_stacks_) {
+            out << line << '\n';
+        }
+    }
+    sites_.clear();
+    return samples_;
+}
+
+std::vector<std::string> GCAllocationSampler::collapsed_stacks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_stacks_;
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+int64_t __runtime_gc_writeHeapSnapshot() {
+    GCHeapSnapshot snapshot = GCHeapSnapshot::capture();
+    std::string path = "ultrascript-" + std::to_string(getpid()) + ".heapsnapshot";
+    return snapshot.write_v8(path) ? static_cast<int64_t>(snapshot.nodes.size()) : -1;
+}
+
+void* __runtime_gc_heapSummary() {
+    return __string_create(GCHeapSnapshot::capture().summary_json().c_str());
+}
+
+bool __runtime_gc_startAllocationSampling() {
+    size_t interval = GCAllocationSampler::DEFAULT_INTERVAL;
+    if (const char* value = std::getenv("ULTRASCRIPT_ALLOC_SAMPLE_INTERVAL")) {
+        interval = std::max(1, std::atoi(value));
+    }
+    return GCAllocationSampler::instance().start(interval);
+}
+
+int64_t __runtime_gc_stopAllocationSampling() {
+    GCAllocationSampler& sampler = GCAllocationSampler::instance();
+    std::string path = sampler.output_path();
+    if (path.empty()) {
+        path = "ultrascript-" + std::to_string(getpid()) + ".alloc.collapsed";
+    }
+    return static_cast<int64_t>(sampler.stop(path));
+}
+
+void __heap_profiler_start_from_environment() {
+    const char* path = std::getenv("ULTRASCRIPT_ALLOC_PROFILE");
+    if (!path || !path[0]) return;
+
+    GCAllocationSampler::instance().set_output_path(path);
+    __runtime_gc_startAllocationSampling();
+}
+
+void __heap_profiler_finish() {
+    if (GCAllocationSampler::instance().is_running()) {
+        __runtime_gc_stopAllocationSampling();
+    }
+    const char* path = std::getenv("ULTRASCRIPT_HEAP_SNAPSHOT");
+    if (path && path[0]) {
+        GCHeapSnapshot::capture().write_v8(path);
+    }
+}
+
+}
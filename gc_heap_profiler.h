@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// HEAP PROFILER - Heap snapshots and allocation-site sampling
+// ============================================================================
+//
+// A heap snapshot stops the world, walks every object in the GC heap and
+// records the references between them. Class instances with registered
+// ClassMetadata get named property edges; any other object is scanned word
+// by word, like the collector scans it. The file uses the V8 .heapsnapshot
+// format, so Chrome DevTools (Memory tab) and other V8 heap tools can load it
+// and show per-class counts, sizes and retainers. Type summaries group the
+// same data by type for quick checks.
+//
+// The allocation sampler records the call stack of every Nth gc_alloc on
+// each thread, walking frame pointers (JIT code keeps them). Stacks are named
+// through the JIT symbol table and written as collapsed stacks weighted by
+// estimated bytes ("root;caller;allocator;Type bytes"), for flamegraph.pl or
+// speedscope. Objects allocated by the JIT's inline fast path do not go
+// through gc_alloc and are only seen when the thread's buffer is refilled.
+//
+//   ULTRASCRIPT_HEAP_SNAPSHOT=<file>         snapshot written at exit
+//   ULTRASCRIPT_ALLOC_PROFILE=<file>         sample the whole run, written at exit
+//   ULTRASCRIPT_ALLOC_SAMPLE_INTERVAL=<n>    sample every nth allocation (default 512)
+//   runtime.gc.writeHeapSnapshot() / runtime.gc.heapSummary()
+//   runtime.gc.startAllocationSampling() / runtime.gc.stopAllocationSampling()
+
+struct GCHeapSnapshot {
+    struct Node {
+        uintptr_t address;
+        uint32_t type_id;
+        uint32_t size;             // Cell bytes, header included
+        size_t first_edge;         // Edges of a node are contiguous
+        size_t edge_count;
+    };
+
+    struct Edge {
+        size_t to;                 // Node index
+        std::string name;          // Property name, empty for a word offset
+        uint32_t offset;           // Byte offset of the reference in the object
+    };
+
+    struct TypeSummary {
+        uint32_t type_id = 0;
+        std::string name;
+        size_t count = 0;
+        size_t bytes = 0;
+        std::map<std::string, size_t> retainers;   // References from objects of each type
+        size_t root_references = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::vector<size_t> roots;     // Node indices referenced by root slots
+
+    // Stops the world for the walk; must not be called while it is stopped
+    static GCHeapSnapshot capture();
+
+    // Largest types first
+    std::vector<TypeSummary> summarize() const;
+    std::string summary_json() const;
+    bool write_v8(const std::string& path) const;
+};
+
+// Class name for a type_id: registered ClassMetadata, builtin names, or a placeholder
+std::string gc_type_name(uint32_t type_id);
+
+// Set while the allocation sampler runs; gc_alloc tests it before calling in
+extern std::atomic<uint8_t> gc_allocation_sampling_active;
+
+class GCAllocationSampler {
+public:
+    static constexpr size_t MAX_STACK_DEPTH = 32;
+    static constexpr size_t DEFAULT_INTERVAL = 512;
+
+    static GCAllocationSampler& instance();
+
+    bool start(size_t interval = DEFAULT_INTERVAL);
+    // Stops sampling and writes collapsed stacks to output_path (if
+    // non-empty). Returns the number of samples recorded.
+    size_t stop(const std::string& output_path);
+    bool is_running() const { return gc_allocation_sampling_active.load(std::memory_order_relaxed) != 0; }
+
+    void set_output_path(const std::string& path) { output_path_ = path; }
+    const std::string& output_path() const { return output_path_; }
+
+    // Collapsed stack lines of the last run
+    std::vector<std::string> collapsed_stacks() const;
+
+    // Called by gc_alloc for every allocation while running
+    void on_allocation(size_t size, uint32_t type_id);
+
+private:
+    struct Site {
+        size_t samples = 0;
+        size_t bytes = 0;          // Sampled bytes; estimates multiply by the interval
+    };
+
+    mutable std::mutex mutex_;
+    std::atomic<size_t> interval_{DEFAULT_INTERVAL};
+    std::atomic<uint64_t> generation_{0};   // Bumped by start() so threads reset their countdown
+    std::map<std::pair<std::vector<uintptr_t>, uint32_t>, Site> sites_;   // (stack leaf first, type_id)
+    size_t samples_ = 0;
+    std::string output_path_;
+    std::vector<std::string> last_stacks_;
+
+    GCAllocationSampler() = default;
+};
+
+extern "C" {
+    // runtime.gc.* entry points
+    int64_t __runtime_gc_writeHeapSnapshot();
+    void* __runtime_gc_heapSummary();
+    bool __runtime_gc_startAllocationSampling();
+    int64_t __runtime_gc_stopAllocationSampling();
+
+    // Environment-driven snapshot and sampling; called by runtime init/cleanup
+    void __heap_profiler_start_from_environment();
+    void __heap_profiler_finish();
+}
@@ -0,0 +1,185 @@
+#include "gc_marker.h"
+#include <algorithm>
+
+// The stack of the worker running on this thread, if it is marking
+static thread_local GCMarkStack* tls_mark_stack = nullptr;
+
+// ============================================================================
+// MARK STACK
+// ============================================================================
+
+void GCMarkStack::push(void* obj) {
+    lock();
+    items_.push_back(obj);
+    size_.store(items_.size(), std::memory_order_relaxed);
+    unlock();
+}
+
+bool GCMarkStack::pop(void*& obj) {
+    if (!maybe_nonempty()) return false;
+    lock();
+    bool found = !items_.empty();
+    if (found) {
+        obj = items_.back();
+        items_.pop_back();
+        size_.store(items_.size(), std::memory_order_relaxed);
+    }
+    unlock();
+    return found;
+}
+
+size_t GCMarkStack::steal_half(GCVector<void*>& out) {
+    if (!maybe_nonempty()) return 0;
+    lock();
+    // Oldest entries first: they tend to lead to the largest untouched subgraphs
+    size_t count = (items_.size() + 1) / 2;
+    out.insert(out.end(), items_.begin(), items_.begin() + count);
+    items_.erase(items_.begin(), items_.begin() + count);
+    size_.store(items_.size(), std::memory_order_relaxed);
+    unlock();
+    return count;
+}
+
+// ============================================================================
+// PARALLEL MARKER
+// ============================================================================
+
+GCParallelMarker::GCParallelMarker(std::function<void(void*)> scan)
+    : scan_(std::move(scan)) {
+    size_t cores = std::thread::hardware_concurrency();
+    thread_count_ = std::max<size_t>(1, std::min<size_t>(cores ? cores : 1, 8));
+    // The collecting thread's worker; marking works with no helpers at all
+    workers_.push_back(std::make_unique<Worker>());
+    workers_[0]->stack.reserve_page();
+}
+
+GCParallelMarker::~GCParallelMarker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutting_down_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& helper : helpers_) {
+        if (helper.joinable()) helper.join();
+    }
+}
+
+void GCParallelMarker::set_thread_count(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_count_ = std::max<size_t>(1, count);
+}
+
+bool GCParallelMarker::push(void* obj) {
+    if (!tls_mark_stack) return false;
+    tls_mark_stack->push(obj);
+    return true;
+}
+
+void GCParallelMarker::start_helpers() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (workers_.size() < thread_count_) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->stack.reserve_page();
+    }
+    // Helpers are started once and never retired; a smaller thread count
+    // just leaves the extra ones asleep
+    while (helpers_.size() + 1 < thread_count_) {
+        size_t index = helpers_.size() + 1;
+        helpers_.emplace_back(&GCParallelMarker::helper_loop, this, index);
+    }
+}
+
+void GCParallelMarker::mark(const std::function<void()>& seed) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    participants_ = std::min(thread_count_, helpers_.size() + 1);
+    for (size_t i = 0; i < participants_; i++) {
+        workers_[i]->scanned = 0;
+        workers_[i]->steals = 0;
+    }
+
+    tls_mark_stack = &workers_[0]->stack;
+    seed();
+
+    active_workers_.store(participants_, std::memory_order_release);
+    helpers_running_ = participants_ - 1;
+    epoch_++;
+    lock.unlock();
+    start_cv_.notify_all();
+
+    work(0);
+
+    lock.lock();
+    done_cv_.wait(lock, [this] { return helpers_running_ == 0; });
+    tls_mark_stack = nullptr;
+
+    stats_ = Stats();
+    for (size_t i = 0; i < participants_; i++) {
+        stats_.objects_scanned += workers_[i]->scanned;
+        stats_.steals += workers_[i]->steals;
+        if (workers_[i]->scanned) stats_.workers_used++;
+    }
+}
+
+void GCParallelMarker::helper_loop(size_t index) {
+    uint64_t seen_epoch = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        start_cv_.wait(lock, [&] { return shutting_down_ || epoch_ != seen_epoch; });
+        if (shutting_down_) return;
+        seen_epoch = epoch_;
+        if (index >= participants_) continue;
+
+        lock.unlock();
+        tls_mark_stack = &workers_[index]->stack;
+        work(index);
+        tls_mark_stack = nullptr;
+        lock.lock();
+
+        if (--helpers_running_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+bool GCParallelMarker::steal(size_t thief) {
+    GCVector<void*>& loot = workers_[thief]->loot;
+    for (size_t offset = 1; offset < participants_; offset++) {
+        size_t victim = (thief + offset) % participants_;
+        if (workers_[victim]->stack.steal_half(loot)) {
+            workers_[thief]->steals++;
+            for (void* obj : loot) {
+                workers_[thief]->stack.push(obj);
+            }
+            loot.clear();
+            return true;
+        }
+    }
+    return false;
+}
+
+void GCParallelMarker::work(size_t index) {
+    Worker& worker = *workers_[index];
+    for (;;) {
+        void* obj;
+        while (worker.stack.pop(obj)) {
+            scan_(obj);
+            worker.scanned++;
+        }
+        if (steal(index)) continue;
+
+        // Idle: done once every worker is, otherwise wait for something to steal
+        active_workers_.fetch_sub(1, std::memory_order_acq_rel);
+        for (;;) {
+            if (active_workers_.load(std::memory_order_acquire) == 0) return;
+            bool work_left = false;
+            for (size_t i = 0; i < participants_ && !work_left; i++) {
+                work_left = workers_[i]->stack.maybe_nonempty();
+            }
+            if (work_left) {
+                active_workers_.fetch_add(1, std::memory_order_acq_rel);
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
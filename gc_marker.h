@@ -0,0 +1,108 @@
+#pragma once
+
+#include "gc_mmap_allocator.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// PARALLEL MARKER - Work-stealing mark stacks shared by the GC helper threads
+// ============================================================================
+//
+// Every marking thread owns a mark stack. Objects are marked in the heap's
+// side bitmap with an atomic fetch_or (GCHeap::mark), so whichever thread
+// marks an object first is the one that pushes it; nobody scans an object
+// twice. A thread pops from the top of its own stack and, when that runs
+// dry, steals the older half of another thread's stack.
+//
+// The collecting thread is worker 0 and seeds its own stack; helpers are
+// started once and sleep between collections. Marking ends when every
+// worker is idle: a worker only goes idle with an empty stack, so no active
+// workers means no work left anywhere.
+//
+// Marking runs with the world stopped, where malloc may be locked by a
+// parked thread: the stacks are GCVectors, and helpers are started by
+// start_helpers() before the stop rather than by mark().
+
+class GCMarkStack {
+public:
+    void push(void* obj);
+    bool pop(void*& obj);
+    // Move the bottom half of this stack into out; returns how many moved
+    size_t steal_half(GCVector<void*>& out);
+    void reserve_page() { gc_reserve_page(items_); }
+    bool maybe_nonempty() const { return size_.load(std::memory_order_relaxed) > 0; }
+
+private:
+    void lock() { while (lock_.test_and_set(std::memory_order_acquire)) {} }
+    void unlock() { lock_.clear(std::memory_order_release); }
+
+    std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+    GCVector<void*> items_;
+    std::atomic<size_t> size_{0};
+};
+
+class GCParallelMarker {
+public:
+    struct Stats {
+        size_t objects_scanned = 0;
+        size_t steals = 0;
+        size_t workers_used = 0;   // Workers that scanned at least one object in the last mark
+    };
+
+    // scan visits one marked object and pushes what it references through push()
+    explicit GCParallelMarker(std::function<void(void*)> scan);
+    ~GCParallelMarker();
+
+    // Total marking threads, the caller included; takes effect once
+    // start_helpers() has run
+    void set_thread_count(size_t count);
+    size_t thread_count() const { return thread_count_; }
+
+    // Create the workers and helper threads the thread count asks for.
+    // Call before stopping the world: mark() only uses the ones running.
+    void start_helpers();
+
+    // Run seed on the calling thread as worker 0, then mark until no work is
+    // left. Calls to push() from seed land on worker 0's stack.
+    void mark(const std::function<void()>& seed);
+
+    // Queue a newly marked object on the calling worker's stack. Returns
+    // false outside mark(), where the caller has to scan it itself.
+    static bool push(void* obj);
+
+    const Stats& last_stats() const { return stats_; }
+
+private:
+    struct Worker {
+        GCMarkStack stack;
+        GCVector<void*> loot;   // Stolen entries on their way to stack
+        size_t scanned = 0;
+        size_t steals = 0;
+    };
+
+    std::function<void(void*)> scan_;
+    size_t thread_count_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> helpers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    uint64_t epoch_ = 0;           // Bumped per mark; helpers wait for a new one
+    size_t helpers_running_ = 0;
+    size_t participants_ = 0;      // Workers taking part in the current mark
+    bool shutting_down_ = false;
+    std::atomic<size_t> active_workers_{0};
+    Stats stats_;
+
+    void helper_loop(size_t index);
+    void work(size_t index);
+    bool steal(size_t thief);
+};
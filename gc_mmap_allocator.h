@@ -0,0 +1,59 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// ============================================================================
+// GC MMAP ALLOCATOR - Collector buffers that never go through malloc
+// ============================================================================
+//
+// A stop-the-world pause parks the mutators in a signal handler wherever
+// they happen to be, inside malloc or free included, so the collector must
+// not touch the malloc lock until the world resumes. Buffers the pause fills
+// (root slots, mark stacks, page lists, page bitmaps) take their memory from
+// mmap instead: a parked thread cannot be holding anything the kernel needs.
+//
+// Every allocation is a separate mapping rounded up to whole pages, so this
+// suits buffers that are few and grow geometrically, and that are cleared
+// rather than destroyed between collections.
+
+inline size_t gc_mmap_length(size_t bytes) {
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1) & ~(page - 1);
+}
+
+template <typename T>
+struct GCMmapAllocator {
+    using value_type = T;
+
+    GCMmapAllocator() = default;
+    template <typename U>
+    GCMmapAllocator(const GCMmapAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        void* mem = mmap(nullptr, gc_mmap_length(count * sizeof(T)), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T*>(mem);
+    }
+    void deallocate(T* ptr, size_t count) {
+        munmap(ptr, gc_mmap_length(count * sizeof(T)));
+    }
+
+    template <typename U>
+    bool operator==(const GCMmapAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const GCMmapAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using GCVector = std::vector<T, GCMmapAllocator<T>>;
+
+// Start a buffer at a whole page rather than mapping a page per early doubling
+template <typename T>
+void gc_reserve_page(GCVector<T>& buffer) {
+    buffer.reserve(gc_mmap_length(sizeof(T)) / sizeof(T));
+}
@@ -0,0 +1,74 @@
+#include "gc_stack_maps.h"
+#include "gc_heap.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+// ============================================================================
+// MAP REGISTRY
+// ============================================================================
+
+GCStackMapRegistry& GCStackMapRegistry::instance() {
+    // Leaked: maps are read by JIT code and the collector until exit
+    static GCStackMapRegistry* registry = new GCStackMapRegistry();
+    return *registry;
+}
+
+const GCStackMap* GCStackMapRegistry::intern(uint32_t scope_size, std::vector<uint32_t> slots) {
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto key = std::make_pair(scope_size, slots);
+    auto it = maps_.find(key);
+    if (it != maps_.end()) {
+        return it->second;
+    }
+    GCStackMap* map = new GCStackMap{scope_size, std::move(slots)};
+    maps_.emplace(std::move(key), map);
+    return map;
+}
+
+size_t GCStackMapRegistry::map_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maps_.size();
+}
+
+static std::atomic<bool>& scope_roots_flag() {
+    static std::atomic<bool> enabled([] {
+        const char* value = std::getenv("ULTRASCRIPT_GC_SCOPE_ROOTS");
+        return value && value[0] == '1';
+    }());
+    return enabled;
+}
+
+bool gc_scope_roots_enabled() {
+    return scope_roots_flag().load(std::memory_order_relaxed);
+}
+
+void gc_set_scope_roots_enabled(bool enabled) {
+    scope_roots_flag().store(enabled, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// SCOPE CHAINS
+// ============================================================================
+
+void gc_for_each_scope_slot(void* innermost_scope, const std::function<void(void** slot)>& visit) {
+    for (void* scope = innermost_scope; scope; scope = gc_scope_header(scope)->previous) {
+        const GCStackMap* map = gc_scope_header(scope)->map;
+        if (!map) continue;
+        for (uint32_t offset : map->slots) {
+            visit(reinterpret_cast<void**>(static_cast<char*>(scope) + offset));
+        }
+    }
+}
+
+void* gc_scope_chain_save() {
+    GCHeap::instance().attach_current_thread();
+    return gc_current_tlab().scope_chain;
+}
+
+void gc_scope_chain_restore(void* chain) {
+    gc_current_tlab().scope_chain = chain;
+}
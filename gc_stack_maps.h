@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// GC STACK MAPS - Precise roots in JIT scope objects
+// ============================================================================
+//
+// JIT code keeps its variables in heap-allocated scope objects (r15 holds
+// the innermost one), not in machine stack slots, so a stack map here
+// describes a scope object: which of its fields may hold a GC reference.
+// The code generator interns one map per scope layout at compile time.
+//
+// Every scope object starts with a header in front of its variables; r15
+// and everything else holding a scope address point past it, so variable
+// offsets are unchanged:
+//
+//   [previous][map][enclosing] [variables ...]
+//                              ^ scope address
+//
+//   previous   the thread's innermost live scope when this one was entered
+//   map        this scope's stack map
+//   enclosing  r15 at entry, restored when a block scope exits
+//
+// The thread's innermost scope is published in its GCThreadLocalBuffer
+// (scope_chain). JIT code fills in the header before publishing the scope
+// and unpublishes it before freeing it, so the chain is consistent at every
+// instruction - a thread parked by the stop signal anywhere in JIT code is at
+// a safepoint. The collector walks each stopped thread's chain and treats the
+// mapped fields as precise root slots: it may rewrite them when objects move.
+// Goroutines run to completion on their worker thread, so their scopes are on
+// that thread's chain.
+//
+// Script objects and strings are reference counted outside the GC heap, so
+// by default no scope field is a GC reference: scope maps come out empty,
+// scopes with an empty map are never put on the chain, and stores to parent
+// scopes skip the barriers. gc_set_scope_roots_enabled(true) (or
+// ULTRASCRIPT_GC_SCOPE_ROOTS=1) brings the reference slots back for code
+// generated afterwards, for embedders that keep GC heap objects in script
+// variables.
+
+struct GCStackMap {
+    uint32_t scope_size;           // Bytes of variables after the header
+    std::vector<uint32_t> slots;   // Byte offsets of fields that may hold references
+};
+
+struct GCScopeHeader {
+    void* previous;
+    const GCStackMap* map;
+    void* enclosing;
+};
+
+constexpr size_t GC_SCOPE_HEADER_SIZE = sizeof(GCScopeHeader);
+static_assert(GC_SCOPE_HEADER_SIZE == 24, "JIT code addresses the header words at r15 - 24, - 16 and - 8");
+
+inline GCScopeHeader* gc_scope_header(void* scope) {
+    return reinterpret_cast<GCScopeHeader*>(static_cast<char*>(scope) - GC_SCOPE_HEADER_SIZE);
+}
+
+class GCStackMapRegistry {
+public:
+    static GCStackMapRegistry& instance();
+
+    // Maps are shared by every scope with the same layout and never freed:
+    // code referencing them may run until the process exits
+    const GCStackMap* intern(uint32_t scope_size, std::vector<uint32_t> slots);
+    size_t map_count() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::pair<uint32_t, std::vector<uint32_t>>, GCStackMap*> maps_;
+};
+
+bool gc_scope_roots_enabled();
+void gc_set_scope_roots_enabled(bool enabled);
+
+// Visit the mapped slots of every scope on a chain, innermost first. Only
+// valid while the chain's thread is stopped or is the caller.
+void gc_for_each_scope_slot(void* innermost_scope, const std::function<void(void** slot)>& visit);
+
+// Bracket native entry into JIT code: an exception leaves the chain pointing
+// at the thrower's scopes. Saving also registers the calling thread with the
+// heap, so collections stop it and scan its chain.
+void* gc_scope_chain_save();
+void gc_scope_chain_restore(void* chain);
@@ -1,10 +1,19 @@
 #include "gc_system.h"
+#include "gc_telemetry.h"
+#include "gc_heap_profiler.h"
+#include "cycle_collector.h"
+#include "runtime.h"
 // Removed lexical_scope.h include - using pure static analysis now
 #include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <cassert>
 
+// Longest delay an allocation past the soft limit waits, reached at the hard limit
+static constexpr uint64_t GC_SOFT_LIMIT_MAX_DELAY_US = 1000;
+
 
 // ============================================================================
 // ESCAPE ANALYZER IMPLEMENTATION
@@ -316,6 +325,8 @@ void VariableTracker::dump_variables() const {
 // GARBAGE COLLECTOR IMPLEMENTATION
 // ============================================================================
 
+std::atomic<uint8_t> gc_marking_active{0};
+
 GarbageCollector& GarbageCollector::instance() {
     static GarbageCollector collector;
     return collector;
@@ -324,25 +335,56 @@ GarbageCollector& GarbageCollector::instance() {
 GarbageCollector::GarbageCollector() {
     std::cout << "[GC] Initializing Garbage Collector" << std::endl;
     
+    marker_ = std::make_unique<GCParallelMarker>([this](void* obj) {
+        traverse_object_references(obj, GCHeap::header_of(obj)->type_id);
+    });
+    
+    configure_heap_limits_from_environment();
+    GCHeap::instance().set_limit_handler(&GarbageCollector::make_room_for_external);
+    
     // Start background collector thread
     collector_thread_ = std::thread(&GarbageCollector::collector_thread_func, this);
+    sweeper_thread_ = std::thread(&GarbageCollector::sweeper_thread_func, this);
 }
 
 GarbageCollector::~GarbageCollector() {
+    GCHeap::instance().set_limit_handler(nullptr);
     shutdown();
 }
 
 void* GarbageCollector::gc_alloc(size_t size, uint32_t type_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Fast path: bump the thread's allocation buffer, no lock
+    void* ptr = gc_tlab_try_allocate(gc_current_tlab(), size, type_id);
+    if (!ptr) {
+        ptr = allocate_slow(size, type_id);
+    }
+    if (gc_allocation_sampling_active.load(std::memory_order_relaxed) && ptr) {
+        GCAllocationSampler::instance().on_allocation(size, type_id);
+    }
+    return ptr;
+}
+
+void* GarbageCollector::allocate_slow(size_t size, uint32_t type_id) {
+    GCHeap& heap = GCHeap::instance();
+    
+    // Before allocating: a collection now would not see the new object's references
+    size_t soft_limit = soft_heap_limit_.load(std::memory_order_relaxed);
+    if (soft_limit && heap.committed_bytes() > soft_limit) {
+        throttle_allocation(soft_limit);
+    }
     
-    void* ptr = allocate_with_header(size, type_id);
+    void* ptr = heap.allocate_slow(gc_current_tlab(), size, type_id);
+    if (!ptr && heap.commit_limit()) {
+        ptr = allocate_at_hard_limit(size, type_id);
+    }
+    
+    // Buffer refills are where the heap grows, so check the triggers here
     if (ptr) {
-        heap_used_ += size + sizeof(GCObjectHeader);
-        stats_.total_allocated += size;
-        stats_.live_objects++;
-        
-        // Check if we should trigger collection
         if (should_collect()) {
+            full_collection_requested_.store(true);
+            request_collection();
+        } else if (generational_gc_enabled_ &&
+                   GCHeap::instance().allocated_bytes() - allocated_at_last_collection_.load() > nursery_size_) {
             request_collection();
         }
     }
@@ -351,36 +393,22 @@ void* GarbageCollector::gc_alloc(size_t size, uint32_t type_id) {
 }
 
 void* GarbageCollector::gc_alloc_array(size_t element_size, size_t count, uint32_t type_id) {
-    size_t total_size = element_size * count;
-    void* ptr = gc_alloc(total_size, type_id);
-    
-    if (ptr) {
-        GCObjectHeader* header = get_header(ptr);
-        if (header) {
-            header->flags |= GCObjectHeader::LARGE_OBJECT;
-        }
+    if (element_size != 0 && count > SIZE_MAX / element_size) {
+        return nullptr;
     }
-    
-    return ptr;
+    // The heap flags cells above GC_MAX_SMALL_CELL as LARGE_OBJECT itself
+    return gc_alloc(element_size * count, type_id);
+}
+
+void* GarbageCollector::gc_grow(void* ptr, size_t size) {
+    if (!ptr) return gc_alloc(size);
+    std::lock_guard<std::mutex> lock(collection_mutex_);
+    return GCHeap::instance().grow_object(ptr, size);
 }
 
 void GarbageCollector::gc_free(void* ptr) {
     if (!ptr) return;
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = object_headers_.find(ptr);
-    if (it != object_headers_.end()) {
-        GCObjectHeader* header = it->second;
-        size_t size = header->size;
-        
-        object_headers_.erase(it);
-        heap_used_ -= size + sizeof(GCObjectHeader);
-        stats_.total_freed += size;
-        stats_.live_objects--;
-        
-        std::free(reinterpret_cast<char*>(ptr) - sizeof(GCObjectHeader));
-    }
+    GCHeap::instance().free_object(ptr);
 }
 
 void GarbageCollector::add_root(void** root_ptr) {
@@ -396,45 +424,491 @@ void GarbageCollector::remove_root(void** root_ptr) {
 // Removed lexical scope functions - using pure static analysis now
 
 void GarbageCollector::collect() {
-    auto start_time = std::chrono::high_resolution_clock::now();
+    if (concurrent_gc_enabled_) {
+        collect_concurrent();
+        return;
+    }
     
-    std::cout << "[GC] Starting full collection..." << std::endl;
+    auto start_time = std::chrono::steady_clock::now();
+    GCTelemetry& telemetry = GCTelemetry::instance();
     
+    std::lock_guard<std::mutex> collection(collection_mutex_);
     std::lock_guard<std::mutex> lock(mutex_);
+    GCHeap& heap = GCHeap::instance();
+    
+    // Compaction buffers are reserved while the other threads still run:
+    // one parked inside malloc would hold its lock through the pause
+    heap.reserve_compaction(GC_COMPACTION_MAX_PAGES);
+    reserve_pause_buffers();
+    
+    // No output until the world resumes: a parked thread may hold the stdio lock
+    auto pause_start = std::chrono::steady_clock::now();
+    heap.stop_the_world();
     
-    size_t objects_before = stats_.live_objects;
-    size_t heap_used_before = heap_used_;
+    // Objects allocated from here on are not visited by this collection
+    heap.snapshot_objects();
+    size_t objects_before = 0;
+    heap.for_each_object([&objects_before](char*, GCObjectHeader*) { objects_before++; });
+    stats_.live_objects = objects_before;
+    
+    // Evacuation pages are chosen before marking, which pins what it cannot move
+    GCHeap::Fragmentation fragmentation = heap.fragmentation();
+    compacting_ = fragmentation.free_bytes >= GC_COMPACTION_MIN_FREE_BYTES &&
+                  fragmentation.free_bytes >= fragmentation.small_bytes * compaction_threshold_ &&
+                  heap.begin_compaction(GC_COMPACTION_MAX_OCCUPANCY, GC_COMPACTION_MAX_PAGES) > 0;
     
     // Mark phase
+    auto phase_start = std::chrono::steady_clock::now();
     mark_phase();
+    telemetry.record_phase(GCPhase::MARK, gc_micros_since(phase_start));
+    
+    // Defrag phase: move the live objects off the evacuation pages
+    if (compacting_) {
+        phase_start = std::chrono::steady_clock::now();
+        defrag_phase();
+        telemetry.record_phase(GCPhase::DEFRAG, gc_micros_since(phase_start));
+    }
     
     // Sweep phase
-    sweep_phase();
+    phase_start = std::chrono::steady_clock::now();
+    GCHeap::SweepResult result = sweep_phase();
+    telemetry.record_phase(GCPhase::SWEEP, gc_micros_since(phase_start));
     
-    // Defrag phase (optional, expensive)
-    if (heap_used_ > heap_limit_ * 0.9) {
-        defrag_phase();
+    heap.resume_the_world();
+    telemetry.record_phase(GCPhase::PAUSE, gc_micros_since(pause_start));
+    start_background_sweep();
+    
+    stats_.collections++;
+    stats_.old_collections++;
+    allocated_at_last_collection_.store(heap.allocated_bytes());
+    record_collection_time(gc_micros_since(start_time));
+    report_collection(GCCollectionReport::Kind::FULL, result, 0);
+}
+
+void GarbageCollector::collect_young() {
+    if (!generational_gc_enabled_) {
+        collect();
+        return;
     }
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+    auto start_time = std::chrono::steady_clock::now();
+    GCTelemetry& telemetry = GCTelemetry::instance();
     
+    std::lock_guard<std::mutex> collection(collection_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    GCHeap& heap = GCHeap::instance();
+    
+    // Objects move, so every allocating thread stays parked until the roots are updated
+    reserve_pause_buffers();
+    heap.stop_the_world();
+    heap.snapshot_objects();
+    minor_collection_ = true;
+    
+    // Roots are the registered slots plus old objects on dirty cards; tracing
+    // stops at old objects, which all survive
+    auto phase_start = std::chrono::steady_clock::now();
+    mark_roots();
+    marker_->mark([this, &heap]() {
+        seed_from_mark_queue();
+        heap.scan_dirty_cards([this](char*, char* begin, char* end) {
+            bool young_refs = false;
+            for (char* slot = begin; slot + sizeof(void*) <= end; slot += sizeof(void*)) {
+                void* candidate = *reinterpret_cast<void**>(slot);
+                if (candidate && is_gc_managed(candidate) && !gc_is_old(GCHeap::header_of(candidate))) {
+                    mark_object(candidate);
+                    young_refs = true;
+                }
+            }
+            return young_refs;
+        });
+    });
+    telemetry.record_phase(GCPhase::MARK, gc_micros_since(phase_start));
+    
+    phase_start = std::chrono::steady_clock::now();
+    size_t promoted = promote_survivors();
+    telemetry.record_phase(GCPhase::PROMOTE, gc_micros_since(phase_start));
+    
+    phase_start = std::chrono::steady_clock::now();
+    GCHeap::SweepResult result = heap.sweep_young();
+    telemetry.record_phase(GCPhase::SWEEP, gc_micros_since(phase_start));
+    minor_collection_ = false;
+    heap.resume_the_world();
+    telemetry.record_phase(GCPhase::PAUSE, gc_micros_since(start_time));
+    
+    stats_.young_collections++;
+    allocated_at_last_collection_.store(heap.allocated_bytes());
+    report_collection(GCCollectionReport::Kind::MINOR, result, promoted);
+}
+
+void GarbageCollector::collect_concurrent() {
+    auto start_time = std::chrono::steady_clock::now();
+    GCTelemetry& telemetry = GCTelemetry::instance();
+    
+    std::lock_guard<std::mutex> collection(collection_mutex_);
+    GCHeap& heap = GCHeap::instance();
+    
+    // Initial mark: snapshot the heap and grey the roots
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> satb_lock(satb_mutex_);
+        reserve_pause_buffers();
+        auto pause_start = std::chrono::steady_clock::now();
+        heap.stop_the_world();
+        heap.snapshot_objects();
+        satb_queue_.clear();
+        mark_roots();
+        gc_marking_active.store(1, std::memory_order_release);
+        heap.resume_the_world();
+        telemetry.record_phase(GCPhase::PAUSE, gc_micros_since(pause_start));
+    }
+    
+    // Concurrent mark: mutators run and log overwritten references
+    for (;;) {
+        drain_mark_queue();
+        std::vector<void*> logged;
+        {
+            std::lock_guard<std::mutex> satb_lock(satb_mutex_);
+            logged.swap(satb_queue_);
+        }
+        if (logged.empty()) break;
+        mark_queue_.insert(mark_queue_.end(), logged.begin(), logged.end());
+    }
+    
+    // Remark: roots may have changed, and the barrier log holds the rest
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> satb_lock(satb_mutex_);
+        reserve_pause_buffers();
+        auto pause_start = std::chrono::steady_clock::now();
+        heap.stop_the_world();
+        mark_roots();
+        mark_queue_.insert(mark_queue_.end(), satb_queue_.begin(), satb_queue_.end());
+        satb_queue_.clear();
+        drain_mark_queue();
+        gc_marking_active.store(0, std::memory_order_release);
+        heap.resume_the_world();
+        telemetry.record_phase(GCPhase::PAUSE, gc_micros_since(pause_start));
+    }
+    // Marking ran mostly alongside the mutators; this is its wall time
+    telemetry.record_phase(GCPhase::MARK, gc_micros_since(start_time));
+    
+    // Objects allocated since the snapshot were allocated black, so the
+    // sweep can run alongside the mutators too
+    auto phase_start = std::chrono::steady_clock::now();
+    GCHeap::SweepResult result = heap.sweep();
+    telemetry.record_phase(GCPhase::SWEEP, gc_micros_since(phase_start));
+    start_background_sweep();
+    
+    std::lock_guard<std::mutex> lock(mutex_);
     stats_.collections++;
-    update_stats();
+    stats_.old_collections++;
+    allocated_at_last_collection_.store(heap.allocated_bytes());
+    record_collection_time(gc_micros_since(start_time));
+    report_collection(GCCollectionReport::Kind::CONCURRENT, result, 0);
+}
+
+// Called with mutex_ held, after the world resumed
+void GarbageCollector::report_collection(GCCollectionReport::Kind kind, const GCHeap::SweepResult& result, size_t promoted) {
+    GCHeap& heap = GCHeap::instance();
+    GCHeap::Occupancy occupancy = heap.occupancy();
+    
+    GCCollectionReport report;
+    report.kind = kind;
+    report.freed_bytes = result.freed_bytes;
+    report.promoted_bytes = promoted;
+    report.allocated_bytes = heap.allocated_bytes();
+    report.young_bytes = occupancy.bytes[static_cast<size_t>(GCHeap::Space::YOUNG)];
+    report.old_bytes = occupancy.bytes[static_cast<size_t>(GCHeap::Space::OLD)];
+    report.young_pages = occupancy.pages[static_cast<size_t>(GCHeap::Space::YOUNG)];
+    report.old_pages = occupancy.pages[static_cast<size_t>(GCHeap::Space::OLD)];
+    GCTelemetry::instance().record_collection(report);
+}
+
+void GarbageCollector::inspect_heap(const std::function<void(const GCVector<void**>& root_slots)>& visit) {
+    std::lock_guard<std::mutex> collection(collection_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    GCHeap& heap = GCHeap::instance();
     
-    size_t objects_freed = objects_before - stats_.live_objects;
-    size_t bytes_freed = heap_used_before - heap_used_;
+    reserve_pause_buffers();
+    heap.stop_the_world();
+    heap.flush_allocation_runs();
+    gather_root_slots();
+    visit(root_slots_);
+    heap.resume_the_world();
+}
+
+void GarbageCollector::satb_enqueue(void* old_value) {
+    if (!gc_marking_active.load(std::memory_order_acquire) || !old_value || !is_gc_managed(old_value)) {
+        return;
+    }
+    if (GCHeap::instance().is_marked(old_value)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(satb_mutex_);
+    satb_queue_.push_back(old_value);
+    stats_.satb_entries++;
+}
+
+// Objects collections leave where they are
+static constexpr uint8_t GC_UNMOVABLE_FLAGS =
+    GCObjectHeader::CONSERVATIVE_REF | GCObjectHeader::PINNED | GCObjectHeader::LARGE_OBJECT;
+
+// Survivors that cannot move are aged where they are
+static void age_in_place(char* payload, GCObjectHeader* header, bool promote) {
+    header->flags &= ~GCObjectHeader::CONSERVATIVE_REF;
+    header->generation++;
+    if (promote) {
+        GCHeap::instance().dirty_object_cards(payload);
+    }
+}
+
+static bool promotion_target_before(const std::pair<void*, void**>& root, const void* target) {
+    return root.first < target;
+}
+
+size_t GarbageCollector::promote_survivors() {
+    GCHeap& heap = GCHeap::instance();
     
-    std::cout << "[GC] Collection complete: freed " << objects_freed 
-              << " objects (" << bytes_freed << " bytes) in " 
-              << duration.count() / 1000.0 << "ms" << std::endl;
+    // Only objects whose every reference is a root slot can move: objects
+    // allocated during the collection are marked but reached through no root.
+    // Sorted by target, the slots of each one form a run. The pause must not
+    // malloc, so this is a reserved array rather than a hash set.
+    promotion_roots_.clear();
+    for (void** root : root_slots_) {
+        if (*root && is_gc_managed(*root) && !gc_is_old(GCHeap::header_of(*root))) {
+            promotion_roots_.push_back({*root, root});
+        }
+    }
+    std::sort(promotion_roots_.begin(), promotion_roots_.end());
+    
+    // Age every other survivor in place; the root targets move below, once
+    // the walk is done and cells it has yet to visit cannot be reused
+    size_t promoted = 0;
+    heap.for_each_young_object([this, &promoted](char* payload, GCObjectHeader* header) {
+        if (!GCHeap::instance().is_marked(payload)) return;
+        bool promote = header->generation + 1 >= GC_PROMOTION_AGE;
+        if (promote) {
+            promoted += gc_cell_size_for(header->size);
+        }
+        if (!(header->flags & GC_UNMOVABLE_FLAGS)) {
+            auto root = std::lower_bound(promotion_roots_.begin(), promotion_roots_.end(), payload, promotion_target_before);
+            if (root != promotion_roots_.end() && root->first == payload) return;
+        }
+        age_in_place(payload, header, promote);
+    });
+    
+    for (size_t first = 0, last; first < promotion_roots_.size(); first = last) {
+        char* payload = static_cast<char*>(promotion_roots_[first].first);
+        for (last = first + 1; last < promotion_roots_.size() && promotion_roots_[last].first == payload; last++) {}
+        GCObjectHeader* header = GCHeap::header_of(payload);
+        if ((header->flags & GC_UNMOVABLE_FLAGS) || !heap.is_marked(payload)) continue;
+        
+        bool promote = header->generation + 1 >= GC_PROMOTION_AGE;
+        size_t size = header->size;
+        if (void* copy = heap.evacuate(payload, promote)) {
+            for (size_t i = first; i < last; i++) {
+                *promotion_roots_[i].second = copy;
+            }
+            stats_.bytes_moved += size;
+            continue;
+        }
+        age_in_place(payload, header, promote);
+    }
+    return promoted;
 }
 
-void GarbageCollector::collect_young() {
-    // Simplified young generation collection
-    // For now, just do a full collection
+void GarbageCollector::enable_generational_gc(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    generational_gc_enabled_ = enable;
+}
+
+void GarbageCollector::enable_concurrent_gc(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    concurrent_gc_enabled_ = enable;
+}
+
+void GarbageCollector::enable_huge_pages(bool enable) {
+    GCHeap::instance().set_large_object_huge_pages(enable);
+}
+
+void GarbageCollector::set_heap_limit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    heap_limit_ = bytes;
+}
+
+// ============================================================================
+// HEAP LIMITS
+// ============================================================================
+
+// "1048576", "512M", "2G"
+static size_t parse_byte_size(const char* text) {
+    char* end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || value <= 0) return 0;
+    switch (*end) {
+        case 'k': case 'K': value *= 1024.0; break;
+        case 'm': case 'M': value *= 1024.0 * 1024.0; break;
+        case 'g': case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+        default: break;
+    }
+    return static_cast<size_t>(value);
+}
+
+// Memory budget of the process's cgroup (v2, then v1), 0 when there is none
+static size_t cgroup_memory_limit() {
+    static const char* const paths[] = {"/sys/fs/cgroup/memory.max",
+                                        "/sys/fs/cgroup/memory/memory.limit_in_bytes"};
+    for (const char* path : paths) {
+        std::ifstream in(path);
+        std::string value;
+        if (!(in >> value) || value == "max") continue;
+        // v1 reports an unlimited group as a number near 2^63
+        unsigned long long limit = std::strtoull(value.c_str(), nullptr, 10);
+        if (limit > 0 && limit < (1ULL << 50)) {
+            return static_cast<size_t>(limit);
+        }
+    }
+    return 0;
+}
+
+void GarbageCollector::configure_heap_limits_from_environment() {
+    size_t hard = 0;
+    size_t soft = 0;
+    if (const char* value = std::getenv("ULTRASCRIPT_GC_HARD_LIMIT")) {
+        hard = parse_byte_size(value);
+    } else if (size_t budget = cgroup_memory_limit()) {
+        // The rest of the budget is for malloc'd objects, code and stacks
+        hard = budget / 4 * 3;
+    }
+    if (const char* value = std::getenv("ULTRASCRIPT_GC_SOFT_LIMIT")) {
+        soft = parse_byte_size(value);
+    } else {
+        soft = hard / 5 * 4;
+    }
+    if (soft || hard) {
+        set_heap_limits(soft, hard);
+    }
+}
+
+void GarbageCollector::set_heap_limits(size_t soft_bytes, size_t hard_bytes) {
+    if (hard_bytes && soft_bytes > hard_bytes) {
+        soft_bytes = hard_bytes;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Periodic collections keep running below the limits
+        if (hard_bytes) {
+            heap_limit_ = std::min(heap_limit_, hard_bytes);
+        }
+    }
+    soft_heap_limit_.store(soft_bytes, std::memory_order_relaxed);
+    soft_limit_trigger_.store(soft_bytes, std::memory_order_relaxed);
+    GCHeap::instance().set_commit_limit(hard_bytes);
+}
+
+void GarbageCollector::set_out_of_memory_callback(std::function<void(size_t)> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_of_memory_callback_ = std::move(callback);
+}
+
+// Past the soft limit: force a collection (unless one already failed to get
+// below it and the heap has not grown much since), then slow the caller down
+void GarbageCollector::throttle_allocation(size_t soft_limit) {
+    auto start_time = std::chrono::steady_clock::now();
+    GCHeap& heap = GCHeap::instance();
+    GCTelemetry& telemetry = GCTelemetry::instance();
+    
+    if (heap.committed_bytes() > soft_limit_trigger_.load(std::memory_order_relaxed)) {
+        // Threads arriving meanwhile wait here for this collection
+        std::lock_guard<std::mutex> lock(heap_limit_mutex_);
+        if (heap.committed_bytes() > soft_limit_trigger_.load(std::memory_order_relaxed)) {
+            collect();
+            heap.finish_sweeping();
+            telemetry.record_limit_collection();
+            // Still above: the live data needs the room, so let it grow an
+            // eighth of the limit before forcing the next one
+            size_t committed = heap.committed_bytes();
+            soft_limit_trigger_.store(committed > soft_limit ? committed + soft_limit / 8 : soft_limit,
+                                      std::memory_order_relaxed);
+        }
+    }
+    
+    size_t committed = heap.committed_bytes();
+    if (committed > soft_limit) {
+        size_t hard_limit = heap.commit_limit();
+        uint64_t delay = GC_SOFT_LIMIT_MAX_DELAY_US;
+        if (hard_limit > soft_limit) {
+            delay = delay * std::min(committed - soft_limit, hard_limit - soft_limit) / (hard_limit - soft_limit);
+        }
+        if (delay) {
+            std::this_thread::sleep_for(std::chrono::microseconds(delay));
+        }
+    }
+    telemetry.record_throttle(gc_micros_since(start_time));
+}
+
+// The heap refused to commit past the hard limit
+void* GarbageCollector::allocate_at_hard_limit(size_t size, uint32_t type_id) {
+    for (int attempt = 0; make_room_at_hard_limit(size, attempt); attempt++) {
+        if (void* ptr = GCHeap::instance().allocate_slow(gc_current_tlab(), size, type_id)) {
+            return ptr;
+        }
+    }
+    return nullptr;
+}
+
+// Collect, then let the application shed load and collect again, before
+// giving up. Reference-count cycles go too: class instances are malloc'd
+// and count against the limit as external bytes.
+bool GarbageCollector::make_room_at_hard_limit(size_t size, int attempt) {
+    static thread_local bool in_callback = false;
+    GCHeap& heap = GCHeap::instance();
+    GCTelemetry& telemetry = GCTelemetry::instance();
+    
+    if (attempt == 1) {
+        std::function<void(size_t)> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback = out_of_memory_callback_;
+        }
+        // An allocation inside the callback that hits the limit just fails
+        if (callback && !in_callback) {
+            in_callback = true;
+            callback(size);
+            in_callback = false;
+        } else {
+            attempt = 2;
+        }
+    }
+    if (attempt > 1) {
+        telemetry.record_out_of_memory();
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(heap_limit_mutex_);
     collect();
-    stats_.young_collections++;
+    heap.finish_sweeping();
+    CycleCollector::instance().collect();
+    telemetry.record_limit_collection();
+    return true;
+}
+
+bool GarbageCollector::make_room_for_external(size_t bytes, int attempt) {
+    return instance().make_room_at_hard_limit(bytes, attempt);
+}
+
+void GarbageCollector::set_mark_threads(size_t count) {
+    marker_->set_thread_count(count);
+}
+
+void GarbageCollector::set_compaction_threshold(double threshold) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    compaction_threshold_ = threshold;
+}
+
+void GarbageCollector::set_nursery_size(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nursery_size_ = bytes;
 }
 
 void GarbageCollector::request_collection() {
@@ -443,91 +917,159 @@ void GarbageCollector::request_collection() {
 }
 
 bool GarbageCollector::should_collect() const {
-    return (static_cast<double>(heap_used_) / heap_limit_) > collection_threshold_;
+    return (static_cast<double>(GCHeap::instance().committed_bytes()) / heap_limit_) > collection_threshold_;
 }
 
-void GarbageCollector::mark_phase() {
-    std::cout << "[GC] Mark phase..." << std::endl;
-    
-    // Clear all mark bits
-    for (auto& [ptr, header] : object_headers_) {
-        header->unmark();
+size_t GarbageCollector::bytes_until_collection() const {
+    GCHeap& heap = GCHeap::instance();
+    size_t full_at = static_cast<size_t>(heap_limit_ * collection_threshold_);
+    size_t committed = heap.committed_bytes();
+    size_t until = full_at > committed ? full_at - committed : 0;
+    if (generational_gc_enabled_) {
+        size_t since = heap.allocated_bytes() - allocated_at_last_collection_.load();
+        until = std::min(until, since < nursery_size_ ? nursery_size_ - since : 0);
     }
+    return until;
+}
+
+size_t GarbageCollector::get_heap_used() const {
+    GCHeap& heap = GCHeap::instance();
+    return heap.allocated_bytes() - heap.freed_bytes();
+}
+
+const GarbageCollector::Stats& GarbageCollector::get_stats() {
+    GCHeap& heap = GCHeap::instance();
+    stats_.total_allocated = heap.allocated_bytes();
+    stats_.total_freed = heap.freed_bytes();
+    return stats_;
+}
+
+void GarbageCollector::mark_phase() {
+    // Mark bits were cleared by the heap snapshot
     
     // Mark from roots
     mark_roots();
     
     // Process mark queue
-    while (!mark_queue_.empty()) {
-        void* obj = mark_queue_.front();
-        mark_queue_.pop();
-        mark_object(obj);
-    }
+    drain_mark_queue();
 }
 
-void GarbageCollector::sweep_phase() {
-    std::cout << "[GC] Sweep phase..." << std::endl;
-    
-    auto it = object_headers_.begin();
-    while (it != object_headers_.end()) {
-        void* ptr = it->first;
-        GCObjectHeader* header = it->second;
-        
-        if (!header->is_marked()) {
-            // Object is unreachable, free it
-            size_t size = header->size;
-            heap_used_ -= size + sizeof(GCObjectHeader);
-            stats_.total_freed += size;
-            stats_.live_objects--;
-            
-            std::free(reinterpret_cast<char*>(ptr) - sizeof(GCObjectHeader));
-            it = object_headers_.erase(it);
-        } else {
-            // Object is still alive, unmark for next collection
-            header->unmark();
-            ++it;
-        }
+// Mark everything reachable from the queued objects on all marking threads
+void GarbageCollector::drain_mark_queue() {
+    marker_->mark([this]() { seed_from_mark_queue(); });
+}
+
+// Everything queued was reached through a root slot or the barrier log
+void GarbageCollector::seed_from_mark_queue() {
+    for (void* obj : mark_queue_) {
+        mark_object(obj, true);
     }
+    mark_queue_.clear();
+}
+
+GCHeap::SweepResult GarbageCollector::sweep_phase() {
+    // Bitmap sweep: large objects are freed now, small pages are queued for
+    // the lazy sweep, which frees every allocated but unmarked cell
+    GCHeap::SweepResult result = GCHeap::instance().sweep();
+    stats_.live_objects -= result.freed_objects;
+    return result;
+}
+
+void GarbageCollector::start_background_sweep() {
+    sweep_requested_.store(true);
+    sweep_cv_.notify_one();
 }
 
 void GarbageCollector::defrag_phase() {
-    std::cout << "[GC] Defrag phase..." << std::endl;
-    
-    // Simple defragmentation: compact all live objects
-    // This is a simplified version - real implementation would be more sophisticated
+    GCHeap& heap = GCHeap::instance();
+    
+    // Evacuate: copy live objects off the chosen pages, leaving forwarding
+    // pointers. Dead ones are left to the sweep. Two captures at most: a
+    // bigger std::function target would be malloc'd inside the pause.
+    size_t moved = 0;
+    heap.for_each_evacuating_object([this, &moved](char* payload, GCObjectHeader* header) {
+        GCHeap& heap = GCHeap::instance();
+        if (!heap.is_marked(payload)) return;
+        // The forwarding pointer needs a word of payload
+        if ((header->flags & GC_UNMOVABLE_FLAGS) || header->size < sizeof(void*)) {
+            header->flags &= ~GCObjectHeader::CONSERVATIVE_REF;
+            return;
+        }
+        if (heap.relocate(payload)) {
+            moved++;
+            stats_.bytes_moved += header->size;
+        }
+    });
     
-    std::vector<std::pair<void*, GCObjectHeader*>> live_objects;
-    for (const auto& [ptr, header] : object_headers_) {
-        live_objects.push_back({ptr, header});
+    // Rewrite the precise references. A recorded slot may itself sit in a
+    // moved object, in which case the copy's slot is the live one.
+    for (void** root : root_slots_) {
+        if (void* copy = heap.forwarding_address(*root)) {
+            *root = copy;
+        }
     }
+    for (void** slot : compaction_slots_) {
+        if (void* holder = heap.find_object(slot)) {
+            if (char* copy = static_cast<char*>(heap.forwarding_address(holder))) {
+                slot = reinterpret_cast<void**>(copy + (reinterpret_cast<char*>(slot) - static_cast<char*>(holder)));
+            }
+        }
+        if (void* copy = heap.forwarding_address(*slot)) {
+            *slot = copy;
+        }
+    }
+    compaction_slots_.clear();
     
-    // Sort by address to maintain relative order
-    std::sort(live_objects.begin(), live_objects.end());
-    
-    // TODO: Implement actual memory compaction
-    // This would involve:
-    // 1. Allocating new contiguous memory block
-    // 2. Copying all live objects to new locations
-    // 3. Updating all pointers to point to new locations
-    // 4. Freeing old fragmented memory
-    
-    stats_.defrag_operations++;
+    heap.end_compaction();
+    compacting_ = false;
+    if (moved) {
+        stats_.defrag_operations++;
+    }
 }
 
-void GarbageCollector::mark_object(void* obj) {
+void GarbageCollector::mark_object(void* obj, bool precise) {
     if (!obj) return;
     
     GCObjectHeader* header = get_header(obj);
-    if (!header || header->is_marked()) {
+    if (!header) return;
+    if (minor_collection_) {
+        if (gc_is_old(header)) return;
+        // The slot cannot be rewritten, so the object must stay where it is
+        if (!precise) {
+            __atomic_fetch_or(&header->flags, GCObjectHeader::CONSERVATIVE_REF, __ATOMIC_RELAXED);
+        }
+    } else if (compacting_ && !precise && GCHeap::instance().is_evacuating(obj)) {
+        __atomic_fetch_or(&header->flags, GCObjectHeader::CONSERVATIVE_REF, __ATOMIC_RELAXED);
+    }
+    if (!GCHeap::instance().mark(obj)) {
         return;  // Already marked
     }
     
-    header->mark();
+    // Whoever sets the mark bit scans the object; marking threads queue it instead
+    if (GCParallelMarker::push(obj)) {
+        return;
+    }
     
     // Traverse object references based on type information
     traverse_object_references(obj, header->type_id);
 }
 
+void GarbageCollector::mark_slot(void** slot) {
+    void* obj = *slot;
+    if (!obj || !is_gc_managed(obj)) return;
+    
+    // Compaction rewrites the slot if the object moves
+    if (compacting_ && GCHeap::instance().is_evacuating(obj)) {
+        {
+            std::lock_guard<std::mutex> lock(compaction_slots_mutex_);
+            compaction_slots_.push_back(slot);
+        }
+        mark_object(obj, true);
+        return;
+    }
+    mark_object(obj);
+}
+
 void GarbageCollector::traverse_object_references(void* obj, uint32_t type_id) {
     if (!obj) return;
     
@@ -606,25 +1148,15 @@ void GarbageCollector::traverse_class_properties(void* obj, ClassMetadata* class
         void* property_ptr = object_data + prop.offset;
         
         switch (prop.type) {
-            case PropertyType::OBJECT_PTR: {
+            case PropertyType::OBJECT_PTR:
                 // This property contains a pointer to another object
-                void** ptr_field = static_cast<void**>(property_ptr);
-                void* referenced_obj = *ptr_field;
-                if (referenced_obj && is_gc_managed(referenced_obj)) {
-                    mark_object(referenced_obj);
-                }
+                mark_slot(static_cast<void**>(property_ptr));
                 break;
-            }
             
-            case PropertyType::STRING: {
+            case PropertyType::STRING:
                 // String properties may point to GC-managed strings
-                void** str_field = static_cast<void**>(property_ptr);
-                void* str_obj = *str_field;
-                if (str_obj && is_gc_managed(str_obj)) {
-                    mark_object(str_obj);
-                }
+                mark_slot(static_cast<void**>(property_ptr));
                 break;
-            }
             
             case PropertyType::INT64:
             case PropertyType::FLOAT64:
@@ -675,9 +1207,8 @@ void GarbageCollector::conservative_scan_memory(void* ptr, size_t size) {
 }
 
 bool GarbageCollector::is_gc_managed(void* ptr) {
-    // Check if this pointer points to GC-managed memory
-    std::lock_guard<std::mutex> lock(mutex_);
-    return object_headers_.find(ptr) != object_headers_.end();
+    // Check if this pointer is the start of an object in the current snapshot
+    return GCHeap::instance().is_object_start(ptr);
 }
 
 // Type ID mapping for GC integration
@@ -707,32 +1238,51 @@ DataType GarbageCollector::type_id_to_datatype(uint32_t type_id) {
     }
 }
 
+void GarbageCollector::register_class_metadata(uint32_t type_id, ClassMetadata* metadata) {
+    std::lock_guard<std::mutex> lock(class_metadata_mutex_);
+    class_metadata_[type_id] = metadata;
+}
+
 ClassMetadata* GarbageCollector::find_class_metadata_by_type_id(uint32_t type_id) {
-    // Access the global class registry to find metadata
-    // This requires integration with the ClassRegistry system
-    static std::unordered_map<uint32_t, ClassMetadata*> type_id_to_metadata;
-    static bool initialized = false;
-    
-    if (!initialized) {
-        // Build reverse lookup table from ClassRegistry
-        // Note: This would need to be integrated with the actual ClassRegistry
-        // For now, return nullptr - this will trigger conservative scanning
-        initialized = true;
-    }
-    
-    auto it = type_id_to_metadata.find(type_id);
-    return (it != type_id_to_metadata.end()) ? it->second : nullptr;
+    std::lock_guard<std::mutex> lock(class_metadata_mutex_);
+    auto it = class_metadata_.find(type_id);
+    return (it != class_metadata_.end()) ? it->second : nullptr;
+}
+
+std::unordered_map<uint32_t, ClassMetadata*> GarbageCollector::registered_classes() const {
+    std::lock_guard<std::mutex> lock(class_metadata_mutex_);
+    return class_metadata_;
 }
 
 void GarbageCollector::mark_roots() {
-    // Mark from explicit roots
-    for (void** root : roots_) {
-        if (*root) {
-            mark_queue_.push(*root);
+    gather_root_slots();
+    for (void** root : root_slots_) {
+        if (*root && is_gc_managed(*root)) {
+            mark_queue_.push_back(*root);
         }
     }
-    
-    // Note: Scope variable marking removed - using pure static analysis now
+}
+
+// Called with mutex_ held, before the world stops. The buffers keep their
+// capacity between collections; a pause that outgrows them maps more memory
+// rather than calling malloc.
+void GarbageCollector::reserve_pause_buffers() {
+    root_slots_.reserve(roots_.size() + 2 * stats_.stack_slots + 64);
+    promotion_roots_.reserve(root_slots_.capacity());
+    mark_queue_.reserve(root_slots_.capacity());
+    marker_->start_helpers();
+}
+
+// Called with the world stopped: the scope chains only hold still then
+void GarbageCollector::gather_root_slots() {
+    root_slots_.assign(roots_.begin(), roots_.end());
+    size_t registered = root_slots_.size();
+    GCHeap::instance().for_each_scope_chain([this](void* chain) {
+        gc_for_each_scope_slot(chain, [this](void** slot) {
+            root_slots_.push_back(slot);
+        });
+    });
+    stats_.stack_slots = root_slots_.size() - registered;
 }
 
 // Removed mark_scope_variables function - using pure static analysis now
@@ -778,39 +1328,13 @@ void GarbageCollector::scan_for_gc_references(void* ptr, DataType type) {
 }
 
 GCObjectHeader* GarbageCollector::get_header(void* obj) {
-    auto it = object_headers_.find(obj);
-    return (it != object_headers_.end()) ? it->second : nullptr;
+    return GCHeap::instance().is_object_start(obj) ? GCHeap::header_of(obj) : nullptr;
 }
 
-void* GarbageCollector::allocate_with_header(size_t size, uint32_t type_id) {
-    size_t total_size = sizeof(GCObjectHeader) + size;
-    void* raw_memory = std::malloc(total_size);
-    
-    if (!raw_memory) {
-        return nullptr;
-    }
-    
-    // Initialize header
-    GCObjectHeader* header = static_cast<GCObjectHeader*>(raw_memory);
-    header->size = static_cast<uint32_t>(size);
-    header->type_id = type_id;
-    header->flags = 0;
-    header->generation = 0;  // Start in young generation
-    header->padding = 0;
-    
-    // Object data starts after header
-    void* obj_ptr = reinterpret_cast<char*>(raw_memory) + sizeof(GCObjectHeader);
-    
-    // Register object
-    object_headers_[obj_ptr] = header;
-    heap_blocks_.push_back(raw_memory);
-    
-    return obj_ptr;
-}
-
-void GarbageCollector::update_stats() {
-    // Update average collection time and other stats
-    // Implementation would track timing history
+void GarbageCollector::record_collection_time(uint64_t micros) {
+    // Running mean over full collections
+    double ms = micros / 1000.0;
+    stats_.avg_collection_time_ms += (ms - stats_.avg_collection_time_ms) / std::max<size_t>(stats_.collections, 1);
 }
 
 void GarbageCollector::collector_thread_func() {
@@ -828,7 +1352,8 @@ void GarbageCollector::collector_thread_func() {
         if (collection_requested_.exchange(false)) {
             lock.unlock();
             
-            if (generational_gc_enabled_ && stats_.young_collections < 5) {
+            bool full = full_collection_requested_.exchange(false);
+            if (generational_gc_enabled_ && !full) {
                 collect_young();
             } else {
                 collect();
@@ -837,21 +1362,35 @@ void GarbageCollector::collector_thread_func() {
     }
 }
 
+void GarbageCollector::sweeper_thread_func() {
+    GCHeap& heap = GCHeap::instance();
+    while (running_.load()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            sweep_cv_.wait(lock, [this] {
+                return sweep_requested_.load() || !running_.load();
+            });
+        }
+        sweep_requested_.store(false);
+        
+        // One page per heap lock: allocators and the next collection get in between
+        while (running_.load() && heap.sweep_next_page()) {}
+    }
+}
+
 void GarbageCollector::shutdown() {
     running_.store(false);
     collection_cv_.notify_all();
+    sweep_cv_.notify_all();
     
     if (collector_thread_.joinable()) {
         collector_thread_.join();
     }
-    
-    // Free all remaining objects
-    for (void* block : heap_blocks_) {
-        std::free(block);
+    if (sweeper_thread_.joinable()) {
+        sweeper_thread_.join();
     }
     
-    heap_blocks_.clear();
-    object_headers_.clear();
+    // Heap pages stay mapped: other threads may still be running at exit
     roots_.clear();
     // Removed root_scopes_.clear() - using pure static analysis now
     
@@ -968,6 +1507,10 @@ void* __gc_alloc_array(size_t element_size, size_t count, uint32_t type_id) {
     return GarbageCollector::instance().gc_alloc_array(element_size, count, type_id);
 }
 
+void* __gc_grow(void* ptr, size_t size) {
+    return GarbageCollector::instance().gc_grow(ptr, size);
+}
+
 void __gc_free(void* ptr) {
     GarbageCollector::instance().gc_free(ptr);
 }
@@ -988,10 +1531,35 @@ void __gc_collect_young() {
     GarbageCollector::instance().collect_young();
 }
 
+void __gc_satb_enqueue(void* old_value) {
+    GarbageCollector::instance().satb_enqueue(old_value);
+}
+
 int __gc_should_collect() {
     return GarbageCollector::instance().should_collect() ? 1 : 0;
 }
 
+void __gc_set_heap_limits(int64_t soft_bytes, int64_t hard_bytes) {
+    GarbageCollector::instance().set_heap_limits(static_cast<size_t>(std::max<int64_t>(soft_bytes, 0)),
+                                                 static_cast<size_t>(std::max<int64_t>(hard_bytes, 0)));
+}
+
+void __gc_set_out_of_memory_callback(void (*callback)(int64_t requested_bytes)) {
+    if (!callback) {
+        GarbageCollector::instance().set_out_of_memory_callback(nullptr);
+        return;
+    }
+    GarbageCollector::instance().set_out_of_memory_callback([callback](size_t requested) {
+        callback(static_cast<int64_t>(requested));
+    });
+}
+
+void* __gc_out_of_memory_error() {
+    // Malloc'd, so it can be made with the heap at its limit; boxed like the
+    // values throw statements throw
+    return __dynamic_value_create_from_string(__string_create("RangeError: out of memory (GC heap hard limit reached)"));
+}
+
 void __gc_enter_scope(const char* scope_name, int is_function) {
     std::string name = scope_name ? scope_name : "";
     GCParserIntegration::on_enter_scope(name, is_function != 0);
@@ -12,6 +12,10 @@
 #include <condition_variable>
 #include <functional>
 #include "compiler.h"
+#include "gc_heap.h"
+#include "gc_marker.h"
+#include "gc_stack_maps.h"
+#include "gc_telemetry.h"
 
 
 // Forward declarations
@@ -99,36 +103,6 @@ private:
     GCEscapeAnalyzer() = default;
 };
 
-// ============================================================================
-// GC OBJECT HEADER - Minimal overhead tracking
-// ============================================================================
-
-struct GCObjectHeader {
-    enum Flags : uint8_t {
-        MARKED = 0x01,
-        ESCAPED = 0x02,
-        PINNED = 0x04,
-        LARGE_OBJECT = 0x08
-    };
-    
-    uint32_t size;          // Object size in bytes
-    uint32_t type_id;       // Runtime type information
-    uint8_t flags;          // GC flags
-    uint8_t generation;     // Generation (0=young, 1=old)
-    uint16_t padding;       // Padding for alignment
-    
-    void mark() { flags |= MARKED; }
-    void unmark() { flags &= ~MARKED; }
-    bool is_marked() const { return flags & MARKED; }
-    
-    void set_escaped() { flags |= ESCAPED; }
-    bool has_escaped() const { return flags & ESCAPED; }
-    
-    void pin() { flags |= PINNED; }
-    void unpin() { flags &= ~PINNED; }
-    bool is_pinned() const { return flags & PINNED; }
-};
-
 // ============================================================================
 // VARIABLE TRACKER - Tracks variables in each scope
 // ============================================================================
@@ -208,9 +182,64 @@ private:
 // ============================================================================
 // GARBAGE COLLECTOR - Mark-sweep-defrag implementation
 // ============================================================================
+//
+// Objects live in the page-based GCHeap (gc_heap.h). Allocation bumps the
+// calling thread's buffer without taking mutex_; the lock guards collection,
+// roots and configuration.
+//
+// With generational collection enabled, every nursery_size_ bytes of
+// allocation trigger a minor collection; a full collection runs when the heap
+// passes the collection threshold. Minor collections move young objects that
+// are only reachable through root slots and update those slots, so code
+// holding a young object's address anywhere else must pin() it.
+//
+// Minor collections and non-concurrent full collections stop every
+// allocating thread (GCHeap::stop_the_world) for their whole duration. With
+// concurrent collection enabled, a full collection only stops the world to
+// read the roots and to remark; marking runs alongside the mutators, which
+// log overwritten references through the snapshot-at-the-beginning barrier
+// while gc_marking_active is set.
+//
+// Non-concurrent full collections also compact once free space scattered
+// among live cells passes compaction_threshold_. They evacuate the sparsest
+// pages and rewrite the root slots and typed class properties that point into
+// them. Objects reached through anything imprecise stay where they are, like
+// pinned ones.
+//
+// Root slots are the registered ones plus the fields that stack maps mark as
+// references in every live JIT scope of a stopped thread (gc_stack_maps.h).
+// Both are precise, so collections may move what they point to.
+//
+// A parked mutator may be inside malloc, so nothing a pause fills goes
+// through it: those buffers are GCVectors (gc_mmap_allocator.h), reserved
+// before the stop and kept between collections.
+//
+// Full collections leave small pages to the heap's lazy sweep; the sweeper
+// thread works through them after each collection, outside any pause.
+//
+// Collections print nothing; each one reports its phase times, promotion and
+// occupancy to GCTelemetry (gc_telemetry.h).
+//
+// Heap limits bound the bytes the heap commits. Past the soft limit, every
+// allocation that needs a new buffer first waits for a forced full collection
+// (one at a time; other allocating threads queue behind it) and is then
+// delayed in proportion to how close the heap is to the hard limit. The hard
+// limit is the heap's commit limit: an allocation that would pass it gets a
+// full collection, then the out-of-memory callback and one more collection,
+// and fails if there is still no room. gc_alloc returns nullptr; JIT code
+// throws a catchable out-of-memory error instead. The hard limit also covers
+// the external bytes of malloc'd class instances and string buffers
+// (GCHeap::reserve_external_bytes): creating an instance or a long string
+// concatenation past it fails, and throws, the same way.
+//
+//   ULTRASCRIPT_GC_SOFT_LIMIT=<bytes>[K|M|G]   default 80% of the hard limit
+//   ULTRASCRIPT_GC_HARD_LIMIT=<bytes>[K|M|G]   default 75% of the cgroup memory budget, if any
+//   runtime.gc.setHeapLimits(soft, hard)
 
 class GarbageCollector {
 public:
+    // Byte counts include cell headers. Allocation is not counted per object,
+    // so live_objects is exact as of the last collection.
     struct Stats {
         size_t total_allocated = 0;
         size_t total_freed = 0;
@@ -221,6 +250,8 @@ public:
         double avg_collection_time_ms = 0.0;
         size_t defrag_operations = 0;
         size_t bytes_moved = 0;
+        size_t satb_entries = 0;   // References logged by the pre-write barrier
+        size_t stack_slots = 0;    // JIT scope slots read as roots by the last collection
     };
     
     static GarbageCollector& instance();
@@ -228,6 +259,9 @@ public:
     // Memory allocation with GC tracking
     void* gc_alloc(size_t size, uint32_t type_id = 0);
     void* gc_alloc_array(size_t element_size, size_t count, uint32_t type_id = 0);
+    // Grow an object, moving it if needed (see GCHeap::grow_object); waits
+    // for a running collection
+    void* gc_grow(void* ptr, size_t size);
     void gc_free(void* ptr);
     
     // Root set management
@@ -239,50 +273,105 @@ public:
     void collect();  // Full collection
     void collect_young();  // Young generation only
     void request_collection();  // Async collection request
+    void satb_enqueue(void* old_value);  // Pre-write barrier slow path
     bool should_collect() const;
     
     // Configuration
     void set_heap_limit(size_t bytes);
     void set_collection_threshold(double threshold);  // 0.0-1.0
     void enable_generational_gc(bool enable);
+    void set_nursery_size(size_t bytes);  // Allocation between minor collections
+    void set_mark_threads(size_t count);  // Marking threads, the collecting one included
+    void set_compaction_threshold(double threshold);  // Free fraction of used small pages, 0.0-1.0
     void enable_concurrent_gc(bool enable);
+    void enable_huge_pages(bool enable);  // Transparent huge pages for large objects
+    // Committed byte limits, 0 for none; soft is capped at hard
+    void set_heap_limits(size_t soft_bytes, size_t hard_bytes);
+    size_t soft_heap_limit() const { return soft_heap_limit_.load(std::memory_order_relaxed); }
+    size_t hard_heap_limit() const { return GCHeap::instance().commit_limit(); }
+    // Called with the requested size, and no lock held, before an allocation
+    // fails at the hard limit; references it drops are collected before the retry
+    void set_out_of_memory_callback(std::function<void(size_t)> callback);
     
     // Statistics
-    const Stats& get_stats() const { return stats_; }
-    size_t get_heap_size() const { return heap_size_; }
-    size_t get_heap_used() const { return heap_used_; }
+    const Stats& get_stats();
+    size_t get_heap_size() const { return GCHeap::instance().committed_bytes(); }
+    size_t get_heap_used() const;
+    size_t bytes_until_collection() const;  // Allocation left before the next trigger
+    
+    // Class layouts let collections and heap snapshots trace instances precisely
+    void register_class_metadata(uint32_t type_id, ClassMetadata* metadata);
+    ClassMetadata* find_class_metadata_by_type_id(uint32_t type_id);
+    std::unordered_map<uint32_t, ClassMetadata*> registered_classes() const;
+    
+    // Stop the world with every allocation visible and call visit with this
+    // moment's root slots. visit must not print, malloc, or take a lock a
+    // mutator may hold.
+    void inspect_heap(const std::function<void(const GCVector<void**>& root_slots)>& visit);
+    const GCParallelMarker::Stats& get_mark_stats() const { return marker_->last_stats(); }
     
     // Shutdown
     void shutdown();
     
 private:
     mutable std::mutex mutex_;
+    std::mutex collection_mutex_;  // One collection at a time; taken before mutex_
     std::atomic<bool> running_{true};
     
+    // References overwritten while marking
+    std::mutex satb_mutex_;
+    std::vector<void*> satb_queue_;
+    
     // Memory management
-    std::vector<void*> heap_blocks_;
-    size_t heap_size_ = 0;
-    size_t heap_used_ = 0;
     size_t heap_limit_ = 256 * 1024 * 1024;  // 256MB default
     double collection_threshold_ = 0.8;  // Collect at 80% full
     
+    // Heap limits; the hard one is the heap's commit limit
+    std::atomic<size_t> soft_heap_limit_{0};
+    std::atomic<size_t> soft_limit_trigger_{0};  // Committed bytes that force the next limit collection
+    std::mutex heap_limit_mutex_;  // One limit collection at a time; taken before collection_mutex_
+    std::function<void(size_t)> out_of_memory_callback_;  // Guarded by mutex_
+    
     // Root set
     std::unordered_set<void**> roots_;
+    GCVector<void**> root_slots_;  // This collection's roots: registered slots plus mapped JIT scope slots
     // Removed root_scopes_ member - using pure static analysis now
     
-    // Object tracking
-    std::unordered_map<void*, GCObjectHeader*> object_headers_;
-    std::queue<void*> mark_queue_;
+    // Object tracking: the queue seeds the parallel marker
+    GCVector<void*> mark_queue_;
+    std::unique_ptr<GCParallelMarker> marker_;
     
     // Configuration
     bool generational_gc_enabled_ = true;
     bool concurrent_gc_enabled_ = false;
     
+    // Generational state
+    size_t nursery_size_ = 8 * 1024 * 1024;
+    std::atomic<size_t> allocated_at_last_collection_{0};
+    std::atomic<bool> full_collection_requested_{false};
+    bool minor_collection_ = false;  // Tracing stops at old objects
+    GCVector<std::pair<void*, void**>> promotion_roots_;  // Young root targets and their slots, by target
+    
+    // Registered class layouts
+    mutable std::mutex class_metadata_mutex_;
+    std::unordered_map<uint32_t, ClassMetadata*> class_metadata_;
+    
+    // Compaction state
+    double compaction_threshold_ = 0.5;
+    bool compacting_ = false;  // Evacuation pages were chosen for this collection
+    std::mutex compaction_slots_mutex_;
+    GCVector<void**> compaction_slots_;  // Precise heap slots pointing into evacuation pages
+    
     // Background collection thread
     std::thread collector_thread_;
     std::condition_variable collection_cv_;
     std::atomic<bool> collection_requested_{false};
     
+    // Background sweeping thread
+    std::thread sweeper_thread_;
+    std::condition_variable sweep_cv_;
+    std::atomic<bool> sweep_requested_{false};
+    
     // Statistics
     Stats stats_;
     
@@ -291,16 +380,30 @@ private:
     
     // GC implementation
     void mark_phase();
-    void sweep_phase();
+    GCHeap::SweepResult sweep_phase();
     void defrag_phase();
-    void mark_object(void* obj);
+    void mark_object(void* obj, bool precise = false);  // precise: the slot may be rewritten
+    void mark_slot(void** slot);  // A typed reference field of a heap object
+    size_t promote_survivors();  // Returns the bytes promoted
     void mark_roots();
+    void gather_root_slots();
+    void reserve_pause_buffers();
     // Removed mark_scope_variables method - using pure static analysis now
     void collector_thread_func();
+    void sweeper_thread_func();
+    void start_background_sweep();
+    void collect_concurrent();
+    void drain_mark_queue();
+    void seed_from_mark_queue();
     
     // Memory management
     GCObjectHeader* get_header(void* obj);
-    void* allocate_with_header(size_t size, uint32_t type_id);
+    void* allocate_slow(size_t size, uint32_t type_id);
+    void throttle_allocation(size_t soft_limit);
+    void* allocate_at_hard_limit(size_t size, uint32_t type_id);
+    bool make_room_at_hard_limit(size_t size, int attempt);
+    static bool make_room_for_external(size_t bytes, int attempt);  // GCHeap's limit handler
+    void configure_heap_limits_from_environment();
     
     // Type system integration
     void traverse_object_references(void* obj, uint32_t type_id);
@@ -312,7 +415,6 @@ private:
     void traverse_dynamic_property(void* prop_ptr);
     void conservative_scan_memory(void* ptr, size_t size);
     bool is_gc_managed(void* ptr);
-    ClassMetadata* find_class_metadata_by_type_id(uint32_t type_id);
     
     // Scope and variable scanning
     bool contains_gc_references(DataType type);
@@ -323,7 +425,10 @@ private:
     // Type mapping utilities
     uint32_t datatype_to_type_id(DataType type);
     DataType type_id_to_datatype(uint32_t type_id);
-    void update_stats();
+    
+    // Statistics and telemetry
+    void record_collection_time(uint64_t micros);
+    void report_collection(GCCollectionReport::Kind kind, const GCHeap::SweepResult& result, size_t promoted);
 };
 
 // ============================================================================
@@ -365,12 +470,18 @@ public:
 extern "C" {
     void* __gc_alloc(size_t size, uint32_t type_id);
     void* __gc_alloc_array(size_t element_size, size_t count, uint32_t type_id);
+    void* __gc_grow(void* ptr, size_t size);
     void __gc_free(void* ptr);
     void __gc_add_root(void** root_ptr);
     void __gc_remove_root(void** root_ptr);
     void __gc_collect();
     void __gc_collect_young();
+    void __gc_satb_enqueue(void* old_value);
     int __gc_should_collect();
+    void __gc_set_heap_limits(int64_t soft_bytes, int64_t hard_bytes);
+    void __gc_set_out_of_memory_callback(void (*callback)(int64_t requested_bytes));
+    // Error value (a boxed string) JIT code throws when an allocation fails at the hard limit
+    void* __gc_out_of_memory_error();
     
     // Parser integration
     void __gc_enter_scope(const char* scope_name, int is_function);
@@ -380,3 +491,12 @@ extern "C" {
     void __gc_finalize_analysis();
 }
 
+// Set while a concurrent collection is marking; JIT code tests the byte directly
+extern std::atomic<uint8_t> gc_marking_active;
+
+// Snapshot-at-the-beginning barrier: call before overwriting a reference slot
+inline void gc_satb_barrier(void** slot) {
+    if (gc_marking_active.load(std::memory_order_relaxed)) {
+        __gc_satb_enqueue(*slot);
+    }
+}
@@ -0,0 +1,274 @@
+#include "gc_telemetry.h"
+#include "cycle_collector.h"
+#include "gc_heap.h"
+#include "gc_system.h"
+#include "runtime.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// ============================================================================
+// PAUSE HISTOGRAM
+// ============================================================================
+
+const char* gc_phase_name(GCPhase phase) {
+    switch (phase) {
+        case GCPhase::PAUSE: return "pause";
+        case GCPhase::MARK: return "mark";
+        case GCPhase::SWEEP: return "sweep";
+        case GCPhase::DEFRAG: return "defrag";
+        case GCPhase::PROMOTE: return "promote";
+        default: return "unknown";
+    }
+}
+
+size_t GCPauseHistogram::bucket_for(uint64_t micros) {
+    if (micros == 0) return 0;
+    size_t bucket = 64 - __builtin_clzll(micros);
+    return std::min(bucket, BUCKET_COUNT - 1);
+}
+
+void GCPauseHistogram::record(uint64_t micros) {
+    buckets_[bucket_for(micros)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(micros, std::memory_order_relaxed);
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (micros > seen && !max_.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {}
+}
+
+uint64_t GCPauseHistogram::percentile_micros(double percentile) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(total * std::clamp(percentile, 0.0, 100.0) / 100.0 + 0.5);
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t index = 0; index < BUCKET_COUNT; index++) {
+        seen += bucket(index);
+        if (seen >= rank) {
+            return std::min(uint64_t(1) << index, max_micros());
+        }
+    }
+    return max_micros();
+}
+
+// ============================================================================
+// TELEMETRY
+// ============================================================================
+
+GCTelemetry& GCTelemetry::instance() {
+    // Leaked: the log thread and late collections may outlive static destructors
+    static GCTelemetry* telemetry = new GCTelemetry();
+    return *telemetry;
+}
+
+void GCTelemetry::record_collection(const GCCollectionReport& report) {
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point previous_time = last_time_;
+    last_.collections++;
+    switch (report.kind) {
+        case GCCollectionReport::Kind::MINOR: last_.minor_collections++; break;
+        case GCCollectionReport::Kind::CONCURRENT: last_.concurrent_collections++; last_.full_collections++; break;
+        case GCCollectionReport::Kind::FULL: last_.full_collections++; break;
+    }
+
+    double seconds = std::chrono::duration<double>(now - previous_time).count();
+    if (seconds > 0) {
+        last_.allocation_rate = (report.allocated_bytes - previous_allocated_) / seconds;
+        last_.promotion_rate = report.promoted_bytes / seconds;
+    }
+    previous_allocated_ = report.allocated_bytes;
+    last_time_ = now;
+
+    last_.promoted_bytes += report.promoted_bytes;
+    last_.freed_bytes += report.freed_bytes;
+    last_.young_bytes = report.young_bytes;
+    last_.old_bytes = report.old_bytes;
+    last_.young_pages = report.young_pages;
+    last_.old_pages = report.old_pages;
+}
+
+GCTelemetry::Snapshot GCTelemetry::snapshot() const {
+    // Heap figures first: the heap lock is held across whole pauses
+    GCHeap& heap = GCHeap::instance();
+    size_t committed = heap.committed_bytes();
+    size_t allocated = heap.allocated_bytes();
+    size_t hard_limit = heap.commit_limit();
+    size_t soft_limit = GarbageCollector::instance().soft_heap_limit();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Snapshot result = last_;
+    result.committed_bytes = committed;
+    result.allocated_bytes = allocated;
+    result.soft_limit_bytes = soft_limit;
+    result.hard_limit_bytes = hard_limit;
+    result.limit_collections = limit_collections_.load(std::memory_order_relaxed);
+    result.throttled_allocations = throttled_allocations_.load(std::memory_order_relaxed);
+    result.throttle_micros = throttle_micros_.load(std::memory_order_relaxed);
+    result.out_of_memory_errors = out_of_memory_errors_.load(std::memory_order_relaxed);
+    if (last_.collections > 0) {
+        result.seconds_since_collection = std::chrono::duration<double>(Clock::now() - last_time_).count();
+    }
+    return result;
+}
+
+std::string GCTelemetry::to_json() const {
+    Snapshot stats = snapshot();
+    std::ostringstream out;
+    out << "{\"collections\":" << stats.collections
+        << ",\"minor_collections\":" << stats.minor_collections
+        << ",\"full_collections\":" << stats.full_collections
+        << ",\"concurrent_collections\":" << stats.concurrent_collections
+        << ",\"seconds_since_collection\":" << stats.seconds_since_collection
+        << ",\"allocation_rate\":" << static_cast<uint64_t>(stats.allocation_rate)
+        << ",\"promotion_rate\":" << static_cast<uint64_t>(stats.promotion_rate)
+        << ",\"promoted_bytes\":" << stats.promoted_bytes
+        << ",\"freed_bytes\":" << stats.freed_bytes
+        << ",\"heap\":{\"committed_bytes\":" << stats.committed_bytes
+        << ",\"allocated_bytes\":" << stats.allocated_bytes
+        << ",\"young_bytes\":" << stats.young_bytes
+        << ",\"young_pages\":" << stats.young_pages
+        << ",\"old_bytes\":" << stats.old_bytes
+        << ",\"old_pages\":" << stats.old_pages << "}"
+        << ",\"limits\":{\"soft_bytes\":" << stats.soft_limit_bytes
+        << ",\"hard_bytes\":" << stats.hard_limit_bytes
+        << ",\"limit_collections\":" << stats.limit_collections
+        << ",\"throttled_allocations\":" << stats.throttled_allocations
+        << ",\"throttle_us\":" << stats.throttle_micros
+        << ",\"out_of_memory_errors\":" << stats.out_of_memory_errors << "}"
+        << ",\"phases\":{";
+    for (size_t index = 0; index < static_cast<size_t>(GCPhase::COUNT); index++) {
+        const GCPauseHistogram& histogram = histograms_[index];
+        out << (index ? "," : "") << "\"" << gc_phase_name(static_cast<GCPhase>(index)) << "\":{"
+            << "\"count\":" << histogram.count()
+            << ",\"total_us\":" << histogram.total_micros()
+            << ",\"max_us\":" << histogram.max_micros()
+            << ",\"p50_us\":" << histogram.percentile_micros(50)
+            << ",\"p99_us\":" << histogram.percentile_micros(99)
+            << ",\"buckets\":[";
+        // Trailing empty buckets are left out
+        size_t used = GCPauseHistogram::BUCKET_COUNT;
+        while (used > 0 && histogram.bucket(used - 1) == 0) used--;
+        for (size_t bucket = 0; bucket < used; bucket++) {
+            out << (bucket ? "," : "") << histogram.bucket(bucket);
+        }
+        out << "]}";
+    }
+    out << "}}";
+    return out.str();
+}
+
+// ============================================================================
+// PERIODIC LOG
+// ============================================================================
+
+bool GCTelemetry::start_log(const std::string& path, uint64_t interval_ms) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    if (log_running_) return false;
+    {
+        std::ofstream probe(path, std::ios::app);
+        if (!probe) return false;
+    }
+    log_running_ = true;
+    log_thread_ = std::thread(&GCTelemetry::log_loop, this, path, std::max<uint64_t>(interval_ms, 1));
+    return true;
+}
+
+void GCTelemetry::stop_log() {
+    {
+        std::lock_guard<std::mutex> lock(log_mutex_);
+        if (!log_running_) return;
+        log_running_ = false;
+    }
+    log_cv_.notify_all();
+    if (log_thread_.joinable()) {
+        log_thread_.join();
+    }
+}
+
+void GCTelemetry::log_loop(std::string path, uint64_t interval_ms) {
+    std::ofstream out(path, std::ios::app);
+    std::unique_lock<std::mutex> lock(log_mutex_);
+    for (;;) {
+        bool stopping = log_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms),
+                                         [this] { return !log_running_; });
+        lock.unlock();
+        out << to_json() << '\n';
+        out.flush();
+        lock.lock();
+        if (stopping) break;
+    }
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+int64_t __runtime_gc_collect() {
+    GarbageCollector::instance().collect();
+    return static_cast<int64_t>(GarbageCollector::instance().get_heap_used());
+}
+
+int64_t __runtime_gc_heapSize() {
+    return static_cast<int64_t>(GarbageCollector::instance().get_heap_size());
+}
+
+int64_t __runtime_gc_heapUsed() {
+    return static_cast<int64_t>(GarbageCollector::instance().get_heap_used());
+}
+
+int64_t __runtime_gc_nextGC() {
+    return static_cast<int64_t>(GarbageCollector::instance().bytes_until_collection());
+}
+
+void* __runtime_gc_stats() {
+    return __string_create(GCTelemetry::instance().to_json().c_str());
+}
+
+int64_t __runtime_gc_allocationRate() {
+    return static_cast<int64_t>(GCTelemetry::instance().snapshot().allocation_rate);
+}
+
+int64_t __runtime_gc_promotionRate() {
+    return static_cast<int64_t>(GCTelemetry::instance().snapshot().promotion_rate);
+}
+
+int64_t __runtime_gc_sinceLastGC() {
+    double seconds = GCTelemetry::instance().snapshot().seconds_since_collection;
+    return seconds < 0 ? -1 : static_cast<int64_t>(seconds * 1000);
+}
+
+// Reference-count cycles (cycle_collector.h); returns the objects freed
+int64_t __runtime_gc_collectCycles() {
+    return static_cast<int64_t>(CycleCollector::instance().collect());
+}
+
+void* __runtime_gc_cycleStats() {
+    return __string_create(CycleCollector::instance().to_json().c_str());
+}
+
+// Returns the hard limit in effect
+int64_t __runtime_gc_setHeapLimits(int64_t soft_bytes, int64_t hard_bytes) {
+    __gc_set_heap_limits(soft_bytes, hard_bytes);
+    return static_cast<int64_t>(GarbageCollector::instance().hard_heap_limit());
+}
+
+void __gc_telemetry_start_from_environment() {
+    const char* path = std::getenv("ULTRASCRIPT_GC_LOG");
+    if (!path || !path[0]) return;
+
+    uint64_t interval_ms = 1000;
+    if (const char* interval = std::getenv("ULTRASCRIPT_GC_LOG_INTERVAL_MS")) {
+        interval_ms = std::max(1, std::atoi(interval));
+    }
+    GCTelemetry::instance().start_log(path, interval_ms);
+}
+
+void __gc_telemetry_finish() {
+    GCTelemetry::instance().stop_log();
+}
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// ============================================================================
+// GC TELEMETRY - Pause histograms, rates and occupancy
+// ============================================================================
+//
+// The collector reports each collection once the world has resumed: how long
+// each phase took, every stop-the-world window, the bytes it promoted and
+// the live bytes left in each generation. Reporting is a few relaxed atomic
+// adds plus one short lock and never prints, so it is always on.
+//
+// Rates are taken between the last two collections (for the first one, since
+// startup). runtime.gc reads the aggregate, and a log thread can append it as
+// one JSON object per line:
+//
+//   ULTRASCRIPT_GC_LOG=<file>            log for the whole run
+//   ULTRASCRIPT_GC_LOG_INTERVAL_MS=<n>   log period (default 1000)
+//   runtime.gc.stats()                   the same JSON as a string
+
+enum class GCPhase : uint8_t {
+    PAUSE,     // One stop-the-world window; a concurrent collection has two
+    MARK,
+    SWEEP,     // Synchronous part only: small pages are swept lazily
+    DEFRAG,    // Evacuating sparse pages in a full collection
+    PROMOTE,   // Moving and aging nursery survivors in a minor collection
+    COUNT
+};
+
+const char* gc_phase_name(GCPhase phase);
+
+// Log2 buckets of microseconds: bucket 0 holds sub-microsecond times and
+// bucket i times in [2^(i-1), 2^i); the last one is open-ended
+class GCPauseHistogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 24;   // Last bound ~8.4s
+
+    void record(uint64_t micros);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t total_micros() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t max_micros() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t bucket(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    // Upper bound of the bucket holding the percentile (0-100), capped at the max
+    uint64_t percentile_micros(double percentile) const;
+
+    static size_t bucket_for(uint64_t micros);
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+struct GCCollectionReport {
+    enum class Kind : uint8_t { MINOR, FULL, CONCURRENT };
+
+    Kind kind = Kind::FULL;
+    size_t freed_bytes = 0;
+    size_t promoted_bytes = 0;       // Young bytes moved or aged into the old generation
+    size_t allocated_bytes = 0;      // GCHeap::allocated_bytes() when the collection ended
+    size_t young_bytes = 0;          // GCHeap::occupancy() after the collection
+    size_t old_bytes = 0;
+    size_t young_pages = 0;
+    size_t old_pages = 0;
+};
+
+class GCTelemetry {
+public:
+    struct Snapshot {
+        uint64_t collections = 0;
+        uint64_t minor_collections = 0;
+        uint64_t full_collections = 0;       // Concurrent ones included
+        uint64_t concurrent_collections = 0;
+        double allocation_rate = 0.0;        // Bytes/s between the last two collections
+        double promotion_rate = 0.0;         // Bytes/s promoted by the last collection
+        uint64_t promoted_bytes = 0;         // Since startup
+        uint64_t freed_bytes = 0;
+        double seconds_since_collection = -1.0;   // -1 before the first one
+        size_t young_bytes = 0;              // Occupancy as of the last collection
+        size_t old_bytes = 0;
+        size_t young_pages = 0;
+        size_t old_pages = 0;
+        size_t committed_bytes = 0;          // Current
+        size_t allocated_bytes = 0;
+        size_t soft_limit_bytes = 0;         // Heap limits, 0 when unset
+        size_t hard_limit_bytes = 0;
+        uint64_t limit_collections = 0;      // Forced by the soft or hard limit
+        uint64_t throttled_allocations = 0;  // Allocations slowed down past the soft limit
+        uint64_t throttle_micros = 0;        // Time they spent waiting, collections included
+        uint64_t out_of_memory_errors = 0;   // Allocations failed at the hard limit
+    };
+
+    static GCTelemetry& instance();
+
+    // Collector side. Phase times may be recorded while the world is stopped;
+    // collection reports only after it resumed.
+    void record_phase(GCPhase phase, uint64_t micros) {
+        histograms_[static_cast<size_t>(phase)].record(micros);
+    }
+    void record_collection(const GCCollectionReport& report);
+    // Heap limit enforcement, from allocating threads
+    void record_limit_collection() { limit_collections_.fetch_add(1, std::memory_order_relaxed); }
+    void record_throttle(uint64_t micros) {
+        throttled_allocations_.fetch_add(1, std::memory_order_relaxed);
+        throttle_micros_.fetch_add(micros, std::memory_order_relaxed);
+    }
+    void record_out_of_memory() { out_of_memory_errors_.fetch_add(1, std::memory_order_relaxed); }
+
+    const GCPauseHistogram& histogram(GCPhase phase) const {
+        return histograms_[static_cast<size_t>(phase)];
+    }
+    Snapshot snapshot() const;
+    std::string to_json() const;
+
+    // Append to_json() to path every interval until stop_log(), which writes
+    // a last line; false if the file cannot be opened or a log is running
+    bool start_log(const std::string& path, uint64_t interval_ms);
+    void stop_log();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    GCPauseHistogram histograms_[static_cast<size_t>(GCPhase::COUNT)];
+    std::atomic<uint64_t> limit_collections_{0};
+    std::atomic<uint64_t> throttled_allocations_{0};
+    std::atomic<uint64_t> throttle_micros_{0};
+    std::atomic<uint64_t> out_of_memory_errors_{0};
+
+    mutable std::mutex mutex_;
+    Snapshot last_;                  // Collection counters and occupancy; rates and current sizes are filled by snapshot()
+    Clock::time_point last_time_ = Clock::now();   // Startup until the first collection
+    size_t previous_allocated_ = 0;
+
+    std::mutex log_mutex_;
+    std::condition_variable log_cv_;
+    std::thread log_thread_;
+    bool log_running_ = false;
+
+    GCTelemetry() = default;
+    void log_loop(std::string path, uint64_t interval_ms);
+};
+
+// Elapsed microseconds, for timing phases
+inline uint64_t gc_micros_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+extern "C" {
+    // runtime.gc.* entry points
+    int64_t __runtime_gc_collect();
+    int64_t __runtime_gc_heapSize();
+    int64_t __runtime_gc_heapUsed();
+    int64_t __runtime_gc_nextGC();
+    void* __runtime_gc_stats();
+    int64_t __runtime_gc_allocationRate();
+    int64_t __runtime_gc_promotionRate();
+    int64_t __runtime_gc_sinceLastGC();
+    int64_t __runtime_gc_collectCycles();
+    void* __runtime_gc_cycleStats();
+    int64_t __runtime_gc_setHeapLimits(int64_t soft_bytes, int64_t hard_bytes);
+
+    // Log for the whole run when ULTRASCRIPT_GC_LOG is set; called by runtime init/cleanup
+    void __gc_telemetry_start_from_environment();
+    void __gc_telemetry_finish();
+}
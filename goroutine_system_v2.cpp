@@ -1,4 +1,8 @@
 #include "goroutine_system_v2.h"
+#include "sampling_profiler.h"
+#include "gc_stack_maps.h"
+#include "jit_code_heap.h"
+#include "exception_unwinder.h"
 #include <iostream>
 #include <algorithm>
 #include <cstdlib>
@@ -380,6 +384,7 @@ void FFIThread::continue_execution(std::shared_ptr<Goroutine> goroutine) {
 }
 
 void FFIThread::main_loop() {
+    SamplingProfiler::instance().register_current_thread();
     while (!should_exit_) {
         std::unique_lock<std::mutex> lock(work_mutex_);
         work_signal_.wait(lock, [this] { return bound_goroutine_ || should_exit_; });
@@ -391,6 +396,7 @@ void FFIThread::main_loop() {
             execute_with_native_stack();
         }
     }
+    SamplingProfiler::instance().unregister_current_thread();
 }
 
 //=============================================================================
@@ -475,6 +481,7 @@ ThreadWorker::~ThreadWorker() {
 }
 
 void ThreadWorker::main_loop() {
+    SamplingProfiler::instance().register_current_thread();
     while (!should_exit_.load()) {
         // 1. Wait for work assignment (blocks until work arrives)
         wait_for_work();
@@ -493,10 +500,14 @@ void ThreadWorker::main_loop() {
             cont = Continuation(ContinuationAction::CHECK_QUEUE);
         }
         
+        // One code region per wake-up; the tasks it runs nest theirs inside.
+        // Between tasks no JIT frame is on this stack.
+        JITCodeRegion code_region;
         while (cont.action != ContinuationAction::DONE) {
             switch (cont.action) {
                 case ContinuationAction::RUN_GOROUTINE:
                     cont = execute_goroutine(cont.goroutine);
+                    JITCodeHeap::instance().quiescent();
                     break;
                     
                 case ContinuationAction::CHECK_QUEUE:
@@ -511,6 +522,7 @@ void ThreadWorker::main_loop() {
         // 3. Clear work assignment and return to idle state
         assigned_work_ = nullptr;
     }
+    SamplingProfiler::instance().unregister_current_thread();
 }
 
 bool ThreadWorker::try_assign_work(std::shared_ptr<Goroutine> goroutine) {
@@ -618,6 +630,8 @@ Continuation ThreadWorker::check_and_get_next_work() {
 }
 
 bool ThreadWorker::run_goroutine_until_yield_or_complete(std::shared_ptr<Goroutine> goroutine) {
+    // A goroutine that throws leaves its JIT scopes on the thread's chain
+    void* scope_chain = gc_scope_chain_save();
     try {
         // Check stack overflow
         if (goroutine->check_stack_overflow()) {
@@ -629,6 +643,7 @@ bool ThreadWorker::run_goroutine_until_yield_or_complete(std::shared_ptr<Gorouti
         if (goroutine->get_state() == GoroutineState::CREATED) {
             // First time running - execute main function
             goroutine->execute_main_function();
+            gc_scope_chain_restore(scope_chain);
             goroutine->set_state(GoroutineState::COMPLETED);
             return true; // Completed
         } else if (goroutine->get_state() == GoroutineState::RUNNING) {
@@ -640,6 +655,7 @@ bool ThreadWorker::run_goroutine_until_yield_or_complete(std::shared_ptr<Gorouti
         
         return false; // Yielded
     } catch (const std::exception& e) {
+        gc_scope_chain_restore(scope_chain);
         std::cerr << "Goroutine " << goroutine->get_id() << " threw exception: " << e.what() << std::endl;
         goroutine->set_state(GoroutineState::COMPLETED);
         return true; // Completed with error
@@ -1442,11 +1458,9 @@ extern "C" void __gots_cancel_async_handle_v2(int64_t async_id) {
 
 extern "C" void __runtime_spawn_main_goroutine_v2(void* function_address) {
     // Create main goroutine
-    typedef void (*MainFunction)();
-    auto main_func = reinterpret_cast<MainFunction>(function_address);
-    
-    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), 
-                                                 [main_func]() { main_func(); });
+    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [function_address]() {
+        jit_call_guarded("the main goroutine", function_address);
+    });
     
     // Initialize scheduler
     EventDrivenScheduler::instance().initialize();
@@ -1462,11 +1476,9 @@ extern "C" void __runtime_wait_for_main_goroutine_v2() {
 }
 
 extern "C" void* __runtime_spawn_goroutine_v2(void* function_address) {
-    typedef void (*GoroutineFunction)();
-    auto func = reinterpret_cast<GoroutineFunction>(function_address);
-    
-    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1),
-                                                 [func]() { func(); });
+    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [function_address]() {
+        jit_call_guarded("a goroutine", function_address);
+    });
     
     // Schedule the new goroutine
     EventDrivenScheduler::instance().schedule_regular(goroutine);
@@ -1528,14 +1540,9 @@ extern "C" void __gots_clear_timeout(int64_t timer_id) {
 
 // Await goroutine functions - spawn and wait for result
 extern "C" void* __goroutine_spawn_and_wait_direct(void* function_address) {
-    typedef int64_t (*GoroutineFunction)();
-    auto func = reinterpret_cast<GoroutineFunction>(function_address);
-    
-    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1),
-                                                 [func]() { 
-                                                     int64_t result = func();
-                                                     return result;
-                                                 });
+    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [function_address]() {
+        jit_call_guarded("an awaited goroutine", function_address);
+    });
     
     // Schedule the goroutine
     EventDrivenScheduler::instance().schedule_regular(goroutine);
@@ -1554,15 +1561,11 @@ extern "C" void* __goroutine_spawn_and_wait_fast(void* func_address) {
     // High-performance path: Direct function address execution
     if (func_address) {
         // Call the compiled function directly
-        typedef int64_t (*GoroutineFunction)();
-        auto func = reinterpret_cast<GoroutineFunction>(func_address);
-        
-        auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1),
-                                                     [func]() -> void { 
-                                                         int64_t result = func();
-                                                         // Note: Cannot set result from inside lambda as we don't have goroutine ref here
-                                                         // This will be fixed in proper implementation
-                                                     });
+        auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [func_address]() {
+            // Note: Cannot set result from inside lambda as we don't have goroutine ref here
+            // This will be fixed in proper implementation
+            jit_call_guarded("an awaited goroutine", func_address);
+        });
         
         // Schedule the goroutine
         EventDrivenScheduler::instance().schedule_regular(goroutine);
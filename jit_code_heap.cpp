@@ -0,0 +1,496 @@
+#include "jit_code_heap.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+// ============================================================================
+// JIT CODE HEAP IMPLEMENTATION
+// ============================================================================
+
+JITCodeHeap& JITCodeHeap::instance() {
+    // Intentionally leaked: goroutines may still be executing JIT code while
+    // static destructors run, so the mappings must outlive them.
+    static JITCodeHeap* heap = new JITCodeHeap();
+    return *heap;
+}
+
+JITCodeHeap::JITCodeHeap() {
+    long page = sysconf(_SC_PAGESIZE);
+    if (page > 0) {
+        page_size_ = static_cast<size_t>(page);
+    }
+
+    const char* huge = std::getenv("ULTRASCRIPT_JIT_HUGE_PAGES");
+    if (huge && huge[0] == '1') {
+        use_huge_pages_ = true;
+    }
+}
+
+JITCodeHeap::~JITCodeHeap() {
+    shutdown();
+}
+
+void JITCodeHeap::set_segment_size(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    segment_size_ = (bytes + SEGMENT_ALIGNMENT - 1) & ~(SEGMENT_ALIGNMENT - 1);
+}
+
+size_t JITCodeHeap::round_chunk_size(size_t size) const {
+    // Fallback mode toggles protections per chunk, so chunks must own whole pages
+    size_t alignment = dual_mapping_available_ ? CHUNK_ALIGNMENT : page_size_;
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+bool JITCodeHeap::map_dual_segment(Segment& segment) {
+    // hugetlb memfds can be created without a reserved pool and only fail at
+    // mmap time, so try the whole sequence with huge pages first, then without
+    for (int attempt = use_huge_pages_ ? 0 : 1; attempt < 2; attempt++) {
+        bool huge = (attempt == 0);
+        int fd = memfd_create("ultrascript-jit", MFD_CLOEXEC | (huge ? MFD_HUGETLB : 0));
+        if (fd < 0) {
+            continue;
+        }
+        if (ftruncate(fd, segment.size) != 0) {
+            close(fd);
+            continue;
+        }
+
+        void* rw = mmap(nullptr, segment.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (rw == MAP_FAILED) {
+            close(fd);
+            continue;
+        }
+        void* rx = mmap(nullptr, segment.size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+        if (rx == MAP_FAILED) {
+            munmap(rw, segment.size);
+            close(fd);
+            continue;
+        }
+
+        if (use_huge_pages_ && !huge) {
+            // No hugetlbfs pool - ask for transparent huge pages on the shmem mapping instead
+            madvise(rx, segment.size, MADV_HUGEPAGE);
+            madvise(rw, segment.size, MADV_HUGEPAGE);
+        }
+
+        segment.fd = fd;
+        segment.exec_base = static_cast<uint8_t*>(rx);
+        segment.write_base = static_cast<uint8_t*>(rw);
+        segment.dual_mapped = true;
+        segment.huge_pages = huge;
+        return true;
+    }
+    return false;
+}
+
+bool JITCodeHeap::map_fallback_segment(Segment& segment) {
+    void* mem = mmap(nullptr, segment.size, PROT_READ | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+    if (use_huge_pages_) {
+        madvise(mem, segment.size, MADV_HUGEPAGE);
+    }
+    segment.exec_base = static_cast<uint8_t*>(mem);
+    segment.write_base = segment.exec_base;
+    segment.dual_mapped = false;
+    return true;
+}
+
+bool JITCodeHeap::map_segment(size_t min_size) {
+    Segment segment;
+    segment.size = segment_size_;
+    if (min_size > segment.size) {
+        segment.size = (min_size + SEGMENT_ALIGNMENT - 1) & ~(SEGMENT_ALIGNMENT - 1);
+    }
+
+    bool mapped = false;
+    if (dual_mapping_available_) {
+        mapped = map_dual_segment(segment);
+        if (!mapped && segments_.empty()) {
+            // memfd is unavailable (old kernel, seccomp) - use mprotect toggling from now on
+            std::cerr << "[JIT_HEAP] Dual mapping unavailable, falling back to mprotect W^X" << std::endl;
+            dual_mapping_available_ = false;
+        }
+    }
+    if (!mapped && !dual_mapping_available_) {
+        mapped = map_fallback_segment(segment);
+    }
+    if (!mapped) {
+        return false;
+    }
+
+    // Unused code space traps instead of sliding into garbage
+    if (segment.dual_mapped) {
+        std::memset(segment.write_base, TRAP_BYTE, segment.size);
+    }
+
+    segment.free_blocks[0] = segment.size;
+    segments_.push_back(std::move(segment));
+
+    stats_.reserved_bytes += segments_.back().size;
+    stats_.segments = segments_.size();
+    stats_.dual_mapped = dual_mapping_available_;
+    stats_.huge_pages = stats_.huge_pages || segments_.back().huge_pages;
+    return true;
+}
+
+bool JITCodeHeap::carve_from_segment(Segment& segment, size_t size, size_t& offset_out) {
+    // First fit keeps related functions close together for iTLB locality
+    for (auto it = segment.free_blocks.begin(); it != segment.free_blocks.end(); ++it) {
+        if (it->second < size) continue;
+
+        offset_out = it->first;
+        size_t remaining = it->second - size;
+        segment.free_blocks.erase(it);
+        if (remaining > 0) {
+            segment.free_blocks[offset_out + size] = remaining;
+        }
+        return true;
+    }
+    return false;
+}
+
+JITCodeChunk* JITCodeHeap::allocate(size_t size, const std::string& owner) {
+    if (size == 0) {
+        size = 1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t rounded = round_chunk_size(size);
+    size_t offset = 0;
+    size_t segment_index = segments_.size();
+
+    for (size_t i = 0; i < segments_.size(); i++) {
+        if (carve_from_segment(segments_[i], rounded, offset)) {
+            segment_index = i;
+            break;
+        }
+    }
+
+    if (segment_index == segments_.size()) {
+        if (!map_segment(rounded)) {
+            std::cerr << "[JIT_HEAP] Failed to map code segment for " << rounded << " bytes" << std::endl;
+            return nullptr;
+        }
+        // The mapping mode may have changed, which changes chunk rounding
+        rounded = round_chunk_size(size);
+        segment_index = segments_.size() - 1;
+        if (!carve_from_segment(segments_[segment_index], rounded, offset)) {
+            return nullptr;
+        }
+    }
+
+    Segment& segment = segments_[segment_index];
+    auto chunk = std::make_unique<JITCodeChunk>();
+    chunk->exec_base = segment.exec_base + offset;
+    chunk->write_base = segment.write_base + offset;
+    chunk->size = rounded;
+    chunk->segment_index = segment_index;
+    chunk->owner = owner;
+
+    JITCodeChunk* result = chunk.get();
+    chunks_[reinterpret_cast<uintptr_t>(result->exec_base)] = std::move(chunk);
+
+    stats_.used_bytes += rounded;
+    stats_.live_chunks++;
+    return result;
+}
+
+void JITCodeHeap::release_locked(JITCodeChunk* chunk) {
+    auto it = chunks_.find(reinterpret_cast<uintptr_t>(chunk->exec_base));
+    if (it == chunks_.end() || it->second.get() != chunk) {
+        return;
+    }
+
+    // A chunk released directly may also have been retired; the pointer dies below
+    auto retired = std::find_if(retired_.begin(), retired_.end(),
+                                [chunk](const RetiredChunk& entry) { return entry.chunk == chunk; });
+    if (retired != retired_.end()) {
+        retired_.erase(retired);
+        retired_count_.store(retired_.size(), std::memory_order_release);
+        stats_.retired_chunks = retired_.size();
+    }
+
+    Segment& segment = segments_[chunk->segment_index];
+    size_t offset = static_cast<size_t>(chunk->exec_base - segment.exec_base);
+    size_t length = chunk->size;
+
+    // Stale calls into freed code hit int3 rather than whatever is placed there next
+    if (segment.dual_mapped) {
+        std::memset(chunk->write_base, TRAP_BYTE, length);
+    } else {
+        protect_chunk(chunk, PROT_READ | PROT_WRITE);
+        std::memset(chunk->write_base, TRAP_BYTE, length);
+        protect_chunk(chunk, PROT_READ | PROT_EXEC);
+    }
+
+    // Insert and coalesce with neighbours
+    auto next = segment.free_blocks.lower_bound(offset);
+    if (next != segment.free_blocks.end() && offset + length == next->first) {
+        length += next->second;
+        next = segment.free_blocks.erase(next);
+    }
+    if (next != segment.free_blocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += length;
+            length = 0;
+        }
+    }
+    if (length > 0) {
+        segment.free_blocks[offset] = length;
+    }
+
+    stats_.used_bytes -= chunk->size;
+    stats_.live_chunks--;
+    stats_.released_chunks++;
+    chunks_.erase(it);
+}
+
+void JITCodeHeap::release(JITCodeChunk* chunk) {
+    if (!chunk) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_locked(chunk);
+}
+
+void JITCodeHeap::retire_locked(JITCodeChunk* chunk) {
+    for (const RetiredChunk& entry : retired_) {
+        if (entry.chunk == chunk) return;
+    }
+    // Threads entering from here on see the new epoch and cannot reach the chunk
+    retired_.push_back({chunk, epoch_.fetch_add(1, std::memory_order_seq_cst)});
+    retired_count_.store(retired_.size(), std::memory_order_release);
+    stats_.retired_chunks = retired_.size();
+}
+
+void JITCodeHeap::retire(JITCodeChunk* chunk) {
+    if (!chunk) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (chunks_.count(reinterpret_cast<uintptr_t>(chunk->exec_base))) {
+        retire_locked(chunk);
+    }
+}
+
+bool JITCodeHeap::retire_code_at(const void* exec_addr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    JITCodeChunk* chunk = find_chunk_locked(exec_addr);
+    if (!chunk) return false;
+    retire_locked(chunk);
+    return true;
+}
+
+size_t JITCodeHeap::reclaim_retired() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (retired_.empty()) return 0;
+
+    // Oldest epoch any thread is still running JIT code from
+    uint64_t oldest = UINT64_MAX;
+    for (CodeThread* thread = code_threads_; thread; thread = thread->next) {
+        uint64_t entered = thread->entered_epoch.load(std::memory_order_seq_cst);
+        if (entered != 0) {
+            oldest = std::min(oldest, entered);
+        }
+    }
+
+    std::vector<RetiredChunk> still_retired;
+    std::vector<JITCodeChunk*> reclaimable;
+    for (const RetiredChunk& entry : retired_) {
+        if (entry.epoch < oldest) {
+            reclaimable.push_back(entry.chunk);
+        } else {
+            still_retired.push_back(entry);
+        }
+    }
+    retired_.swap(still_retired);
+    retired_count_.store(retired_.size(), std::memory_order_release);
+    stats_.retired_chunks = retired_.size();
+
+    for (JITCodeChunk* chunk : reclaimable) {
+        release_locked(chunk);
+    }
+    return reclaimable.size();
+}
+
+// ============================================================================
+// CODE EPOCHS
+// ============================================================================
+
+// Unlinks the thread's record when it exits
+struct JITCodeThreadHolder {
+    void* thread = nullptr;
+    ~JITCodeThreadHolder();
+};
+
+static thread_local JITCodeThreadHolder tls_code_thread;
+
+JITCodeThreadHolder::~JITCodeThreadHolder() {
+    if (!thread) return;
+    JITCodeHeap& heap = JITCodeHeap::instance();
+    heap.remove_code_thread(static_cast<JITCodeHeap::CodeThread*>(thread));
+    thread = nullptr;
+    if (heap.retired_count_.load(std::memory_order_acquire) > 0) {
+        heap.reclaim_retired();
+    }
+}
+
+JITCodeHeap::CodeThread* JITCodeHeap::current_code_thread() {
+    if (!tls_code_thread.thread) {
+        CodeThread* thread = new CodeThread();
+        std::lock_guard<std::mutex> lock(mutex_);
+        thread->next = code_threads_;
+        code_threads_ = thread;
+        tls_code_thread.thread = thread;
+    }
+    return static_cast<CodeThread*>(tls_code_thread.thread);
+}
+
+void JITCodeHeap::remove_code_thread(CodeThread* thread) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (CodeThread** link = &code_threads_; *link; link = &(*link)->next) {
+        if (*link == thread) {
+            *link = thread->next;
+            break;
+        }
+    }
+    delete thread;
+}
+
+void JITCodeHeap::publish_entered_epoch(CodeThread* thread) {
+    // Publish, then re-read: a reclaimer that missed our store must have
+    // advanced the epoch first, so we never announce an epoch older than a
+    // retirement the reclaimer has already judged
+    uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+    for (;;) {
+        thread->entered_epoch.store(epoch, std::memory_order_seq_cst);
+        uint64_t current = epoch_.load(std::memory_order_seq_cst);
+        if (current == epoch) break;
+        epoch = current;
+    }
+}
+
+void JITCodeHeap::enter_code() {
+    CodeThread* thread = current_code_thread();
+    if (thread->depth++ > 0) return;
+    publish_entered_epoch(thread);
+}
+
+void JITCodeHeap::leave_code() {
+    CodeThread* thread = static_cast<CodeThread*>(tls_code_thread.thread);
+    if (!thread) return;
+    if (thread->depth > 0 && --thread->depth > 0) return;
+
+    thread->entered_epoch.store(0, std::memory_order_seq_cst);
+    if (retired_count_.load(std::memory_order_acquire) > 0) {
+        reclaim_retired();
+    }
+}
+
+void JITCodeHeap::quiescent() {
+    CodeThread* thread = static_cast<CodeThread*>(tls_code_thread.thread);
+    // Nested regions still have JIT frames below them
+    if (!thread || thread->depth != 1) return;
+
+    publish_entered_epoch(thread);
+    if (retired_count_.load(std::memory_order_acquire) > 0) {
+        reclaim_retired();
+    }
+}
+
+void JITCodeHeap::protect_chunk(JITCodeChunk* chunk, int prot) {
+    if (mprotect(chunk->exec_base, chunk->size, prot) != 0) {
+        std::cerr << "[JIT_HEAP] mprotect failed for chunk '" << chunk->owner << "'" << std::endl;
+    }
+}
+
+void JITCodeHeap::begin_write(JITCodeChunk* chunk) {
+    if (!chunk || dual_mapping_available_) return;
+    protect_chunk(chunk, PROT_READ | PROT_WRITE);
+}
+
+void JITCodeHeap::end_write(JITCodeChunk* chunk) {
+    if (!chunk) return;
+    if (!dual_mapping_available_) {
+        protect_chunk(chunk, PROT_READ | PROT_EXEC);
+    }
+    // x86 keeps the icache coherent, other targets need the explicit flush
+    __builtin___clear_cache(reinterpret_cast<char*>(chunk->exec_base),
+                            reinterpret_cast<char*>(chunk->exec_base + chunk->size));
+}
+
+void JITCodeHeap::write_code(JITCodeChunk* chunk, const uint8_t* code, size_t size) {
+    if (!chunk || size > chunk->size) {
+        std::cerr << "[JIT_HEAP] Code does not fit in chunk" << std::endl;
+        return;
+    }
+    begin_write(chunk);
+    std::memcpy(chunk->write_base, code, size);
+    std::memset(chunk->write_base + size, TRAP_BYTE, chunk->size - size);
+    end_write(chunk);
+}
+
+JITCodeChunk* JITCodeHeap::find_chunk(const void* exec_addr) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_chunk_locked(exec_addr);
+}
+
+JITCodeChunk* JITCodeHeap::find_chunk_locked(const void* exec_addr) const {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(exec_addr);
+    auto it = chunks_.upper_bound(addr);
+    if (it == chunks_.begin()) {
+        return nullptr;
+    }
+    --it;
+    return it->second->contains(exec_addr) ? it->second.get() : nullptr;
+}
+
+JITCodeHeap::Stats JITCodeHeap::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void JITCodeHeap::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Segment& segment : segments_) {
+        munmap(segment.exec_base, segment.size);
+        if (segment.dual_mapped) {
+            munmap(segment.write_base, segment.size);
+        }
+        if (segment.fd >= 0) {
+            close(segment.fd);
+        }
+    }
+    segments_.clear();
+    chunks_.clear();
+    retired_.clear();
+    retired_count_.store(0, std::memory_order_release);
+    stats_ = Stats();
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+void __jit_code_retire(void* exec_addr) {
+    JITCodeHeap::instance().retire_code_at(exec_addr);
+}
+
+size_t __jit_code_reclaim() {
+    return JITCodeHeap::instance().reclaim_retired();
+}
+
+}
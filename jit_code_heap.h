@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// JIT CODE HEAP - Per-function executable memory with W^X dual mapping
+// ============================================================================
+//
+// Code is carved out of large segments (2MB multiples, optionally backed by
+// huge pages to cut iTLB misses). Each segment is mapped twice from the same
+// memfd: once RX for execution and once RW for emitting and patching, so the
+// compiler never has to flip protections with mprotect. If memfd mapping is
+// unavailable the heap falls back to page-aligned chunks and per-chunk
+// mprotect toggling inside begin_write()/end_write().
+//
+// Chunks are released individually so lazily compiled, tiered-up or hot
+// reloaded functions can give their old code back. Code that may still be
+// running on another goroutine should be retire()d once nothing calls it any
+// more, and is reclaimed when no thread can be executing it.
+//
+// That point is found with epochs. Threads bracket every run of JIT code
+// with enter_code()/leave_code() (JITCodeRegion), which records the global
+// epoch the thread entered at. retire() stamps the chunk with the current
+// epoch and advances it. A retired chunk is free once every thread still in
+// JIT code entered after it was stamped; the last thread to leave JIT code
+// reclaims whatever that frees.
+//
+// Regions are entered where the runtime dispatches into JIT code: the main
+// program, each HTTP callback and each goroutine task (jit_call_guarded).
+// Goroutine workers hold one region across a run of tasks and call
+// quiescent() between them, which moves the thread to the current epoch as
+// if it had left and re-entered.
+
+struct JITCodeChunk {
+    uint8_t* exec_base = nullptr;   // RX view - addresses the CPU executes
+    uint8_t* write_base = nullptr;  // RW view - where code is emitted and patched
+    size_t size = 0;                // Usable bytes (rounded to chunk alignment)
+    size_t segment_index = 0;
+    std::string owner;              // Function name or "__program" for debugging/profiling
+
+    // Translate an address inside the RX view to its RW alias
+    uint8_t* writable(const void* exec_addr) const {
+        return write_base + (static_cast<const uint8_t*>(exec_addr) - exec_base);
+    }
+    bool contains(const void* exec_addr) const {
+        const uint8_t* p = static_cast<const uint8_t*>(exec_addr);
+        return p >= exec_base && p < exec_base + size;
+    }
+};
+
+class JITCodeHeap {
+public:
+    struct Stats {
+        size_t reserved_bytes = 0;   // Total bytes mapped for code segments
+        size_t used_bytes = 0;       // Bytes currently handed out to chunks
+        size_t live_chunks = 0;
+        size_t released_chunks = 0;
+        size_t retired_chunks = 0;   // Waiting for every thread to leave older JIT code
+        size_t segments = 0;
+        bool dual_mapped = false;
+        bool huge_pages = false;
+    };
+
+    static constexpr size_t SEGMENT_ALIGNMENT = 2 * 1024 * 1024;  // 2MB huge page size
+    static constexpr size_t DEFAULT_SEGMENT_SIZE = 8 * 1024 * 1024;
+    static constexpr size_t CHUNK_ALIGNMENT = 64;                  // Cache line aligned entry points
+    static constexpr uint8_t TRAP_BYTE = 0xCC;                     // int3 fill for unused/freed code
+
+    static JITCodeHeap& instance();
+
+    // Allocation and reclamation
+    JITCodeChunk* allocate(size_t size, const std::string& owner = "");
+    void release(JITCodeChunk* chunk);   // Immediately reusable - caller guarantees no thread runs it
+    void retire(JITCodeChunk* chunk);    // Deferred release for code that may still be executing
+    bool retire_code_at(const void* exec_addr);  // Retire the chunk containing exec_addr
+    size_t reclaim_retired();            // Release the retired chunks no thread can be running, returns count
+
+    // Bracket a thread's execution of JIT code; calls nest
+    void enter_code();
+    void leave_code();
+    // Called in the outermost region with no JIT frames on the thread's stack
+    void quiescent();
+
+    // Write access. No-ops when dual mapped; mprotect toggling in fallback mode.
+    void begin_write(JITCodeChunk* chunk);
+    void end_write(JITCodeChunk* chunk);
+
+    // Copy code into a chunk and make it executable
+    void write_code(JITCodeChunk* chunk, const uint8_t* code, size_t size);
+
+    // Lookup
+    JITCodeChunk* find_chunk(const void* exec_addr) const;
+
+    // Configuration - must be set before the first allocation to take effect
+    void set_use_huge_pages(bool enable) { use_huge_pages_ = enable; }
+    void set_segment_size(size_t bytes);
+    bool is_dual_mapped() const { return dual_mapping_available_; }
+
+    Stats get_stats() const;
+
+    // Unmap everything (process shutdown / tests)
+    void shutdown();
+
+private:
+    struct Segment {
+        uint8_t* exec_base = nullptr;
+        uint8_t* write_base = nullptr;   // Same as exec_base in fallback mode
+        size_t size = 0;
+        int fd = -1;
+        bool dual_mapped = false;
+        bool huge_pages = false;
+        std::map<size_t, size_t> free_blocks;  // offset -> length, coalesced on release
+    };
+
+    struct RetiredChunk {
+        JITCodeChunk* chunk;
+        uint64_t epoch;                  // Threads that entered code at or before this may run it
+    };
+
+    // One per thread that ever entered JIT code
+    struct CodeThread {
+        std::atomic<uint64_t> entered_epoch{0};  // 0 while outside JIT code
+        unsigned depth = 0;                      // Only touched by the owning thread
+        CodeThread* next = nullptr;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Segment> segments_;
+    std::map<uintptr_t, std::unique_ptr<JITCodeChunk>> chunks_;  // exec_base -> chunk
+    std::vector<RetiredChunk> retired_;
+    std::atomic<size_t> retired_count_{0};  // Lets leave_code() skip the lock when nothing is retired
+    std::atomic<uint64_t> epoch_{1};
+    CodeThread* code_threads_ = nullptr;
+    size_t segment_size_ = DEFAULT_SEGMENT_SIZE;
+    size_t page_size_ = 4096;
+    bool use_huge_pages_ = false;
+    bool dual_mapping_available_ = true;
+    Stats stats_;
+
+    friend struct JITCodeThreadHolder;
+
+    JITCodeHeap();
+    ~JITCodeHeap();
+    JITCodeHeap(const JITCodeHeap&) = delete;
+    JITCodeHeap& operator=(const JITCodeHeap&) = delete;
+
+    bool map_segment(size_t min_size);
+    bool map_dual_segment(Segment& segment);
+    bool map_fallback_segment(Segment& segment);
+    bool carve_from_segment(Segment& segment, size_t size, size_t& offset_out);
+    void release_locked(JITCodeChunk* chunk);
+    void retire_locked(JITCodeChunk* chunk);
+    JITCodeChunk* find_chunk_locked(const void* exec_addr) const;
+    CodeThread* current_code_thread();
+    void publish_entered_epoch(CodeThread* thread);
+    void remove_code_thread(CodeThread* thread);
+    void protect_chunk(JITCodeChunk* chunk, int prot);
+    size_t round_chunk_size(size_t size) const;
+};
+
+// Scope in which the calling thread may execute JIT code
+class JITCodeRegion {
+public:
+    JITCodeRegion() { JITCodeHeap::instance().enter_code(); }
+    ~JITCodeRegion() { JITCodeHeap::instance().leave_code(); }
+    JITCodeRegion(const JITCodeRegion&) = delete;
+    JITCodeRegion& operator=(const JITCodeRegion&) = delete;
+};
+
+// C API for runtime components that hot-swap code (lazy compilation, tier-up)
+extern "C" {
+    void __jit_code_retire(void* exec_addr);
+    size_t __jit_code_reclaim();
+}
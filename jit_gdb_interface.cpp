@@ -0,0 +1,226 @@
+#include "jit_gdb_interface.h"
+#include <elf.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// ============================================================================
+// GDB HOOKS
+// ============================================================================
+//
+// gdb looks these up by name and sets a breakpoint on the function, so they
+// need C linkage, default visibility and must not be inlined or folded away.
+
+extern "C" {
+
+struct jit_descriptor __jit_debug_descriptor = {1, JIT_NOACTION, nullptr, nullptr};
+
+void __attribute__((noinline, used)) __jit_debug_register_code() {
+    __asm__ __volatile__("" ::: "memory");
+}
+
+void __jit_gdb_enable() {
+    GDBJITInterface::instance().enable();
+}
+
+}
+
+// ============================================================================
+// ELF SYMBOL FILE
+// ============================================================================
+
+namespace {
+
+enum SectionIndex : uint16_t {
+    SECTION_NULL = 0,
+    SECTION_TEXT,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+    SECTION_COUNT
+};
+
+// Append a null-terminated string to a string table, returning its offset
+uint32_t add_string(std::vector<char>& table, const std::string& value) {
+    uint32_t offset = static_cast<uint32_t>(table.size());
+    table.insert(table.end(), value.begin(), value.end());
+    table.push_back('\0');
+    return offset;
+}
+
+template <typename T>
+void append_bytes(std::vector<uint8_t>& out, const T* data, size_t count) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+}
+
+void align_to(std::vector<uint8_t>& out, size_t alignment) {
+    while (out.size() % alignment != 0) {
+        out.push_back(0);
+    }
+}
+
+}  // namespace
+
+std::vector<uint8_t> GDBJITInterface::build_symbol_file(uintptr_t code_start, size_t code_size,
+                                                        const std::vector<JITSymbol>& symbols) {
+    // Section names
+    std::vector<char> shstrtab(1, '\0');
+    uint32_t text_name = add_string(shstrtab, ".text");
+    uint32_t symtab_name = add_string(shstrtab, ".symtab");
+    uint32_t strtab_name = add_string(shstrtab, ".strtab");
+    uint32_t shstrtab_name = add_string(shstrtab, ".shstrtab");
+
+    // Symbols are relative to .text, whose sh_addr is the real code address
+    std::vector<char> strtab(1, '\0');
+    std::vector<Elf64_Sym> symtab(1);  // Index 0 is the mandatory null symbol
+    for (const JITSymbol& symbol : symbols) {
+        if (symbol.start < code_start || symbol.start >= code_start + code_size) continue;
+        Elf64_Sym sym{};
+        sym.st_name = add_string(strtab, symbol.name);
+        sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+        sym.st_other = STV_DEFAULT;
+        sym.st_shndx = SECTION_TEXT;
+        sym.st_value = symbol.start - code_start;
+        sym.st_size = symbol.size;
+        symtab.push_back(sym);
+    }
+
+    std::vector<uint8_t> image(sizeof(Elf64_Ehdr), 0);
+
+    align_to(image, 8);
+    size_t symtab_offset = image.size();
+    append_bytes(image, symtab.data(), symtab.size());
+    size_t strtab_offset = image.size();
+    append_bytes(image, strtab.data(), strtab.size());
+    size_t shstrtab_offset = image.size();
+    append_bytes(image, shstrtab.data(), shstrtab.size());
+
+    align_to(image, 8);
+    size_t section_headers_offset = image.size();
+    Elf64_Shdr sections[SECTION_COUNT] = {};
+
+    sections[SECTION_TEXT].sh_name = text_name;
+    sections[SECTION_TEXT].sh_type = SHT_NOBITS;  // Code stays where it is
+    sections[SECTION_TEXT].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+    sections[SECTION_TEXT].sh_addr = code_start;
+    sections[SECTION_TEXT].sh_size = code_size;
+    sections[SECTION_TEXT].sh_addralign = 16;
+
+    sections[SECTION_SYMTAB].sh_name = symtab_name;
+    sections[SECTION_SYMTAB].sh_type = SHT_SYMTAB;
+    sections[SECTION_SYMTAB].sh_offset = symtab_offset;
+    sections[SECTION_SYMTAB].sh_size = symtab.size() * sizeof(Elf64_Sym);
+    sections[SECTION_SYMTAB].sh_link = SECTION_STRTAB;
+    sections[SECTION_SYMTAB].sh_info = 1;  // First non-local symbol
+    sections[SECTION_SYMTAB].sh_addralign = 8;
+    sections[SECTION_SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+
+    sections[SECTION_STRTAB].sh_name = strtab_name;
+    sections[SECTION_STRTAB].sh_type = SHT_STRTAB;
+    sections[SECTION_STRTAB].sh_offset = strtab_offset;
+    sections[SECTION_STRTAB].sh_size = strtab.size();
+    sections[SECTION_STRTAB].sh_addralign = 1;
+
+    sections[SECTION_SHSTRTAB].sh_name = shstrtab_name;
+    sections[SECTION_SHSTRTAB].sh_type = SHT_STRTAB;
+    sections[SECTION_SHSTRTAB].sh_offset = shstrtab_offset;
+    sections[SECTION_SHSTRTAB].sh_size = shstrtab.size();
+    sections[SECTION_SHSTRTAB].sh_addralign = 1;
+
+    append_bytes(image, sections, SECTION_COUNT);
+
+    Elf64_Ehdr header{};
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_NONE;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = section_headers_offset;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = SECTION_COUNT;
+    header.e_shstrndx = SECTION_SHSTRTAB;
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    return image;
+}
+
+// ============================================================================
+// REGISTRATION
+// ============================================================================
+
+GDBJITInterface& GDBJITInterface::instance() {
+    // Leaked: the descriptor must keep pointing at valid entries until exit
+    static GDBJITInterface* gdb_interface = new GDBJITInterface();
+    return *gdb_interface;
+}
+
+GDBJITInterface::GDBJITInterface() {
+    const char* env = std::getenv("ULTRASCRIPT_GDB_JIT");
+    if (env && env[0] == '1') {
+        enabled_ = true;
+    }
+}
+
+void GDBJITInterface::register_code(uintptr_t code_start, size_t code_size, const std::vector<JITSymbol>& symbols) {
+    if (!enabled_) return;
+
+    auto* registration = new Registration{code_start, new jit_code_entry{}, build_symbol_file(code_start, code_size, symbols)};
+    jit_code_entry* entry = registration->entry;
+    entry->symfile_addr = reinterpret_cast<const char*>(registration->image.data());
+    entry->symfile_size = registration->image.size();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry->next_entry = __jit_debug_descriptor.first_entry;
+    if (entry->next_entry) {
+        entry->next_entry->prev_entry = entry;
+    }
+    __jit_debug_descriptor.first_entry = entry;
+    __jit_debug_descriptor.relevant_entry = entry;
+    __jit_debug_descriptor.action_flag = JIT_REGISTER_FN;
+    __jit_debug_register_code();
+
+    registrations_.push_back(registration);
+}
+
+void GDBJITInterface::unlink_entry(jit_code_entry* entry) {
+    if (entry->prev_entry) {
+        entry->prev_entry->next_entry = entry->next_entry;
+    } else {
+        __jit_debug_descriptor.first_entry = entry->next_entry;
+    }
+    if (entry->next_entry) {
+        entry->next_entry->prev_entry = entry->prev_entry;
+    }
+    __jit_debug_descriptor.relevant_entry = entry;
+    __jit_debug_descriptor.action_flag = JIT_UNREGISTER_FN;
+    __jit_debug_register_code();
+}
+
+void GDBJITInterface::unregister_code(uintptr_t code_start, size_t code_size) {
+    if (!enabled_) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = registrations_.begin();
+    while (it != registrations_.end()) {
+        Registration* registration = *it;
+        if (registration->code_start >= code_start && registration->code_start < code_start + code_size) {
+            unlink_entry(registration->entry);
+            delete registration->entry;
+            delete registration;
+            it = registrations_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t GDBJITInterface::registered_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return registrations_.size();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "jit_symbols.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// GDB JIT INTERFACE - Function symbols for JIT code in gdb and core dumps
+// ============================================================================
+//
+// Implements the debugger side of the GDB JIT compilation interface. For each
+// registered code block an in-memory ELF object is built carrying a NOBITS
+// .text section at the block's address and one STT_FUNC symbol per function.
+// The object is linked into __jit_debug_descriptor and announced through
+// __jit_debug_register_code(), on which gdb keeps a breakpoint. The objects
+// live in process memory, so they are also found in core dumps.
+//
+// Disabled by default: set ULTRASCRIPT_GDB_JIT=1 (or call __jit_gdb_enable()
+// before code is compiled). When disabled, registration is a single branch.
+
+// Layout fixed by gdb (gdb/jit.h)
+extern "C" {
+    typedef enum {
+        JIT_NOACTION = 0,
+        JIT_REGISTER_FN,
+        JIT_UNREGISTER_FN
+    } jit_actions_t;
+
+    struct jit_code_entry {
+        struct jit_code_entry* next_entry;
+        struct jit_code_entry* prev_entry;
+        const char* symfile_addr;
+        uint64_t symfile_size;
+    };
+
+    struct jit_descriptor {
+        uint32_t version;
+        uint32_t action_flag;  // jit_actions_t
+        struct jit_code_entry* relevant_entry;
+        struct jit_code_entry* first_entry;
+    };
+
+    extern struct jit_descriptor __jit_debug_descriptor;
+    void __jit_debug_register_code();
+
+    void __jit_gdb_enable();
+}
+
+class GDBJITInterface {
+public:
+    static GDBJITInterface& instance();
+
+    bool is_enabled() const { return enabled_; }
+    void enable() { enabled_ = true; }
+
+    // Build and announce a symbol file for one code block
+    void register_code(uintptr_t code_start, size_t code_size, const std::vector<JITSymbol>& symbols);
+    // Remove every symbol file whose code starts inside [code_start, code_start + code_size)
+    void unregister_code(uintptr_t code_start, size_t code_size);
+
+    size_t registered_count() const;
+
+    // In-memory ELF64 relocatable object describing the code block
+    static std::vector<uint8_t> build_symbol_file(uintptr_t code_start, size_t code_size,
+                                                  const std::vector<JITSymbol>& symbols);
+
+private:
+    struct Registration {
+        uintptr_t code_start;
+        jit_code_entry* entry;
+        std::vector<uint8_t> image;
+    };
+
+    mutable std::mutex mutex_;
+    bool enabled_ = false;
+    std::vector<Registration*> registrations_;
+
+    GDBJITInterface();
+    void unlink_entry(jit_code_entry* entry);
+};
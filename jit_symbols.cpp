@@ -0,0 +1,344 @@
+#include "jit_symbols.h"
+#include "jit_gdb_interface.h"
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+// ============================================================================
+// SYMBOL TABLE
+// ============================================================================
+
+JITSymbolTable& JITSymbolTable::instance() {
+    // Leaked for the same reason as the code heap: samples and crash handlers
+    // may look up symbols while static destructors run
+    static JITSymbolTable* table = new JITSymbolTable();
+    return *table;
+}
+
+static bool is_function_label(const std::string& name) {
+    // Control-flow labels generated inside function bodies
+    static const char* const internal_prefixes[] = {
+        "func_already_init_", "function_call_continue_", "function_type_error_",
+        "try_", "case_", "switch_", "__switch_", "__main_epilogue",
+    };
+    for (const char* prefix : internal_prefixes) {
+        if (name.compare(0, std::strlen(prefix), prefix) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<JITSymbol> JITSymbolTable::symbols_from_labels(uintptr_t code_base, size_t code_size,
+                                                           const std::unordered_map<std::string, int64_t>& label_offsets,
+                                                           std::vector<size_t> function_starts) {
+    std::sort(function_starts.begin(), function_starts.end());
+    function_starts.erase(std::unique(function_starts.begin(), function_starts.end()), function_starts.end());
+
+    std::unordered_map<size_t, std::string> names;
+    for (const auto& label : label_offsets) {
+        if (label.second < 0 || !is_function_label(label.first)) continue;
+        size_t offset = static_cast<size_t>(label.second);
+        auto it = names.find(offset);
+        // Several labels can share an entry point; keep the one that sorts first for stable output
+        if (it == names.end() || label.first < it->second) {
+            names[offset] = label.first;
+        }
+    }
+
+    std::vector<JITSymbol> symbols;
+    for (size_t i = 0; i < function_starts.size(); i++) {
+        size_t start = function_starts[i];
+        size_t end = (i + 1 < function_starts.size()) ? function_starts[i + 1] : code_size;
+        if (start >= end) continue;
+
+        JITSymbol symbol;
+        symbol.start = code_base + start;
+        symbol.size = end - start;
+        auto it = names.find(start);
+        symbol.name = (it != names.end()) ? it->second : "jit_code_" + std::to_string(start);
+        symbols.push_back(std::move(symbol));
+    }
+    return symbols;
+}
+
+void JITSymbolTable::add_code(uintptr_t code_start, size_t code_size, const std::vector<JITSymbol>& symbols,
+                              const uint8_t* code_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Anything previously registered in this range is stale
+        auto it = symbols_.lower_bound(code_start);
+        while (it != symbols_.end() && it->first < code_start + code_size) {
+            it = symbols_.erase(it);
+        }
+        for (const JITSymbol& symbol : symbols) {
+            symbols_[symbol.start] = symbol;
+        }
+    }
+
+    GDBJITInterface& gdb = GDBJITInterface::instance();
+    if (gdb.is_enabled()) {
+        gdb.unregister_code(code_start, code_size);
+        gdb.register_code(code_start, code_size, symbols);
+    }
+
+    JITPerfMap& perf = JITPerfMap::instance();
+    if (perf.is_enabled()) {
+        for (const JITSymbol& symbol : symbols) {
+            const uint8_t* bytes = code_bytes ? code_bytes + (symbol.start - code_start) : nullptr;
+            perf.record_code_load(symbol, bytes);
+        }
+    }
+}
+
+void JITSymbolTable::remove_code(uintptr_t code_start, size_t code_size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = symbols_.lower_bound(code_start);
+        while (it != symbols_.end() && it->first < code_start + code_size) {
+            it = symbols_.erase(it);
+        }
+    }
+    GDBJITInterface::instance().unregister_code(code_start, code_size);
+}
+
+bool JITSymbolTable::lookup(uintptr_t pc, JITSymbol& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = symbols_.upper_bound(pc);
+    if (it == symbols_.begin()) return false;
+    --it;
+    if (!it->second.contains(pc)) return false;
+    out = it->second;
+    return true;
+}
+
+std::vector<JITSymbol> JITSymbolTable::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<JITSymbol> result;
+    result.reserve(symbols_.size());
+    for (const auto& entry : symbols_) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+std::string symbolize_code_address(uintptr_t pc) {
+    JITSymbol symbol;
+    if (JITSymbolTable::instance().lookup(pc, symbol)) {
+        return symbol.name;
+    }
+
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void*>(pc), &info) && info.dli_fname) {
+        if (info.dli_sname) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = (status == 0 && demangled) ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+        const char* module = std::strrchr(info.dli_fname, '/');
+        std::ostringstream out;
+        out << "[" << (module ? module + 1 : info.dli_fname) << "+0x" << std::hex
+            << (pc - reinterpret_cast<uintptr_t>(info.dli_fbase)) << "]";
+        return out.str();
+    }
+
+    std::ostringstream out;
+    out << "[unknown 0x" << std::hex << pc << "]";
+    return out.str();
+}
+
+// ============================================================================
+// PERF MAP / JITDUMP
+// ============================================================================
+
+// jitdump format constants (tools/perf/util/jitdump.h)
+static constexpr uint32_t JITDUMP_MAGIC = 0x4A695444;
+static constexpr uint32_t JITDUMP_VERSION = 1;
+static constexpr uint32_t JITDUMP_ELF_MACH_X86_64 = 62;
+static constexpr uint32_t JIT_CODE_LOAD = 0;
+static constexpr uint32_t JIT_CODE_CLOSE = 3;
+
+struct JitdumpFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+};
+
+struct JitdumpRecordHeader {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+};
+
+struct JitdumpCodeLoad {
+    JitdumpRecordHeader header;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+    // Followed by the null-terminated name and the code bytes
+};
+
+// perf record -k 1 uses CLOCK_MONOTONIC, so jitdump timestamps must match
+static uint64_t jitdump_timestamp() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+JITPerfMap& JITPerfMap::instance() {
+    static JITPerfMap* perf_map = new JITPerfMap();
+    return *perf_map;
+}
+
+JITPerfMap::JITPerfMap() {
+    const char* map = std::getenv("ULTRASCRIPT_PERF_MAP");
+    if (map && map[0] == '1') {
+        enable_perf_map();
+    }
+    const char* dump = std::getenv("ULTRASCRIPT_JITDUMP");
+    if (dump && dump[0] == '1') {
+        enable_jitdump();
+    }
+}
+
+void JITPerfMap::enable_perf_map() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (perf_map_file_) return;
+
+    std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+    perf_map_file_ = std::fopen(path.c_str(), "w");
+    if (!perf_map_file_) {
+        std::cerr << "[JIT_PERF] Failed to open " << path << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+    // Line buffered so the map is usable even if the process dies
+    setvbuf(perf_map_file_, nullptr, _IOLBF, 0);
+    std::cout << "[JIT_PERF] Writing perf map to " << path << std::endl;
+}
+
+void JITPerfMap::enable_jitdump() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jitdump_file_) return;
+
+    std::string path = "/tmp/jit-" + std::to_string(getpid()) + ".dump";
+    jitdump_file_ = std::fopen(path.c_str(), "w+");
+    if (!jitdump_file_) {
+        std::cerr << "[JIT_PERF] Failed to open " << path << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    write_jitdump_header();
+
+    // perf finds the dump through an executable mapping of the file in the
+    // recorded process, so keep one page of it mapped for the process lifetime
+    long page = sysconf(_SC_PAGESIZE);
+    void* marker = mmap(nullptr, static_cast<size_t>(page), PROT_READ | PROT_EXEC, MAP_PRIVATE,
+                        fileno(jitdump_file_), 0);
+    if (marker == MAP_FAILED) {
+        std::cerr << "[JIT_PERF] Failed to map " << path << ": " << std::strerror(errno) << std::endl;
+        std::fclose(jitdump_file_);
+        jitdump_file_ = nullptr;
+        return;
+    }
+    jitdump_marker_ = marker;
+    std::cout << "[JIT_PERF] Writing jitdump to " << path << std::endl;
+}
+
+void JITPerfMap::write_jitdump_header() {
+    JitdumpFileHeader header{};
+    header.magic = JITDUMP_MAGIC;
+    header.version = JITDUMP_VERSION;
+    header.total_size = sizeof(header);
+    header.elf_mach = JITDUMP_ELF_MACH_X86_64;
+    header.pid = static_cast<uint32_t>(getpid());
+    header.timestamp = jitdump_timestamp();
+    std::fwrite(&header, sizeof(header), 1, jitdump_file_);
+    std::fflush(jitdump_file_);
+}
+
+void JITPerfMap::record_code_load(const JITSymbol& symbol, const uint8_t* code_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string name = "gts:" + symbol.name;
+
+    if (perf_map_file_) {
+        std::fprintf(perf_map_file_, "%lx %zx %s\n", static_cast<unsigned long>(symbol.start),
+                     symbol.size, name.c_str());
+    }
+
+    if (jitdump_file_) {
+        JitdumpCodeLoad record{};
+        size_t code_size = code_bytes ? symbol.size : 0;
+        record.header.id = JIT_CODE_LOAD;
+        record.header.total_size = static_cast<uint32_t>(sizeof(record) + name.size() + 1 + code_size);
+        record.header.timestamp = jitdump_timestamp();
+        record.pid = static_cast<uint32_t>(getpid());
+        record.tid = static_cast<uint32_t>(syscall(SYS_gettid));
+        record.vma = symbol.start;
+        record.code_addr = symbol.start;
+        record.code_size = code_size;
+        record.code_index = next_code_index_++;
+        std::fwrite(&record, sizeof(record), 1, jitdump_file_);
+        std::fwrite(name.c_str(), name.size() + 1, 1, jitdump_file_);
+        if (code_size) {
+            std::fwrite(code_bytes, code_size, 1, jitdump_file_);
+        }
+        std::fflush(jitdump_file_);
+    }
+}
+
+void JITPerfMap::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (jitdump_file_) {
+        JitdumpRecordHeader close_record{JIT_CODE_CLOSE, sizeof(JitdumpRecordHeader), jitdump_timestamp()};
+        std::fwrite(&close_record, sizeof(close_record), 1, jitdump_file_);
+        std::fclose(jitdump_file_);
+        jitdump_file_ = nullptr;
+    }
+    if (jitdump_marker_) {
+        munmap(jitdump_marker_, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+        jitdump_marker_ = nullptr;
+    }
+    if (perf_map_file_) {
+        std::fclose(perf_map_file_);
+        perf_map_file_ = nullptr;
+    }
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+void __jit_perf_map_enable() {
+    JITPerfMap::instance().enable_perf_map();
+}
+
+void __jit_jitdump_enable() {
+    JITPerfMap::instance().enable_jitdump();
+}
+
+void __jit_perf_map_finish() {
+    JITPerfMap::instance().shutdown();
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// JIT SYMBOLS - Names for code placed in executable memory
+// ============================================================================
+//
+// Every block of JIT code registers the functions it contains here. The table
+// answers "which script function is at this PC" for the profiler, registers
+// symbol files with gdb (see jit_gdb_interface.h) and feeds the Linux perf
+// integrations:
+//
+//   ULTRASCRIPT_PERF_MAP=1   append "start size name" lines to /tmp/perf-<pid>.map
+//   ULTRASCRIPT_JITDUMP=1    write /tmp/jit-<pid>.dump (jitdump v1, with code
+//                            bytes) for `perf inject --jit`; record with -k 1
+//
+// Both files are append-only: recompiled functions get a new entry and perf
+// uses the most recent one covering an address.
+
+struct JITSymbol {
+    uintptr_t start = 0;
+    size_t size = 0;
+    std::string name;
+
+    bool contains(uintptr_t pc) const { return pc >= start && pc < start + size; }
+};
+
+class JITSymbolTable {
+public:
+    static JITSymbolTable& instance();
+
+    // Split a block of program code into function symbols. Function entry
+    // points are the prologue offsets recorded by the code generator; each
+    // symbol extends to the next entry point (or the end of the code) and is
+    // named after a label defined at its entry.
+    static std::vector<JITSymbol> symbols_from_labels(uintptr_t code_base, size_t code_size,
+                                                      const std::unordered_map<std::string, int64_t>& label_offsets,
+                                                      std::vector<size_t> function_starts);
+
+    // Register the symbols of one code block. code_bytes (optional) points at
+    // the executable copy and is used for jitdump.
+    void add_code(uintptr_t code_start, size_t code_size, const std::vector<JITSymbol>& symbols,
+                  const uint8_t* code_bytes = nullptr);
+    void remove_code(uintptr_t code_start, size_t code_size);
+
+    // Symbol covering pc; returns false for non-JIT addresses
+    bool lookup(uintptr_t pc, JITSymbol& out) const;
+    std::vector<JITSymbol> snapshot() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<uintptr_t, JITSymbol> symbols_;  // Keyed by start address
+
+    JITSymbolTable() = default;
+};
+
+// Name of any code address: the JIT symbol covering it, else the demangled
+// dynamic symbol, else module+offset
+std::string symbolize_code_address(uintptr_t pc);
+
+class JITPerfMap {
+public:
+    static JITPerfMap& instance();
+
+    void enable_perf_map();
+    void enable_jitdump();
+    bool is_enabled() const { return perf_map_file_ != nullptr || jitdump_file_ != nullptr; }
+
+    // Append one function to the enabled outputs
+    void record_code_load(const JITSymbol& symbol, const uint8_t* code_bytes);
+
+    // Writes the jitdump close record and closes both files
+    void shutdown();
+
+private:
+    std::mutex mutex_;
+    FILE* perf_map_file_ = nullptr;
+    FILE* jitdump_file_ = nullptr;
+    void* jitdump_marker_ = nullptr;  // PROT_EXEC mapping of the dump that tells perf where to find it
+    uint64_t next_code_index_ = 0;
+
+    JITPerfMap();
+    void write_jitdump_header();
+};
+
+extern "C" {
+    // Enable perf outputs at runtime (equivalent to the environment variables)
+    void __jit_perf_map_enable();
+    void __jit_jitdump_enable();
+    // Closes the perf outputs at program exit
+    void __jit_perf_map_finish();
+}
@@ -0,0 +1,300 @@
+#include "object_refcount.h"
+#include "cycle_collector.h"
+#include "dynamic_properties.h"
+#include "gc_heap.h"
+#include "runtime.h"
+#include <algorithm>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// Read by JIT code through %fs, so it must sit in the static TLS block
+static thread_local ObjectRefCountOwner* tls_owner __attribute__((tls_model("initial-exec"))) = nullptr;
+static thread_local bool tls_owner_released = false;
+
+// Merges the thread's queue when it exits; objects still biased to it are
+// merged by whichever thread queues them next
+struct ObjectRefCountOwnerHolder {
+    ObjectRefCountOwner* owner = nullptr;
+    ~ObjectRefCountOwnerHolder();
+};
+
+static thread_local ObjectRefCountOwnerHolder tls_owner_holder;
+
+static int64_t& biased_count(void* object) {
+    return *reinterpret_cast<int64_t*>(static_cast<char*>(object) + OBJECT_REF_COUNT_OFFSET);
+}
+
+// Moves the biased count into the shared one and drops the bias; the owner's
+// mutex is held and the owner either is the caller or has exited. True when
+// the total was zero.
+static bool merge_locked(void* object) {
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    int64_t biased = __atomic_load_n(&biased_count(object), __ATOMIC_RELAXED);
+    // Added before the biased count is cleared, so the total never reads low
+    int64_t old = prefix->shared.fetch_add(biased * ObjectRefCountPrefix::ONE + ObjectRefCountPrefix::MERGED);
+    __atomic_store_n(&biased_count(object), 0, __ATOMIC_RELAXED);
+    prefix->owner.store(OBJECT_REF_COUNT_SHARED_OWNER, std::memory_order_release);
+    return (old >> ObjectRefCountPrefix::COUNT_SHIFT) + biased == 0;
+}
+
+static void destroy_all(const std::vector<void*>& dead) {
+    for (void* object : dead) {
+        __object_destruct(object);
+    }
+}
+
+ObjectRefCountOwnerHolder::~ObjectRefCountOwnerHolder() {
+    if (!owner) return;
+    std::vector<void*> dead;
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        owner->alive = false;
+        for (void* object : owner->queued) {
+            if (merge_locked(object)) dead.push_back(object);
+        }
+        owner->queued.clear();
+        owner->has_queued.store(false, std::memory_order_relaxed);
+    }
+    // Leaked: other threads may still find it on objects this thread created
+    tls_owner = nullptr;
+    tls_owner_released = true;
+    owner = nullptr;
+    destroy_all(dead);
+}
+
+static ObjectRefCountOwner* current_owner() {
+    if (!tls_owner && !tls_owner_released) {
+        tls_owner = new ObjectRefCountOwner();
+        tls_owner_holder.owner = tls_owner;
+    }
+    return tls_owner;
+}
+
+int64_t object_ref_count_tls_offset() {
+    uintptr_t thread_pointer;
+    asm("mov %%fs:0, %0" : "=r"(thread_pointer));
+    return static_cast<int64_t>(reinterpret_cast<uintptr_t>(&tls_owner) - thread_pointer);
+}
+
+// ============================================================================
+// ALLOCATION
+// ============================================================================
+
+void* object_ref_count_allocate(size_t size) {
+    char* memory = static_cast<char*>(calloc(1, OBJECT_REF_COUNT_PREFIX_SIZE + size));
+    if (!memory) return nullptr;
+    // Counted against the GC heap's hard limit; past it the caller throws
+    if (!GCHeap::instance().reserve_external_bytes(malloc_usable_size(memory))) {
+        free(memory);
+        return nullptr;
+    }
+    void* object = memory + OBJECT_REF_COUNT_PREFIX_SIZE;
+    ObjectRefCountPrefix* prefix = new (memory) ObjectRefCountPrefix();
+    ObjectRefCountOwner* owner = current_owner();
+    if (owner) {
+        // The owner's own allocations are where it picks up its queue
+        if (owner->has_queued.load(std::memory_order_relaxed)) {
+            object_ref_count_merge_queued();
+        }
+        prefix->owner.store(owner, std::memory_order_relaxed);
+        prefix->shared.store(0, std::memory_order_relaxed);
+        biased_count(object) = 1;
+    } else {
+        // Past TLS teardown: shared from the start
+        prefix->owner.store(OBJECT_REF_COUNT_SHARED_OWNER, std::memory_order_relaxed);
+        prefix->shared.store(ObjectRefCountPrefix::ONE | ObjectRefCountPrefix::MERGED, std::memory_order_relaxed);
+    }
+    return object;
+}
+
+void object_ref_count_free(void* object) {
+    if (!object) return;
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    if (prefix->shared.load(std::memory_order_acquire) & ObjectRefCountPrefix::BUFFERED) {
+        CycleCollector::instance().forget(object);
+    }
+    GCHeap::instance().release_external_bytes(malloc_usable_size(prefix));
+    free(prefix);
+}
+
+// ============================================================================
+// COUNTING
+// ============================================================================
+
+void object_ref_count_retain(void* object) {
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    if (tls_owner && prefix->owner.load(std::memory_order_relaxed) == tls_owner) {
+        biased_count(object)++;
+        return;
+    }
+    prefix->shared.fetch_add(ObjectRefCountPrefix::ONE, std::memory_order_relaxed);
+}
+
+// The owner's biased count just reached zero
+static bool release_biased_zero(void* object) {
+    ObjectRefCountOwner* owner = tls_owner;
+    bool dead;
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        dead = merge_locked(object);
+        auto queued = std::find(owner->queued.begin(), owner->queued.end(), object);
+        if (queued != owner->queued.end()) {
+            owner->queued.erase(queued);
+        }
+    }
+    if (owner->has_queued.load(std::memory_order_relaxed)) {
+        object_ref_count_merge_queued();
+    }
+    return dead;
+}
+
+static bool release_shared(void* object) {
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    for (;;) {
+        ObjectRefCountOwner* owner = prefix->owner.load(std::memory_order_acquire);
+        int64_t shared = prefix->shared.load(std::memory_order_relaxed);
+        // Merged, or biased with the shared count staying non-negative: one CAS
+        while ((shared & ObjectRefCountPrefix::MERGED) || (shared >> ObjectRefCountPrefix::COUNT_SHIFT) > 0) {
+            if (prefix->shared.compare_exchange_weak(shared, shared - ObjectRefCountPrefix::ONE, std::memory_order_acq_rel)) {
+                return (shared & ObjectRefCountPrefix::MERGED) && (shared >> ObjectRefCountPrefix::COUNT_SHIFT) == 1;
+            }
+        }
+        if (owner == OBJECT_REF_COUNT_SHARED_OWNER) continue;
+
+        // Going negative: the owner still holds the rest in its biased count
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        if (prefix->owner.load(std::memory_order_relaxed) != owner) continue;   // Merged meanwhile
+        int64_t old = prefix->shared.fetch_sub(ObjectRefCountPrefix::ONE, std::memory_order_acq_rel);
+        if (!owner->alive) {
+            return merge_locked(object);
+        }
+        if (!(old & ObjectRefCountPrefix::QUEUED)) {
+            prefix->shared.fetch_or(ObjectRefCountPrefix::QUEUED, std::memory_order_relaxed);
+            owner->queued.push_back(object);
+            owner->has_queued.store(true, std::memory_order_relaxed);
+        }
+        return false;
+    }
+}
+
+// A decrement that leaves an object with counted references alive may leave
+// a garbage cycle behind
+static bool may_leave_cycle(void* object) {
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    return prefix->references.load(std::memory_order_relaxed) != 0 &&
+           !(prefix->shared.load(std::memory_order_relaxed) & ObjectRefCountPrefix::BUFFERED);
+}
+
+bool object_ref_count_release(void* object) {
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    if (tls_owner && prefix->owner.load(std::memory_order_relaxed) == tls_owner) {
+        if (--biased_count(object) == 0) {
+            return release_biased_zero(object);
+        }
+        // Only this thread can end a biased object's life, so it is still here
+        if (may_leave_cycle(object)) {
+            CycleCollector::instance().possible_root(object);
+        }
+        return false;
+    }
+    // Another thread may free it once our reference is gone: buffer it first
+    if (may_leave_cycle(object)) {
+        CycleCollector::instance().possible_root(object);
+    }
+    return release_shared(object);
+}
+
+int64_t object_ref_count_total(void* object) {
+    if (!object) return 0;
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    return __atomic_load_n(&biased_count(object), __ATOMIC_RELAXED) +
+           (prefix->shared.load(std::memory_order_acquire) >> ObjectRefCountPrefix::COUNT_SHIFT);
+}
+
+// ============================================================================
+// COUNTED REFERENCES
+// ============================================================================
+
+void object_ref_count_store(void* object, size_t slot, void* value) {
+    void** field = GET_OBJECT_PROPERTY_PTR(object, slot);
+    if (slot >= OBJECT_REF_COUNT_MAX_REFERENCE_SLOTS) {
+        // No mask bit to release it by: a plain store
+        __atomic_store_n(field, value, __ATOMIC_RELEASE);
+        return;
+    }
+    if (value) {
+        object_ref_count_retain(value);
+    }
+    void* old = __atomic_exchange_n(field, value, __ATOMIC_ACQ_REL);
+    uint64_t bit = uint64_t(1) << slot;
+    ObjectRefCountPrefix* prefix = object_ref_count_prefix(object);
+    uint64_t previous = value ? prefix->references.fetch_or(bit, std::memory_order_acq_rel)
+                              : prefix->references.fetch_and(~bit, std::memory_order_acq_rel);
+    // Whatever the slot held before it was counted is not ours to release
+    if (old && (previous & bit) && object_ref_count_release(old)) {
+        __object_destruct(old);
+    }
+}
+
+void object_ref_count_release_references(void* object) {
+    uint64_t slots = object_ref_count_prefix(object)->references.exchange(0, std::memory_order_acq_rel);
+    while (slots) {
+        size_t slot = __builtin_ctzll(slots);
+        slots &= slots - 1;
+        void* child = __atomic_exchange_n(GET_OBJECT_PROPERTY_PTR(object, slot), nullptr, __ATOMIC_ACQ_REL);
+        if (child && object_ref_count_release(child)) {
+            __object_destruct(child);
+        }
+    }
+}
+
+void object_ref_count_merge_queued() {
+    ObjectRefCountOwner* owner = tls_owner;
+    if (!owner || !owner->has_queued.load(std::memory_order_relaxed)) return;
+    std::vector<void*> dead;
+    {
+        std::lock_guard<std::mutex> lock(owner->mutex);
+        for (void* object : owner->queued) {
+            if (merge_locked(object)) dead.push_back(object);
+        }
+        owner->queued.clear();
+        owner->has_queued.store(false, std::memory_order_relaxed);
+    }
+    destroy_all(dead);
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+void __object_set_reference(void* object, int64_t slot, void* value) {
+    if (!object || slot < 0 || slot >= GET_OBJECT_PROPERTY_COUNT(object)) return;
+    object_ref_count_store(object, static_cast<size_t>(slot), value);
+}
+
+void __object_ref_count_possible_root(void* object) {
+    if (may_leave_cycle(object)) {
+        CycleCollector::instance().possible_root(object);
+    }
+}
+
+void __object_ref_count_retain_shared(void* object) {
+    object_ref_count_retain(object);
+}
+
+void __object_ref_count_release_shared(void* object) {
+    if (object_ref_count_release(object)) {
+        __object_destruct(object);
+    }
+}
+
+void __object_ref_count_biased_zero(void* object) {
+    if (release_biased_zero(object)) {
+        __object_destruct(object);
+    }
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "dynamic_properties.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// ============================================================================
+// OBJECT REFERENCE COUNTS - Biased to the creating thread
+// ============================================================================
+//
+// Most class instances are only ever touched by the thread that created them,
+// so their count is split in two (biased reference counting):
+//
+//   - the biased count, at OBJECT_REF_COUNT_OFFSET inside the object, is only
+//     written by the owning thread, with plain inc/dec - no lock prefix
+//   - the shared count, in a prefix in front of the object, takes atomic adds
+//     from every other thread
+//
+// JIT code compares the prefix's owner with the thread's token (one load from
+// %fs) and takes the plain path when they match. The object's total count is
+// biased + shared; the shared part may go negative while biased.
+//
+// The owner merges the two (moves the biased count into the shared one and
+// gives up ownership) when its biased count drops to zero, or when another
+// thread's decrement takes the shared count below zero: that thread queues the
+// object on the owner, which merges its queue the next time it creates an
+// object, takes a slow path or exits. Merged objects are counted on the shared
+// part only, and whoever drops it to zero destroys the object. Objects biased
+// to a thread that exited are merged by the thread that finds them.
+//
+// Only references stored through object_ref_count_store are counted edges of
+// the object graph; the prefix keeps a mask of those slots so the cycle
+// collector (cycle_collector.h) can follow them and a dying object can
+// release them.
+
+struct ObjectRefCountOwner {
+    std::mutex mutex;                    // Guards queued and alive, and merging
+    std::vector<void*> queued;           // Objects whose shared count went negative
+    std::atomic<bool> has_queued{false};
+    bool alive = true;
+};
+
+// Sits right before the object; the allocation starts here
+struct ObjectRefCountPrefix {
+    std::atomic<ObjectRefCountOwner*> owner;
+    std::atomic<int64_t> shared;         // count << COUNT_SHIFT | flags
+    std::atomic<uint64_t> references;    // Property slots holding counted references
+    int64_t cycle_state;                 // Color and trial count, during cycle collections
+
+    static constexpr int64_t MERGED = 1;
+    static constexpr int64_t QUEUED = 2;
+    static constexpr int64_t BUFFERED = 4;   // In the cycle collector's candidate buffer
+    static constexpr int COUNT_SHIFT = 3;
+    static constexpr int64_t ONE = int64_t(1) << COUNT_SHIFT;
+};
+
+static constexpr int64_t OBJECT_REF_COUNT_PREFIX_SIZE = sizeof(ObjectRefCountPrefix);
+static constexpr int64_t OBJECT_REF_COUNT_OWNER_OFFSET = -OBJECT_REF_COUNT_PREFIX_SIZE;   // From the object
+static constexpr int64_t OBJECT_REF_COUNT_SHARED_OFFSET = OBJECT_REF_COUNT_OWNER_OFFSET + 8;
+static constexpr int64_t OBJECT_REF_COUNT_REFERENCES_OFFSET = OBJECT_REF_COUNT_OWNER_OFFSET + 16;
+static constexpr size_t OBJECT_REF_COUNT_MAX_REFERENCE_SLOTS = 64;
+
+// Owner of merged objects: never a thread's token, which is null before the
+// thread creates its first object
+#define OBJECT_REF_COUNT_SHARED_OWNER reinterpret_cast<ObjectRefCountOwner*>(uintptr_t(1))
+
+inline ObjectRefCountPrefix* object_ref_count_prefix(void* object) {
+    return reinterpret_cast<ObjectRefCountPrefix*>(static_cast<char*>(object) - OBJECT_REF_COUNT_PREFIX_SIZE);
+}
+
+// Zeroed object of size bytes, biased to the calling thread with a count of
+// 1; nullptr past the GC heap's hard limit (GCHeap::reserve_external_bytes)
+void* object_ref_count_allocate(size_t size);
+void object_ref_count_free(void* object);
+
+void object_ref_count_retain(void* object);
+// True when this dropped the last reference; the caller destroys the object
+bool object_ref_count_release(void* object);
+// Biased + shared; exact only while no other thread changes it
+int64_t object_ref_count_total(void* object);
+
+// Counted reference in property slot (index < OBJECT_REF_COUNT_MAX_REFERENCE_SLOTS):
+// retains value, then releases what the slot held. The cycle collector
+// follows these slots only.
+void object_ref_count_store(void* object, size_t slot, void* value);
+// Visit the objects referenced from counted slots
+template <typename Visit>
+void object_ref_count_for_each_reference(void* object, Visit visit);
+// Releases every counted reference the object holds; called when it dies
+void object_ref_count_release_references(void* object);
+
+// Merge the objects other threads queued on the calling thread
+void object_ref_count_merge_queued();
+
+// Offset of the thread's owner token from its thread pointer (%fs:0)
+int64_t object_ref_count_tls_offset();
+
+template <typename Visit>
+void object_ref_count_for_each_reference(void* object, Visit visit) {
+    uint64_t slots = object_ref_count_prefix(object)->references.load(std::memory_order_acquire);
+    while (slots) {
+        size_t slot = __builtin_ctzll(slots);
+        slots &= slots - 1;
+        if (void* child = __atomic_load_n(GET_OBJECT_PROPERTY_PTR(object, slot), __ATOMIC_ACQUIRE)) {
+            visit(child);
+        }
+    }
+}
+
+extern "C" {
+    // Counted property store, for JIT code and the runtime
+    void __object_set_reference(void* object, int64_t slot, void* value);
+
+    // JIT slow paths: called when the owner check fails, and by the owner
+    // when its biased count reaches zero. Destroy the object when it dies.
+    void __object_ref_count_retain_shared(void* object);
+    void __object_ref_count_release_shared(void* object);
+    void __object_ref_count_biased_zero(void* object);
+    // The owner's decrement left the biased count above zero
+    void __object_ref_count_possible_root(void* object);
+}
@@ -78,6 +78,17 @@ void Parser::advance() {
     }
 }
 
+// Binary operator a compound assignment applies
+static TokenType compound_assignment_operator(TokenType assign_op) {
+    switch (assign_op) {
+        case TokenType::PLUS_ASSIGN: return TokenType::PLUS;
+        case TokenType::MINUS_ASSIGN: return TokenType::MINUS;
+        case TokenType::MULTIPLY_ASSIGN: return TokenType::MULTIPLY;
+        case TokenType::DIVIDE_ASSIGN: return TokenType::DIVIDE;
+        default: return assign_op;
+    }
+}
+
 bool Parser::match(TokenType type) {
     if (check(type)) {
         advance();
@@ -119,6 +130,7 @@ std::unique_ptr<ExpressionNode> Parser::parse_assignment_expression() {
     if (match(TokenType::ASSIGN) || match(TokenType::PLUS_ASSIGN) ||
         match(TokenType::MINUS_ASSIGN) || match(TokenType::MULTIPLY_ASSIGN) ||
         match(TokenType::DIVIDE_ASSIGN)) {
+        TokenType assign_op = tokens[pos - 1].type;
         
         auto identifier = dynamic_cast<Identifier*>(expr.get());
         auto property_access = dynamic_cast<PropertyAccess*>(expr.get());
@@ -128,6 +140,12 @@ std::unique_ptr<ExpressionNode> Parser::parse_assignment_expression() {
             std::string var_name = identifier->name;
             auto value = parse_assignment_expression();
             
+            // x op= y is x = x op y: for strings, s += x concatenates onto the
+            // running rope and appends in place (GoTSString::concat_rope)
+            if (assign_op != TokenType::ASSIGN) {
+                value = std::make_unique<BinaryOp>(std::move(expr), compound_assignment_operator(assign_op), std::move(value));
+            }
+            
             // Function assignment tracking now handled in static analysis phase
             
             // GC Integration: Track assignment for escape analysis
@@ -2588,7 +2606,13 @@ std::unique_ptr<CatchClause> Parser::parse_catch_clause() {
         throw std::runtime_error("Expected ')' after catch parameter");
     }
     
+    // The catch body is not a block scope here, so the caught value is a
+    // let binding of the enclosing scope
     auto catch_clause = std::make_unique<CatchClause>(param_name);
+    if (scope_analyzer_) {
+        scope_analyzer_->declare_variable(param_name, "let", DataType::ANY);
+        catch_clause->variable_declaration_info = scope_analyzer_->get_variable_declaration_info(param_name);
+    }
     
     // Parse catch body
     if (!match(TokenType::LBRACE)) {
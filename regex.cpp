@@ -1,4 +1,5 @@
 #include "regex.h"
+#include "string_search.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -1330,7 +1331,32 @@ std::string GoTSRegExp::toString() const {
 // String regex functions
 namespace string_regex {
 
+// Patterns that match only themselves skip the engine for the string search
+// kernels. Same results as the engine: the first occurrence, or every
+// non-overlapping one with the g flag.
+static std::vector<RegexMatch> match_literal(const std::string& text, const std::string& pattern, bool global) {
+    std::vector<RegexMatch> matches;
+    size_t at = 0;
+    while ((at = string_search_find(text.data(), text.size(), pattern.data(), pattern.size(), at)) != STRING_SEARCH_NOT_FOUND) {
+        RegexMatch match;
+        match.start = static_cast<int>(at);
+        match.end = static_cast<int>(at + pattern.size());
+        match.matched_text = pattern;
+        matches.push_back(std::move(match));
+        if (!global) break;
+        at += pattern.size();
+    }
+    return matches;
+}
+
+static bool is_global(const std::string& flags) {
+    return flags.find('g') != std::string::npos;
+}
+
 std::vector<RegexMatch> match(const std::string& text, const std::string& pattern, const std::string& flags) {
+    if (string_search_is_literal(pattern, flags)) {
+        return match_literal(text, pattern, is_global(flags));
+    }
     RegexEngine engine(pattern, flags);
     return engine.match_all(text);
 }
@@ -1341,8 +1367,13 @@ std::vector<RegexMatch> match(const std::string& text, const GoTSRegExp& regexp)
 }
 
 std::string replace(const std::string& text, const std::string& pattern, const std::string& replacement, const std::string& flags) {
-    RegexEngine engine(pattern, flags);
-    std::vector<RegexMatch> matches = engine.match_all(text);
+    bool literal = string_search_is_literal(pattern, flags);
+    std::unique_ptr<RegexEngine> engine;
+    if (!literal) {
+        engine = std::make_unique<RegexEngine>(pattern, flags);
+    }
+    bool global = literal ? is_global(flags) : has_flag(engine->get_flags(), RegexFlags::GLOBAL);
+    std::vector<RegexMatch> matches = literal ? match_literal(text, pattern, global) : engine->match_all(text);
     
     if (matches.empty()) {
         return text;
@@ -1361,7 +1392,7 @@ std::string replace(const std::string& text, const std::string& pattern, const s
         last_end = match.end;
         
         // If not global, only replace first match
-        if (!has_flag(engine.get_flags(), RegexFlags::GLOBAL)) {
+        if (!global) {
             break;
         }
     }
@@ -1397,6 +1428,10 @@ std::string replace(const std::string& text, const GoTSRegExp& regexp, const std
 }
 
 int search(const std::string& text, const std::string& pattern, const std::string& flags) {
+    if (string_search_is_literal(pattern, flags)) {
+        size_t at = string_search_find(text.data(), text.size(), pattern.data(), pattern.size());
+        return at == STRING_SEARCH_NOT_FOUND ? -1 : static_cast<int>(at);
+    }
     RegexEngine engine(pattern, flags);
     RegexMatch match = engine.exec(text);
     return match.is_valid() ? match.start : -1;
@@ -1408,8 +1443,13 @@ int search(const std::string& text, const GoTSRegExp& regexp) {
 }
 
 std::vector<std::string> split(const std::string& text, const std::string& pattern, const std::string& flags, int limit) {
-    RegexEngine engine(pattern, flags);
-    std::vector<RegexMatch> matches = engine.match_all(text);
+    std::vector<RegexMatch> matches;
+    if (string_search_is_literal(pattern, flags)) {
+        matches = match_literal(text, pattern, is_global(flags));
+    } else {
+        RegexEngine engine(pattern, flags);
+        matches = engine.match_all(text);
+    }
     
     std::vector<std::string> result;
     int last_end = 0;
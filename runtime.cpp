@@ -5,6 +5,15 @@
 #include "goroutine_system_v2.h"
 #include "ultra_performance_array.h"
 #include "dynamic_properties.h"
+#include "sampling_profiler.h"
+#include "gc_heap.h"
+#include "gc_telemetry.h"
+#include "gc_heap_profiler.h"
+#include "exception_unwinder.h"
+#include "jit_symbols.h"
+#include "object_refcount.h"
+#include "string_search.h"
+#include "simd_optimizations.h"
 #include <iostream>
 #include <algorithm>
 #include <chrono>
@@ -244,6 +253,9 @@ void __runtime_init() {
         g_function_table[i].func_ptr = nullptr;
     }
     __new_goroutine_system_init();
+    __profiler_start_from_environment();
+    __gc_telemetry_start_from_environment();
+    __heap_profiler_start_from_environment();
 }
 
 // Prevent double cleanup
@@ -258,7 +270,11 @@ void __runtime_cleanup() {
     }
     
     std::cout << "DEBUG: __runtime_cleanup() starting" << std::endl;
+    __profiler_finish();
+    __gc_telemetry_finish();
+    __heap_profiler_finish();
     __new_goroutine_system_cleanup();
+    __jit_perf_map_finish();
     std::cout << "DEBUG: __runtime_cleanup() completed" << std::endl;
 }
 
@@ -273,11 +289,8 @@ void* __goroutine_spawn_fast(uint16_t func_id) {
     }
     
     // Create a task that calls the function directly - minimal overhead
-    typedef int64_t (*FuncType)();
-    FuncType func = reinterpret_cast<FuncType>(func_ptr);
-    
     auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), 
-                                                 [func]() { func(); });
+                                                 [func_ptr]() { jit_call_guarded("a goroutine", func_ptr); });
     
     EventDrivenScheduler::instance().schedule_regular(goroutine);
     return reinterpret_cast<void*>(1);
@@ -291,11 +304,8 @@ void* __goroutine_spawn_fast_arg1(uint16_t func_id, int64_t arg1) {
     }
     
     // Create a task that calls the function with one argument - minimal overhead
-    typedef int64_t (*FuncType)(int64_t);
-    FuncType func = reinterpret_cast<FuncType>(func_ptr);
-    
     auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), 
-                                                 [func, arg1]() { func(arg1); });
+                                                 [func_ptr, arg1]() { jit_call_guarded("a goroutine", func_ptr, arg1); });
     
     EventDrivenScheduler::instance().schedule_regular(goroutine);
     return reinterpret_cast<void*>(1);
@@ -309,11 +319,9 @@ void* __goroutine_spawn_fast_arg2(uint16_t func_id, int64_t arg1, int64_t arg2)
     }
     
     // Create a task that calls the function with two arguments - minimal overhead
-    typedef int64_t (*FuncType)(int64_t, int64_t);
-    FuncType func = reinterpret_cast<FuncType>(func_ptr);
-    
-    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), 
-                                                 [func, arg1, arg2]() { func(arg1, arg2); });
+    auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [func_ptr, arg1, arg2]() {
+        jit_call_guarded("a goroutine", func_ptr, arg1, arg2);
+    });
     
     EventDrivenScheduler::instance().schedule_regular(goroutine);
     return reinterpret_cast<void*>(1);
@@ -673,15 +681,9 @@ int64_t __debug_get_ref_count(int64_t object_address) {
     std::cout.flush();
     
     // Object layout: [class_name_ptr][property_count][ref_count][properties...]
-    // ref_count is at offset 16 (8 bytes for class_name_ptr + 8 bytes for property_count)
-    std::atomic<int64_t>* ref_count_ptr = reinterpret_cast<std::atomic<int64_t>*>(
-        static_cast<char*>(object_ptr) + 16
-    );
-    
-    std::cout << "[DEBUG] __debug_get_ref_count: ref_count_ptr=" << ref_count_ptr << std::endl;
-    std::cout.flush();
-    
-    int64_t ref_count = ref_count_ptr->load();
+    // ref_count at offset 16 is the owner's biased count; the shared part
+    // sits in front of the object (object_refcount.h)
+    int64_t ref_count = object_ref_count_total(object_ptr);
     std::cout << "[DEBUG] __debug_get_ref_count: loaded ref_count=" << ref_count << std::endl;
     std::cout.flush();
     
@@ -729,22 +731,153 @@ void* __string_create(const char* str) {
     return static_cast<void*>(gots_str);
 }
 
-// String interning for literals - simple implementation for now
-void* __string_intern(const char* str) {
-    std::cout << "[DEBUG] __string_intern called with: " << (str ? str : "null") << std::endl;
-    std::cout.flush();
-    
-    try {
-        // For now, just return a new GoTSString - could optimize with interning later
-        GoTSString* gots_str = new GoTSString(str);
-        std::cout << "[DEBUG] __string_intern created GoTSString at: " << gots_str << std::endl;
-        std::cout.flush();
-        return static_cast<void*>(gots_str);
-    } catch (const std::exception& e) {
-        std::cout << "[ERROR] __string_intern failed: " << e.what() << std::endl;
-        std::cout.flush();
-        return nullptr;
+// ============================================================================
+// STRING EQUALITY AND HASHING
+// ============================================================================
+
+// Below one vector the call overhead is not worth it
+static constexpr size_t STRING_SIMD_MIN_LENGTH = 32;
+
+static bool string_use_avx2() {
+    static const bool supported = SIMDOptimizations::is_avx2_supported();
+    return supported;
+}
+
+static bool string_bytes_equal(const char* a, const char* b, size_t length) {
+    if (length >= STRING_SIMD_MIN_LENGTH && string_use_avx2()) {
+        return SIMDOptimizations::strings_equal_avx2(a, b, length);
+    }
+    return memcmp(a, b, length) == 0;
+}
+
+static size_t string_first_difference(const char* a, const char* b, size_t length) {
+    if (length >= STRING_SIMD_MIN_LENGTH && string_use_avx2()) {
+        return SIMDOptimizations::first_difference_avx2(a, b, length);
+    }
+    size_t i = 0;
+    while (i < length && a[i] == b[i]) i++;
+    return i;
+}
+
+uint64_t GoTSString::compute_hash() const {
+    uint64_t hash = StringPool::hash(data(), size()) & ((uint64_t(1) << 56) - 1);
+    if (!is_small()) {
+        // Racing threads store the same value
+        __atomic_store_n(const_cast<uint64_t*>(&large.hash), (hash << 8) | 1, __ATOMIC_RELAXED);
+    }
+    return hash;
+}
+
+bool GoTSString::equals_large(const GoTSString& other) const {
+    // Hashes both known and different: the bytes differ
+    if (!is_small() && !other.is_small()) {
+        uint64_t mine = __atomic_load_n(&large.hash, __ATOMIC_RELAXED);
+        uint64_t theirs = __atomic_load_n(&other.large.hash, __ATOMIC_RELAXED);
+        if (mine && theirs && mine != theirs) return false;
+    }
+    return string_bytes_equal(data(), other.data(), size());
+}
+
+// ============================================================================
+// STRING POOL
+// ============================================================================
+
+StringPool& StringPool::instance() {
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
+
+StringPool::StringPool() {
+    for (Shard& shard : shards_) {
+        shard.table.store(allocate_table(INITIAL_SHARD_SLOTS), std::memory_order_relaxed);
+    }
+}
+
+StringPool::Table* StringPool::allocate_table(size_t slots) {
+    Table* table = new Table();
+    table->mask = slots - 1;
+    table->slots = new std::atomic<Entry*>[slots];
+    for (size_t i = 0; i < slots; i++) {
+        table->slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    return table;
+}
+
+// FNV-1a multiplies after every byte, so each step waits on the last and
+// wider loads have nothing to overlap; the plain loop is the fast version
+uint64_t StringPool::hash(const char* data, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+GoTSString* StringPool::find(const Table* table, uint64_t hash, const char* data, size_t length) {
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        Entry* entry = table->slots[i].load(std::memory_order_acquire);
+        if (!entry) return nullptr;
+        if (entry->hash == hash && entry->string->size() == length &&
+            string_bytes_equal(entry->string->data(), data, length)) {
+            return entry->string;
+        }
+    }
+}
+
+GoTSString* StringPool::intern(const char* str) {
+    if (!str) return nullptr;
+    return intern(str, strlen(str));
+}
+
+GoTSString* StringPool::intern(const char* data, size_t length) {
+    uint64_t hash = StringPool::hash(data, length);
+    Shard& shard = shard_for(hash);
+    if (GoTSString* found = find(shard.table.load(std::memory_order_acquire), hash, data, length)) {
+        return found;
+    }
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    if (GoTSString* found = find(table, hash, data, length)) {
+        return found;   // Another thread interned it first
+    }
+
+    // Keep the load under 3/4 so probes stay short and always end
+    if ((shard.count + 1) * 4 > (table->mask + 1) * 3) {
+        Table* grown = allocate_table((table->mask + 1) * 2);
+        for (size_t i = 0; i <= table->mask; i++) {
+            Entry* entry = table->slots[i].load(std::memory_order_relaxed);
+            if (!entry) continue;
+            size_t slot = entry->hash & grown->mask;
+            while (grown->slots[slot].load(std::memory_order_relaxed)) slot = (slot + 1) & grown->mask;
+            grown->slots[slot].store(entry, std::memory_order_relaxed);
+        }
+        // The old table stays allocated: lock-free readers may still be in it
+        shard.table.store(grown, std::memory_order_release);
+        table = grown;
     }
+
+    Entry* entry = new Entry{hash, new GoTSString(data, length)};
+    size_t slot = hash & table->mask;
+    while (table->slots[slot].load(std::memory_order_relaxed)) slot = (slot + 1) & table->mask;
+    table->slots[slot].store(entry, std::memory_order_release);
+    shard.count++;
+    return entry->string;
+}
+
+size_t StringPool::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.count;
+    }
+    return total;
+}
+
+// String interning for literals: one shared GoTSString per distinct literal
+void* __string_intern(const char* str) {
+    return static_cast<void*>(StringPool::instance().intern(str ? str : ""));
 }
 
 // String creation with length - handles null bytes properly
@@ -775,24 +908,19 @@ extern "C" const char* __string_data(void* string_ptr) {
 
 // String comparison functions for high-performance string operations
 extern "C" bool __string_equals(void* str1_ptr, void* str2_ptr) {
-    if (!str1_ptr || !str2_ptr) {
-        return (str1_ptr == str2_ptr);  // Both null = equal, one null = not equal
-    }
+    // Same pointer: interned literals with equal bytes always are
+    if (str1_ptr == str2_ptr) return true;
+    if (!str1_ptr || !str2_ptr) return false;
     
     GoTSString* str1 = static_cast<GoTSString*>(str1_ptr);
     GoTSString* str2 = static_cast<GoTSString*>(str2_ptr);
     
-    // Fast path: same length check first
-    if (str1->length() != str2->length()) {
-        return false;
-    }
-    
-    // Use memcmp for high-performance comparison (handles null bytes correctly)
-    return (memcmp(str1->data(), str2->data(), str1->length()) == 0);
+    // Length first, then cached hashes, then the bytes (handles null bytes correctly)
+    return *str1 == *str2;
 }
 
 extern "C" int64_t __string_compare(void* str1_ptr, void* str2_ptr) {
-    if (!str1_ptr && !str2_ptr) return 0;
+    if (str1_ptr == str2_ptr) return 0;
     if (!str1_ptr) return -1;
     if (!str2_ptr) return 1;
     
@@ -800,16 +928,38 @@ extern "C" int64_t __string_compare(void* str1_ptr, void* str2_ptr) {
     GoTSString* str2 = static_cast<GoTSString*>(str2_ptr);
     
     size_t min_len = std::min(str1->length(), str2->length());
-    int result = memcmp(str1->data(), str2->data(), min_len);
+    const char* data1 = str1->data();
+    const char* data2 = str2->data();
+    size_t diff = string_first_difference(data1, data2, min_len);
     
-    if (result == 0) {
+    if (diff == min_len) {
         // Strings are equal up to min_len, compare lengths
         if (str1->length() < str2->length()) return -1;
         if (str1->length() > str2->length()) return 1;
         return 0;
     }
     
-    return (result < 0) ? -1 : 1;
+    return static_cast<uint8_t>(data1[diff]) < static_cast<uint8_t>(data2[diff]) ? -1 : 1;
+}
+
+extern "C" uint64_t __string_switch_hash_bytes(const char* data, size_t length, uint64_t seed) {
+    // FNV-1a over the bytes, seeded, with a final avalanche so low bits are usable as a slot index
+    uint64_t hash = 0xcbf29ce484222325ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= length;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+extern "C" uint64_t __string_switch_hash(void* str_ptr, uint64_t seed) {
+    if (!str_ptr) return 0;
+    GoTSString* str = static_cast<GoTSString*>(str_ptr);
+    return __string_switch_hash_bytes(str->data(), str->length(), seed);
 }
 
 // DynamicValue to typed value extraction functions
@@ -1098,13 +1248,12 @@ void* __goroutine_spawn_func_ptr(void* func_ptr, void* arg) {
         
         // Use the goroutine scheduler to spawn with the function pointer
         // CRITICAL: Must match the calling convention of the main function!
-        typedef int (*func_t)();  // Same signature as main function
-        func_t function = reinterpret_cast<func_t>(func_ptr);
-        
-        auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [function]() {
-            printf("[DEBUG] Goroutine task executing, calling function at %p\n", function);
-            int result = function();  // Properly handle return value
-            printf("[DEBUG] Goroutine task completed with result: %d\n", result);
+        auto goroutine = std::make_shared<Goroutine>(g_next_goroutine_id.fetch_add(1), [func_ptr]() {
+            printf("[DEBUG] Goroutine task executing, calling function at %p\n", func_ptr);
+            int64_t result = 0;
+            if (jit_call_guarded("a goroutine", func_ptr, 0, 0, &result)) {
+                printf("[DEBUG] Goroutine task completed with result: %d\n", static_cast<int>(result));
+            }
         });
         
         EventDrivenScheduler::instance().schedule_regular(goroutine);
@@ -1387,6 +1536,125 @@ extern "C" void* __dynamic_value_copy_for_parameter(void* source_dynamic_value)
 
 // Property access runtime functions removed - will be reimplemented according to new architecture
 
+// ============================================================================
+// ROPE STRINGS
+// ============================================================================
+
+// String memory counts against the GC heap's hard limit without being
+// refused there: __string_concat checks for room before it builds a long result
+char* GoTSString::allocate_buffer(size_t bytes) {
+    char* buffer = new char[bytes];
+    GCHeap::instance().add_external_bytes(bytes);
+    return buffer;
+}
+
+void GoTSString::free_buffer(char* buffer, size_t bytes) {
+    GCHeap::instance().release_external_bytes(bytes);
+    delete[] buffer;
+}
+
+static GoTSStringRope* rope_allocate(GoTSStringRope* prefix, size_t prefix_size, size_t capacity) {
+    void* memory = malloc(sizeof(GoTSStringRope) + capacity);
+    if (!memory) throw std::bad_alloc();
+    GCHeap::instance().add_external_bytes(sizeof(GoTSStringRope) + capacity);
+    GoTSStringRope* rope = new (memory) GoTSStringRope();
+    rope->refs.store(1, std::memory_order_relaxed);
+    rope->prefix = prefix;
+    rope->prefix_size = prefix_size;
+    rope->capacity = capacity;
+    rope->used.store(0, std::memory_order_relaxed);
+    if (prefix) {
+        prefix->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return rope;
+}
+
+// Doubles with each chunk so a long build allocates O(log n) of them
+static size_t rope_chunk_capacity(size_t needed, size_t previous) {
+    size_t grown = std::min(GoTSString::ROPE_MAX_CHUNK, std::max(GoTSString::ROPE_MIN_CHUNK, previous * 2));
+    return std::max(needed, grown);
+}
+
+// Iterative: a long build is a long prefix chain
+void GoTSString::rope_release(GoTSStringRope* rope) {
+    while (rope && rope->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        GoTSStringRope* prefix = rope->prefix;
+        GCHeap::instance().release_external_bytes(sizeof(GoTSStringRope) + rope->capacity);
+        rope->~GoTSStringRope();
+        free(rope);
+        rope = prefix;
+    }
+}
+
+const char* GoTSString::flatten() const {
+    size_t total = large.size;
+    char* flat = allocate_buffer(total + 1);
+    flat[total] = '\0';
+    size_t end = total;
+    for (GoTSStringRope* rope = this->rope(); rope; rope = rope->prefix) {
+        memcpy(flat + rope->prefix_size, rope->chunk(), end - rope->prefix_size);
+        end = rope->prefix_size;
+    }
+    // Threads reading the same rope race to publish; the loser frees its copy
+    char* expected = nullptr;
+    if (!__atomic_compare_exchange_n(const_cast<char**>(&large.data), &expected, flat, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free_buffer(flat, total + 1);
+        return expected;
+    }
+    return flat;
+}
+
+GoTSString GoTSString::concat_rope(const GoTSString& other) const {
+    size_t my_size = size();
+    size_t other_size = other.size();
+    const char* other_data = other.data();
+    GoTSStringRope* rope;
+    if (!is_small() && is_rope()) {
+        GoTSStringRope* tip = this->rope();
+        size_t tail = my_size - tip->prefix_size;
+        size_t claimed = tail;
+        if (tail + other_size <= tip->capacity &&
+            tip->used.compare_exchange_strong(claimed, tail + other_size, std::memory_order_acq_rel)) {
+            // This string ends where the chunk does: append in place
+            memcpy(tip->chunk() + tail, other_data, other_size);
+            tip->refs.fetch_add(1, std::memory_order_relaxed);
+            rope = tip;
+        } else {
+            rope = rope_allocate(tip, my_size, rope_chunk_capacity(other_size, tip->capacity));
+            memcpy(rope->chunk(), other_data, other_size);
+            rope->used.store(other_size, std::memory_order_relaxed);
+        }
+    } else {
+        // First concatenation past the threshold: one copy, with room to grow
+        size_t total = my_size + other_size;
+        rope = rope_allocate(nullptr, 0, rope_chunk_capacity(total, total));
+        memcpy(rope->chunk(), data(), my_size);
+        memcpy(rope->chunk() + my_size, other_data, other_size);
+        rope->used.store(total, std::memory_order_relaxed);
+    }
+
+    GoTSString result;
+    result.large.data = nullptr;
+    result.large.size = my_size + other_size;
+    result.large.capacity = reinterpret_cast<size_t>(rope);
+    result.clear_small_flag();
+    return result;
+}
+
+// Past the GC heap's hard limit a concatenation that needs a buffer fails:
+// the __string_concat functions return nullptr and JIT code throws the
+// out-of-memory error. Room is asked for the appended bytes, the most a
+// rope append adds short of a new chunk.
+static bool string_concat_has_room(size_t total_size, size_t appended_size) {
+    if (total_size <= GoTSString::SSO_THRESHOLD) return true;
+    GCHeap& heap = GCHeap::instance();
+    if (!heap.reserve_external_bytes(appended_size)) return false;
+    // The buffers count themselves as they are allocated
+    heap.release_external_bytes(appended_size);
+    return true;
+}
+
 // String functions
 extern "C" void* __string_concat(void* str1, void* str2) {
     if (!str1 || !str2) return nullptr;
@@ -1394,6 +1662,7 @@ extern "C" void* __string_concat(void* str1, void* str2) {
     // Handle GoTSString concatenation properly
     GoTSString* s1 = static_cast<GoTSString*>(str1);
     GoTSString* s2 = static_cast<GoTSString*>(str2);
+    if (!string_concat_has_room(s1->size() + s2->size(), s2->size())) return nullptr;
     
     // Create new GoTSString with proper concatenation
     GoTSString* result = new GoTSString(*s1 + *s2);
@@ -1406,6 +1675,8 @@ extern "C" void* __string_concat_cstr(void* str_ptr, const char* cstr) {
     if (!str_ptr || !cstr) return nullptr;
     
     GoTSString* str = static_cast<GoTSString*>(str_ptr);
+    size_t cstr_size = strlen(cstr);
+    if (!string_concat_has_room(str->size() + cstr_size, cstr_size)) return nullptr;
     GoTSString* result = new GoTSString(*str + GoTSString(cstr));
     
     return static_cast<void*>(result);
@@ -1416,6 +1687,7 @@ extern "C" void* __string_concat_cstr_left(const char* cstr, void* str_ptr) {
     if (!cstr || !str_ptr) return nullptr;
     
     GoTSString* str = static_cast<GoTSString*>(str_ptr);
+    if (!string_concat_has_room(strlen(cstr) + str->size(), str->size())) return nullptr;
     GoTSString* result = new GoTSString(GoTSString(cstr) + *str);
     
     return static_cast<void*>(result);
@@ -1518,6 +1790,41 @@ extern "C" void* __string_match(void* string_ptr, void* regex_ptr) {
     return result;
 }
 
+// String search methods, on the kernels in string_search.h
+extern "C" int64_t __string_index_of(void* string_ptr, void* search_ptr) {
+    if (!string_ptr || !search_ptr) return -1;
+    GoTSString* str = static_cast<GoTSString*>(string_ptr);
+    GoTSString* search = static_cast<GoTSString*>(search_ptr);
+    size_t at = string_search_find(str->data(), str->size(), search->data(), search->size());
+    return at == STRING_SEARCH_NOT_FOUND ? -1 : static_cast<int64_t>(at);
+}
+
+extern "C" bool __string_includes(void* string_ptr, void* search_ptr) {
+    return __string_index_of(string_ptr, search_ptr) >= 0;
+}
+
+extern "C" bool __string_starts_with(void* string_ptr, void* prefix_ptr) {
+    if (!string_ptr || !prefix_ptr) return false;
+    GoTSString* str = static_cast<GoTSString*>(string_ptr);
+    GoTSString* prefix = static_cast<GoTSString*>(prefix_ptr);
+    return prefix->size() <= str->size() && memcmp(str->data(), prefix->data(), prefix->size()) == 0;
+}
+
+extern "C" void* __string_split(void* string_ptr, void* delimiter_ptr) {
+    if (!string_ptr) return nullptr;
+    GoTSString* str = static_cast<GoTSString*>(string_ptr);
+    Array* result = new Array();
+    if (!delimiter_ptr) {
+        result->push(std::string(str->data(), str->size()));
+        return result;
+    }
+    GoTSString* delimiter = static_cast<GoTSString*>(delimiter_ptr);
+    for (std::string& piece : string_search_split(str->data(), str->size(), delimiter->data(), delimiter->size())) {
+        result->push(std::move(piece));
+    }
+    return result;
+}
+
 // ==================== Object Creation Functions ====================
 
 int64_t __object_create(void* class_name_ptr, int64_t property_count) {
@@ -1533,10 +1840,11 @@ int64_t __object_create(void* class_name_ptr, int64_t property_count) {
         size_t property_storage_size = property_count * sizeof(void*);
         size_t total_size = metadata_size + property_storage_size;
         
-        // Allocate contiguous memory block
-        void* raw_memory = calloc(1, total_size);
+        // Allocate contiguous memory block, biased to this thread with a count of 1
+        void* raw_memory = object_ref_count_allocate(total_size);
         if (!raw_memory) {
-            throw std::bad_alloc();
+            // Past the GC heap's hard limit: JIT code throws the out-of-memory error
+            return 0;
         }
         
         // Layout: [class_name_ptr][property_count][ref_count][dynamic_map_ptr][property0][property1]...
@@ -1558,10 +1866,6 @@ int64_t __object_create(void* class_name_ptr, int64_t property_count) {
         // Store property count at offset 1 (8 bytes)
         obj_data[1] = reinterpret_cast<void*>(property_count);
         
-        // Initialize reference count to 1 at offset 2 (16 bytes)
-        // Use placement new to properly initialize atomic
-        new (reinterpret_cast<char*>(raw_memory) + OBJECT_REF_COUNT_OFFSET) std::atomic<int64_t>(1);
-        
         // Initialize dynamic property map pointer to nullptr at offset 3 (24 bytes) - lazy initialization
         obj_data[3] = nullptr;
         
@@ -1577,7 +1881,7 @@ int64_t __object_create(void* class_name_ptr, int64_t property_count) {
         void** test_ptr = static_cast<void**>(raw_memory);
         std::cout << "[DEBUG] __object_create verification: class_name_ptr=" << test_ptr[0] 
                   << ", property_count=" << reinterpret_cast<int64_t>(test_ptr[1]) 
-                  << ", ref_count=" << GET_OBJECT_REF_COUNT(raw_memory).load()
+                  << ", ref_count=" << object_ref_count_total(raw_memory)
                   << ", dynamic_map_ptr=" << test_ptr[3] << std::endl;
         
         // Test write to property slot 0 (offset 32)
@@ -1637,38 +1941,35 @@ extern "C" void* __jit_object_create_sized(void* class_name_ptr, size_t size) {
 extern "C" void __object_add_ref(void* object_ptr) {
     if (!object_ptr) return;
     
-    std::atomic<int64_t>& ref_count = GET_OBJECT_REF_COUNT(object_ptr);
-    int64_t old_count = ref_count.fetch_add(1);
+    object_ref_count_retain(object_ptr);
     
     std::cout << "[DEBUG] __object_add_ref: object=" << object_ptr 
-              << ", ref_count " << old_count << " -> " << (old_count + 1) << std::endl;
+              << ", ref_count -> " << object_ref_count_total(object_ptr) << std::endl;
 }
 
 extern "C" void __object_release(void* object_ptr) {
     if (!object_ptr) return;
     
-    std::atomic<int64_t>& ref_count = GET_OBJECT_REF_COUNT(object_ptr);
-    int64_t old_count = ref_count.fetch_sub(1);
+    bool last_reference = object_ref_count_release(object_ptr);
     
     std::cout << "[DEBUG] __object_release: object=" << object_ptr 
-              << ", ref_count " << old_count << " -> " << (old_count - 1) << std::endl;
+              << ", last reference=" << last_reference << std::endl;
     
-    if (old_count == 1) {
+    if (last_reference) {
         // Reference count reached zero, free the object
         std::cout << "[DEBUG] __object_release: freeing object " << object_ptr << std::endl;
         
-        // First, clean up the dynamic property map if it exists
+        // Drop the references it holds in counted property slots
+        object_ref_count_release_references(object_ptr);
+        
+        // Then clean up the dynamic property map if it exists
         DynamicPropertyMap* dynamic_map = GET_OBJECT_DYNAMIC_MAP(object_ptr);
         if (dynamic_map) {
             dynamic_map->release();  // This will delete the map if its ref count reaches 0
         }
         
-        // Destroy the atomic ref_count object
-        reinterpret_cast<std::atomic<int64_t>*>(
-            reinterpret_cast<char*>(object_ptr) + OBJECT_REF_COUNT_OFFSET)->~atomic();
-        
         // Free the object memory
-        free(object_ptr);
+        object_ref_count_free(object_ptr);
         
         std::cout << "[DEBUG] __object_release: object freed" << std::endl;
     }
@@ -1708,18 +2009,17 @@ extern "C" void __object_destruct(void* object_ptr) {
     
     std::cout << "[DEBUG] __object_destruct: freeing object " << object_ptr << std::endl;
     
+    // Drop the references it holds in counted property slots
+    object_ref_count_release_references(object_ptr);
+    
     // Clean up the dynamic property map if it exists
     DynamicPropertyMap* dynamic_map = GET_OBJECT_DYNAMIC_MAP(object_ptr);
     if (dynamic_map) {
         dynamic_map->release();  // This will delete the map if its ref count reaches 0
     }
     
-    // Destroy the atomic ref_count object
-    reinterpret_cast<std::atomic<int64_t>*>(
-        reinterpret_cast<char*>(object_ptr) + OBJECT_REF_COUNT_OFFSET)->~atomic();
-    
     // Free the object memory
-    free(object_ptr);
+    object_ref_count_free(object_ptr);
     
     std::cout << "[DEBUG] __object_destruct: object freed" << std::endl;
 }
@@ -1732,18 +2032,17 @@ extern "C" void __object_free_direct(void* object_ptr) {
     // Direct free without reference counting - used for stack-allocated objects
     // where we know the destructor has already been called directly
     
+    // Drop the references it holds in counted property slots
+    object_ref_count_release_references(object_ptr);
+    
     // Clean up the dynamic property map if it exists
     DynamicPropertyMap* dynamic_map = GET_OBJECT_DYNAMIC_MAP(object_ptr);
     if (dynamic_map) {
         dynamic_map->release();  // This will delete the map if its ref count reaches 0
     }
     
-    // Destroy the atomic ref_count object
-    reinterpret_cast<std::atomic<int64_t>*>(
-        reinterpret_cast<char*>(object_ptr) + OBJECT_REF_COUNT_OFFSET)->~atomic();
-    
     // Free the object memory
-    free(object_ptr);
+    object_ref_count_free(object_ptr);
     
     std::cout << "[DEBUG] __object_free_direct: object freed" << std::endl;
 }
@@ -1751,8 +2050,7 @@ extern "C" void __object_free_direct(void* object_ptr) {
 extern "C" int64_t __object_get_ref_count(void* object_ptr) {
     if (!object_ptr) return 0;
     
-    std::atomic<int64_t>& ref_count = GET_OBJECT_REF_COUNT(object_ptr);
-    return ref_count.load();
+    return object_ref_count_total(object_ptr);
 }
 
 // ==================== Advanced Reference Counting for Dynamic Values ====================
@@ -39,13 +39,39 @@ extern ExecutableMemoryInfo g_executable_memory;
 // is now in ultra_performance_array.h and included in compiler.h
 // Old TypedArray and LegacyArray implementations have been removed
 
+// Chunk of a rope string. A rope is a chain of chunks, newest first: the
+// string's bytes are its prefix chain's first prefix_size bytes followed by
+// the start of this chunk. Strings sharing a chunk see different lengths of
+// it, so the string whose end is the chunk's end can append into the spare
+// capacity without disturbing the others.
+struct GoTSStringRope {
+    std::atomic<int64_t> refs;
+    GoTSStringRope* prefix;          // Retained; null for the first chunk
+    size_t prefix_size;              // Bytes in front of this chunk
+    size_t capacity;                 // Chunk bytes allocated after the header
+    std::atomic<size_t> used;        // Chunk bytes claimed; appends claim more by CAS
+
+    char* chunk() { return reinterpret_cast<char*>(this + 1); }
+};
+
 // High-Performance String Implementation with Small String Optimization (SSO)
 // This implements an extremely fast string type optimized for JIT compilation
+//
+// Concatenations of ROPE_THRESHOLD bytes or more produce ropes instead of
+// copies: building a string with s = s + x in a loop appends each piece to
+// the tip chunk in place, amortized O(1) per byte. A rope keeps its chunk in
+// large.capacity (even, where a flat string's capacity is odd) and is
+// flattened into large.data the first time its bytes are read.
 class GoTSString {
 public:
     // SSO threshold - strings up to 22 bytes are stored inline (on 64-bit systems)
     static constexpr size_t SSO_THRESHOLD = sizeof(void*) + sizeof(size_t) + sizeof(size_t) - 1;
     
+    // Rope tuning: results this long become ropes; chunks double up to the max
+    static constexpr size_t ROPE_THRESHOLD = 256;
+    static constexpr size_t ROPE_MIN_CHUNK = 1024;
+    static constexpr size_t ROPE_MAX_CHUNK = 1 << 20;
+    
 private:
     union {
         // Large string storage
@@ -53,6 +79,7 @@ private:
             char* data;
             size_t size;
             size_t capacity;
+            uint64_t hash;      // hash() << 8 | 1 once computed, else 0; overlaps small.size
         } large;
         
         // Small string storage - direct inline storage
@@ -76,14 +103,34 @@ private:
     }
     
     void clear_small_flag() {
-        // Clear the high bit for large strings
-        reinterpret_cast<uint8_t*>(this)[24] &= 0x7F;
+        // Large strings: the flag byte is the low byte of the cached hash
+        // word, so clearing the word clears the flag and forgets the hash
+        large.hash = 0;
     }
     
     uint8_t get_small_size() const {
         // Mask off the flag bit to get actual size (max 127 chars for small strings)
         return small.size & 0x7F;
     }
+    
+    // Large strings only: chunk pointers are aligned, so their low bit is clear
+    bool is_rope() const {
+        return (large.capacity & 1) == 0;
+    }
+    
+    GoTSStringRope* rope() const {
+        return reinterpret_cast<GoTSStringRope*>(large.capacity);
+    }
+    
+    // Slow paths, in runtime.cpp
+    uint64_t compute_hash() const;
+    bool equals_large(const GoTSString& other) const;
+    const char* flatten() const;
+    GoTSString concat_rope(const GoTSString& other) const;
+    static void rope_release(GoTSStringRope* rope);
+    // Flat buffers and flattened ropes, counted as the GC heap's external bytes
+    static char* allocate_buffer(size_t bytes);
+    static void free_buffer(char* buffer, size_t bytes);
 
 public:
     // Default constructor - creates empty small string
@@ -109,7 +156,7 @@ public:
             // Large string - allocate on heap
             large.size = len;
             large.capacity = ((len + 16) & ~15) | 1; // Round up to 16-byte boundary, set odd flag
-            large.data = new char[large.capacity & ~1]; // Mask off the flag bit
+            large.data = allocate_buffer(large.capacity & ~1); // Mask off the flag bit
             memcpy(large.data, str, len + 1);
             clear_small_flag();  // Make sure flag is clear for large strings
         }
@@ -131,7 +178,7 @@ public:
             // Large string - allocate on heap
             large.size = len;
             large.capacity = ((len + 16) & ~15) | 1; // Round up to 16-byte boundary, set odd flag
-            large.data = new char[large.capacity & ~1]; // Mask off the flag bit
+            large.data = allocate_buffer(large.capacity & ~1); // Mask off the flag bit
             memcpy(large.data, data, len);
             large.data[len] = '\0';  // Always null-terminate for safety
             clear_small_flag();  // Make sure flag is clear for large strings
@@ -142,12 +189,20 @@ public:
     GoTSString(const GoTSString& other) {
         if (other.is_small()) {
             memcpy(&small, &other.small, sizeof(small));
+        } else if (other.is_rope()) {
+            // Shares the chunks; the copy flattens on its own when read
+            other.rope()->refs.fetch_add(1, std::memory_order_relaxed);
+            large.data = nullptr;
+            large.size = other.large.size;
+            large.capacity = other.large.capacity;
+            large.hash = other.large.hash;
         } else {
             large.size = other.large.size;
             large.capacity = other.large.capacity;
             size_t actual_capacity = large.capacity & ~1;
-            large.data = new char[actual_capacity];
+            large.data = allocate_buffer(actual_capacity);
             memcpy(large.data, other.large.data, large.size + 1);
+            large.hash = other.large.hash;
         }
     }
     
@@ -162,7 +217,7 @@ public:
             large.data = other.large.data;
             large.size = other.large.size;
             large.capacity = other.large.capacity;
-            clear_small_flag();
+            large.hash = other.large.hash;
             
             // Reset other to empty small string
             other.large.data = nullptr;
@@ -194,7 +249,7 @@ public:
                 large.data = other.large.data;
                 large.size = other.large.size;
                 large.capacity = other.large.capacity;
-                clear_small_flag();
+                large.hash = other.large.hash;
                 
                 // Reset other to empty small string
                 other.large.data = nullptr;
@@ -210,13 +265,19 @@ public:
     // Destructor
     ~GoTSString() {
         if (!is_small()) {
-            delete[] large.data;
+            if (is_rope()) {
+                rope_release(rope());
+                // Flattened copy, if it was ever read
+                if (large.data) free_buffer(large.data, large.size + 1);
+            } else {
+                free_buffer(large.data, large.capacity & ~1);
+            }
         }
     }
     
     // Access methods - highly optimized
     inline const char* c_str() const {
-        return is_small() ? small.buffer : large.data;
+        return data();
     }
     
     inline size_t size() const {
@@ -232,7 +293,7 @@ public:
     }
     
     inline char operator[](size_t index) const {
-        return is_small() ? small.buffer[index] : large.data[index];
+        return data()[index];
     }
     
     // Concatenation - extremely optimized
@@ -246,11 +307,13 @@ public:
             memcpy(result.small.buffer + size(), other.c_str(), other.size());
             result.small.buffer[total_size] = '\0';
             result.small.size = static_cast<uint8_t>(total_size) | 0x80;  // Set flag bit + size
+        } else if (total_size >= ROPE_THRESHOLD) {
+            return concat_rope(other);
         } else {
             // Need large string
             result.large.size = total_size;
             result.large.capacity = ((total_size + 16) & ~15) | 1;
-            result.large.data = new char[result.large.capacity & ~1];
+            result.large.data = allocate_buffer(result.large.capacity & ~1);
             memcpy(result.large.data, c_str(), size());
             memcpy(result.large.data + size(), other.c_str(), other.size());
             result.large.data[total_size] = '\0';
@@ -262,6 +325,7 @@ public:
     
     // Comparison operators - optimized for JIT
     bool operator==(const GoTSString& other) const {
+        if (this == &other) return true;
         size_t len = size();
         if (len != other.size()) return false;
         if (len == 0) return true;
@@ -271,7 +335,17 @@ public:
             return memcmp(small.buffer, other.small.buffer, len) == 0;
         }
         
-        return memcmp(c_str(), other.c_str(), len) == 0;
+        return equals_large(other);
+    }
+    
+    // FNV-1a, 56 bits. Computed once for large strings and cached in the
+    // string; small strings hash their few bytes each time.
+    inline uint64_t hash() const {
+        if (!is_small()) {
+            uint64_t cached = __atomic_load_n(&large.hash, __ATOMIC_RELAXED);
+            if (cached) return cached >> 8;
+        }
+        return compute_hash();
     }
     
     bool operator!=(const GoTSString& other) const {
@@ -297,7 +371,10 @@ public:
     
     // Raw data access for handling null bytes properly
     inline const char* data() const {
-        return is_small() ? small.buffer : large.data;
+        if (is_small()) return small.buffer;
+        // Null only for a rope nobody has read yet
+        const char* flat = __atomic_load_n(&large.data, __ATOMIC_ACQUIRE);
+        return flat ? flat : flatten();
     }
     
     // Static factory method for creating from data with length
@@ -321,15 +398,23 @@ public:
             memcpy(small.buffer + my_size, other.data(), other_size);
             small.buffer[total_size] = '\0';
             small.size = static_cast<uint8_t>(total_size) | 0x80;
+        } else if (total_size >= ROPE_THRESHOLD || (!is_small() && is_rope())) {
+            *this = *this + other;
+        } else if (!is_small() && total_size < (large.capacity & ~size_t(1))) {
+            // Room left from an earlier append
+            memcpy(large.data + my_size, other.data(), other_size);
+            large.data[total_size] = '\0';
+            large.size = total_size;
+            clear_small_flag();
         } else {
             // Need to create new large string or grow existing one
-            char* new_data = new char[((total_size + 16) & ~15)];
+            char* new_data = allocate_buffer((total_size + 16) & ~15);
             memcpy(new_data, data(), my_size);
             memcpy(new_data + my_size, other.data(), other_size);
             new_data[total_size] = '\0';
             
             if (!is_small()) {
-                delete[] large.data;
+                free_buffer(large.data, large.capacity & ~1);
             }
             
             large.data = new_data;
@@ -342,41 +427,66 @@ public:
     }
 };
 
+// Lets string-keyed maps reuse the cached hash
+namespace std {
+template <>
+struct hash<GoTSString> {
+    size_t operator()(const GoTSString& str) const { return str.hash(); }
+};
+}
+
 // String interning system for literal optimization
+//
+// Sharded open-addressing tables keyed by hash plus bytes. Lookups take no
+// lock: they probe the shard's current table with acquire loads, and entries
+// are never removed. Inserts lock only their shard, and a full shard
+// publishes a doubled table without freeing the old one, which readers may
+// still be probing. Interned strings live for the whole run.
 class StringPool {
-private:
-    std::unordered_map<std::string, GoTSString*> interned_strings;
-    std::mutex pool_mutex;
-    
 public:
+    static constexpr size_t SHARD_COUNT = 64;
+    static constexpr size_t INITIAL_SHARD_SLOTS = 64;
+
+    static StringPool& instance();
+
     // Get or create an interned string
-    GoTSString* intern(const char* str) {
-        if (!str) return nullptr;
-        
-        std::lock_guard<std::mutex> lock(pool_mutex);
-        
-        std::string key(str);  // Create proper string key
-        auto it = interned_strings.find(key);
-        if (it != interned_strings.end()) {
-            return it->second;
-        }
-        
-        GoTSString* new_string = new GoTSString(str);
-        interned_strings[key] = new_string;  // Use string key, not char* key
-        return new_string;
-    }
-    
-    // Cleanup - called on program exit
-    ~StringPool() {
-        for (auto& pair : interned_strings) {
-            delete pair.second;
-        }
+    GoTSString* intern(const char* str);
+    GoTSString* intern(const char* data, size_t length);
+
+    size_t size() const;
+
+    // FNV-1a; the AVX2 loader for long strings gives the same result
+    static uint64_t hash(const char* data, size_t length);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        GoTSString* string;
+    };
+
+    struct Table {
+        size_t mask;
+        std::atomic<Entry*>* slots;
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<Table*> table{nullptr};
+        mutable std::mutex mutex;  // Serializes inserts and growth
+        size_t count = 0;
+    };
+
+    Shard shards_[SHARD_COUNT];
+
+    StringPool();
+
+    static_assert(SHARD_COUNT == 64, "shard_for takes the top 6 hash bits");
+    Shard& shard_for(uint64_t hash) {
+        return shards_[hash >> 58];   // Top bits; the table index uses the low ones
     }
+    static GoTSString* find(const Table* table, uint64_t hash, const char* data, size_t length);
+    static Table* allocate_table(size_t slots);
 };
 
-// Global string pool instance
-extern StringPool global_string_pool;
-
 struct Promise {
     std::atomic<bool> resolved{false};
     std::shared_ptr<void> value;
@@ -916,6 +1026,11 @@ extern "C" {
     int64_t* __array_data(void* array);
     int64_t __string_compare(void* str1, void* str2);
     
+    // Seeded hash used by switch statements over string cases: the compiler
+    // searches for a seed that maps every case label to its own slot
+    uint64_t __string_switch_hash(void* str, uint64_t seed);
+    uint64_t __string_switch_hash_bytes(const char* data, size_t length, uint64_t seed);
+    
     // String access (legacy - use new string functions above)
     const char* __string_c_str(void* string_ptr);
     char __string_char_at(void* string_ptr, int64_t index);
@@ -1040,6 +1155,9 @@ extern "C" {
     void* __string_replace(void* string_ptr, void* pattern_ptr, void* replacement_ptr);
     int64_t __string_search(void* string_ptr, void* regex_ptr);
     void* __string_split(void* string_ptr, void* delimiter_ptr);
+    int64_t __string_index_of(void* string_ptr, void* search_ptr);
+    bool __string_includes(void* string_ptr, void* search_ptr);
+    bool __string_starts_with(void* string_ptr, void* prefix_ptr);
     
     // Regex property functions
     void* __regex_get_source(void* regex_ptr);
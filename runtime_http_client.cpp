@@ -1,6 +1,7 @@
 #include "runtime_http_server.h"
 #include "runtime.h"
 #include "runtime_object.h"
+#include "exception_unwinder.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -271,11 +272,10 @@ void* __runtime_http_create_server_simple(void* callback_ptr) {
     auto server = std::make_unique<HTTPServer>();
     
     // Convert callback to HTTPRequestHandler
-    auto callback_func = reinterpret_cast<void(*)(void*, void*)>(callback_ptr);
-    
-    HTTPRequestHandler handler = [callback_func](HTTPRequest& req, HTTPResponse& res) {
+    HTTPRequestHandler handler = [callback_ptr](HTTPRequest& req, HTTPResponse& res) {
         // Execute callback in current goroutine context
-        callback_func(static_cast<void*>(&req), static_cast<void*>(&res));
+        jit_call_guarded("an HTTP request handler", callback_ptr, reinterpret_cast<int64_t>(&req),
+                         reinterpret_cast<int64_t>(&res));
     };
     
     server->on_request(handler);
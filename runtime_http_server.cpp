@@ -1,6 +1,7 @@
 #include "runtime_http_server.h"
 #include "runtime.h"
 #include "goroutine_system_v2.h"
+#include "exception_unwinder.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -718,10 +719,9 @@ void* __runtime_http_create_server_advanced(void* handler_ptr) {
     if (!handler_ptr) return nullptr;
     
     // Convert function pointer to HTTPRequestHandler
-    auto handler_func = reinterpret_cast<void(*)(void*, void*)>(handler_ptr);
-    
-    HTTPRequestHandler handler = [handler_func](HTTPRequest& req, HTTPResponse& res) {
-        handler_func(static_cast<void*>(&req), static_cast<void*>(&res));
+    HTTPRequestHandler handler = [handler_ptr](HTTPRequest& req, HTTPResponse& res) {
+        jit_call_guarded("an HTTP request handler", handler_ptr, reinterpret_cast<int64_t>(&req),
+                         reinterpret_cast<int64_t>(&res));
     };
     
     auto server = std::make_unique<HTTPServer>();
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include <cstring>
 
 
@@ -273,6 +274,24 @@ struct GCObject {
     void* heapSize;
     void* heapUsed;
     void* nextGC;
+    void* stats;
+    void* allocationRate;
+    void* promotionRate;
+    void* sinceLastGC;
+    void* writeHeapSnapshot;
+    void* heapSummary;
+    void* startAllocationSampling;
+    void* stopAllocationSampling;
+    void* collectCycles;
+    void* cycleStats;
+    void* setHeapLimits;
+};
+
+struct ProfilerObject {
+    static constexpr const char* OBJECT_NAME = "profiler";
+    void* start;
+    void* stop;
+    void* running;
 };
 
 struct LockObject {
@@ -296,6 +315,7 @@ struct RuntimeObject {
     ConsoleObject console;
     JITObject jit;
     GCObject gc;
+    ProfilerObject profiler;
     LockObject lock;
     void* eval;
     void* compile;
@@ -310,11 +330,22 @@ struct RuntimeObject {
 
 extern RuntimeObject* global_runtime;
 
+// Value types at the runtime call boundary; the JIT types the call's result
+// from return_type and converts number arguments declared INT64
+enum class RuntimeValueType : uint8_t {
+    VOID,
+    INT64,
+    BOOLEAN,
+    STRING,   // GoTSString*
+    POINTER   // Opaque handle or callback
+};
+
 struct RuntimeMethodInfo {
     const char* object_path;
     void* function_pointer;
     bool is_async;
-    int arg_count;
+    RuntimeValueType return_type;
+    std::vector<RuntimeValueType> arg_types;
 };
 
 extern std::unordered_map<std::string, RuntimeMethodInfo> runtime_method_registry;
@@ -3,6 +3,9 @@
 #include "runtime_object.h"
 #include "lock_system.h"
 #include "ffi_syscalls.h"  // FFI functions
+#include "sampling_profiler.h"
+#include "gc_telemetry.h"
+#include "gc_heap_profiler.h"
 
 // Forward declaration for Date object
 // DateObject initialization removed
@@ -1780,17 +1783,57 @@ void initialize_runtime_object() {
     global_runtime->process.gid = reinterpret_cast<void*>(__runtime_process_gid);
     global_runtime->process.cwd = reinterpret_cast<void*>(__runtime_process_cwd);
     global_runtime->process.chdir = reinterpret_cast<void*>(__runtime_process_chdir);
+
+    // Initialize profiler object function pointers
+    global_runtime->profiler.start = reinterpret_cast<void*>(__runtime_profiler_start);
+    global_runtime->profiler.stop = reinterpret_cast<void*>(__runtime_profiler_stop);
+    global_runtime->profiler.running = reinterpret_cast<void*>(__runtime_profiler_running);
+
+    // Initialize gc object function pointers
+    global_runtime->gc.collect = reinterpret_cast<void*>(__runtime_gc_collect);
+    global_runtime->gc.heapSize = reinterpret_cast<void*>(__runtime_gc_heapSize);
+    global_runtime->gc.heapUsed = reinterpret_cast<void*>(__runtime_gc_heapUsed);
+    global_runtime->gc.nextGC = reinterpret_cast<void*>(__runtime_gc_nextGC);
+    global_runtime->gc.stats = reinterpret_cast<void*>(__runtime_gc_stats);
+    global_runtime->gc.allocationRate = reinterpret_cast<void*>(__runtime_gc_allocationRate);
+    global_runtime->gc.promotionRate = reinterpret_cast<void*>(__runtime_gc_promotionRate);
+    global_runtime->gc.sinceLastGC = reinterpret_cast<void*>(__runtime_gc_sinceLastGC);
+    global_runtime->gc.writeHeapSnapshot = reinterpret_cast<void*>(__runtime_gc_writeHeapSnapshot);
+    global_runtime->gc.heapSummary = reinterpret_cast<void*>(__runtime_gc_heapSummary);
+    global_runtime->gc.startAllocationSampling = reinterpret_cast<void*>(__runtime_gc_startAllocationSampling);
+    global_runtime->gc.stopAllocationSampling = reinterpret_cast<void*>(__runtime_gc_stopAllocationSampling);
+    global_runtime->gc.collectCycles = reinterpret_cast<void*>(__runtime_gc_collectCycles);
+    global_runtime->gc.cycleStats = reinterpret_cast<void*>(__runtime_gc_cycleStats);
+    global_runtime->gc.setHeapLimits = reinterpret_cast<void*>(__runtime_gc_setHeapLimits);
     // Register all methods for JIT optimization
-    runtime_method_registry["time.now"] = {"time.now", global_runtime->time.now_millis, false, 0};
-    runtime_method_registry["time.nowNanos"] = {"time.nowNanos", global_runtime->time.now_nanos, false, 0};
-    runtime_method_registry["date.now"] = {"date.now", global_runtime->date.now, false, 0};
-    runtime_method_registry["date.constructor"] = {"date.constructor", global_runtime->date.constructor, false, 1};
-    runtime_method_registry["process.pid"] = {"process.pid", global_runtime->process.pid, false, 0};
-    runtime_method_registry["process.cwd"] = {"process.cwd", global_runtime->process.cwd, false, 0};
-    runtime_method_registry["lock.create"] = {"lock.create", global_runtime->lock.create, false, 0};
-    runtime_method_registry["http.createServer"] = {"http.createServer", global_runtime->http.createServer, false, 1};
-    runtime_method_registry["http.get"] = {"http.get", global_runtime->http.get, true, 1};
-    runtime_method_registry["http.post"] = {"http.post", global_runtime->http.post, true, 2};
+    runtime_method_registry["time.now"] = {"time.now", global_runtime->time.now_millis, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["time.nowNanos"] = {"time.nowNanos", global_runtime->time.now_nanos, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["date.now"] = {"date.now", global_runtime->date.now, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["date.constructor"] = {"date.constructor", global_runtime->date.constructor, false, RuntimeValueType::POINTER, {RuntimeValueType::INT64}};
+    runtime_method_registry["process.pid"] = {"process.pid", global_runtime->process.pid, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["process.cwd"] = {"process.cwd", global_runtime->process.cwd, false, RuntimeValueType::STRING, {}};
+    runtime_method_registry["profiler.start"] = {"profiler.start", global_runtime->profiler.start, false, RuntimeValueType::BOOLEAN, {}};
+    runtime_method_registry["profiler.stop"] = {"profiler.stop", global_runtime->profiler.stop, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["profiler.running"] = {"profiler.running", global_runtime->profiler.running, false, RuntimeValueType::BOOLEAN, {}};
+    runtime_method_registry["gc.collect"] = {"gc.collect", global_runtime->gc.collect, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.heapSize"] = {"gc.heapSize", global_runtime->gc.heapSize, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.heapUsed"] = {"gc.heapUsed", global_runtime->gc.heapUsed, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.nextGC"] = {"gc.nextGC", global_runtime->gc.nextGC, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.stats"] = {"gc.stats", global_runtime->gc.stats, false, RuntimeValueType::STRING, {}};
+    runtime_method_registry["gc.allocationRate"] = {"gc.allocationRate", global_runtime->gc.allocationRate, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.promotionRate"] = {"gc.promotionRate", global_runtime->gc.promotionRate, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.sinceLastGC"] = {"gc.sinceLastGC", global_runtime->gc.sinceLastGC, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.writeHeapSnapshot"] = {"gc.writeHeapSnapshot", global_runtime->gc.writeHeapSnapshot, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.heapSummary"] = {"gc.heapSummary", global_runtime->gc.heapSummary, false, RuntimeValueType::STRING, {}};
+    runtime_method_registry["gc.startAllocationSampling"] = {"gc.startAllocationSampling", global_runtime->gc.startAllocationSampling, false, RuntimeValueType::BOOLEAN, {}};
+    runtime_method_registry["gc.stopAllocationSampling"] = {"gc.stopAllocationSampling", global_runtime->gc.stopAllocationSampling, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.collectCycles"] = {"gc.collectCycles", global_runtime->gc.collectCycles, false, RuntimeValueType::INT64, {}};
+    runtime_method_registry["gc.cycleStats"] = {"gc.cycleStats", global_runtime->gc.cycleStats, false, RuntimeValueType::STRING, {}};
+    runtime_method_registry["gc.setHeapLimits"] = {"gc.setHeapLimits", global_runtime->gc.setHeapLimits, false, RuntimeValueType::INT64, {RuntimeValueType::INT64, RuntimeValueType::INT64}};
+    runtime_method_registry["lock.create"] = {"lock.create", global_runtime->lock.create, false, RuntimeValueType::POINTER, {}};
+    runtime_method_registry["http.createServer"] = {"http.createServer", global_runtime->http.createServer, false, RuntimeValueType::POINTER, {RuntimeValueType::POINTER}};
+    runtime_method_registry["http.get"] = {"http.get", global_runtime->http.get, true, RuntimeValueType::POINTER, {RuntimeValueType::STRING}};
+    runtime_method_registry["http.post"] = {"http.post", global_runtime->http.post, true, RuntimeValueType::POINTER, {RuntimeValueType::STRING, RuntimeValueType::STRING}};
     // Add more as needed...
 }
 
@@ -0,0 +1,360 @@
+#include "sampling_profiler.h"
+#include "jit_symbols.h"
+#include <sched.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+// Frames further than this above the interrupted stack pointer are not trusted
+static constexpr uintptr_t MAX_STACK_SPAN = 64 * 1024 * 1024;
+
+static pid_t current_tid() {
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+// Fault-free read of another part of our own address space
+static bool safe_read(uintptr_t address, void* out, size_t size) {
+    struct iovec local = {out, size};
+    struct iovec remote = {reinterpret_cast<void*>(address), size};
+    return process_vm_readv(getpid(), &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size);
+}
+
+static void profiler_signal_handler(int, siginfo_t*, void* ucontext) {
+    int saved_errno = errno;
+    SamplingProfiler::instance().record_sample(ucontext);
+    errno = saved_errno;
+}
+
+// ============================================================================
+// SAMPLING
+// ============================================================================
+
+SamplingProfiler& SamplingProfiler::instance() {
+    // Leaked: a late SIGPROF may still arrive on another thread during exit
+    static SamplingProfiler* profiler = new SamplingProfiler();
+    return *profiler;
+}
+
+void SamplingProfiler::record_sample(void* ucontext) {
+    // Announce the handler before checking running_ so stop() cannot free the buffer under it
+    struct InFlight {
+        std::atomic<int>& count;
+        explicit InFlight(std::atomic<int>& c) : count(c) { count.fetch_add(1); }
+        ~InFlight() { count.fetch_sub(1, std::memory_order_release); }
+    } in_flight(handlers_in_flight_);
+    if (!running_.load()) return;
+
+    size_t index = next_sample_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Sample& sample = samples_[index];
+    const mcontext_t& mc = static_cast<ucontext_t*>(ucontext)->uc_mcontext;
+    uintptr_t rip = static_cast<uintptr_t>(mc.gregs[REG_RIP]);
+    uintptr_t rbp = static_cast<uintptr_t>(mc.gregs[REG_RBP]);
+    uintptr_t rsp = static_cast<uintptr_t>(mc.gregs[REG_RSP]);
+
+    uint32_t depth = 0;
+    sample.tid = current_tid();
+    sample.pcs[depth++] = rip;
+
+    // JIT code and the -O0 runtime keep frame pointers: [rbp] = caller rbp, [rbp+8] = return address.
+    // Optimized library code (libc, libstdc++) does not, so when the chain is broken we look for
+    // the next saved frame pointer on the stack and continue from there.
+    uintptr_t frame = rbp;
+    uintptr_t floor = rsp;
+    while (depth < MAX_STACK_DEPTH) {
+        if (frame < floor || frame >= rsp + MAX_STACK_SPAN || (frame & 7) != 0) {
+            frame = scan_for_frame(floor);
+            if (frame == 0) break;
+        }
+        uintptr_t record[2];
+        if (!safe_read(frame, record, sizeof(record)) || !is_code_address(record[1])) break;
+        sample.pcs[depth++] = record[1];
+        floor = frame + 16;  // Stacks grow down - callers live at higher addresses
+        frame = record[0];
+    }
+
+    sample.depth.store(depth, std::memory_order_release);
+}
+
+bool SamplingProfiler::is_code_address(uintptr_t address) const {
+    size_t count = code_range_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        if (address >= code_ranges_[i].start && address < code_ranges_[i].end) return true;
+    }
+    return false;
+}
+
+uintptr_t SamplingProfiler::scan_for_frame(uintptr_t from) const {
+    // A pushed frame pointer is a stack address just above its own slot, followed by a return address
+    uintptr_t words[STACK_SCAN_WORDS];
+    from = (from + 7) & ~static_cast<uintptr_t>(7);
+    struct iovec local = {words, sizeof(words)};
+    struct iovec remote = {reinterpret_cast<void*>(from), sizeof(words)};
+    ssize_t bytes = process_vm_readv(getpid(), &local, 1, &remote, 1, 0);
+    if (bytes <= 0) return 0;
+
+    size_t count = static_cast<size_t>(bytes) / sizeof(uintptr_t);
+    for (size_t i = 0; i + 1 < count; i++) {
+        uintptr_t slot = from + i * sizeof(uintptr_t);
+        uintptr_t saved = words[i];
+        if (saved > slot && saved < slot + MAX_STACK_SPAN && (saved & 7) == 0 && is_code_address(words[i + 1])) {
+            return slot;
+        }
+    }
+    return 0;
+}
+
+void SamplingProfiler::snapshot_code_ranges() {
+    // Executable mappings: the binary, shared libraries and the JIT code heap. Writable
+    // ones are skipped - an executable stack would make every stack address look like code.
+    // A sample racing with a refresh may misjudge one candidate frame, nothing worse.
+    std::vector<CodeRange> ranges;
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line) && ranges.size() < MAX_CODE_RANGES) {
+        unsigned long start = 0, end = 0;
+        char perms[5] = {0};
+        if (std::sscanf(line.c_str(), "%lx-%lx %4s", &start, &end, perms) == 3 && perms[2] == 'x' && perms[1] != 'w') {
+            ranges.push_back({static_cast<uintptr_t>(start), static_cast<uintptr_t>(end)});
+        }
+    }
+
+    code_range_count_.store(0, std::memory_order_release);
+    std::copy(ranges.begin(), ranges.end(), code_ranges_);
+    code_range_count_.store(ranges.size(), std::memory_order_release);
+}
+
+void SamplingProfiler::note_code_mapped() {
+    if (!running_.load()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot_code_ranges();
+}
+
+bool SamplingProfiler::install_signal_handler() {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = profiler_signal_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+        std::cerr << "[PROFILER] sigaction(SIGPROF) failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SamplingProfiler::arm_timer(ThreadEntry& entry) {
+    clockid_t clock;
+    if (pthread_getcpuclockid(entry.handle, &clock) != 0) {
+        return false;
+    }
+
+    struct sigevent event;
+    std::memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = entry.tid;
+    if (timer_create(clock, &event, &entry.timer) != 0) {
+        std::cerr << "[PROFILER] timer_create failed for thread " << entry.tid << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    long interval_ns = 1000000000L / std::max(1, frequency_hz_);
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = interval_ns / 1000000000L;
+    spec.it_interval.tv_nsec = interval_ns % 1000000000L;
+    spec.it_value = spec.it_interval;
+    timer_settime(entry.timer, 0, &spec, nullptr);
+    entry.timer_armed = true;
+    return true;
+}
+
+void SamplingProfiler::disarm_timer(ThreadEntry& entry) {
+    if (entry.timer_armed) {
+        timer_delete(entry.timer);
+        entry.timer_armed = false;
+    }
+}
+
+void SamplingProfiler::register_current_thread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pid_t tid = current_tid();
+    for (const ThreadEntry& entry : threads_) {
+        if (entry.tid == tid) return;
+    }
+    threads_.push_back({tid, pthread_self(), timer_t(), false});
+    if (running_.load()) {
+        arm_timer(threads_.back());
+    }
+}
+
+void SamplingProfiler::unregister_current_thread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pid_t tid = current_tid();
+    for (auto it = threads_.begin(); it != threads_.end(); ++it) {
+        if (it->tid == tid) {
+            disarm_timer(*it);
+            threads_.erase(it);
+            return;
+        }
+    }
+}
+
+bool SamplingProfiler::start(int frequency_hz, size_t sample_capacity) {
+    register_current_thread();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) return true;
+    if (!install_signal_handler()) return false;
+
+    frequency_hz_ = frequency_hz;
+    capacity_ = sample_capacity;
+    snapshot_code_ranges();
+    samples_.reset(new Sample[capacity_]);
+    for (size_t i = 0; i < capacity_; i++) {
+        samples_[i].depth.store(0, std::memory_order_relaxed);
+    }
+    next_sample_.store(0);
+    dropped_.store(0);
+    running_.store(true, std::memory_order_release);
+
+    for (ThreadEntry& entry : threads_) {
+        arm_timer(entry);
+    }
+    std::cout << "[PROFILER] Sampling " << threads_.size() << " thread(s) at " << frequency_hz_ << " Hz" << std::endl;
+    return true;
+}
+
+// ============================================================================
+// SYMBOLIZATION AND OUTPUT
+// ============================================================================
+
+size_t SamplingProfiler::stop(const std::string& output_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_.load()) return 0;
+        running_.store(false);
+        for (ThreadEntry& entry : threads_) {
+            disarm_timer(entry);
+        }
+    }
+    // timer_delete does not wait for handlers already running on other threads
+    while (handlers_in_flight_.load(std::memory_order_acquire) != 0) {
+        sched_yield();
+    }
+
+    // Aggregate identical stacks; names are cached per address
+    size_t recorded = std::min(next_sample_.load(), capacity_);
+    std::unordered_map<uintptr_t, std::string> names;
+    std::map<std::string, size_t> stacks;
+    size_t samples = 0;
+    for (size_t i = 0; i < recorded; i++) {
+        uint32_t depth = samples_[i].depth.load(std::memory_order_acquire);
+        if (depth == 0) continue;
+
+        std::string stack;
+        for (uint32_t frame = depth; frame-- > 0;) {
+            // Return addresses point after the call - look up the call instruction itself
+            uintptr_t pc = samples_[i].pcs[frame] - (frame > 0 ? 1 : 0);
+            auto it = names.find(pc);
+            if (it == names.end()) {
+                it = names.emplace(pc, symbolize_code_address(pc)).first;
+            }
+            if (!stack.empty()) stack += ';';
+            stack += it->second;
+        }
+        stacks[stack]++;
+        samples++;
+    }
+
+    last_stacks_.clear();
+    for (const auto& entry : stacks) {
+        last_stacks_.push_back(entry.first + " " + std::to_string(entry.second));
+    }
+
+    if (!output_path.empty()) {
+        std::ofstream out(output_path);
+        for (const std::string& line : last_stacks_) {
+            out << line << '\n';
+        }
+        std::cout << "[PROFILER] Wrote " << samples << " samples (" << stacks.size() << " unique stacks, "
+                  << dropped_.load() << " dropped) to " << output_path << std::endl;
+    }
+
+    samples_.reset();
+    capacity_ = 0;
+    return samples;
+}
+
+std::vector<std::string> SamplingProfiler::collapsed_stacks() const {
+    return last_stacks_;
+}
+
+// ============================================================================
+// C API
+// ============================================================================
+
+extern "C" {
+
+static int profiler_frequency_from_environment() {
+    int frequency = SamplingProfiler::DEFAULT_FREQUENCY_HZ;
+    if (const char* hz = std::getenv("ULTRASCRIPT_PROFILE_HZ")) {
+        frequency = std::max(1, std::atoi(hz));
+    }
+    return frequency;
+}
+
+bool __runtime_profiler_start() {
+    return SamplingProfiler::instance().start(profiler_frequency_from_environment());
+}
+
+int64_t __runtime_profiler_stop() {
+    SamplingProfiler& profiler = SamplingProfiler::instance();
+    std::string path = profiler.output_path();
+    if (path.empty()) {
+        path = "ultrascript-" + std::to_string(getpid()) + ".collapsed";
+    }
+    return static_cast<int64_t>(profiler.stop(path));
+}
+
+bool __runtime_profiler_running() {
+    return SamplingProfiler::instance().is_running();
+}
+
+void __profiler_start_from_environment() {
+    const char* path = std::getenv("ULTRASCRIPT_PROFILE");
+    if (!path || !path[0]) return;
+
+    SamplingProfiler& profiler = SamplingProfiler::instance();
+    profiler.set_output_path(path);
+    profiler.start(profiler_frequency_from_environment());
+}
+
+void __profiler_finish() {
+    SamplingProfiler& profiler = SamplingProfiler::instance();
+    if (profiler.is_running()) {
+        __runtime_profiler_stop();
+    }
+}
+
+}
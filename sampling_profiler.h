@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <pthread.h>
+#include <time.h>
+#include <vector>
+
+// ============================================================================
+// SAMPLING PROFILER - SIGPROF-driven CPU sampling for JIT and runtime code
+// ============================================================================
+//
+// Each registered thread (main thread, goroutine workers, FFI threads) gets a
+// timer on its own CPU-time clock that delivers SIGPROF to that thread only,
+// so idle workers cost nothing and busy ones are sampled in proportion to the
+// CPU they burn. The signal handler records the interrupted PC plus a frame
+// pointer walk into a preallocated buffer - no locks, no allocation, and every
+// stack read goes through process_vm_readv so a bad frame pointer cannot fault.
+//
+// Symbolization happens at stop(): JIT addresses are named through the
+// JITSymbolTable, runtime addresses through dladdr. The result is written as
+// collapsed stacks ("root;caller;leaf count") for flamegraph.pl / speedscope.
+//
+//   ULTRASCRIPT_PROFILE=<file>     profile the whole run, written at exit
+//   ULTRASCRIPT_PROFILE_HZ=<n>     sampling frequency (default 100)
+//   runtime.profiler.start() / runtime.profiler.stop()
+
+class SamplingProfiler {
+public:
+    static constexpr size_t MAX_STACK_DEPTH = 64;
+    static constexpr size_t DEFAULT_SAMPLE_CAPACITY = 16384;
+    static constexpr int DEFAULT_FREQUENCY_HZ = 100;
+    static constexpr size_t MAX_CODE_RANGES = 512;
+    static constexpr size_t STACK_SCAN_WORDS = 256;  // How far to look past a broken frame chain
+
+    struct Sample {
+        std::atomic<uint32_t> depth;  // Written last; 0 while the handler is still filling it
+        pid_t tid;
+        uintptr_t pcs[MAX_STACK_DEPTH];  // Leaf first
+    };
+
+    static SamplingProfiler& instance();
+
+    // Thread registration - threads registered while running are sampled immediately
+    void register_current_thread();
+    void unregister_current_thread();
+
+    bool start(int frequency_hz = DEFAULT_FREQUENCY_HZ, size_t sample_capacity = DEFAULT_SAMPLE_CAPACITY);
+    // Stops sampling and writes collapsed stacks to output_path (if non-empty).
+    // Returns the number of samples recorded.
+    size_t stop(const std::string& output_path);
+    bool is_running() const { return running_.load(std::memory_order_relaxed); }
+
+    void set_output_path(const std::string& path) { output_path_ = path; }
+    const std::string& output_path() const { return output_path_; }
+
+    // Call after new executable memory is mapped (JIT code heap growth)
+    void note_code_mapped();
+
+    // Collapsed stack lines for the samples of the last run
+    std::vector<std::string> collapsed_stacks() const;
+    size_t dropped_samples() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Called from the SIGPROF handler
+    void record_sample(void* ucontext);
+
+private:
+    struct ThreadEntry {
+        pid_t tid;
+        pthread_t handle;
+        timer_t timer;
+        bool timer_armed;
+    };
+
+    std::mutex mutex_;
+    std::vector<ThreadEntry> threads_;
+    struct CodeRange {
+        uintptr_t start;
+        uintptr_t end;
+    };
+
+    std::atomic<bool> running_{false};
+    // SIGPROF handlers past the running_ check; stop() waits for zero before reading or freeing samples_
+    std::atomic<int> handlers_in_flight_{0};
+    int frequency_hz_ = DEFAULT_FREQUENCY_HZ;
+    std::string output_path_;
+
+    std::unique_ptr<Sample[]> samples_;
+    size_t capacity_ = 0;
+    std::atomic<size_t> next_sample_{0};
+    std::atomic<size_t> dropped_{0};
+    std::vector<std::string> last_stacks_;
+
+    // Executable mappings captured at start(); read by the signal handler
+    CodeRange code_ranges_[MAX_CODE_RANGES];
+    std::atomic<size_t> code_range_count_{0};
+
+    SamplingProfiler() = default;
+    bool install_signal_handler();
+    bool arm_timer(ThreadEntry& entry);
+    void disarm_timer(ThreadEntry& entry);
+    void snapshot_code_ranges();
+    bool is_code_address(uintptr_t address) const;
+    uintptr_t scan_for_frame(uintptr_t from) const;
+};
+
+extern "C" {
+    // runtime.profiler.* entry points
+    bool __runtime_profiler_start();
+    int64_t __runtime_profiler_stop();
+    bool __runtime_profiler_running();
+
+    // Profile the whole run when ULTRASCRIPT_PROFILE is set; called by runtime init/cleanup
+    void __profiler_start_from_environment();
+    void __profiler_finish();
+}
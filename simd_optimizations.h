@@ -3,6 +3,7 @@
 #include <immintrin.h>
 #include <cstdint>
 #include <cstring>
+#include <new>
 
 
 
@@ -17,6 +18,7 @@ public:
     // ============================================================================
     
     // Process 32 cards simultaneously using AVX2
+    __attribute__((target("avx2")))
     static size_t scan_dirty_cards_avx2(uint8_t* card_table, size_t card_count, 
                                        uint32_t* dirty_indices, size_t max_indices) {
         size_t found_count = 0;
@@ -56,6 +58,7 @@ public:
     }
     
     // Clear multiple cards efficiently using SIMD
+    __attribute__((target("avx2")))
     static void clear_cards_avx2(uint8_t* card_table, size_t card_count) {
         size_t simd_count = card_count & ~31; // Round down to multiple of 32
         const __m256i zero_vec = _mm256_setzero_si256();
@@ -70,29 +73,52 @@ public:
     }
     
     // ============================================================================
-    // OBJECT HEADER OPERATIONS
+    // BITMAP OPERATIONS
     // ============================================================================
     
-    // Batch process object headers for GC marking
-    static void mark_objects_batch_avx2(void** objects, size_t count, uint32_t mark_bit) {
-        const __m256i mark_mask = _mm256_set1_epi32(mark_bit);
-        size_t simd_count = count & ~7; // Process 8 pointers at a time
-        
-        for (size_t i = 0; i < simd_count; i += 8) {
-            // Load 8 object pointers
-            __m256i obj_ptrs_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(objects + i));
-            __m256i obj_ptrs_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(objects + i + 4));
+    // Sweep one page's side bitmaps: dead = alloc & ~mark, alloc &= mark.
+    // Returns the number of cells still allocated. Callers check
+    // is_avx2_supported() first.
+    __attribute__((target("avx2,popcnt")))
+    static size_t sweep_bitmaps_avx2(uint64_t* alloc_bits, const uint64_t* mark_bits,
+                                     uint64_t* dead_bits, size_t words) {
+        size_t live = 0;
+        size_t simd_words = words & ~size_t(3); // 4 words per 256-bit vector
+        
+        for (size_t i = 0; i < simd_words; i += 4) {
+            __m256i alloc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(alloc_bits + i));
+            __m256i mark = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mark_bits + i));
             
-            // For each object, mark the header (would need custom implementation)
-            // This is a conceptual example - actual implementation would vary
+            // andnot computes ~mark & alloc
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dead_bits + i), _mm256_andnot_si256(mark, alloc));
+            __m256i survivors = _mm256_and_si256(alloc, mark);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(alloc_bits + i), survivors);
             
-            // Process remaining objects with scalar code
+            live += __builtin_popcountll(_mm256_extract_epi64(survivors, 0));
+            live += __builtin_popcountll(_mm256_extract_epi64(survivors, 1));
+            live += __builtin_popcountll(_mm256_extract_epi64(survivors, 2));
+            live += __builtin_popcountll(_mm256_extract_epi64(survivors, 3));
         }
         
-        // Handle remaining objects
-        for (size_t i = simd_count; i < count; ++i) {
+        // Handle remaining words
+        for (size_t i = simd_words; i < words; ++i) {
+            dead_bits[i] = alloc_bits[i] & ~mark_bits[i];
+            alloc_bits[i] &= mark_bits[i];
+            live += __builtin_popcountll(alloc_bits[i]);
+        }
+        
+        return live;
+    }
+    
+    // ============================================================================
+    // OBJECT HEADER OPERATIONS
+    // ============================================================================
+    
+    // Batch process object headers for GC marking. Each header is a separate
+    // read-modify-write at an unrelated address, so there is nothing to vectorize.
+    static void mark_objects_batch_avx2(void** objects, size_t count, uint32_t mark_bit) {
+        for (size_t i = 0; i < count; ++i) {
             if (objects[i]) {
-                // Mark object header (scalar implementation)
                 uint8_t* header = static_cast<uint8_t*>(objects[i]) - 8;
                 *reinterpret_cast<uint32_t*>(header + 4) |= mark_bit;
             }
@@ -103,7 +129,8 @@ public:
     // STRING OPERATIONS
     // ============================================================================
     
-    // Fast string comparison using SIMD
+    // Fast string comparison using SIMD. Callers check is_avx2_supported() first.
+    __attribute__((target("avx2")))
     static bool strings_equal_avx2(const char* str1, const char* str2, size_t length) {
         if (length == 0) return true;
         
@@ -125,7 +152,109 @@ public:
         return std::memcmp(str1 + simd_length, str2 + simd_length, length - simd_length) == 0;
     }
     
-    // Fast string hashing using SIMD
+    // Offset of the first byte that differs, or length when none does.
+    // Callers check is_avx2_supported() first.
+    __attribute__((target("avx2,bmi")))
+    static size_t first_difference_avx2(const char* str1, const char* str2, size_t length) {
+        size_t simd_length = length & ~size_t(31);
+
+        for (size_t i = 0; i < simd_length; i += 32) {
+            __m256i chunk1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str1 + i));
+            __m256i chunk2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str2 + i));
+            uint32_t equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk1, chunk2));
+            if (equal != 0xFFFFFFFF) {
+                return i + __builtin_ctz(~equal);
+            }
+        }
+
+        for (size_t i = simd_length; i < length; ++i) {
+            if (str1[i] != str2[i]) return i;
+        }
+        return length;
+    }
+
+    // Offset of the first occurrence of byte, or SIZE_MAX. Callers check
+    // is_avx2_supported() first.
+    __attribute__((target("avx2,bmi")))
+    static size_t find_byte_avx2(const char* str, size_t length, char byte) {
+        const __m256i target = _mm256_set1_epi8(byte);
+        size_t simd_length = length & ~size_t(31);
+
+        for (size_t i = 0; i < simd_length; i += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+            uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target));
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+
+        const void* found = std::memchr(str + simd_length, byte, length - simd_length);
+        return found ? static_cast<const char*>(found) - str : SIZE_MAX;
+    }
+
+    // Number of occurrences of byte. Callers check is_avx2_supported() first.
+    __attribute__((target("avx2,popcnt")))
+    static size_t count_byte_avx2(const char* str, size_t length, char byte) {
+        const __m256i target = _mm256_set1_epi8(byte);
+        size_t simd_length = length & ~size_t(31);
+        size_t count = 0;
+
+        for (size_t i = 0; i < simd_length; i += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+            count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target)));
+        }
+
+        for (size_t i = simd_length; i < length; ++i) {
+            count += str[i] == byte;
+        }
+
+        return count;
+    }
+
+    // Offset of the first occurrence of needle (2 bytes or longer), or
+    // SIZE_MAX. Compares the needle's first and last bytes against 32
+    // candidate positions at once and verifies the middle only where both
+    // match. Callers check is_avx2_supported() first.
+    __attribute__((target("avx2,bmi")))
+    static size_t find_substring_avx2(const char* haystack, size_t length,
+                                      const char* needle, size_t needle_length) {
+        if (needle_length > length) return SIZE_MAX;
+
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last = _mm256_set1_epi8(needle[needle_length - 1]);
+        size_t candidates = length - needle_length + 1;
+        size_t simd_candidates = candidates & ~size_t(31);
+
+        for (size_t i = 0; i < simd_candidates; i += 32) {
+            __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+            __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needle_length - 1));
+            __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+                                            _mm256_cmpeq_epi8(block_last, last));
+            uint32_t mask = _mm256_movemask_epi8(both);
+
+            while (mask != 0) {
+                size_t candidate = i + __builtin_ctz(mask);
+                if (std::memcmp(haystack + candidate + 1, needle + 1, needle_length - 2) == 0) {
+                    return candidate;
+                }
+                mask &= mask - 1;
+            }
+        }
+
+        // Handle remaining candidate positions
+        for (size_t i = simd_candidates; i < candidates; ++i) {
+            if (haystack[i] == needle[0] && std::memcmp(haystack + i, needle, needle_length) == 0) {
+                return i;
+            }
+        }
+
+        return SIZE_MAX;
+    }
+
+    // FNV-1a over unsigned bytes, the same value a scalar loop gives. The hash
+    // is one serial multiply chain, so this is no faster than that loop; the
+    // string pool uses the loop. Callers check is_avx2_supported() first.
+    __attribute__((target("avx2")))
     static uint64_t hash_string_avx2(const char* str, size_t length) {
         const uint64_t FNV_PRIME = 0x100000001b3ULL;
         const uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
@@ -137,17 +266,18 @@ public:
         for (size_t i = 0; i < simd_length; i += 32) {
             __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
             
-            // Extract bytes and hash them (simplified)
+            // FNV is serial per byte: spill the chunk and fold it in
+            alignas(32) uint8_t bytes[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(bytes), chunk);
             for (int j = 0; j < 32; ++j) {
-                uint8_t byte = _mm256_extract_epi8(chunk, j);
-                hash ^= byte;
+                hash ^= bytes[j];
                 hash *= FNV_PRIME;
             }
         }
         
         // Hash remaining bytes
         for (size_t i = simd_length; i < length; ++i) {
-            hash ^= str[i];
+            hash ^= static_cast<uint8_t>(str[i]);
             hash *= FNV_PRIME;
         }
         
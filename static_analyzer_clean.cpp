@@ -308,6 +308,26 @@ void StaticAnalyzer::traverse_ast_node_for_variables(ASTNode* node) {
         }
     }
     
+    // Exception handling
+    else if (auto* try_stmt = dynamic_cast<TryStatement*>(node)) {
+        for (const auto& stmt : try_stmt->try_body) {
+            traverse_ast_node_for_variables(stmt.get());
+        }
+        if (try_stmt->catch_clause) {
+            for (const auto& stmt : try_stmt->catch_clause->body) {
+                traverse_ast_node_for_variables(stmt.get());
+            }
+        }
+        for (const auto& stmt : try_stmt->finally_body) {
+            traverse_ast_node_for_variables(stmt.get());
+        }
+    }
+    else if (auto* throw_stmt = dynamic_cast<ThrowStatement*>(node)) {
+        if (throw_stmt->value) {
+            traverse_ast_node_for_variables(throw_stmt->value.get());
+        }
+    }
+    
     // Property access
     else if (auto* prop_access = dynamic_cast<PropertyAccess*>(node)) {
         // Object name might be a variable reference
@@ -0,0 +1,112 @@
+#include "string_search.h"
+#include "simd_optimizations.h"
+#include <algorithm>
+#include <cstring>
+
+static bool use_avx2() {
+    static const bool supported = SIMDOptimizations::is_avx2_supported();
+    return supported;
+}
+
+static size_t find_byte(const char* str, size_t length, char byte) {
+    if (use_avx2()) {
+        return SIMDOptimizations::find_byte_avx2(str, length, byte);
+    }
+    const void* found = std::memchr(str, byte, length);
+    return found ? static_cast<const char*>(found) - str : STRING_SEARCH_NOT_FOUND;
+}
+
+static size_t count_byte(const char* str, size_t length, char byte) {
+    if (use_avx2()) {
+        return SIMDOptimizations::count_byte_avx2(str, length, byte);
+    }
+    size_t count = 0;
+    for (const char* at = str; (at = static_cast<const char*>(std::memchr(at, byte, str + length - at))); at++) {
+        count++;
+    }
+    return count;
+}
+
+size_t string_search_find(const char* haystack, size_t length,
+                          const char* needle, size_t needle_length, size_t from) {
+    if (from > length) return STRING_SEARCH_NOT_FOUND;
+    if (needle_length == 0) return from;
+    const char* start = haystack + from;
+    size_t remaining = length - from;
+    if (needle_length > remaining) return STRING_SEARCH_NOT_FOUND;
+
+    size_t found;
+    if (needle_length == 1) {
+        found = find_byte(start, remaining, needle[0]);
+    } else if (use_avx2()) {
+        found = SIMDOptimizations::find_substring_avx2(start, remaining, needle, needle_length);
+    } else {
+        // memchr to each first byte, then compare
+        found = STRING_SEARCH_NOT_FOUND;
+        size_t last_start = remaining - needle_length;
+        for (size_t i = 0; i <= last_start; i++) {
+            const void* hit = std::memchr(start + i, needle[0], last_start - i + 1);
+            if (!hit) break;
+            i = static_cast<const char*>(hit) - start;
+            if (std::memcmp(start + i + 1, needle + 1, needle_length - 1) == 0) {
+                found = i;
+                break;
+            }
+        }
+    }
+    return found == STRING_SEARCH_NOT_FOUND ? found : from + found;
+}
+
+size_t string_search_count(const char* haystack, size_t length,
+                           const char* needle, size_t needle_length) {
+    if (needle_length == 0) return 0;
+    if (needle_length == 1) return count_byte(haystack, length, needle[0]);
+    size_t count = 0;
+    size_t at = 0;
+    while ((at = string_search_find(haystack, length, needle, needle_length, at)) != STRING_SEARCH_NOT_FOUND) {
+        count++;
+        at += needle_length;
+    }
+    return count;
+}
+
+std::vector<std::string> string_search_split(const char* text, size_t length,
+                                             const char* separator, size_t separator_length,
+                                             int limit) {
+    std::vector<std::string> pieces;
+    size_t max_pieces = limit < 0 ? SIZE_MAX : static_cast<size_t>(limit);
+    if (max_pieces == 0) return pieces;
+
+    if (separator_length == 0) {
+        size_t count = std::min(length, max_pieces);
+        pieces.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            pieces.emplace_back(text + i, 1);
+        }
+        return pieces;
+    }
+
+    // One pass to size the result, so a long split does not regrow it
+    if (separator_length == 1) {
+        pieces.reserve(std::min(count_byte(text, length, separator[0]) + 1, max_pieces));
+    }
+
+    size_t piece_start = 0;
+    size_t at;
+    while (pieces.size() < max_pieces &&
+           (at = string_search_find(text, length, separator, separator_length, piece_start)) != STRING_SEARCH_NOT_FOUND) {
+        pieces.emplace_back(text + piece_start, at - piece_start);
+        piece_start = at + separator_length;
+    }
+    if (pieces.size() < max_pieces) {
+        pieces.emplace_back(text + piece_start, length - piece_start);
+    }
+    return pieces;
+}
+
+bool string_search_is_literal(const std::string& pattern, const std::string& flags) {
+    if (pattern.empty()) return false;
+    // Case-insensitive and sticky matching change what a literal matches
+    if (flags.find_first_of("iy") != std::string::npos) return false;
+    return pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// STRING SEARCH - Substring, byte count and split kernels
+// ============================================================================
+//
+// Backs indexOf / includes / startsWith / split on GoTSString and the
+// literal-pattern fast paths of string_regex. Each call picks the AVX2
+// kernel from simd_optimizations.h when the CPU has it (checked once) and
+// a memchr/memcmp loop otherwise:
+//
+//   - substrings are found by filtering 32 positions at a time on the
+//     needle's first and last bytes, then verifying the candidates
+//   - single-byte needles (the common split separators) use a byte scan,
+//     and split counts the separators first to size its result once
+
+static constexpr size_t STRING_SEARCH_NOT_FOUND = SIZE_MAX;
+
+// Offset of the first occurrence of needle at or after from
+size_t string_search_find(const char* haystack, size_t length,
+                          const char* needle, size_t needle_length, size_t from = 0);
+
+// Non-overlapping occurrences of needle; 0 for an empty needle
+size_t string_search_count(const char* haystack, size_t length,
+                           const char* needle, size_t needle_length);
+
+// JavaScript split: the pieces between every occurrence of separator, or
+// one piece per byte for an empty separator. limit < 0 means no limit.
+std::vector<std::string> string_search_split(const char* text, size_t length,
+                                             const char* separator, size_t separator_length,
+                                             int limit = -1);
+
+// True when a regex source matches only itself: no metacharacters and no
+// flags that change what a literal matches
+bool string_search_is_literal(const std::string& pattern, const std::string& flags = "");
@@ -0,0 +1,110 @@
+// Closure pool test program
+#include "closure_pool.h"
+#include "x86_codegen_v2.h"
+#include <sys/mman.h>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    std::cout << "=== UltraScript Closure Pool Test ===" << std::endl;
+    int failures = 0;
+    ClosurePool& pool = ClosurePool::instance();
+
+    // Test 1: Freed blocks are reused by the next allocation of the same class
+    std::cout << "\n1. Testing free-list reuse..." << std::endl;
+    void* first = pool.allocate(24);
+    pool.deallocate(first);
+    void* second = pool.allocate(32);  // Same 32-byte class
+    std::cout << "first=" << first << " second=" << second << std::endl;
+    if (first != second || !pool.owns(first)) failures++;
+    pool.deallocate(second);
+
+    // Test 2: Consecutive allocations bump through one slab
+    std::cout << "\n2. Testing bump allocation..." << std::endl;
+    char* a = static_cast<char*>(pool.allocate(48));
+    char* b = static_cast<char*>(pool.allocate(48));
+    std::cout << "stride=" << (b - a) << std::endl;
+    if (b - a != 48) failures++;
+    pool.deallocate(a);
+    pool.deallocate(b);
+
+    // Test 3: Oversized blocks fall back to malloc
+    std::cout << "\n3. Testing malloc fallback..." << std::endl;
+    void* large = pool.allocate(ClosurePool::MAX_POOLED_SIZE + 1);
+    std::cout << "large owned by pool: " << pool.owns(large) << std::endl;
+    if (pool.owns(large)) failures++;
+    pool.deallocate(large);
+
+    // Test 4: Blocks allocated on one thread and freed on others come back to the owner
+    std::cout << "\n4. Testing cross-thread return..." << std::endl;
+    const size_t count = 10000;
+    std::vector<void*> blocks;
+    for (size_t i = 0; i < count; i++) {
+        void* block = pool.allocate(64);
+        std::memset(block, 0xAB, 64);
+        blocks.push_back(block);
+    }
+    uint64_t slabs_before = pool.stats().slabs;
+    std::vector<std::thread> freers;
+    for (int t = 0; t < 4; t++) {
+        freers.emplace_back([&blocks, t, count]() {
+            for (size_t i = t; i < count; i += 4) {
+                ClosurePool::instance().deallocate(blocks[i]);
+            }
+        });
+    }
+    for (auto& thread : freers) thread.join();
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = pool.allocate(64);
+    }
+    ClosurePool::Stats stats = pool.stats();
+    std::cout << "remote frees=" << stats.remote_frees << " new slabs=" << (stats.slabs - slabs_before) << std::endl;
+    if (stats.remote_frees < count || stats.slabs != slabs_before) failures++;
+    for (void* block : blocks) pool.deallocate(block);
+
+    // Test 5: JIT scope allocation pops the free list and bumps inline, and
+    // calls out for threads without a cache and for oversized scopes
+    std::cout << "\n5. Testing JIT scope allocation..." << std::endl;
+    auto build_scope_alloc = [](size_t scope_size) {
+        X86CodeGenV2 codegen;
+        X86InstructionBuilder& builder = codegen.get_instruction_builder();
+        builder.push(X86Reg::R15);  // Also realigns rsp for the slow-path call
+        codegen.emit_scope_alloc(scope_size);
+        builder.mov(X86Reg::RAX, X86Reg::R15);
+        builder.pop(X86Reg::R15);
+        codegen.emit_ret();
+        std::vector<uint8_t> code = codegen.get_code();
+        void* exec = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        std::memcpy(exec, code.data(), code.size());
+        return reinterpret_cast<char* (*)()>(exec);
+    };
+    const size_t header = 24;  // GC scope header in front of the scope
+    auto jit_scope = build_scope_alloc(64 - header);
+    void* freed = pool.allocate(64);
+    pool.deallocate(freed);
+    uint64_t allocations_before = pool.stats().allocations;
+    char* popped = jit_scope() - header;
+    char* bumped = jit_scope() - header;
+    uint64_t counted = pool.stats().allocations - allocations_before;
+    std::cout << "reused freed block=" << (popped == freed) << " bumped=" << static_cast<void*>(bumped)
+              << " counted=" << counted << std::endl;
+    if (popped != freed || !pool.owns(bumped) || bumped == popped || counted != 2) failures++;
+    pool.deallocate(popped);
+    pool.deallocate(bumped);
+    std::thread([&]() {
+        // A fresh thread has no cache: the first scope comes from the call
+        char* first = jit_scope() - header;
+        char* second = jit_scope() - header;
+        if (!pool.owns(first) || !pool.owns(second) || first == second) failures++;
+        pool.deallocate(first);
+        pool.deallocate(second);
+    }).join();
+    char* oversized = build_scope_alloc(ClosurePool::MAX_POOLED_SIZE)() - header;
+    if (pool.owns(oversized)) failures++;
+    pool.deallocate(oversized);
+
+    std::cout << "\n" << (failures == 0 ? "All closure pool tests passed" : "Closure pool tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+// Exception unwinder test program: finally landing pads run as emitted machine
+// code, registered in the exception tables the way the compiler does it
+#include "x86_codegen_v2.h"
+#include "exception_unwinder.h"
+#include "closure_pool.h"
+#include "gc_stack_maps.h"
+#include <sys/mman.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef int64_t (*EntryFn)();
+
+struct EmittedCode {
+    uint8_t* base = nullptr;
+    std::unordered_map<std::string, int64_t> labels;
+
+    EntryFn entry(const std::string& label) const {
+        return reinterpret_cast<EntryFn>(base + labels.at(label));
+    }
+};
+
+// Copies the code into executable memory and registers its exception tables
+static EmittedCode install(X86CodeGenV2& codegen) {
+    std::vector<uint8_t> code = codegen.get_code();
+    EmittedCode emitted;
+    emitted.labels = codegen.get_label_offsets();
+    void* exec = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(exec, code.data(), code.size());
+    emitted.base = static_cast<uint8_t*>(exec);
+
+    uintptr_t code_base = reinterpret_cast<uintptr_t>(exec);
+    std::vector<ExceptionRegion> regions;
+    for (const auto& region : codegen.get_exception_regions()) {
+        regions.push_back({code_base + region.start_offset, code_base + region.end_offset,
+                           code_base + static_cast<uintptr_t>(emitted.labels.at(region.landing_pad_label)),
+                           region.scope_depth});
+    }
+    std::vector<FrameUnwindInfo> frames;
+    for (const auto& record : codegen.get_frame_unwind_records()) {
+        FrameUnwindInfo info{code_base + record.start_offset, {}, record.allocates_scopes};
+        for (X86Reg reg : record.saved_registers) {
+            info.saved_registers.push_back(static_cast<uint8_t>(reg));
+        }
+        frames.push_back(std::move(info));
+    }
+    ExceptionTableRegistry::instance().register_code(code_base, code.size(), std::move(regions), std::move(frames));
+    return emitted;
+}
+
+static void begin_function(X86CodeGenV2& codegen, const std::string& name) {
+    codegen.emit_label(name);
+    codegen.set_stack_frame_size(24);
+    codegen.emit_prologue();
+}
+
+// Emits `throw value` with the value in RDI
+static void emit_throw(X86CodeGenV2& codegen, int64_t value) {
+    codegen.emit_mov_reg_imm(7, value);
+    codegen.emit_call("__runtime_throw_exception");
+}
+
+int main() {
+    std::cout << "=== UltraScript Exception Unwinder Test ===" << std::endl;
+    int failures = 0;
+
+    X86CodeGenV2 codegen;
+    codegen.add_saved_register(X86Reg::RBX);
+    codegen.add_saved_register(X86Reg::R12);
+
+    // catch_outer() { try { work(); return -1; } catch (e) { return e; } }
+    begin_function(codegen, "catch_outer");
+    codegen.begin_exception_region("catch_outer_pad");
+    codegen.emit_call("work");
+    codegen.end_exception_region();
+    codegen.emit_mov_reg_imm(0, -1);
+    codegen.emit_jump("catch_outer_done");
+    codegen.emit_landing_pad("catch_outer_pad");
+    codegen.emit_label("catch_outer_done");
+    codegen.emit_epilogue();
+
+    // work() { try { throw 111; } finally { try { throw 222; } catch (e) {} } }
+    begin_function(codegen, "work");
+    codegen.begin_exception_region("work_finally");
+    emit_throw(codegen, 111);
+    codegen.end_exception_region();
+    codegen.emit_jump("work_done");
+    codegen.emit_landing_pad("work_finally");
+    codegen.emit_save_pending_exception();
+    codegen.begin_exception_region("work_finally_catch");
+    emit_throw(codegen, 222);
+    codegen.end_exception_region();
+    codegen.emit_landing_pad("work_finally_catch");
+    codegen.emit_throw_pending_exception();
+    codegen.emit_label("work_done");
+    codegen.emit_epilogue();
+
+    // leave() { try { throw 333; } finally { return 7; } return -1; }
+    begin_function(codegen, "leave");
+    codegen.begin_exception_region("leave_finally");
+    emit_throw(codegen, 333);
+    codegen.end_exception_region();
+    codegen.emit_jump("leave_done");
+    codegen.emit_landing_pad("leave_finally");
+    codegen.emit_save_pending_exception();
+    codegen.emit_mov_reg_imm(0, 7);
+    codegen.emit_function_return();
+    codegen.emit_label("leave_done");
+    codegen.emit_mov_reg_imm(0, -1);
+    codegen.emit_epilogue();
+
+    // thrower() { throw 555; }
+    begin_function(codegen, "thrower");
+    emit_throw(codegen, 555);
+    codegen.emit_epilogue();
+
+    EmittedCode code = install(codegen);
+
+    // Frames that enter scopes save r15, the scope their caller was in. The
+    // map's reference slot puts the scopes on the scope chain.
+    static const GCStackMap scope_map{16, {0}};
+    X86CodeGenV2 scoped;
+    scoped.add_saved_register(X86Reg::RBX);
+    scoped.add_saved_register(X86Reg::R15);
+
+    // scope_catch() { try { scope_throw(); } catch (e) {} return 1; }
+    begin_function(scoped, "scope_catch");
+    scoped.begin_exception_region("scope_catch_pad");
+    scoped.emit_call("scope_throw");
+    scoped.end_exception_region();
+    scoped.emit_landing_pad("scope_catch_pad");
+    scoped.emit_mov_reg_imm(0, 1);
+    scoped.emit_epilogue();
+
+    // scope_throw() { let a; { let b; throw 444; } }
+    begin_function(scoped, "scope_throw");
+    scoped.emit_scope_alloc(scope_map.scope_size);
+    scoped.emit_gc_scope_link(&scope_map);
+    scoped.emit_scope_alloc(scope_map.scope_size);
+    scoped.emit_gc_scope_link(&scope_map);
+    emit_throw(scoped, 444);
+    scoped.emit_scope_free(true);
+    scoped.emit_scope_free(true);
+    scoped.emit_epilogue();
+
+    // scope_keep() { let a; try { let b; throw 666; } catch (e) {} return 1; }
+    begin_function(scoped, "scope_keep");
+    scoped.emit_scope_alloc(scope_map.scope_size);
+    scoped.emit_gc_scope_link(&scope_map);
+    scoped.begin_exception_region("scope_keep_pad");
+    scoped.emit_scope_alloc(scope_map.scope_size);
+    scoped.emit_gc_scope_link(&scope_map);
+    emit_throw(scoped, 666);
+    scoped.emit_scope_free(true);
+    scoped.end_exception_region();
+    scoped.emit_landing_pad("scope_keep_pad");
+    scoped.emit_scope_free(true);
+    scoped.emit_mov_reg_imm(0, 1);
+    scoped.emit_epilogue();
+
+    EmittedCode scoped_code = install(scoped);
+
+    // Test 1: A try/catch inside a finally body does not replace the exception
+    // the finally landing pad resumed with
+    std::cout << "\n1. Testing rethrow after a finally body that catches..." << std::endl;
+    int64_t caught = code.entry("catch_outer")();
+    std::cout << "caught=" << caught << std::endl;
+    if (caught != 111) failures++;
+
+    // Test 2: Returning from a finally body that holds a pending exception
+    // restores the caller's frame
+    std::cout << "\n2. Testing return from a finally body..." << std::endl;
+    int64_t returned = code.entry("leave")();
+    std::cout << "returned=" << returned << std::endl;
+    if (returned != 7) failures++;
+
+    // Test 3: An exception no script frame catches is handed back to the
+    // native caller at the runtime-to-JIT boundary
+    std::cout << "\n3. Testing an exception escaping to the runtime..." << std::endl;
+    int64_t value = 0;
+    bool completed = jit_call_guarded("the unwinder test", reinterpret_cast<void*>(code.entry("thrower")), 0, 0, &value);
+    std::cout << "completed=" << completed << std::endl;
+    if (completed) failures++;
+    value = 0;
+    completed = jit_call_guarded("the unwinder test", reinterpret_cast<void*>(code.entry("leave")), 0, 0, &value);
+    std::cout << "completed=" << completed << " value=" << value << std::endl;
+    if (!completed || value != 7) failures++;
+
+    // Test 4: Scopes entered by unwound frames, and by a try body left for its
+    // landing pad, are freed and taken off the scope chain
+    std::cout << "\n4. Testing scopes released while unwinding..." << std::endl;
+    ClosurePool::Stats before = ClosurePool::instance().stats();
+    void* chain_before = gc_scope_chain_save();
+    int64_t unwound = scoped_code.entry("scope_catch")();
+    int64_t kept = scoped_code.entry("scope_keep")();
+    ClosurePool::Stats after = ClosurePool::instance().stats();
+    uint64_t allocated = after.allocations - before.allocations;
+    uint64_t freed = after.frees - before.frees;
+    std::cout << "allocated=" << allocated << " freed=" << freed << std::endl;
+    if (unwound != 1 || kept != 1) failures++;
+    if (allocated != 4 || freed != 4) failures++;
+    if (gc_scope_chain_save() != chain_before) failures++;
+
+    if (failures) {
+        std::cout << "\n" << failures << " exception unwinder test(s) FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "\nAll exception unwinder tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,659 @@
+// GC heap, size-class pages, thread-local allocation, generations, concurrent and parallel marking, lazy sweeping, compaction, stack maps, telemetry, heap profiler, heap limits, malloc-free pauses test program
+#include "gc_system.h"
+#include "gc_heap_profiler.h"
+#include "x86_codegen_v2.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Every malloc and free while the world is stopped, outside the mutator
+// threads the tests park. A parked thread may hold the malloc lock, so
+// collections must not make any.
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void __libc_free(void* ptr);
+static std::atomic<size_t> mallocs_while_stopped{0};
+static thread_local bool parked_mutator = false;
+
+static void count_malloc() {
+    if (!parked_mutator && GCHeap::world_stopped()) mallocs_while_stopped.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void* malloc(size_t size) { count_malloc(); return __libc_malloc(size); }
+extern "C" void* calloc(size_t count, size_t size) { count_malloc(); return __libc_calloc(count, size); }
+extern "C" void* realloc(void* ptr, size_t size) { count_malloc(); return __libc_realloc(ptr, size); }
+extern "C" void free(void* ptr) { if (ptr) count_malloc(); __libc_free(ptr); }
+
+// Not static, so the sampler can name it through the dynamic symbol table
+__attribute__((noinline)) void allocate_for_sampling(std::vector<void*>& out, int count) {
+    for (int i = 0; i < count; i++) out.push_back(GarbageCollector::instance().gc_alloc(24, 1));
+}
+
+int main() {
+    std::cout << "=== UltraScript GC Heap Test ===" << std::endl;
+    int failures = 0;
+    GCHeap& heap = GCHeap::instance();
+    GarbageCollector& gc = GarbageCollector::instance();
+    gc.set_nursery_size(SIZE_MAX);  // Collections below run only when the tests ask for them
+    gc.set_compaction_threshold(2.0);  // Nor do they move objects unless asked to
+
+    // Test 1: Consecutive allocations bump through the thread's buffer
+    std::cout << "\n1. Testing bump allocation..." << std::endl;
+    char* a = static_cast<char*>(gc.gc_alloc(24, 4));
+    char* b = static_cast<char*>(gc.gc_alloc(24, 4));
+    std::cout << "a=" << static_cast<void*>(a) << " stride=" << (b - a) << std::endl;
+    if (!heap.contains(a) || b - a != static_cast<ptrdiff_t>(gc_cell_size_for(24))) failures++;
+    if (GCHeap::header_of(b)->size != 24 || GCHeap::header_of(b)->type_id != 4) failures++;
+    if (reinterpret_cast<uintptr_t>(a) % GC_CELL_ALIGNMENT != 0) failures++;
+
+    // Test 2: Size classes are segregated into their own pages; interior
+    // pointers resolve to their object by address arithmetic
+    std::cout << "\n2. Testing size-class pages..." << std::endl;
+    char* small = static_cast<char*>(gc.gc_alloc(8, 4));
+    char* medium = static_cast<char*>(gc.gc_alloc(1000, 4));
+    char* medium2 = static_cast<char*>(gc.gc_alloc(1000, 4));
+    size_t medium_cell = gc_size_classes.cells[gc_size_class_for(gc_cell_size_for(1000))];
+    std::cout << "small page=" << (reinterpret_cast<uintptr_t>(small) / GC_PAGE_SIZE)
+              << " medium page=" << (reinterpret_cast<uintptr_t>(medium) / GC_PAGE_SIZE)
+              << " medium stride=" << (medium2 - medium) << std::endl;
+    if (reinterpret_cast<uintptr_t>(small) / GC_PAGE_SIZE == reinterpret_cast<uintptr_t>(medium) / GC_PAGE_SIZE) failures++;
+    if (medium2 - medium != static_cast<ptrdiff_t>(medium_cell)) failures++;
+    heap.snapshot_objects();
+    if (heap.find_object(medium + 500) != medium || heap.find_object(small + 4) != small) failures++;
+    gc.gc_free(small);
+    gc.gc_free(medium);
+    gc.gc_free(medium2);
+
+    // Test 3: Many threads allocate concurrently; every object stays intact and walkable
+    std::cout << "\n3. Testing concurrent allocation..." << std::endl;
+    const size_t threads = 8;
+    const size_t per_thread = 20000;
+    std::vector<std::vector<uint64_t*>> objects(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&objects, t, per_thread]() {
+            for (size_t i = 0; i < per_thread; i++) {
+                uint64_t* obj = static_cast<uint64_t*>(__gc_alloc(16 + (i % 7) * 8, 4));
+                obj[0] = t;
+                obj[1] = i;
+                objects[t].push_back(obj);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    size_t corrupted = 0;
+    for (size_t t = 0; t < threads; t++) {
+        for (size_t i = 0; i < per_thread; i++) {
+            if (objects[t][i][0] != t || objects[t][i][1] != i) corrupted++;
+        }
+    }
+    heap.snapshot_objects();
+    size_t walked = 0;
+    heap.for_each_object([&walked](char*, GCObjectHeader*) { walked++; });
+    std::cout << "corrupted=" << corrupted << " walked=" << walked << std::endl;
+    if (corrupted != 0 || walked != threads * per_thread + 2) failures++;
+
+    // Test 4: Unreachable objects are swept and their pages given back
+    std::cout << "\n4. Testing collection..." << std::endl;
+    void* kept = gc.gc_alloc(64, 4);
+    gc.add_root(&kept);
+    size_t committed_before = heap.committed_bytes();
+    gc.collect();
+    heap.snapshot_objects();
+    walked = 0;
+    heap.for_each_object([&walked](char*, GCObjectHeader*) { walked++; });
+    std::cout << "walked=" << walked << " committed " << committed_before << " -> " << heap.committed_bytes() << std::endl;
+    if (!heap.is_object_start(kept) || heap.is_object_start(a) || walked != 1) failures++;
+    if (heap.committed_bytes() >= committed_before) failures++;
+    gc.remove_root(&kept);
+
+    // Test 5: Cells freed by a sweep are handed out again, zeroed
+    std::cout << "\n5. Testing cell reuse..." << std::endl;
+    std::vector<uint64_t*> batch;
+    std::thread([&batch]() {
+        for (int i = 0; i < 100; i++) {
+            uint64_t* obj = static_cast<uint64_t*>(__gc_alloc(200, 4));
+            obj[0] = 0xdeadbeef;
+            batch.push_back(obj);
+        }
+    }).join();
+    void* survivor = batch[50];
+    gc.add_root(&survivor);
+    gc.collect();
+    gc.remove_root(&survivor);
+    uint64_t* reused = nullptr;
+    std::thread([&reused]() { reused = static_cast<uint64_t*>(__gc_alloc(200, 4)); }).join();
+    std::cout << "reused=" << reused << " first freed=" << batch[0] << std::endl;
+    if (reused != batch[0] || reused[0] != 0) failures++;
+
+    // Test 6: Large objects get their own pages
+    std::cout << "\n6. Testing large objects..." << std::endl;
+    void* large = gc.gc_alloc(GC_PAGE_SIZE * 2, 4);
+    bool large_flag = GCHeap::header_of(large)->flags & GCObjectHeader::LARGE_OBJECT;
+    std::cout << "large=" << large << " flagged=" << large_flag << std::endl;
+    if (!large || !large_flag || static_cast<char*>(large)[GC_PAGE_SIZE * 2 - 1] != 0) failures++;
+    gc.gc_free(large);
+
+    // Test 7: The JIT inline fast path produces the same cells as the runtime
+    std::cout << "\n7. Testing JIT inline allocation..." << std::endl;
+    X86CodeGenV2 codegen;
+    codegen.emit_sub_reg_imm(4, 8);  // Keep rsp 16-byte aligned for the slow-path call
+    codegen.emit_gc_alloc_inline(40, 7, 0);
+    codegen.emit_add_reg_imm(4, 8);
+    codegen.emit_ret();
+    std::vector<uint8_t> code = codegen.get_code();
+    void* exec = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(exec, code.data(), code.size());
+    auto jit_alloc = reinterpret_cast<void* (*)()>(exec);
+    char* first = static_cast<char*>(jit_alloc());
+    char* second = static_cast<char*>(jit_alloc());
+    char* runtime = static_cast<char*>(gc.gc_alloc(40, 7));
+    std::cout << "first=" << static_cast<void*>(first) << " stride=" << (second - first)
+              << " runtime stride=" << (runtime - second) << std::endl;
+    GCObjectHeader* header = GCHeap::header_of(second);
+    ptrdiff_t stride = gc_size_classes.cells[gc_size_class_for(gc_cell_size_for(40))];
+    if (!heap.contains(first) || second - first != stride || runtime - second != stride) failures++;
+    if (header->size != 40 || header->type_id != 7 || header->flags != 0) failures++;
+    std::thread([&]() {
+        // A fresh thread has no buffer: the first call takes the slow path
+        char* other = static_cast<char*>(jit_alloc());
+        if (!heap.contains(other) || GCHeap::header_of(other)->type_id != 7) failures++;
+    }).join();
+    munmap(exec, code.size());
+
+    // Test 8: Minor collections copy root-only survivors, pin conservatively
+    // referenced ones, and promote both after GC_PROMOTION_AGE collections
+    std::cout << "\n8. Testing minor collections..." << std::endl;
+    void** parent = static_cast<void**>(gc.gc_alloc(48, 4));
+    void* child = gc.gc_alloc(32, 4);
+    void* garbage = gc.gc_alloc(32, 4);
+    parent[0] = child;
+    void* parent_root = parent;
+    gc.add_root(&parent_root);
+    gc.collect_young();
+    void** moved = static_cast<void**>(parent_root);
+    std::cout << "parent " << static_cast<void*>(parent) << " -> " << parent_root
+              << " child generation=" << int(GCHeap::header_of(child)->generation) << std::endl;
+    if (moved == parent || !heap.is_object_start(moved) || moved[0] != child) failures++;
+    if (GCHeap::header_of(moved)->generation != 1 || GCHeap::header_of(child)->generation != 1) failures++;
+    if (heap.is_object_start(garbage) || heap.is_object_start(parent)) failures++;
+    gc.collect_young();
+    void** old_parent = static_cast<void**>(parent_root);
+    if (!gc_is_old(GCHeap::header_of(old_parent)) || !gc_is_old(GCHeap::header_of(child))) failures++;
+    if (old_parent[0] != child || !heap.is_object_start(child)) failures++;
+
+    // Test 9: An old-to-young store recorded by the write barrier keeps the young object alive
+    std::cout << "\n9. Testing card marking..." << std::endl;
+    gc.collect_young();  // Cleans the cards left by the promotions
+    void* young = gc.gc_alloc(64, 4);
+    old_parent[1] = young;
+    heap.dirty_card(&old_parent[1]);
+    gc.collect_young();
+    std::cout << "young alive=" << heap.is_object_start(young)
+              << " generation=" << int(GCHeap::header_of(young)->generation) << std::endl;
+    if (!heap.is_object_start(young) || GCHeap::header_of(young)->generation != 1) failures++;
+
+    // The JIT barrier dirties the same card and ignores addresses outside the heap
+    X86CodeGenV2 barrier_gen;
+    barrier_gen.emit_gc_write_barrier(7, 16);  // rdi = object
+    barrier_gen.emit_ret();
+    std::vector<uint8_t> barrier_code = barrier_gen.get_code();
+    void* barrier_exec = mmap(nullptr, barrier_code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(barrier_exec, barrier_code.data(), barrier_code.size());
+    auto jit_barrier = reinterpret_cast<void (*)(void*)>(barrier_exec);
+    size_t card = (reinterpret_cast<uintptr_t>(&old_parent[2]) - heap.base()) >> GC_CARD_SHIFT;
+    heap.card_table()[card] = 0;
+    jit_barrier(old_parent);
+    uint64_t outside[4] = {};
+    jit_barrier(outside);
+    std::cout << "card dirty=" << int(heap.card_table()[card]) << std::endl;
+    if (heap.card_table()[card] != 1) failures++;
+    munmap(barrier_exec, barrier_code.size());
+    gc.remove_root(&parent_root);
+
+    // Test 10: The JIT pre-write barrier logs the old value only while marking
+    std::cout << "\n10. Testing the SATB barrier..." << std::endl;
+    void** holder = static_cast<void**>(gc.gc_alloc(16, 4));
+    holder[1] = gc.gc_alloc(16, 4);
+    heap.snapshot_objects();  // Both are now part of a snapshot, unmarked
+    X86CodeGenV2 satb_gen;
+    satb_gen.emit_gc_satb_barrier(7, 8);  // rdi = object
+    satb_gen.emit_ret();
+    std::vector<uint8_t> satb_code = satb_gen.get_code();
+    void* satb_exec = mmap(nullptr, satb_code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(satb_exec, satb_code.data(), satb_code.size());
+    auto jit_satb = reinterpret_cast<void (*)(void*)>(satb_exec);
+    size_t logged_before = gc.get_stats().satb_entries;
+    jit_satb(holder);
+    gc_marking_active.store(1);
+    jit_satb(holder);
+    gc_marking_active.store(0);
+    size_t logged = gc.get_stats().satb_entries - logged_before;
+    std::cout << "logged=" << logged << std::endl;
+    if (logged != 1) failures++;
+    munmap(satb_exec, satb_code.size());
+
+    // Test 11: Concurrent marking keeps a list intact while another thread
+    // keeps unlinking and relinking one of its nodes
+    std::cout << "\n11. Testing concurrent marking..." << std::endl;
+    gc.enable_concurrent_gc(true);
+    const size_t chain_length = 1000;
+    void* chain = nullptr;
+    for (size_t i = 0; i < chain_length; i++) {
+        void** node = static_cast<void**>(gc.gc_alloc(16, 4));
+        node[0] = chain;
+        chain = node;
+    }
+    gc.add_root(&chain);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> moves{0};
+    std::thread mutator([&]() {
+        // Between the stores the second node is only held in a local
+        void** first = static_cast<void**>(chain);
+        while (!stop.load()) {
+            void** second = static_cast<void**>(first[0]);
+            gc_satb_barrier(&first[0]);
+            first[0] = second[0];
+            __gc_alloc(32, 4);
+            gc_satb_barrier(&second[0]);
+            second[0] = first[0];
+            gc_satb_barrier(&first[0]);
+            first[0] = second;
+            moves++;
+        }
+    });
+    while (moves.load() < 100) std::this_thread::yield();
+    gc.collect();
+    stop.store(true);
+    mutator.join();
+    size_t reachable = 0;
+    for (void** node = static_cast<void**>(chain); node && heap.is_object_start(node); node = static_cast<void**>(node[0])) {
+        reachable++;
+    }
+    std::cout << "reachable=" << reachable << " moves=" << moves.load() << std::endl;
+    if (reachable != chain_length) failures++;
+    gc.remove_root(&chain);
+    gc.enable_concurrent_gc(false);
+
+    // Test 12: Several marking threads share a large tree and lose nothing
+    std::cout << "\n12. Testing parallel marking..." << std::endl;
+    gc.set_mark_threads(4);
+    const size_t tree_nodes = 100000;
+    std::vector<void**> nodes;
+    nodes.reserve(tree_nodes);
+    for (size_t i = 0; i < tree_nodes; i++) {
+        // 128-byte payloads: generic objects are scanned 128 bytes deep
+        void** node = static_cast<void**>(gc.gc_alloc(128, 4));
+        if (i > 0) nodes[(i - 1) / 2][(i - 1) % 2] = node;
+        nodes.push_back(node);
+        gc.gc_alloc(128, 4);  // Garbage between the nodes
+    }
+    void* tree = nodes[0];
+    gc.add_root(&tree);
+    gc.collect();
+    size_t alive = 0;
+    for (void** node : nodes) {
+        if (heap.is_object_start(node)) alive++;
+    }
+    const GCParallelMarker::Stats& mark_stats = gc.get_mark_stats();
+    std::cout << "alive=" << alive << " scanned=" << mark_stats.objects_scanned
+              << " workers=" << mark_stats.workers_used << " steals=" << mark_stats.steals << std::endl;
+    if (alive != tree_nodes || mark_stats.objects_scanned != tree_nodes) failures++;
+    gc.remove_root(&tree);
+
+    // Test 13: A collection only queues small pages; their dead cells are
+    // already gone to lookups and the sweeper thread frees them afterwards
+    std::cout << "\n13. Testing lazy sweeping..." << std::endl;
+    std::vector<void*> dead_cells;
+    std::thread([&dead_cells]() {
+        for (int i = 0; i < 5000; i++) dead_cells.push_back(__gc_alloc(192, 4));
+    }).join();
+    size_t freed_before = heap.freed_bytes();
+    gc.collect();
+    bool dead = !heap.is_object_start(dead_cells[0]) && !heap.find_object(dead_cells[4999]);
+    size_t expected = 5000 * gc_cell_size_for(192);
+    for (int i = 0; i < 500 && heap.freed_bytes() - freed_before < expected; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    size_t swept = heap.freed_bytes() - freed_before;
+    std::cout << "dead=" << dead << " swept " << swept << " of " << expected << " bytes" << std::endl;
+    if (!dead || swept < expected) failures++;
+
+    // Test 14: Compaction evacuates sparse pages, rewrites the roots and
+    // leaves pinned objects where they are
+    std::cout << "\n14. Testing compaction..." << std::endl;
+    std::vector<uint64_t*> sparse;
+    std::thread([&sparse]() {
+        for (int i = 0; i < 16000; i++) {
+            uint64_t* obj = static_cast<uint64_t*>(__gc_alloc(240, 1));
+            obj[1] = i;
+            sparse.push_back(obj);
+        }
+    }).join();
+    std::vector<void*> rooted(sparse.size() / 16);
+    for (size_t i = 0; i < rooted.size(); i++) {
+        rooted[i] = sparse[i * 16];
+        gc.add_root(&rooted[i]);
+    }
+    GCHeap::header_of(rooted[1])->pin();
+    gc.collect();  // Leaves one live cell in sixteen
+    gc.set_compaction_threshold(0.3);
+    gc.collect();
+    gc.set_compaction_threshold(2.0);
+    size_t relocated = 0, intact = 0;
+    for (size_t i = 0; i < rooted.size(); i++) {
+        if (rooted[i] != sparse[i * 16]) relocated++;
+        if (heap.is_object_start(rooted[i]) && static_cast<uint64_t*>(rooted[i])[1] == i * 16) intact++;
+        gc.remove_root(&rooted[i]);
+    }
+    std::cout << "moved=" << relocated << " intact=" << intact << " pinned stayed=" << (rooted[1] == sparse[16])
+              << " defrags=" << gc.get_stats().defrag_operations << std::endl;
+    if (relocated != rooted.size() - 1 || intact != rooted.size() || rooted[1] != sparse[16]) failures++;
+
+    // Test 15: JIT scopes publish their stack maps on the thread's chain; a
+    // collection keeps what the mapped fields reference and rewrites them
+    // when it moves the object, and ignores unmapped fields. Scopes without
+    // reference fields stay off the chain.
+    std::cout << "\n15. Testing stack maps..." << std::endl;
+    X86CodeGenV2 scope_gen;
+    X86InstructionBuilder& builder = scope_gen.get_instruction_builder();
+    builder.push(X86Reg::R15);
+    builder.push(X86Reg::RBX);
+    builder.push(X86Reg::R12);
+    builder.push(X86Reg::R13);
+    scope_gen.emit_sub_reg_imm(4, 8);
+    builder.mov(X86Reg::RBX, X86Reg::RDI);  // Referenced from a mapped field
+    builder.mov(X86Reg::R12, X86Reg::RSI);  // Only from an unmapped one
+    builder.mov(X86Reg::R13, X86Reg::RDX);  // Called while the scope is live
+    scope_gen.emit_scope_alloc(16);
+    scope_gen.emit_mov_reg_offset_reg(15, 0, 3);
+    scope_gen.emit_mov_reg_offset_reg(15, 8, 12);
+    scope_gen.emit_gc_scope_link(GCStackMapRegistry::instance().intern(16, {0}));
+    builder.call(X86Reg::R13);
+    scope_gen.emit_mov_reg_reg_offset(3, 15, 0);
+    scope_gen.emit_scope_free(true);
+    builder.mov(X86Reg::RAX, X86Reg::RBX);
+    scope_gen.emit_add_reg_imm(4, 8);
+    builder.pop(X86Reg::R13);
+    builder.pop(X86Reg::R12);
+    builder.pop(X86Reg::RBX);
+    builder.pop(X86Reg::R15);
+    scope_gen.emit_ret();
+    std::vector<uint8_t> scope_code = scope_gen.get_code();
+    void* scope_exec = mmap(nullptr, scope_code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(scope_exec, scope_code.data(), scope_code.size());
+    auto jit_scope = reinterpret_cast<void* (*)(void*, void*, void (*)())>(scope_exec);
+    
+    uint64_t* scoped = static_cast<uint64_t*>(gc.gc_alloc(32, 4));
+    void* unmapped = gc.gc_alloc(32, 4);
+    scoped[1] = 0x5ca1ab1e;
+    void* chain_before = gc_current_tlab().scope_chain;
+    static void* chain_during = nullptr;
+    uint64_t* from_scope = static_cast<uint64_t*>(jit_scope(scoped, unmapped, []() {
+        chain_during = gc_current_tlab().scope_chain;
+        GarbageCollector::instance().collect_young();
+    }));
+    std::cout << "scoped " << static_cast<void*>(scoped) << " -> " << static_cast<void*>(from_scope)
+              << " unmapped alive=" << heap.is_object_start(unmapped)
+              << " stack slots=" << gc.get_stats().stack_slots << std::endl;
+    if (from_scope == scoped || !heap.is_object_start(from_scope) || from_scope[1] != 0x5ca1ab1e) failures++;
+    if (heap.is_object_start(unmapped) || gc.get_stats().stack_slots != 1) failures++;
+    if (!chain_during || chain_during == chain_before || gc_current_tlab().scope_chain != chain_before) failures++;
+    munmap(scope_exec, scope_code.size());
+    
+    // A scope whose map has no reference slots is never put on the chain
+    X86CodeGenV2 plain_gen;
+    X86InstructionBuilder& plain = plain_gen.get_instruction_builder();
+    plain.push(X86Reg::R15);
+    plain.push(X86Reg::R13);
+    plain_gen.emit_sub_reg_imm(4, 8);
+    plain.mov(X86Reg::R13, X86Reg::RDI);
+    plain_gen.emit_scope_alloc(16);
+    plain_gen.emit_gc_scope_link(GCStackMapRegistry::instance().intern(16, {}));
+    plain.call(X86Reg::R13);
+    plain_gen.emit_scope_free(true);
+    plain_gen.emit_add_reg_imm(4, 8);
+    plain.pop(X86Reg::R13);
+    plain.pop(X86Reg::R15);
+    plain_gen.emit_ret();
+    std::vector<uint8_t> plain_code = plain_gen.get_code();
+    void* plain_exec = mmap(nullptr, plain_code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(plain_exec, plain_code.data(), plain_code.size());
+    chain_during = nullptr;
+    reinterpret_cast<void (*)(void (*)())>(plain_exec)([]() { chain_during = gc_current_tlab().scope_chain; });
+    std::cout << "unmapped scope on chain=" << (chain_during != chain_before) << std::endl;
+    if (chain_during != chain_before || gc_current_tlab().scope_chain != chain_before) failures++;
+    munmap(plain_exec, plain_code.size());
+
+    // Test 16: Every collection above reported its pauses and phases; the
+    // occupancy counts a rooted object in its generation, and the log thread
+    // writes one JSON line per interval plus one when stopped
+    std::cout << "\n16. Testing telemetry..." << std::endl;
+    GCTelemetry& telemetry = GCTelemetry::instance();
+    GCPauseHistogram histogram;
+    for (uint64_t micros : {0, 1, 3, 3, 900}) histogram.record(micros);
+    bool buckets_ok = GCPauseHistogram::bucket_for(0) == 0 && GCPauseHistogram::bucket_for(1) == 1 &&
+                      GCPauseHistogram::bucket_for(3) == 2 && GCPauseHistogram::bucket_for(UINT64_MAX) == GCPauseHistogram::BUCKET_COUNT - 1 &&
+                      histogram.percentile_micros(50) == 4 && histogram.percentile_micros(100) == 900 &&
+                      histogram.max_micros() == 900 && histogram.total_micros() == 907;
+    void* tracked = gc.gc_alloc(4000, 4);
+    gc.add_root(&tracked);
+    gc.collect();
+    GCTelemetry::Snapshot before = telemetry.snapshot();
+    GCHeap::Occupancy occupancy = heap.occupancy();
+    std::string log_path = "/tmp/ultrascript_gc_log_" + std::to_string(getpid()) + ".jsonl";
+    bool log_started = telemetry.start_log(log_path, 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    telemetry.stop_log();
+    size_t log_lines = 0;
+    bool log_json = true;
+    {
+        std::ifstream log(log_path);
+        for (std::string line; std::getline(log, line); log_lines++) {
+            if (line.front() != '{' || line.back() != '}' || line.find("\"pause\":{") == std::string::npos) log_json = false;
+        }
+    }
+    std::remove(log_path.c_str());
+    gc.remove_root(&tracked);
+    std::cout << "collections=" << before.collections << " minor=" << before.minor_collections
+              << " concurrent=" << before.concurrent_collections
+              << " pauses=" << telemetry.histogram(GCPhase::PAUSE).count()
+              << " p99=" << telemetry.histogram(GCPhase::PAUSE).percentile_micros(99) << "us"
+              << " young=" << occupancy.bytes[0] << " old=" << occupancy.bytes[1]
+              << " log lines=" << log_lines << std::endl;
+    if (!buckets_ok) failures++;
+    if (before.minor_collections == 0 || before.concurrent_collections == 0 || before.seconds_since_collection < 0) failures++;
+    if (telemetry.histogram(GCPhase::PAUSE).count() < before.collections + before.concurrent_collections ||
+        telemetry.histogram(GCPhase::MARK).count() != before.collections || telemetry.histogram(GCPhase::PROMOTE).count() != before.minor_collections) failures++;
+    if (occupancy.bytes[0] + occupancy.bytes[1] < gc_cell_size_for(4000) || before.young_bytes + before.old_bytes == 0) failures++;
+    if (!log_started || log_lines < 2 || !log_json) failures++;
+
+    // Test 17: A heap snapshot names class properties and counts retainers;
+    // the V8 file has one node per object plus the root. The sampler records
+    // every nth allocation with its caller.
+    std::cout << "\n17. Testing heap snapshots and allocation sampling..." << std::endl;
+    ClassMetadata list_node_class;
+    list_node_class.class_name = "ListNode";
+    list_node_class.properties = {{"value", 0, PropertyType::INT64, 0}, {"next", 8, PropertyType::OBJECT_PTR, 1}};
+    list_node_class.instance_size = 16;
+    gc.register_class_metadata(1000, &list_node_class);
+    void* list = nullptr;
+    gc.add_root(&list);
+    for (int i = 0; i < 3; i++) {
+        void** list_node = static_cast<void**>(gc.gc_alloc(16, 1000));
+        list_node[0] = reinterpret_cast<void*>(static_cast<intptr_t>(i));
+        list_node[1] = list;
+        list = list_node;
+    }
+    GCHeapSnapshot heap_snapshot = GCHeapSnapshot::capture();
+    size_t named_edges = 0;
+    for (const GCHeapSnapshot::Edge& edge : heap_snapshot.edges) {
+        if (edge.name == "next") named_edges++;
+    }
+    GCHeapSnapshot::TypeSummary list_summary;
+    for (const GCHeapSnapshot::TypeSummary& summary : heap_snapshot.summarize()) {
+        if (summary.type_id == 1000) list_summary = summary;
+    }
+    std::string snapshot_path = "/tmp/ultrascript_heap_" + std::to_string(getpid()) + ".heapsnapshot";
+    bool written = heap_snapshot.write_v8(snapshot_path);
+    std::string snapshot_text;
+    {
+        std::ifstream in(snapshot_path);
+        snapshot_text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::remove(snapshot_path.c_str());
+    bool v8_ok = snapshot_text.rfind("{\"snapshot\":{\"meta\":", 0) == 0 &&
+                 snapshot_text.find("\"node_count\":" + std::to_string(heap_snapshot.nodes.size() + 1) + ",") != std::string::npos &&
+                 snapshot_text.find("\"ListNode\"") != std::string::npos;
+    gc.remove_root(&list);
+
+    GCAllocationSampler& sampler = GCAllocationSampler::instance();
+    std::vector<void*> sampled_objects;
+    sampler.start(4);
+    allocate_for_sampling(sampled_objects, 100);
+    size_t samples = sampler.stop("");
+    std::vector<std::string> stacks = sampler.collapsed_stacks();
+    bool caller_named = !stacks.empty();
+    for (const std::string& line : stacks) {
+        if (line.find("allocate_for_sampling") == std::string::npos || line.find(";String ") == std::string::npos) caller_named = false;
+    }
+    std::cout << "objects=" << heap_snapshot.nodes.size() << " edges=" << heap_snapshot.edges.size()
+              << " ListNode count=" << list_summary.count << " retained by ListNode=" << list_summary.retainers["ListNode"]
+              << " roots=" << list_summary.root_references << " v8=" << (written && v8_ok)
+              << " samples=" << samples << " stack=" << (stacks.empty() ? "" : stacks[0]) << std::endl;
+    if (named_edges != 2 || list_summary.count != 3 || list_summary.retainers["ListNode"] != 2 || list_summary.root_references != 1) failures++;
+    if (!written || !v8_ok) failures++;
+    if (samples != 25 || !caller_named || sampler.is_running()) failures++;
+
+    // Test 18: Objects above GC_LARGE_OBJECT_THRESHOLD get their own mapping
+    // in the large object space. Growing one extends it in place when the
+    // pages above are free and moves its pages otherwise; a dead one gives
+    // its memory back.
+    std::cout << "\n18. Testing the large object space..." << std::endl;
+    uint8_t* upper = static_cast<uint8_t*>(gc.gc_alloc(2 << 20, 5));
+    uint8_t* lower = static_cast<uint8_t*>(gc.gc_alloc(2 << 20, 5));
+    bool large_placed = heap.in_large_space(upper) && heap.in_large_space(lower) && lower < upper &&
+                        reinterpret_cast<uintptr_t>(lower) >= heap.base() + GC_HEAP_RESERVATION &&
+                        (heap.header_of(lower)->flags & GCObjectHeader::LARGE_OBJECT);
+    std::memset(lower, 0xab, 2 << 20);
+    gc.gc_free(upper);
+    uint8_t* grown = static_cast<uint8_t*>(gc.gc_grow(lower, 3 << 20));
+    bool in_place = grown == lower && heap.header_of(grown)->size == (3u << 20) && grown[(2 << 20) - 1] == 0xab;
+    grown[(3 << 20) - 1] = 0xcd;
+    uint8_t* remapped = static_cast<uint8_t*>(gc.gc_grow(grown, 40 << 20));
+    bool move_ok = remapped != grown && heap.in_large_space(remapped) && heap.is_object_start(remapped) && !heap.is_object_start(grown) &&
+                   remapped[0] == 0xab && remapped[(2 << 20) - 1] == 0xab && remapped[(3 << 20) - 1] == 0xcd && remapped[(40 << 20) - 1] == 0;
+    void* large_root = remapped;
+    gc.add_root(&large_root);
+    gc.collect();
+    bool rooted_kept = heap.is_object_start(remapped) && remapped[(3 << 20) - 1] == 0xcd;
+    size_t committed_live = heap.committed_bytes();
+    gc.remove_root(&large_root);
+    large_root = nullptr;
+    gc.gc_free(remapped);
+    size_t committed_dead = heap.committed_bytes();
+    std::cout << "placed=" << large_placed << " grown in place=" << in_place << " moved=" << move_ok
+              << " kept=" << rooted_kept << " committed " << committed_live << " -> " << committed_dead << std::endl;
+    if (!large_placed || !in_place || !move_ok || !rooted_kept) failures++;
+    if (committed_live - committed_dead < (40u << 20) || heap.is_object_start(remapped)) failures++;
+
+    // Test 19: Past the soft limit, allocation forces collections and waits;
+    // garbage never takes the heap past the hard limit. Live data at the hard
+    // limit goes to the out-of-memory callback, and without one allocation fails.
+    std::cout << "\n19. Testing heap limits..." << std::endl;
+    gc.collect();
+    heap.finish_sweeping();
+    GCTelemetry::Snapshot limits_before = telemetry.snapshot();
+    size_t limit_base = heap.committed_bytes();
+    gc.set_heap_limits(limit_base + (4 << 20), limit_base + (8 << 20));
+    bool garbage_allocated = true;
+    size_t garbage_peak = 0;
+    for (int i = 0; i < 16384; i++) {   // 64MB through an 8MB budget
+        if (!gc.gc_alloc(4000, 5)) garbage_allocated = false;
+        garbage_peak = std::max(garbage_peak, heap.committed_bytes());
+    }
+    std::vector<void*> hogs(8, nullptr);
+    for (void*& hog : hogs) gc.add_root(&hog);
+    int shed_calls = 0;
+    gc.set_out_of_memory_callback([&](size_t) {
+        shed_calls++;
+        for (void*& hog : hogs) hog = nullptr;
+    });
+    bool shed_ok = true;
+    for (void*& hog : hogs) {
+        hog = gc.gc_alloc(2 << 20, 5);   // Large space: 2MB apiece
+        if (!hog) shed_ok = false;
+    }
+    gc.set_out_of_memory_callback(nullptr);
+    void* refused = nullptr;
+    for (int i = 0; i < 8 && !refused; i++) {
+        void* extra = gc.gc_alloc(2 << 20, 5);
+        if (!extra) refused = &hogs;
+        else hogs[i] = extra;
+    }
+    GCTelemetry::Snapshot limits_after = telemetry.snapshot();
+    std::cout << "garbage ok=" << garbage_allocated << " peak over base=" << ((garbage_peak - limit_base) >> 10) << "KB"
+              << " shed calls=" << shed_calls << " refused=" << (refused != nullptr)
+              << " limit collections=" << limits_after.limit_collections - limits_before.limit_collections
+              << " throttled=" << limits_after.throttled_allocations - limits_before.throttled_allocations
+              << " oom=" << limits_after.out_of_memory_errors - limits_before.out_of_memory_errors << std::endl;
+    if (!garbage_allocated || garbage_peak > limit_base + (8 << 20)) failures++;
+    if (!shed_ok || shed_calls == 0 || !refused) failures++;
+    if (limits_after.limit_collections == limits_before.limit_collections ||
+        limits_after.throttled_allocations == limits_before.throttled_allocations ||
+        limits_after.out_of_memory_errors != limits_before.out_of_memory_errors + 1 ||
+        limits_after.hard_limit_bytes != limit_base + (8 << 20)) {
+        failures++;
+    }
+    gc.set_heap_limits(0, 0);
+    for (void*& hog : hogs) gc.remove_root(&hog);
+
+    // Test 20: No collection mallocs or frees while the world is stopped, with
+    // a thread allocating throughout: minor, compacting full and concurrent
+    // collections, and heap snapshots
+    std::cout << "\n20. Testing malloc-free pauses..." << std::endl;
+    std::atomic<bool> mutating{true};
+    std::thread pause_mutator([&mutating]() {
+        parked_mutator = true;
+        while (mutating.load(std::memory_order_relaxed)) __gc_alloc(48, 1);
+    });
+    // The mutator may trigger a collection at any point, so survivors are rooted before they exist
+    std::vector<void*> pause_roots(500, nullptr);
+    for (void*& root : pause_roots) gc.add_root(&root);
+    for (size_t i = 0; i < pause_roots.size() * 16; i++) {
+        void* obj = __gc_alloc(240, 1);
+        if (i % 16 == 0) pause_roots[i / 16] = obj;
+    }
+    gc.gc_alloc(2 << 20, 5);  // Freed by the first sweep
+    size_t mallocs_before = mallocs_while_stopped.load();
+    gc.collect_young();
+    gc.set_compaction_threshold(0.3);
+    gc.collect();
+    gc.set_compaction_threshold(2.0);
+    gc.enable_concurrent_gc(true);
+    gc.collect();
+    gc.enable_concurrent_gc(false);
+    size_t snapshot_nodes = GCHeapSnapshot::capture().nodes.size();
+    size_t pause_mallocs = mallocs_while_stopped.load() - mallocs_before;
+    mutating = false;
+    pause_mutator.join();
+    size_t pause_intact = 0;
+    for (size_t i = 0; i < pause_roots.size(); i++) {
+        if (heap.is_object_start(pause_roots[i])) pause_intact++;
+        gc.remove_root(&pause_roots[i]);
+    }
+    std::cout << "mallocs while stopped=" << pause_mallocs << " intact=" << pause_intact << "/" << pause_roots.size()
+              << " snapshot nodes=" << (snapshot_nodes > 0) << std::endl;
+    if (pause_mallocs != 0 || pause_intact != pause_roots.size() || snapshot_nodes == 0) failures++;
+
+    std::cout << "\n" << (failures == 0 ? "All GC heap tests passed" : "GC heap tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// JIT code heap test program
+#include "jit_code_heap.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// mov eax, imm32 ; ret
+static std::vector<uint8_t> make_return_constant(int32_t value) {
+    std::vector<uint8_t> code = {0xB8, 0, 0, 0, 0, 0xC3};
+    for (int i = 0; i < 4; i++) {
+        code[1 + i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+    }
+    return code;
+}
+
+int main() {
+    std::cout << "=== UltraScript JIT Code Heap Test ===" << std::endl;
+    JITCodeHeap& heap = JITCodeHeap::instance();
+    int failures = 0;
+
+    // Test 1: Allocate, write and execute a function
+    std::cout << "\n1. Testing allocate + execute..." << std::endl;
+    JITCodeChunk* first = heap.allocate(16, "first");
+    auto code = make_return_constant(42);
+    heap.write_code(first, code.data(), code.size());
+    int result = reinterpret_cast<int(*)()>(first->exec_base)();
+    std::cout << "Result: " << result << " (expected: 42), dual mapped: "
+              << (heap.is_dual_mapped() ? "yes" : "no") << std::endl;
+    if (result != 42) failures++;
+
+    // Test 2: Entry points are cache-line aligned and distinct
+    std::cout << "\n2. Testing per-function chunks..." << std::endl;
+    JITCodeChunk* second = heap.allocate(100, "second");
+    code = make_return_constant(7);
+    heap.write_code(second, code.data(), code.size());
+    result = reinterpret_cast<int(*)()>(second->exec_base)();
+    bool aligned = (reinterpret_cast<uintptr_t>(second->exec_base) % JITCodeHeap::CHUNK_ALIGNMENT) == 0;
+    std::cout << "Result: " << result << " (expected: 7), aligned: " << (aligned ? "yes" : "no") << std::endl;
+    if (result != 7 || !aligned || second->exec_base == first->exec_base) failures++;
+
+    // Test 3: Lookup by address inside a chunk
+    std::cout << "\n3. Testing find_chunk..." << std::endl;
+    JITCodeChunk* found = heap.find_chunk(second->exec_base + 3);
+    std::cout << "Found owner: " << (found ? found->owner : "<none>") << std::endl;
+    if (found != second) failures++;
+
+    // Test 4: Retired code is reclaimed and the space reused
+    std::cout << "\n4. Testing retire + reclaim..." << std::endl;
+    uint8_t* first_addr = first->exec_base;
+    heap.retire(first);
+    size_t reclaimed = heap.reclaim_retired();
+    JITCodeChunk* third = heap.allocate(16, "third");
+    std::cout << "Reclaimed: " << reclaimed << ", reused address: "
+              << (third->exec_base == first_addr ? "yes" : "no") << std::endl;
+    if (reclaimed != 1 || third->exec_base != first_addr) failures++;
+
+    // Test 5: Releasing a retired chunk drops it from the retired list
+    std::cout << "\n5. Testing release of retired code..." << std::endl;
+    JITCodeChunk* doomed = heap.allocate(16, "doomed");
+    heap.retire(doomed);
+    heap.release(doomed);
+    size_t after_release = heap.reclaim_retired();
+    std::cout << "Reclaimed after release: " << after_release << " (expected: 0)" << std::endl;
+    if (after_release != 0 || heap.get_stats().retired_chunks != 0) failures++;
+
+    // Test 6: Code retired while a thread runs JIT code waits for that thread to leave
+    std::cout << "\n6. Testing reclamation at quiescence..." << std::endl;
+    JITCodeChunk* busy = heap.allocate(16, "busy");
+    uint8_t* busy_addr = busy->exec_base;
+    std::atomic<int> phase{0};
+    std::thread runner([&]() {
+        JITCodeRegion region;
+        phase.store(1);
+        while (phase.load() != 2) std::this_thread::yield();
+    });
+    while (phase.load() != 1) std::this_thread::yield();
+    bool retired = heap.retire_code_at(busy_addr + 5);
+    size_t while_busy = heap.reclaim_retired();
+    phase.store(2);
+    runner.join();
+    size_t left_over = heap.get_stats().retired_chunks;
+    std::cout << "Retired: " << retired << ", reclaimed while running: " << while_busy
+              << ", still retired after leave: " << left_over << std::endl;
+    if (!retired || while_busy != 0 || left_over != 0 || heap.find_chunk(busy_addr)) failures++;
+
+    // Test 7: A thread that stays in one long region frees code retired during
+    // a task at its next quiescent point, without leaving the region
+    std::cout << "\n7. Testing reclamation at a quiescent point..." << std::endl;
+    JITCodeChunk* replaced = heap.allocate(16, "replaced");
+    uint8_t* replaced_addr = replaced->exec_base;
+    std::atomic<int> step{0};
+    std::thread worker([&]() {
+        JITCodeRegion region;
+        step.store(1);                                    // Running a task
+        while (step.load() != 2) std::this_thread::yield();
+        heap.quiescent();                                 // Between tasks
+        step.store(3);
+        while (step.load() != 4) std::this_thread::yield();
+    });
+    while (step.load() != 1) std::this_thread::yield();
+    heap.retire(replaced);
+    size_t during_task = heap.reclaim_retired();
+    step.store(2);
+    while (step.load() != 3) std::this_thread::yield();
+    bool freed_in_region = heap.get_stats().retired_chunks == 0 && !heap.find_chunk(replaced_addr);
+    step.store(4);
+    worker.join();
+    std::cout << "Reclaimed during task: " << during_task << ", freed at quiescent point: " << freed_in_region
+              << std::endl;
+    if (during_task != 0 || !freed_in_region) failures++;
+
+    auto stats = heap.get_stats();
+    std::cout << "\nSegments: " << stats.segments << ", live chunks: " << stats.live_chunks
+              << ", used bytes: " << stats.used_bytes << ", released: " << stats.released_chunks << std::endl;
+
+    if (failures == 0) {
+        std::cout << "\n✓ All JIT code heap tests passed" << std::endl;
+        return 0;
+    }
+    std::cerr << "\n✗ " << failures << " JIT code heap test(s) failed" << std::endl;
+    return 1;
+}
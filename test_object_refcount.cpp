@@ -0,0 +1,205 @@
+// Biased reference count test program
+#include "object_refcount.h"
+#include "cycle_collector.h"
+#include "gc_heap.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Stands in for the runtime's destructor path: counts objects the queue merges destroy
+static std::atomic<int> destroyed{0};
+
+extern "C" void __object_destruct(void* object) {
+    destroyed++;
+    object_ref_count_release_references(object);
+    object_ref_count_free(object);
+}
+
+// Class instance with property_count counted-reference slots
+static void* make_node(int64_t property_count) {
+    void* node = object_ref_count_allocate(OBJECT_PROPERTIES_START_OFFSET + property_count * 8);
+    if (!node) return nullptr;
+    GET_OBJECT_PROPERTY_COUNT(node) = property_count;
+    return node;
+}
+
+int main() {
+    std::cout << "=== UltraScript Biased Reference Count Test ===" << std::endl;
+    int failures = 0;
+
+    // Test 1: The owner counts on the biased part only
+    std::cout << "\n1. Testing owner-only counting..." << std::endl;
+    void* local = object_ref_count_allocate(64);
+    for (int i = 0; i < 3; i++) object_ref_count_retain(local);
+    bool early = false;
+    for (int i = 0; i < 3; i++) early |= object_ref_count_release(local);
+    int64_t shared = object_ref_count_prefix(local)->shared.load();
+    std::cout << "total=" << object_ref_count_total(local) << " shared=" << shared << std::endl;
+    if (early || object_ref_count_total(local) != 1 || shared != 0) failures++;
+    if (!object_ref_count_release(local)) failures++;
+    object_ref_count_free(local);
+
+    // Test 2: Another thread's references go to the shared count; once the
+    // owner lets go, the object is merged and the last release frees it
+    std::cout << "\n2. Testing shared references..." << std::endl;
+    void* handed = object_ref_count_allocate(64);
+    object_ref_count_retain(handed);
+    bool other_last = false;
+    std::thread other([&]() {
+        object_ref_count_retain(handed);
+        object_ref_count_release(handed);
+        other_last = object_ref_count_release(handed);   // Shared goes to -1: queued on the owner
+    });
+    other.join();
+    int64_t queued = object_ref_count_prefix(handed)->shared.load();
+    object_ref_count_merge_queued();
+    bool merged = object_ref_count_prefix(handed)->owner.load() == OBJECT_REF_COUNT_SHARED_OWNER;
+    bool owner_last = object_ref_count_release(handed);
+    std::cout << "queued=" << ((queued & ObjectRefCountPrefix::QUEUED) != 0) << " merged=" << merged
+              << " other last=" << other_last << " owner last=" << owner_last << std::endl;
+    if (other_last || !(queued & ObjectRefCountPrefix::QUEUED) || !merged || !owner_last) failures++;
+    object_ref_count_free(handed);
+
+    // Test 3: A queued object whose total is zero is destroyed by the owner's merge
+    std::cout << "\n3. Testing destruction on merge..." << std::endl;
+    void* dropped = object_ref_count_allocate(64);
+    for (int i = 0; i < 2; i++) object_ref_count_retain(dropped);   // Biased 3
+    std::thread releaser([&]() {
+        for (int i = 0; i < 3; i++) object_ref_count_release(dropped);
+    });
+    releaser.join();
+    object_ref_count_allocate(16);   // The owner picks up its queue here
+    std::cout << "destroyed=" << destroyed.load() << std::endl;
+    if (destroyed.load() != 1) failures++;
+
+    // Test 4: Objects biased to a thread that exited are merged by whoever finds them
+    std::cout << "\n4. Testing objects of exited threads..." << std::endl;
+    void* orphan = nullptr;
+    std::thread creator([&]() { orphan = object_ref_count_allocate(64); });
+    creator.join();
+    object_ref_count_retain(orphan);
+    bool orphan_early = object_ref_count_release(orphan);
+    bool orphan_last = object_ref_count_release(orphan);
+    std::cout << "early=" << orphan_early << " last=" << orphan_last << std::endl;
+    if (orphan_early || !orphan_last) failures++;
+    object_ref_count_free(orphan);
+
+    // Test 5: Concurrent retains and releases from the owner and other threads
+    // keep the total exact
+    std::cout << "\n5. Testing concurrent counting..." << std::endl;
+    void* busy = object_ref_count_allocate(64);
+    const int rounds = 100000;
+    std::atomic<int> last_releases{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < rounds; i++) {
+                object_ref_count_retain(busy);
+                if (object_ref_count_release(busy)) last_releases++;
+            }
+        });
+    }
+    for (int i = 0; i < rounds; i++) {
+        object_ref_count_retain(busy);
+        if (object_ref_count_release(busy)) last_releases++;
+    }
+    for (std::thread& worker : workers) worker.join();
+    object_ref_count_merge_queued();
+    std::cout << "total=" << object_ref_count_total(busy) << " early last releases=" << last_releases.load() << std::endl;
+    if (object_ref_count_total(busy) != 1 || last_releases.load() != 0) failures++;
+    if (!object_ref_count_release(busy)) failures++;
+    object_ref_count_free(busy);
+
+    // Test 6: Counted stores retain the new value and release the old one
+    std::cout << "\n6. Testing counted reference stores..." << std::endl;
+    int destroyed_before = destroyed.load();
+    void* holder = make_node(2);
+    void* held = make_node(0);
+    __object_set_reference(holder, 0, held);
+    int64_t held_count = object_ref_count_total(held);
+    __object_set_reference(holder, 0, nullptr);
+    object_ref_count_retain(held);   // Kept alive by this test through the next store
+    __object_set_reference(holder, 1, held);
+    object_ref_count_release(held);
+    object_ref_count_release(held);
+    bool released_with_holder = object_ref_count_release(holder);
+    if (released_with_holder) __object_destruct(holder);
+    std::cout << "count while held=" << held_count << " destroyed=" << destroyed.load() - destroyed_before << std::endl;
+    if (held_count != 2 || !released_with_holder || destroyed.load() - destroyed_before != 2) failures++;
+
+    // Test 7: A cycle the program let go of is found and freed
+    std::cout << "\n7. Testing garbage cycle collection..." << std::endl;
+    CycleCollector& collector = CycleCollector::instance();
+    destroyed_before = destroyed.load();
+    void* parent = make_node(1);
+    void* child = make_node(1);
+    __object_set_reference(parent, 0, child);
+    __object_set_reference(child, 0, parent);
+    object_ref_count_release(child);
+    object_ref_count_release(parent);
+    size_t buffered = collector.stats().buffered_roots;
+    size_t freed = collector.collect();
+    std::cout << "buffered=" << buffered << " freed=" << freed
+              << " destroyed=" << destroyed.load() - destroyed_before << std::endl;
+    if (buffered != 2 || freed != 2 || destroyed.load() - destroyed_before != 2) failures++;
+
+    // Test 8: A cycle still referenced from outside survives with its counts intact
+    std::cout << "\n8. Testing live cycles..." << std::endl;
+    destroyed_before = destroyed.load();
+    void* first = make_node(1);
+    void* second = make_node(1);
+    void* third = make_node(1);
+    __object_set_reference(first, 0, second);
+    __object_set_reference(second, 0, third);
+    __object_set_reference(third, 0, first);
+    object_ref_count_release(second);
+    object_ref_count_release(third);   // first keeps its own reference
+    freed = collector.collect();
+    int64_t counts[3] = {object_ref_count_total(first), object_ref_count_total(second), object_ref_count_total(third)};
+    std::cout << "freed=" << freed << " counts=" << counts[0] << "," << counts[1] << "," << counts[2] << std::endl;
+    if (freed != 0 || counts[0] != 2 || counts[1] != 1 || counts[2] != 1) failures++;
+    object_ref_count_release(first);   // Now the whole ring is garbage
+    freed = collector.collect();
+    std::cout << "after release freed=" << freed << std::endl;
+    if (freed != 3 || destroyed.load() - destroyed_before != 3) failures++;
+
+    // Test 9: Filling the root buffer triggers a collection
+    std::cout << "\n9. Testing the root threshold..." << std::endl;
+    collector.set_root_threshold(4);
+    CycleCollector::Stats before = collector.stats();
+    for (int i = 0; i < 4; i++) {
+        void* self = make_node(1);
+        __object_set_reference(self, 0, self);
+        object_ref_count_release(self);
+    }
+    CycleCollector::Stats after = collector.stats();
+    std::cout << "collections=" << after.collections - before.collections
+              << " freed=" << after.objects_freed - before.objects_freed
+              << " buffered=" << after.buffered_roots << std::endl;
+    std::cout << collector.to_json() << std::endl;
+    if (after.collections - before.collections != 1 || after.objects_freed - before.objects_freed != 4 ||
+        after.buffered_roots != 0) {
+        failures++;
+    }
+    collector.set_root_threshold(CycleCollector::DEFAULT_ROOT_THRESHOLD);
+
+    // Test 10: Instances count against the GC heap's hard limit
+    std::cout << "\n10. Testing the heap limit..." << std::endl;
+    GCHeap& heap = GCHeap::instance();
+    size_t external_before = heap.external_bytes();
+    void* counted = make_node(2);
+    size_t counted_bytes = heap.external_bytes() - external_before;
+    heap.set_commit_limit(heap.committed_bytes() + heap.external_bytes());
+    void* refused = make_node(2);
+    if (object_ref_count_release(counted)) object_ref_count_free(counted);   // Room for the next one
+    void* fits = make_node(2);
+    heap.set_commit_limit(0);
+    std::cout << "counted=" << counted_bytes << " refused=" << (refused == nullptr)
+              << " fits=" << (fits != nullptr) << std::endl;
+    if (counted_bytes < OBJECT_REF_COUNT_PREFIX_SIZE + 48 || refused || !fits) failures++;
+    if (fits && object_ref_count_release(fits)) object_ref_count_free(fits);
+    if (heap.external_bytes() != external_before) failures++;
+
+    std::cout << "\n" << (failures == 0 ? "All reference count tests passed" : "Reference count tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
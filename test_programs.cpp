@@ -0,0 +1,102 @@
+// End-to-end test program: compiles and runs .gts programs with the
+// ultraScript binary and checks the lines they print
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <vector>
+
+struct ProgramCase {
+    const char* file;
+    std::vector<std::string> expected_lines;  // Must appear in this order
+    int exit_status = 0;
+};
+
+// An expected line ending in "..." matches any line that starts with the rest
+static bool line_matches(const std::string& line, const std::string& expected) {
+    if (expected.size() >= 3 && expected.compare(expected.size() - 3, 3, "...") == 0) {
+        return line.compare(0, expected.size() - 3, expected, 0, expected.size() - 3) == 0;
+    }
+    return line == expected;
+}
+
+static bool run_program(const ProgramCase& test) {
+    std::string command = std::string("./ultraScript ") + test.file + " 2>&1";
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        std::cout << "  could not start ultraScript" << std::endl;
+        return false;
+    }
+
+    // Program output is interleaved with compiler diagnostics; match the
+    // expected lines as a subsequence of whole lines
+    size_t next = 0;
+    std::string line;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), pipe)) {
+        line += buffer;
+        if (line.empty() || line.back() != '\n') continue;
+        line.pop_back();
+        if (next < test.expected_lines.size() && line_matches(line, test.expected_lines[next])) {
+            next++;
+        }
+        line.clear();
+    }
+    int status = pclose(pipe);
+
+    if (next < test.expected_lines.size()) {
+        std::cout << "  missing output line: \"" << test.expected_lines[next] << "\"" << std::endl;
+        return false;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != test.exit_status) {
+        std::cout << "  ultraScript exited abnormally (status " << status << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << "=== UltraScript Program Tests ===" << std::endl;
+    int failures = 0;
+
+    const std::vector<ProgramCase> cases = {
+        // Callee throws, nested finally blocks run while unwinding, catch rethrows
+        {"test_exception_unwind.gts",
+         {"inner finally", "middle finally", "middle caught", "outer caught", "outer finally", "early caught", "done"}},
+        // Jump table, binary decision tree and string perfect hash dispatch
+        {"test_switch_lowering.gts",
+         {"table hit", "table default", "tree hit", "hash hit", "hash miss", "done"}},
+        // String concatenation past the hard heap limit throws a catchable RangeError
+        {"test_heap_limit.gts",
+         {"the first half of a long string, and the second half of it", "caught out of memory",
+          "the first half of a long string, and the second half of it", "done"}},
+        // Registered runtime calls print typed results and take integer arguments
+        {"test_runtime_calls.gts",
+         {"false", "0", "1073741824", "true", "next collection scheduled", "done"}},
+        // GC telemetry read from a script before and after a collection
+        {"test_gc_telemetry.gts",
+         {"-1", "{\"collections\":0,\"minor_collections\":0,...", "true", "true", "true", "true",
+          "{\"collections\":1,...", "done"}},
+        // Heap summary JSON printed from a script
+        {"test_heap_snapshot.gts", {"[]", "done"}},
+        // Reference-count cycle collection driven and inspected from a script
+        {"test_cycle_stats.gts",
+         {"{\"collections\":0,\"roots_scanned\":0,\"objects_freed\":0,...", "0",
+          "{\"collections\":1,...", "done"}},
+        // Exceptions no script frame catches stop at the runtime-to-JIT boundary
+        {"test_uncaught_exception.gts",
+         {"before", "finally ran", "Uncaught exception in the main program..."}, 1},
+    };
+
+    for (size_t i = 0; i < cases.size(); i++) {
+        std::cout << "\n" << (i + 1) << ". Running " << cases[i].file << "..." << std::endl;
+        if (!run_program(cases[i])) failures++;
+    }
+
+    if (failures) {
+        std::cout << "\n" << failures << " program test(s) FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "\nAll program tests passed" << std::endl;
+    return 0;
+}
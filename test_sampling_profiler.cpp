@@ -0,0 +1,138 @@
+// Sampling CPU profiler test program: native and JIT sessions produce samples
+// and collapsed stacks naming the code that burned the CPU
+#include "sampling_profiler.h"
+#include "jit_symbols.h"
+#include <sys/mman.h>
+#include <atomic>
+#include <time.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static double thread_cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Not static, so the profiler can name it through the dynamic symbol table
+__attribute__((noinline)) uint64_t profile_burn_native(double seconds) {
+    volatile uint64_t sink = 0;
+    double until = thread_cpu_seconds() + seconds;
+    while (thread_cpu_seconds() < until) {
+        for (int i = 0; i < 10000; i++) sink = sink * 31 + i;
+    }
+    return sink;
+}
+
+static bool stacks_mention(const std::vector<std::string>& stacks, const std::string& name) {
+    for (const std::string& stack : stacks) {
+        if (stack.find(name) != std::string::npos) return true;
+    }
+    return false;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+int main() {
+    std::cout << "=== UltraScript Sampling Profiler Test ===" << std::endl;
+    int failures = 0;
+    SamplingProfiler& profiler = SamplingProfiler::instance();
+    std::string path = "/tmp/ultrascript-profiler-test-" + std::to_string(getpid()) + ".collapsed";
+
+    // Test 1: A native session records samples and writes collapsed stacks
+    std::cout << "\n1. Testing native profiling session..." << std::endl;
+    if (!profiler.start(1000)) failures++;
+    if (!profiler.is_running()) failures++;
+    profile_burn_native(0.3);
+    size_t native_samples = profiler.stop(path);
+    std::string collapsed = read_file(path);
+    std::cout << "samples=" << native_samples << " bytes written=" << collapsed.size() << std::endl;
+    if (native_samples == 0 || profiler.is_running()) failures++;
+    if (!stacks_mention(profiler.collapsed_stacks(), "profile_burn_native")) failures++;
+    if (collapsed.find("profile_burn_native") == std::string::npos) failures++;
+    std::remove(path.c_str());
+
+    // Test 2: Samples in JIT code are named through the JIT symbol table
+    std::cout << "\n2. Testing JIT profiling session..." << std::endl;
+    static const uint8_t spin[] = {
+        0x55,                                      // push rbp
+        0x48, 0x89, 0xE5,                          // mov rbp, rsp
+        0x48, 0xB9, 0x00, 0xE1, 0xF5, 0x05, 0, 0, 0, 0,  // mov rcx, 100000000
+        0x48, 0xFF, 0xC9,                          // loop: dec rcx
+        0x75, 0xFB,                                //       jnz loop
+        0x5D,                                      // pop rbp
+        0xC3,                                      // ret
+    };
+    void* code = mmap(nullptr, 4096, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(code, spin, sizeof(spin));
+    JITSymbol symbol;
+    symbol.start = reinterpret_cast<uintptr_t>(code);
+    symbol.size = sizeof(spin);
+    symbol.name = "jit_spin_loop";
+    JITSymbolTable::instance().add_code(symbol.start, symbol.size, {symbol});
+    profiler.note_code_mapped();
+    auto jit_spin = reinterpret_cast<void (*)()>(code);
+
+    if (!profiler.start(1000)) failures++;
+    double until = thread_cpu_seconds() + 0.3;
+    while (thread_cpu_seconds() < until) jit_spin();
+    size_t jit_samples = profiler.stop("");
+    bool named = stacks_mention(profiler.collapsed_stacks(), "jit_spin_loop");
+    std::cout << "samples=" << jit_samples << " named=" << named << std::endl;
+    if (jit_samples == 0 || !named) failures++;
+    JITSymbolTable::instance().remove_code(symbol.start, symbol.size);
+    munmap(code, 4096);
+
+    // Test 3: The runtime.profiler entry points start and stop a session
+    std::cout << "\n3. Testing runtime.profiler entry points..." << std::endl;
+    profiler.set_output_path(path);
+    if (!__runtime_profiler_start() || !__runtime_profiler_running()) failures++;
+    profile_burn_native(0.1);
+    int64_t runtime_samples = __runtime_profiler_stop();
+    std::cout << "samples=" << runtime_samples << " running=" << __runtime_profiler_running() << std::endl;
+    if (runtime_samples <= 0 || __runtime_profiler_running()) failures++;
+    if (read_file(path).empty()) failures++;
+    std::remove(path.c_str());
+
+    // Test 4: Stopping while other threads take samples waits for their handlers
+    // before the sample buffer is freed (run under ASan to catch a regression)
+    std::cout << "\n4. Testing stop with samplers in flight..." << std::endl;
+    std::atomic<bool> burning{true};
+    std::vector<std::thread> burners;
+    for (int i = 0; i < 4; i++) {
+        burners.emplace_back([&]() {
+            profiler.register_current_thread();
+            while (burning.load()) profile_burn_native(0.001);
+            profiler.unregister_current_thread();
+        });
+    }
+    size_t rounds_with_samples = 0;
+    for (int round = 0; round < 200; round++) {
+        if (!profiler.start(10000, 64)) failures++;
+        profile_burn_native(0.002);
+        if (profiler.stop("") > 0) rounds_with_samples++;
+    }
+    burning.store(false);
+    for (std::thread& burner : burners) burner.join();
+    std::cout << "rounds with samples=" << rounds_with_samples << std::endl;
+    if (rounds_with_samples == 0 || profiler.is_running()) failures++;
+
+    if (failures) {
+        std::cout << "\n" << failures << " profiler test(s) FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "\nAll sampling profiler tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+// String pool test program
+#include "runtime.h"
+#include "simd_optimizations.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+int main() {
+    std::cout << "=== UltraScript String Pool Test ===" << std::endl;
+    StringPool& pool = StringPool::instance();
+    int failures = 0;
+
+    // Test 1: Equal bytes intern to one string, different bytes to different ones
+    std::cout << "\n1. Testing interning..." << std::endl;
+    GoTSString* hello = pool.intern("hello");
+    std::string built = std::string("hel") + "lo";
+    bool same = pool.intern(built.c_str()) == hello;
+    bool distinct = pool.intern("hellO") != hello;
+    const char with_null[] = {'a', '\0', 'b'};
+    GoTSString* embedded = pool.intern(with_null, 3);
+    bool embedded_ok = embedded->size() == 3 && pool.intern(with_null, 3) == embedded && pool.intern("a") != embedded;
+    bool via_runtime = __string_intern("hello") == hello;
+    std::cout << "same=" << same << " distinct=" << distinct << " embedded=" << embedded_ok
+              << " runtime=" << via_runtime << std::endl;
+    if (!same || !distinct || !embedded_ok || !via_runtime) failures++;
+
+    // Test 2: The pool hash is FNV-1a over unsigned bytes, high bytes included
+    std::cout << "\n2. Testing hash agreement..." << std::endl;
+    std::string long_key(100, '\0');
+    for (size_t i = 0; i < long_key.size(); i++) long_key[i] = static_cast<char>(i * 37 + 200);
+    uint64_t scalar = 0xcbf29ce484222325ULL;
+    for (char c : long_key) {
+        scalar ^= static_cast<uint8_t>(c);
+        scalar *= 0x100000001b3ULL;
+    }
+    uint64_t pooled = StringPool::hash(long_key.data(), long_key.size());
+    std::cout << "match=" << (scalar == pooled) << std::endl;
+    if (scalar != pooled) failures++;
+
+    // Test 3: Threads interning overlapping keys through table growth all agree
+    std::cout << "\n3. Testing concurrent interning..." << std::endl;
+    const int threads = 8;
+    const int keys = 20000;
+    size_t before = pool.size();
+    std::vector<std::vector<GoTSString*>> seen(threads, std::vector<GoTSString*>(keys));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < keys; i++) {
+                int key = (i * 7 + t * 13) % keys;
+                seen[t][key] = pool.intern(("key-" + std::to_string(key)).c_str());
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    int disagreements = 0;
+    for (int i = 0; i < keys; i++) {
+        std::string expected = "key-" + std::to_string(i);
+        for (int t = 0; t < threads; t++) {
+            if (seen[t][i] != seen[0][i] || *seen[t][i] != GoTSString(expected.c_str())) disagreements++;
+        }
+    }
+    std::cout << "disagreements=" << disagreements << " added=" << pool.size() - before
+              << " time=" << ms << "ms" << std::endl;
+    if (disagreements != 0 || pool.size() - before != static_cast<size_t>(keys)) failures++;
+
+    // Test 4: Cached hashes, equality and ordering fast paths
+    std::cout << "\n4. Testing cached hashes and comparison..." << std::endl;
+    std::string body(100, 'h');
+    GoTSString left((body + "left").c_str());
+    GoTSString right((body + "rigt").c_str());
+    GoTSString same_bytes((body + "left").c_str());
+    uint64_t left_hash = left.hash();
+    GoTSString left_copy(left);
+    bool hash_ok = left_hash == left.hash() && left_hash == left_copy.hash() &&
+                   left_hash == (StringPool::hash(left.data(), left.size()) & ((uint64_t(1) << 56) - 1)) &&
+                   GoTSString("tiny").hash() == GoTSString("tiny").hash();
+    right.hash();
+    bool equal_ok = left == same_bytes && left == left_copy && !(left == right) && same_bytes.hash() == left_hash;
+    GoTSString* interned_a = static_cast<GoTSString*>(__string_intern("interned literal"));
+    GoTSString* interned_b = static_cast<GoTSString*>(__string_intern("interned literal"));
+    bool pointer_ok = interned_a == interned_b && __string_equals(interned_a, interned_b) &&
+                      __string_equals(&left, &same_bytes) && !__string_equals(&left, &right) &&
+                      __string_equals(nullptr, nullptr) && !__string_equals(&left, nullptr);
+    GoTSString high((body + "\xff").c_str());
+    GoTSString low((body + "a").c_str());
+    GoTSString prefix(body.c_str());
+    bool order_ok = __string_compare(&low, &high) == -1 && __string_compare(&high, &low) == 1 &&
+                    __string_compare(&prefix, &low) == -1 && __string_compare(&low, &prefix) == 1 &&
+                    __string_compare(&left, &same_bytes) == 0 && __string_compare(&left, &right) == -1 &&
+                    __string_compare(&low, &low) == 0;
+    std::unordered_map<GoTSString, int> by_name;
+    by_name[left] = 1;
+    by_name[right] = 2;
+    bool map_ok = by_name.size() == 2 && by_name[same_bytes] == 1 && by_name.size() == 2;
+    std::cout << "hash=" << hash_ok << " equal=" << equal_ok << " pointer=" << pointer_ok
+              << " order=" << order_ok << " map=" << map_ok << std::endl;
+    if (!hash_ok || !equal_ok || !pointer_ok || !order_ok || !map_ok) failures++;
+
+    std::cout << "\n" << (failures == 0 ? "All string pool tests passed" : "String pool tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
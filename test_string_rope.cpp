@@ -0,0 +1,102 @@
+// Rope string concatenation test program
+#include "runtime.h"
+#include "gc_heap.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static GoTSString* concat(GoTSString* left, const char* right) {
+    GoTSString piece(right);
+    return static_cast<GoTSString*>(__string_concat(left, &piece));
+}
+
+static bool same(const GoTSString& str, const std::string& expected) {
+    return str.size() == expected.size() && memcmp(str.data(), expected.data(), expected.size()) == 0 &&
+           str.c_str()[expected.size()] == '\0';
+}
+
+int main() {
+    std::cout << "=== UltraScript Rope String Test ===" << std::endl;
+    int failures = 0;
+
+    // Test 1: A loop of s = s + x builds the same string a flat copy would
+    std::cout << "\n1. Testing loop concatenation..." << std::endl;
+    GoTSString* built = new GoTSString("");
+    std::string expected;
+    for (int i = 0; i < 5000; i++) {
+        std::string piece = "piece" + std::to_string(i) + ";";
+        built = concat(built, piece.c_str());
+        expected += piece;
+    }
+    std::cout << "size=" << built->size() << " expected=" << expected.size() << std::endl;
+    if (!same(*built, expected)) failures++;
+
+    // Test 2: Strings sharing a chunk keep their own contents when both are extended
+    std::cout << "\n2. Testing shared prefixes..." << std::endl;
+    GoTSString base(std::string(300, 'b').c_str());
+    GoTSString* stem = static_cast<GoTSString*>(__string_concat(&base, &base));
+    GoTSString* first = concat(stem, "first");
+    GoTSString* second = concat(stem, "second");
+    GoTSString* third = concat(first, "-third");
+    std::string stem_text(600, 'b');
+    bool shared_ok = same(*stem, stem_text) && same(*first, stem_text + "first") &&
+                     same(*second, stem_text + "second") && same(*third, stem_text + "first-third");
+    std::cout << "independent=" << shared_ok << std::endl;
+    if (!shared_ok) failures++;
+
+    // Test 3: Copies, moves, random access and comparisons see the flattened bytes
+    std::cout << "\n3. Testing copies and access..." << std::endl;
+    GoTSString copy(*third);
+    GoTSString moved(std::move(copy));
+    GoTSString appended(*stem);
+    appended += GoTSString("first");
+    appended += GoTSString("-third");
+    bool access_ok = moved == *third && appended == *third && moved[600] == 'f' &&
+                     moved[moved.size() - 1] == 'd' && !(moved < *third) && *second != *first;
+    std::cout << "access=" << access_ok << std::endl;
+    if (!access_ok) failures++;
+
+    // Test 4: Threads flattening the same rope all read the same bytes
+    std::cout << "\n4. Testing concurrent flattening..." << std::endl;
+    GoTSString* racy = concat(built, "!");
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&]() {
+            if (!same(*racy, expected + "!")) mismatches++;
+        });
+    }
+    for (std::thread& reader : readers) reader.join();
+    std::cout << "mismatches=" << mismatches.load() << std::endl;
+    if (mismatches.load() != 0) failures++;
+
+    // Test 5: Building a large string is linear, not quadratic: once it is a
+    // rope, each append either fills the tip chunk in place or starts a new
+    // chunk, and the doubling chunks keep those few. Chunks are the only
+    // string buffers counted as external bytes until the rope is flattened.
+    std::cout << "\n5. Testing append cost..." << std::endl;
+    GCHeap& heap = GCHeap::instance();
+    GoTSString* large = new GoTSString("");
+    size_t rope_appends = 0;
+    size_t chunks = 0;
+    for (int i = 0; i < 200000; i++) {
+        size_t external_before = heap.external_bytes();
+        GoTSString* next = concat(large, "0123456789");
+        if (large->size() >= GoTSString::ROPE_THRESHOLD) {
+            rope_appends++;
+            if (heap.external_bytes() != external_before) chunks++;
+        }
+        delete large;
+        large = next;
+    }
+    size_t large_size = strlen(large->c_str());
+    // Chunks double from ROPE_MIN_CHUNK to ROPE_MAX_CHUNK, then stay there
+    size_t max_chunks = 11 + large_size / GoTSString::ROPE_MAX_CHUNK;
+    std::cout << "size=" << large_size << " appends=" << rope_appends << " chunks=" << chunks << std::endl;
+    if (large_size != 2000000 || rope_appends == 0 || chunks == 0 || chunks > max_chunks) failures++;
+    delete large;
+
+    std::cout << "\n" << (failures == 0 ? "All rope string tests passed" : "Rope string tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
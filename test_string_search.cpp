@@ -0,0 +1,91 @@
+// String search kernel test program
+#include "string_search.h"
+#include "simd_optimizations.h"
+#include "regex.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+static size_t expected_find(const std::string& haystack, const std::string& needle, size_t from = 0) {
+    size_t at = haystack.find(needle, from);
+    return at == std::string::npos ? STRING_SEARCH_NOT_FOUND : at;
+}
+
+int main() {
+    std::cout << "=== UltraScript String Search Test ===" << std::endl;
+    std::cout << "AVX2: " << (SIMDOptimizations::is_avx2_supported() ? "yes" : "no") << std::endl;
+    int failures = 0;
+
+    // Test 1: Substring search agrees with std::string::find on random text,
+    // across needle lengths and the vector/tail boundary
+    std::cout << "\n1. Testing substring search..." << std::endl;
+    std::mt19937 rng(42);
+    int mismatches = 0;
+    for (int round = 0; round < 2000; round++) {
+        std::string haystack(rng() % 200, 'a');
+        for (char& c : haystack) c = "abc"[rng() % 3];
+        std::string needle(1 + rng() % 6, 'a');
+        for (char& c : needle) c = "abc"[rng() % 3];
+        size_t from = haystack.empty() ? 0 : rng() % haystack.size();
+        if (string_search_find(haystack.data(), haystack.size(), needle.data(), needle.size(), from) !=
+            expected_find(haystack, needle, from)) {
+            mismatches++;
+        }
+        if (SIMDOptimizations::is_avx2_supported() && needle.size() >= 2 &&
+            SIMDOptimizations::find_substring_avx2(haystack.data(), haystack.size(), needle.data(), needle.size()) !=
+            expected_find(haystack, needle)) {
+            mismatches++;
+        }
+    }
+    std::cout << "mismatches=" << mismatches << std::endl;
+    if (mismatches != 0) failures++;
+
+    // Test 2: Counting and splitting on single and multi-byte separators
+    std::cout << "\n2. Testing count and split..." << std::endl;
+    std::string csv;
+    for (int i = 0; i < 1000; i++) csv += "field" + std::to_string(i) + (i % 10 == 9 ? "\r\n" : ",");
+    size_t commas = string_search_count(csv.data(), csv.size(), ",", 1);
+    size_t lines = string_search_count(csv.data(), csv.size(), "\r\n", 2);
+    std::vector<std::string> fields = string_search_split(csv.data(), csv.size(), ",", 1);
+    std::vector<std::string> limited = string_search_split(csv.data(), csv.size(), "\r\n", 2, 3);
+    std::vector<std::string> bytes = string_search_split("abc", 3, "", 0);
+    std::cout << "commas=" << commas << " lines=" << lines << " fields=" << fields.size()
+              << " limited=" << limited.size() << " bytes=" << bytes.size() << std::endl;
+    if (commas != 900 || lines != 100 || fields.size() != 901 || fields[0] != "field0" ||
+        limited.size() != 3 || bytes.size() != 3 || bytes[2] != "c") {
+        failures++;
+    }
+
+    // Test 3: Literal patterns route around the regex engine with the same results
+    std::cout << "\n3. Testing literal regex routing..." << std::endl;
+    std::string text = "one, two, three, four";
+    bool literal = string_search_is_literal(", ") && !string_search_is_literal("a.b") &&
+                   !string_search_is_literal("abc", "i");
+    int found = string_regex::search(text, "three");
+    std::vector<RegexMatch> all = string_regex::match(text, ", ", "g");
+    std::vector<RegexMatch> first = string_regex::match(text, ", ");
+    std::string replaced = string_regex::replace(text, ", ", "|", "g");
+    std::cout << "literal=" << literal << " search=" << found << " matches=" << all.size() << "/" << first.size()
+              << " replaced=" << replaced << std::endl;
+    if (!literal || found != 10 || all.size() != 3 || first.size() != 1 || all[1].start != 8 ||
+        replaced != "one|two|three|four") {
+        failures++;
+    }
+
+    // Test 4: A long search is far from byte-at-a-time
+    std::cout << "\n4. Testing search throughput..." << std::endl;
+    std::string body(8 << 20, 'x');
+    body.replace(body.size() - 9, 9, "needle!!!");
+    auto start = std::chrono::steady_clock::now();
+    size_t at = 0;
+    for (int i = 0; i < 20; i++) {
+        at = string_search_find(body.data(), body.size(), "needle", 6);
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "found at " << at << ", " << (20.0 * body.size() / (us ? us : 1)) << " MB/s" << std::endl;
+    if (at != body.size() - 9) failures++;
+
+    std::cout << "\n" << (failures == 0 ? "All string search tests passed" : "String search tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
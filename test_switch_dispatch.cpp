@@ -0,0 +1,120 @@
+// Switch dispatch lowering test program: jump tables, binary decision trees
+// and float64 discriminants, run as emitted machine code
+#include "x86_codegen_v2.h"
+#include <sys/mman.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef int64_t (*DispatchFn)(int64_t);
+
+// Emits `return index of the case matching the argument, or -1`
+static DispatchFn build_dispatch(const std::vector<int64_t>& keys, bool is_float64, bool& used_jump_table) {
+    X86CodeGenV2 codegen;
+    std::vector<std::pair<int64_t, std::string>> cases;
+    for (size_t i = 0; i < keys.size(); i++) {
+        cases.emplace_back(keys[i], "case_" + std::to_string(i));
+    }
+    codegen.emit_mov_reg_reg(0, 7);  // rax = first argument
+    codegen.emit_switch_dispatch(0, is_float64, cases, "no_match");
+    for (size_t i = 0; i < keys.size(); i++) {
+        codegen.emit_label(cases[i].second);
+        codegen.emit_mov_reg_imm(0, static_cast<int64_t>(i));
+        codegen.emit_ret();
+    }
+    codegen.emit_label("no_match");
+    codegen.emit_mov_reg_imm(0, -1);
+    codegen.emit_ret();
+
+    std::vector<uint8_t> code = codegen.get_code();
+    static const uint8_t jmp_r11[] = {0x41, 0xFF, 0xE3};
+    used_jump_table = std::search(code.begin(), code.end(), jmp_r11, jmp_r11 + 3) != code.end();
+    void* exec = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    std::memcpy(exec, code.data(), code.size());
+    return reinterpret_cast<DispatchFn>(exec);
+}
+
+// Every key finds its own case and each probe falls through to no_match
+static int check_keys(DispatchFn dispatch, const std::vector<int64_t>& keys, const std::vector<int64_t>& misses) {
+    int failures = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (dispatch(keys[i]) != static_cast<int64_t>(i)) {
+            std::cout << "  key " << keys[i] << " -> " << dispatch(keys[i]) << ", expected " << i << std::endl;
+            failures++;
+        }
+    }
+    for (int64_t miss : misses) {
+        if (dispatch(miss) != -1) {
+            std::cout << "  miss " << miss << " -> " << dispatch(miss) << std::endl;
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int64_t double_bits(double value) {
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+int main() {
+    std::cout << "=== UltraScript Switch Dispatch Test ===" << std::endl;
+    int failures = 0;
+    bool table = false;
+
+    // Test 1: A dense key range becomes a bounds-checked jump table
+    std::cout << "\n1. Testing dense jump table..." << std::endl;
+    std::vector<int64_t> dense = {3, 4, 5, 6, 8, 9, 10, 12};
+    DispatchFn dense_fn = build_dispatch(dense, false, table);
+    std::cout << "jump table=" << table << std::endl;
+    if (!table) failures++;
+    failures += check_keys(dense_fn, dense, {-1, 0, 2, 7, 11, 13, 1000, INT64_MIN, INT64_MAX});
+
+    // Test 2: Sparse keys are split by a balanced binary decision tree
+    std::cout << "\n2. Testing binary decision tree..." << std::endl;
+    std::vector<int64_t> sparse = {-1000000, -5, 7, 1000, 65536, int64_t(1) << 40, INT64_MAX - 1};
+    DispatchFn sparse_fn = build_dispatch(sparse, false, table);
+    std::cout << "jump table=" << table << std::endl;
+    if (table) failures++;
+    failures += check_keys(sparse_fn, sparse, {-999999, -4, 0, 8, 999, 65537, (int64_t(1) << 40) + 1, INT64_MAX});
+
+    // Test 3: Keys spanning the whole int64 range don't overflow the density check
+    std::cout << "\n3. Testing full-range keys..." << std::endl;
+    std::vector<int64_t> extremes = {INT64_MIN, INT64_MIN + 1, INT64_MIN + 2, 0, INT64_MAX - 1, INT64_MAX};
+    DispatchFn extremes_fn = build_dispatch(extremes, false, table);
+    std::cout << "jump table=" << table << std::endl;
+    if (table) failures++;
+    failures += check_keys(extremes_fn, extremes, {INT64_MIN + 3, -1, 1, INT64_MAX - 2});
+
+    // Test 4: A dense run far from zero, with a minimum that doesn't fit an imm32
+    std::cout << "\n4. Testing jump table at the bottom of the range..." << std::endl;
+    std::vector<int64_t> low = {INT64_MIN, INT64_MIN + 1, INT64_MIN + 2, INT64_MIN + 3, INT64_MIN + 5};
+    DispatchFn low_fn = build_dispatch(low, false, table);
+    std::cout << "jump table=" << table << std::endl;
+    if (!table) failures++;
+    failures += check_keys(low_fn, low, {INT64_MIN + 4, INT64_MIN + 6, 0, INT64_MAX});
+
+    // Test 5: Float64 discriminants match only integral values
+    std::cout << "\n5. Testing float64 discriminants..." << std::endl;
+    std::vector<int64_t> small = {0, 1, 2, 3, 4};
+    DispatchFn float_fn = build_dispatch(small, true, table);
+    int float_failures = 0;
+    if (float_fn(double_bits(3.0)) != 3) float_failures++;
+    if (float_fn(double_bits(-0.0)) != 0) float_failures++;
+    if (float_fn(double_bits(3.5)) != -1) float_failures++;
+    if (float_fn(double_bits(1e300)) != -1) float_failures++;
+    if (float_fn(double_bits(-1.0)) != -1) float_failures++;
+    std::cout << "float mismatches=" << float_failures << std::endl;
+    failures += float_failures;
+
+    if (failures) {
+        std::cout << "\n" << failures << " switch dispatch test(s) FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "\nAll switch dispatch tests passed" << std::endl;
+    return 0;
+}
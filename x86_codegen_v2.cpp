@@ -13,7 +13,15 @@ static std::string generate_unique_label(const std::string& base) {
 #include "dynamic_properties.h"  // For dynamic property functions
 #include "simple_lexical_scope.h"  // For scope management
 #include "static_analyzer.h"  // For static analysis
+#include "exception_unwinder.h"  // For zero-cost exception runtime
+#include "sampling_profiler.h"  // For runtime.profiler
+#include "gc_telemetry.h"  // For runtime.gc
+#include "gc_heap_profiler.h"  // For runtime.gc heap snapshots and allocation sampling
+#include "closure_pool.h"  // For closure and scope allocation
+#include "object_refcount.h"  // For biased reference counts
+#include "gc_system.h"  // For GC heap allocation
 #include <cassert>
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>  // For malloc
 #include <iomanip>
@@ -91,6 +99,7 @@ void* __jit_object_create_sized(void* class_name_ptr, size_t size);
 int64_t __class_property_lookup(void* object, void* property_name_string, void* class_info_ptr);
 bool __string_equals(void* str1_ptr, void* str2_ptr);
 int64_t __string_compare(void* str1_ptr, void* str2_ptr);
+uint64_t __string_switch_hash(void* str_ptr, uint64_t seed);
 void* __dynamic_value_extract_string(void* dynamic_value_ptr);
 int64_t __dynamic_value_extract_int64(void* dynamic_value_ptr);
 double __dynamic_value_extract_float64(void* dynamic_value_ptr);
@@ -258,6 +267,14 @@ void X86CodeGenV2::clear() {
     unresolved_jumps.clear();
     reg_state = RegisterState();
     stack_frame = StackFrame();
+    exception_regions.clear();
+    open_exception_regions.clear();
+    frame_unwind_records.clear();
+    open_frame_sizes.clear();
+    open_frame_records.clear();
+    landing_pad_frame_sizes.clear();
+    gc_frame_scopes.clear();
+    gc_frame_scopes_saved.clear();
     
     // CRITICAL: Clear label state in instruction builder to prevent label corruption
     if (instruction_builder) {
@@ -274,12 +291,14 @@ void X86CodeGenV2::emit_prologue() {
         return;  // Already established
     }
     
+    record_frame_layout(code_buffer.size(), stack_frame.saved_registers, stack_frame.local_stack_size);
     pattern_builder->emit_function_prologue(
         stack_frame.local_stack_size, 
         stack_frame.saved_registers
     );
     
     stack_frame.frame_established = true;
+    gc_frame_scopes.clear();
 }
 
 void X86CodeGenV2::emit_epilogue() {
@@ -297,6 +316,10 @@ void X86CodeGenV2::emit_epilogue() {
     std::cout << "[FUNCTION_EPILOGUE_DEBUG] pattern_builder->emit_function_epilogue completed" << std::endl;
     
     stack_frame.frame_established = false;
+    if (!open_frame_sizes.empty()) {
+        open_frame_sizes.pop_back();
+        open_frame_records.pop_back();
+    }
     std::cout << "[FUNCTION_EPILOGUE_DEBUG] emit_epilogue completed" << std::endl;
 }
 
@@ -584,9 +607,32 @@ void* X86CodeGenV2::get_runtime_function_address(const std::string& function_nam
         (*runtime_functions)["__string_concat_cstr"] = reinterpret_cast<void*>(__string_concat_cstr);
         (*runtime_functions)["__string_concat_cstr_left"] = reinterpret_cast<void*>(__string_concat_cstr_left);
         (*runtime_functions)["__string_match"] = reinterpret_cast<void*>(__string_match);
+        (*runtime_functions)["__string_index_of"] = reinterpret_cast<void*>(__string_index_of);
+        (*runtime_functions)["__string_includes"] = reinterpret_cast<void*>(__string_includes);
+        (*runtime_functions)["__string_starts_with"] = reinterpret_cast<void*>(__string_starts_with);
+        (*runtime_functions)["__string_split"] = reinterpret_cast<void*>(__string_split);
         (*runtime_functions)["__string_create_with_length"] = reinterpret_cast<void*>(__string_create_with_length);
         (*runtime_functions)["__string_equals"] = reinterpret_cast<void*>(__string_equals);
         (*runtime_functions)["__string_compare"] = reinterpret_cast<void*>(__string_compare);
+        (*runtime_functions)["__string_switch_hash"] = reinterpret_cast<void*>(__string_switch_hash);
+        (*runtime_functions)["__runtime_profiler_start"] = reinterpret_cast<void*>(__runtime_profiler_start);
+        (*runtime_functions)["__runtime_profiler_stop"] = reinterpret_cast<void*>(__runtime_profiler_stop);
+        (*runtime_functions)["__runtime_profiler_running"] = reinterpret_cast<void*>(__runtime_profiler_running);
+        (*runtime_functions)["__runtime_gc_collect"] = reinterpret_cast<void*>(__runtime_gc_collect);
+        (*runtime_functions)["__runtime_gc_heapSize"] = reinterpret_cast<void*>(__runtime_gc_heapSize);
+        (*runtime_functions)["__runtime_gc_heapUsed"] = reinterpret_cast<void*>(__runtime_gc_heapUsed);
+        (*runtime_functions)["__runtime_gc_nextGC"] = reinterpret_cast<void*>(__runtime_gc_nextGC);
+        (*runtime_functions)["__runtime_gc_stats"] = reinterpret_cast<void*>(__runtime_gc_stats);
+        (*runtime_functions)["__runtime_gc_allocationRate"] = reinterpret_cast<void*>(__runtime_gc_allocationRate);
+        (*runtime_functions)["__runtime_gc_promotionRate"] = reinterpret_cast<void*>(__runtime_gc_promotionRate);
+        (*runtime_functions)["__runtime_gc_sinceLastGC"] = reinterpret_cast<void*>(__runtime_gc_sinceLastGC);
+        (*runtime_functions)["__runtime_gc_writeHeapSnapshot"] = reinterpret_cast<void*>(__runtime_gc_writeHeapSnapshot);
+        (*runtime_functions)["__runtime_gc_heapSummary"] = reinterpret_cast<void*>(__runtime_gc_heapSummary);
+        (*runtime_functions)["__runtime_gc_startAllocationSampling"] = reinterpret_cast<void*>(__runtime_gc_startAllocationSampling);
+        (*runtime_functions)["__runtime_gc_stopAllocationSampling"] = reinterpret_cast<void*>(__runtime_gc_stopAllocationSampling);
+        (*runtime_functions)["__runtime_gc_collectCycles"] = reinterpret_cast<void*>(__runtime_gc_collectCycles);
+        (*runtime_functions)["__runtime_gc_cycleStats"] = reinterpret_cast<void*>(__runtime_gc_cycleStats);
+        (*runtime_functions)["__runtime_gc_setHeapLimits"] = reinterpret_cast<void*>(__runtime_gc_setHeapLimits);
         (*runtime_functions)["__dynamic_value_extract_string"] = reinterpret_cast<void*>(__dynamic_value_extract_string);
         (*runtime_functions)["__dynamic_value_extract_int64"] = reinterpret_cast<void*>(__dynamic_value_extract_int64);
         (*runtime_functions)["__dynamic_value_extract_float64"] = reinterpret_cast<void*>(__dynamic_value_extract_float64);
@@ -634,6 +680,11 @@ void* X86CodeGenV2::get_runtime_function_address(const std::string& function_nam
         (*runtime_functions)["__object_add_ref"] = reinterpret_cast<void*>(__object_add_ref);
         (*runtime_functions)["__object_release"] = reinterpret_cast<void*>(__object_release);
         (*runtime_functions)["__object_destruct"] = reinterpret_cast<void*>(__object_destruct);
+        (*runtime_functions)["__object_ref_count_retain_shared"] = reinterpret_cast<void*>(__object_ref_count_retain_shared);
+        (*runtime_functions)["__object_ref_count_release_shared"] = reinterpret_cast<void*>(__object_ref_count_release_shared);
+        (*runtime_functions)["__object_ref_count_biased_zero"] = reinterpret_cast<void*>(__object_ref_count_biased_zero);
+        (*runtime_functions)["__object_ref_count_possible_root"] = reinterpret_cast<void*>(__object_ref_count_possible_root);
+        (*runtime_functions)["__object_set_reference"] = reinterpret_cast<void*>(__object_set_reference);
         (*runtime_functions)["__object_free_direct"] = reinterpret_cast<void*>(__object_free_direct);
         (*runtime_functions)["__object_get_ref_count"] = reinterpret_cast<void*>(__object_get_ref_count);
         
@@ -733,6 +784,11 @@ void* X86CodeGenV2::get_runtime_function_address(const std::string& function_nam
         (*runtime_functions)["__get_function_instance_scope_address"] = reinterpret_cast<void*>(__get_function_instance_scope_address);
         (*runtime_functions)["__get_function_instance_size"] = reinterpret_cast<void*>(__get_function_instance_size);
         (*runtime_functions)["__throw_function_type_error"] = reinterpret_cast<void*>(__throw_function_type_error);
+        
+        // Zero-cost exception handling
+        (*runtime_functions)["__runtime_throw_exception"] = reinterpret_cast<void*>(__runtime_throw_exception);
+        (*runtime_functions)["__runtime_rethrow_exception"] = reinterpret_cast<void*>(__runtime_rethrow_exception);
+        (*runtime_functions)["__runtime_current_exception"] = reinterpret_cast<void*>(__runtime_current_exception);
         (*runtime_functions)["__get_current_code_address"] = reinterpret_cast<void*>(__get_current_code_address);
         (*runtime_functions)["__register_function_instance_for_patching"] = reinterpret_cast<void*>(__register_function_instance_for_patching);
         (*runtime_functions)["__patch_all_function_instances"] = reinterpret_cast<void*>(__patch_all_function_instances);
@@ -741,6 +797,11 @@ void* X86CodeGenV2::get_runtime_function_address(const std::string& function_nam
         // Standard C library functions for memory management
         (*runtime_functions)["malloc"] = reinterpret_cast<void*>(malloc);
         (*runtime_functions)["free"] = reinterpret_cast<void*>(free);
+        (*runtime_functions)["__closure_pool_alloc"] = reinterpret_cast<void*>(__closure_pool_alloc);
+        (*runtime_functions)["__closure_pool_alloc_zeroed"] = reinterpret_cast<void*>(__closure_pool_alloc_zeroed);
+        (*runtime_functions)["__closure_pool_free"] = reinterpret_cast<void*>(__closure_pool_free);
+        (*runtime_functions)["__gc_alloc"] = reinterpret_cast<void*>(__gc_alloc);
+        (*runtime_functions)["__gc_free"] = reinterpret_cast<void*>(__gc_free);
         (*runtime_functions)["memset"] = reinterpret_cast<void*>(memset);
         (*runtime_functions)["memcpy"] = reinterpret_cast<void*>(memcpy);
         
@@ -781,7 +842,13 @@ void X86CodeGenV2::emit_ret() {
 
 void X86CodeGenV2::emit_function_return() {
     std::cout << "[FUNCTION_EPILOGUE_DEBUG] emit_function_return called" << std::endl;
+    emit_gc_frame_scopes_exit();
+    // A return leaves the frame but the rest of the body is still emitted in it
+    std::vector<int64_t> frame_sizes = open_frame_sizes;
+    std::vector<size_t> frame_records = open_frame_records;
     emit_epilogue();  // The epilogue already includes ret instruction
+    open_frame_sizes = std::move(frame_sizes);
+    open_frame_records = std::move(frame_records);
     std::cout << "[FUNCTION_EPILOGUE_DEBUG] emit_function_return completed" << std::endl;
 }
 
@@ -1089,62 +1156,97 @@ void X86CodeGenV2::emit_memory_fence(int fence_type) {
     }
 }
 
+// Biased counts (object_refcount.h): when the object's owner is this thread,
+// a plain inc/dec of the count at OBJECT_REF_COUNT_OFFSET; otherwise, or once
+// the biased count reaches zero, a runtime call. Clobbers r11.
+bool X86CodeGenV2::emit_ref_count_owner_check(X86Reg obj, const std::string& shared_label) {
+    int64_t token = object_ref_count_tls_offset();
+    if (token < INT32_MIN || token > INT32_MAX) {
+        // Unreachable TLS: every object looks shared
+        instruction_builder->jmp(shared_label);
+        return false;
+    }
+    uint32_t v = static_cast<uint32_t>(token);
+    instruction_builder->mov(X86Reg::R11, MemoryOperand(obj, static_cast<int32_t>(OBJECT_REF_COUNT_OWNER_OFFSET)));
+    instruction_builder->emit_bytes({0x64, 0x4C, 0x3B, 0x1C, 0x25, uint8_t(v), uint8_t(v >> 8),
+                                     uint8_t(v >> 16), uint8_t(v >> 24)});   // cmp r11, fs:[token]
+    instruction_builder->jnz(shared_label);
+    return true;
+}
+
 void X86CodeGenV2::emit_ref_count_increment(int object_reg) {
     X86Reg obj = get_register_for_int(object_reg);
+    std::string shared_label = generate_unique_label("ref_inc_shared");
+    std::string done_label = generate_unique_label("ref_inc_done");
+    
+    if (emit_ref_count_owner_check(obj, shared_label)) {
+        instruction_builder->inc(MemoryOperand(obj, OBJECT_REF_COUNT_OFFSET), OpSize::QWORD);
+        instruction_builder->jmp(done_label);
+    }
+    
+    // Another thread's object: atomic add to its shared count. Increments sit
+    // next to live values, so save all caller-saved registers
+    emit_label(shared_label);
+    static const X86Reg saved[] = {X86Reg::RAX, X86Reg::RCX, X86Reg::RDX, X86Reg::RSI, X86Reg::RDI,
+                                   X86Reg::R8, X86Reg::R9, X86Reg::R10, X86Reg::R11};
+    for (X86Reg reg : saved) {
+        instruction_builder->push(reg);
+    }
+    instruction_builder->mov(X86Reg::RDI, obj);
+    instruction_builder->push(X86Reg::RBP);
+    instruction_builder->emit_bytes({0x48, 0x89, 0xE5});                     // mov rbp, rsp
+    instruction_builder->emit_bytes({0x48, 0x83, 0xE4, 0xF0});               // and rsp, -16
+    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(__object_ref_count_retain_shared));
+    instruction_builder->call(X86Reg::RAX);
+    instruction_builder->emit_bytes({0x48, 0x89, 0xEC});                     // mov rsp, rbp
+    instruction_builder->pop(X86Reg::RBP);
+    for (size_t i = sizeof(saved) / sizeof(saved[0]); i-- > 0;) {
+        instruction_builder->pop(saved[i]);
+    }
     
-    // Ultra-high performance atomic increment of ref_count at offset 16
-    // Uses the x86 LOCK INC instruction for maximum performance
-    // LOCK INC [obj + OBJECT_REF_COUNT_OFFSET] - atomic increment, fastest possible
-    MemoryOperand ref_count_addr(obj, OBJECT_REF_COUNT_OFFSET);
-    
-    // Emit: lock inc qword ptr [obj + 16] - This is the fastest atomic increment possible
-    instruction_builder->lock_inc(ref_count_addr, OpSize::QWORD);
+    emit_label(done_label);
 }
 
 void X86CodeGenV2::emit_ref_count_decrement(int object_reg, int result_reg) {
     X86Reg obj = get_register_for_int(object_reg);
-    // Inline: lock dec [obj + OBJECT_REF_COUNT_OFFSET]
-    MemoryOperand ref_count_addr(obj, OBJECT_REF_COUNT_OFFSET);
-    instruction_builder->lock_dec(ref_count_addr, OpSize::QWORD);
-
-    // Inline: jnz skip_destruct
-    std::string skip_label = generate_unique_label("skip_destruct");
-    instruction_builder->jnz(skip_label);
-
-    // Inline: call destructor function (shared routine)
-    // rdi should hold the object pointer for the destructor ABI
-    instruction_builder->mov(X86Reg::RDI, obj); // Move object pointer to rdi
-    emit_call("__object_destruct");
-
-    // skip_destruct:
-    emit_label(skip_label);
+    std::string shared_label = generate_unique_label("ref_dec_shared");
+    std::string done_label = generate_unique_label("ref_dec_done");
+    
+    if (emit_ref_count_owner_check(obj, shared_label)) {
+        std::string live_label = generate_unique_label("ref_dec_live");
+        // Inline: dec [obj + OBJECT_REF_COUNT_OFFSET]; jnz live
+        instruction_builder->dec(MemoryOperand(obj, OBJECT_REF_COUNT_OFFSET), OpSize::QWORD);
+        instruction_builder->jnz(live_label);
+        // Biased count gone: merge, destroying the object if that was the last reference
+        instruction_builder->mov(X86Reg::RDI, obj);
+        emit_call("__object_ref_count_biased_zero");
+        instruction_builder->jmp(done_label);
+        
+        // Still referenced: a possible garbage cycle if it holds counted references
+        emit_label(live_label);
+        instruction_builder->mov(X86Reg::R11, MemoryOperand(obj, static_cast<int32_t>(OBJECT_REF_COUNT_REFERENCES_OFFSET)));
+        instruction_builder->test(X86Reg::R11, X86Reg::R11);
+        instruction_builder->jz(done_label);
+        instruction_builder->mov(X86Reg::RDI, obj);
+        emit_call("__object_ref_count_possible_root");
+        instruction_builder->jmp(done_label);
+    }
+    
+    // rdi should hold the object pointer for the runtime ABI
+    emit_label(shared_label);
+    instruction_builder->mov(X86Reg::RDI, obj);
+    emit_call("__object_ref_count_release_shared");
+    
+    emit_label(done_label);
 }
 
 // Additional ultra-fast reference counting operations for specific use cases
 void X86CodeGenV2::emit_ref_count_increment_simple(int object_reg) {
-    // Fastest possible increment - no return value needed
-    X86Reg obj = get_register_for_int(object_reg);
-    MemoryOperand ref_count_addr(obj, OBJECT_REF_COUNT_OFFSET);
-    instruction_builder->lock_inc(ref_count_addr, OpSize::QWORD);
+    emit_ref_count_increment(object_reg);
 }
 
 void X86CodeGenV2::emit_ref_count_decrement_simple(int object_reg) {
-    // Fastest possible decrement - no return value needed
-    X86Reg obj = get_register_for_int(object_reg);
-    MemoryOperand ref_count_addr(obj, OBJECT_REF_COUNT_OFFSET);
-    instruction_builder->lock_dec(ref_count_addr, OpSize::QWORD);
-}
-
-void X86CodeGenV2::emit_ref_count_check_zero_and_free(int object_reg, const std::string& free_label) {
-    // Ultra-optimized: decrement and jump to free if zero
-    X86Reg obj = get_register_for_int(object_reg);
-    MemoryOperand ref_count_addr(obj, OBJECT_REF_COUNT_OFFSET);
-    
-    // Atomic decrement
-    instruction_builder->lock_dec(ref_count_addr, OpSize::QWORD);
-    
-    // Jump to free_label if zero flag is set (ref_count became 0)
-    instruction_builder->jz(free_label);
+    emit_ref_count_decrement(object_reg, object_reg);
 }
 
 // =============================================================================
@@ -1348,6 +1450,208 @@ void X86CodeGenV2::resolve_runtime_function_calls() {
     // No post-processing needed for the new system
 }
 
+// =============================================================================
+// Switch Dispatch Lowering
+// =============================================================================
+
+// Jump tables are used when a key range is at least this dense (cases / range)
+// and no larger than the limit below; sparser ranges are split by binary search
+static constexpr size_t SWITCH_JUMP_TABLE_MIN_CASES = 4;
+static constexpr size_t SWITCH_JUMP_TABLE_MAX_RANGE = 4096;
+static constexpr size_t SWITCH_LINEAR_MAX_CASES = 3;
+
+static bool switch_range_is_dense(const std::vector<std::pair<int64_t, std::string>>& cases, size_t begin, size_t end) {
+    size_t count = end - begin;
+    if (count < SWITCH_JUMP_TABLE_MIN_CASES) return false;
+    // max - min is computed unsigned so keys spanning the whole int64 range
+    // don't overflow; the +1 is only added once the span is known to be small
+    uint64_t span = static_cast<uint64_t>(cases[end - 1].first) - static_cast<uint64_t>(cases[begin].first);
+    return span < SWITCH_JUMP_TABLE_MAX_RANGE && span < count * 3;
+}
+
+void X86CodeGenV2::emit_compare_imm(X86Reg value, int64_t key) {
+    if (key >= INT32_MIN && key <= INT32_MAX) {
+        instruction_builder->cmp(value, ImmediateOperand(key));
+    } else {
+        instruction_builder->mov(X86Reg::RCX, ImmediateOperand(key));
+        instruction_builder->cmp(value, X86Reg::RCX);
+    }
+}
+
+void X86CodeGenV2::emit_switch_dispatch(int value_reg, bool value_is_float64,
+                                        const std::vector<std::pair<int64_t, std::string>>& cases,
+                                        const std::string& default_label) {
+    std::vector<std::pair<int64_t, std::string>> sorted(cases);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    X86Reg value = get_register_for_int(value_reg);
+    if (value != X86Reg::RAX) {
+        instruction_builder->mov(X86Reg::RAX, value);
+        value = X86Reg::RAX;
+    }
+    
+    if (value_is_float64) {
+        // Convert to int64 and keep it only if it converts back to the same double.
+        // Fractions, NaN and out-of-range values fail the round trip; -0.0 is
+        // folded to 0 first so it still matches case 0.
+        std::string is_integral = "__switch_int_" + std::to_string(switch_dispatch_counter++);
+        instruction_builder->mov(X86Reg::RCX, X86Reg::RAX);
+        instruction_builder->shl(X86Reg::RCX, ImmediateOperand(1));
+        instruction_builder->jnz(is_integral);
+        instruction_builder->xor_(X86Reg::RAX, X86Reg::RAX);
+        emit_label(is_integral);
+        instruction_builder->movq(X86XmmReg::XMM0, X86Reg::RAX);
+        instruction_builder->cvtsd2si(X86Reg::RDX, X86XmmReg::XMM0);
+        instruction_builder->cvtsi2sd(X86XmmReg::XMM1, X86Reg::RDX);
+        instruction_builder->movq(X86Reg::RCX, X86XmmReg::XMM1);
+        instruction_builder->cmp(X86Reg::RAX, X86Reg::RCX);
+        instruction_builder->jnz(default_label);
+        instruction_builder->mov(X86Reg::RAX, X86Reg::RDX);
+    }
+    
+    if (sorted.empty()) {
+        instruction_builder->jmp(default_label);
+        return;
+    }
+    emit_switch_range(value, sorted, 0, sorted.size(), default_label);
+}
+
+void X86CodeGenV2::emit_switch_range(X86Reg value, const std::vector<std::pair<int64_t, std::string>>& cases,
+                                     size_t begin, size_t end, const std::string& default_label) {
+    size_t count = end - begin;
+    
+    if (switch_range_is_dense(cases, begin, end)) {
+        emit_jump_table(value, cases, begin, end, default_label);
+        return;
+    }
+    
+    if (count <= SWITCH_LINEAR_MAX_CASES) {
+        for (size_t i = begin; i < end; i++) {
+            emit_compare_imm(value, cases[i].first);
+            instruction_builder->jz(cases[i].second);
+        }
+        instruction_builder->jmp(default_label);
+        return;
+    }
+    
+    // Balanced split: keys below the pivot go left, the rest fall through to the right
+    size_t mid = begin + count / 2;
+    std::string left_label = "__switch_lt_" + std::to_string(switch_dispatch_counter++);
+    emit_compare_imm(value, cases[mid].first);
+    instruction_builder->jl(left_label);
+    emit_switch_range(value, cases, mid, end, default_label);
+    emit_label(left_label);
+    emit_switch_range(value, cases, begin, mid, default_label);
+}
+
+void X86CodeGenV2::emit_jump_table(X86Reg value, const std::vector<std::pair<int64_t, std::string>>& cases,
+                                   size_t begin, size_t end, const std::string& default_label) {
+    int64_t min_key = cases[begin].first;
+    // Small by switch_range_is_dense; unsigned so it can't overflow
+    uint64_t range = static_cast<uint64_t>(cases[end - 1].first) - static_cast<uint64_t>(min_key) + 1;
+    std::string table_label = "__switch_table_" + std::to_string(switch_dispatch_counter++);
+    
+    // RCX = value - min_key, unsigned bounds check against the table size
+    instruction_builder->mov(X86Reg::RCX, value);
+    if (min_key != 0) {
+        if (min_key >= INT32_MIN && min_key <= INT32_MAX) {
+            instruction_builder->sub(X86Reg::RCX, ImmediateOperand(min_key));
+        } else {
+            instruction_builder->mov(X86Reg::RDX, ImmediateOperand(min_key));
+            instruction_builder->sub(X86Reg::RCX, X86Reg::RDX);
+        }
+    }
+    instruction_builder->cmp(X86Reg::RCX, ImmediateOperand(static_cast<int64_t>(range - 1)));
+    instruction_builder->jcc(0x87, default_label);  // JA - also catches negative indices
+    
+    // Entries are rel32 displacements measured from the end of each entry, so
+    // they are patched exactly like jump targets
+    instruction_builder->emit_bytes({0x4C, 0x8D, 0x1D});        // lea r11, [rip + table]
+    instruction_builder->emit_label_placeholder(table_label);
+    instruction_builder->emit_bytes({0x49, 0x63, 0x14, 0x8B});  // movsxd rdx, dword [r11 + rcx*4]
+    instruction_builder->emit_bytes({0x4D, 0x8D, 0x5C, 0x8B, 0x04});  // lea r11, [r11 + rcx*4 + 4]
+    instruction_builder->emit_bytes({0x49, 0x01, 0xD3});        // add r11, rdx
+    instruction_builder->emit_bytes({0x41, 0xFF, 0xE3});        // jmp r11
+    
+    emit_label(table_label);
+    size_t next = begin;
+    for (uint64_t slot = 0; slot < range; slot++) {
+        if (next < end && static_cast<uint64_t>(cases[next].first) - static_cast<uint64_t>(min_key) == slot) {
+            instruction_builder->emit_label_placeholder(cases[next].second);
+            next++;
+        } else {
+            instruction_builder->emit_label_placeholder(default_label);
+        }
+    }
+}
+
+// =============================================================================
+// Zero-Cost Exception Handling Tables
+// =============================================================================
+
+void X86CodeGenV2::record_frame_layout(size_t start_offset, const std::vector<X86Reg>& saved_regs, size_t local_stack_size) {
+    // Mirrors X86PatternBuilder::emit_function_prologue: rbp, saved registers, aligned locals
+    size_t aligned_locals = (local_stack_size + 15) & ~static_cast<size_t>(15);
+    int64_t frame_size = static_cast<int64_t>(saved_regs.size() * 8 + aligned_locals);
+    frame_unwind_records.push_back({start_offset, saved_regs, frame_size, false});
+    open_frame_sizes.push_back(frame_size);
+    open_frame_records.push_back(frame_unwind_records.size() - 1);
+}
+
+void X86CodeGenV2::begin_exception_region(const std::string& landing_pad_label) {
+    // Nothing is emitted - the range is only recorded for the unwinder. The
+    // landing pad runs in the frame of the function containing the try, which
+    // may not be the function whose prologue was emitted last.
+    open_exception_regions.push_back({code_buffer.size(), 0, landing_pad_label, gc_frame_scopes.size()});
+    if (!open_frame_sizes.empty()) {
+        landing_pad_frame_sizes[landing_pad_label] = open_frame_sizes.back();
+    }
+}
+
+void X86CodeGenV2::end_exception_region() {
+    if (open_exception_regions.empty()) {
+        throw std::runtime_error("end_exception_region() without matching begin_exception_region()");
+    }
+    ExceptionRegionRecord region = open_exception_regions.back();
+    open_exception_regions.pop_back();
+    region.end_offset = code_buffer.size();
+    exception_regions.push_back(std::move(region));
+}
+
+void X86CodeGenV2::emit_landing_pad(const std::string& label) {
+    emit_label(label);
+    
+    // The unwinder resumes with the throwing call site's stack pointer; put rsp
+    // back to this frame's steady state so the epilogue pops the right slots
+    auto frame = landing_pad_frame_sizes.find(label);
+    if (frame != landing_pad_frame_sizes.end()) {
+        instruction_builder->lea(X86Reg::RSP, MemoryOperand(X86Reg::RBP, static_cast<int32_t>(-frame->second)));
+    }
+    
+    // The unwinder has already freed the scopes entered since the try began,
+    // unpublished them and pointed r15 at the scope the try started in
+}
+
+void X86CodeGenV2::emit_save_pending_exception() {
+    // Push the exception below the frame's steady state and count it in the
+    // frame size, so landing pads inside the finally body leave it in place
+    instruction_builder->sub(X86Reg::RSP, ImmediateOperand(16));
+    instruction_builder->mov(MemoryOperand(X86Reg::RSP, 0), X86Reg::RAX);
+    if (!open_frame_sizes.empty()) {
+        open_frame_sizes.back() += 16;
+    }
+}
+
+void X86CodeGenV2::emit_throw_pending_exception() {
+    instruction_builder->mov(X86Reg::RDI, MemoryOperand(X86Reg::RSP, 0));
+    instruction_builder->add(X86Reg::RSP, ImmediateOperand(16));
+    if (!open_frame_sizes.empty()) {
+        open_frame_sizes.back() -= 16;
+    }
+    emit_call("__runtime_throw_exception");
+}
+
 // Factory function implementation
 std::unique_ptr<CodeGenerator> create_x86_codegen() {
     return std::make_unique<X86CodeGenV2>();
@@ -1431,16 +1735,10 @@ void X86CodeGenV2::emit_inline_heap_alloc(size_t size, int result_reg) {
     
     X86Reg result = get_register_for_int(result_reg);
     
-    // Ultra-fast inline heap allocation using a simple bump allocator
-    // This avoids expensive malloc() calls by using pre-allocated heap space
-    
-    // For now, use malloc() via system call (can optimize later with bump allocator)
+    // Scopes come from the thread's closure pool: a free-list pop or slab bump
     // mov rdi, size        ; First argument: size
     instruction_builder->mov(X86Reg::RDI, static_cast<int64_t>(size));
-    
-    // Call malloc - we'll use the C runtime malloc for now
-    // Note: This requires linking with libc, but gives us proper memory management
-    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(malloc));
+    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(__closure_pool_alloc));
     instruction_builder->call(X86Reg::RAX);
     
     // Result is in RAX, move to requested result register if different
@@ -1451,6 +1749,267 @@ void X86CodeGenV2::emit_inline_heap_alloc(size_t size, int result_reg) {
     std::cout << "[HEAP_ALLOC_DEBUG] Allocated " << size << " bytes, address in register R" << result_reg << std::endl;
 }
 
+void X86CodeGenV2::emit_gc_alloc_inline(size_t size, uint32_t type_id, int result_reg) {
+    X86Reg result = get_register_for_int(result_reg);
+    size_t cell_size = gc_cell_size_for(size);
+    std::string slow_label = generate_unique_label("gc_alloc_slow");
+    std::string done_label = generate_unique_label("gc_alloc_done");
+    
+    // Runs sit at the same offset from %fs in every thread (initial-exec TLS);
+    // the size class, and so the run and the cell stride, is fixed at compile time
+    bool inline_fast_path = cell_size <= GC_MAX_SMALL_CELL;
+    int64_t run_offset = 0;
+    size_t stride = 0;
+    if (inline_fast_path) {
+        size_t size_class = gc_size_class_for(cell_size);
+        run_offset = GCHeap::tlab_tls_offset() + static_cast<int64_t>(size_class * sizeof(GCAllocationRun));
+        stride = gc_size_classes.cells[size_class];
+        inline_fast_path = run_offset >= INT32_MIN && run_offset + 8 <= INT32_MAX;
+    }
+    
+    if (inline_fast_path) {
+        auto emit_with_disp = [&](std::vector<uint8_t> bytes, int64_t disp) {
+            uint32_t v = static_cast<uint32_t>(disp);
+            bytes.insert(bytes.end(), {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)});
+            instruction_builder->emit_bytes(bytes);
+        };
+        
+        // mov rax, fs:[cursor]
+        emit_with_disp({0x64, 0x48, 0x8B, 0x04, 0x25}, run_offset);
+        // lea r10, [rax + stride]
+        emit_with_disp({0x4C, 0x8D, 0x90}, static_cast<int64_t>(stride));
+        // cmp r10, fs:[limit] ; ja slow  (an unset run has cursor = limit = 0)
+        emit_with_disp({0x64, 0x4C, 0x3B, 0x14, 0x25}, run_offset + 8);
+        instruction_builder->jcc(0x87, slow_label);
+        
+        // Header at cell+4: size and type_id; flags and generation of a free cell are already 0
+        uint64_t header_word = static_cast<uint64_t>(size) | (static_cast<uint64_t>(type_id) << 32);
+        instruction_builder->mov(X86Reg::R11, static_cast<int64_t>(header_word));
+        instruction_builder->emit_bytes({0x4C, 0x89, 0x58, 0x04});              // mov [rax+4], r11
+        
+        // Publish the new cursor, then step past the cell header to the payload
+        emit_with_disp({0x64, 0x4C, 0x89, 0x14, 0x25}, run_offset);            // mov fs:[cursor], r10
+        instruction_builder->emit_bytes({0x48, 0x83, 0xC0, static_cast<uint8_t>(GC_CELL_HEADER_SIZE)});  // add rax, 16
+        instruction_builder->jmp(done_label);
+    }
+    
+    // Refill, large objects, or a thread without runs yet
+    emit_label(slow_label);
+    instruction_builder->mov(X86Reg::RDI, static_cast<int64_t>(size));
+    instruction_builder->mov(X86Reg::RSI, static_cast<int64_t>(type_id));
+    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(__gc_alloc));
+    instruction_builder->call(X86Reg::RAX);
+    emit_out_of_memory_check();
+    
+    emit_label(done_label);
+    if (result != X86Reg::RAX) {
+        instruction_builder->mov(result, X86Reg::RAX);
+    }
+}
+
+void X86CodeGenV2::emit_out_of_memory_check() {
+    std::string allocated_label = generate_unique_label("allocated");
+    
+    // nullptr: the heap is at its hard limit, throw a catchable out-of-memory error
+    instruction_builder->test(X86Reg::RAX, X86Reg::RAX);
+    instruction_builder->jnz(allocated_label);
+    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(__gc_out_of_memory_error));
+    instruction_builder->call(X86Reg::RAX);
+    instruction_builder->mov(X86Reg::RDI, X86Reg::RAX);
+    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(__runtime_throw_exception));
+    instruction_builder->call(X86Reg::RAX);
+    emit_label(allocated_label);
+}
+
+void X86CodeGenV2::emit_gc_write_barrier(int object_reg, int64_t offset) {
+    GCHeap& heap = GCHeap::instance();
+    if (!heap.card_table()) {
+        return;
+    }
+    std::string skip_label = generate_unique_label("gc_barrier_skip");
+    
+    // r11 = slot - heap base; unsigned compare rejects both sides of the range
+    instruction_builder->mov(X86Reg::R11, get_register_for_int(object_reg));
+    if (offset != 0) {
+        uint32_t v = static_cast<uint32_t>(offset);
+        instruction_builder->emit_bytes({0x49, 0x81, 0xC3, uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)});  // add r11, imm32
+    }
+    instruction_builder->mov(X86Reg::R10, static_cast<int64_t>(heap.base()));
+    instruction_builder->emit_bytes({0x4D, 0x29, 0xD3});                     // sub r11, r10
+    instruction_builder->mov(X86Reg::R10, static_cast<int64_t>(heap.reserved_bytes()));
+    instruction_builder->emit_bytes({0x4D, 0x39, 0xD3});                     // cmp r11, r10
+    instruction_builder->jcc(0x83, skip_label);                              // jae skip
+    
+    instruction_builder->emit_bytes({0x49, 0xC1, 0xEB, static_cast<uint8_t>(GC_CARD_SHIFT)});  // shr r11, 9
+    instruction_builder->mov(X86Reg::R10, reinterpret_cast<int64_t>(heap.card_table()));
+    instruction_builder->emit_bytes({0x43, 0xC6, 0x04, 0x1A, 0x01});         // mov byte [r10+r11], 1
+    
+    emit_label(skip_label);
+}
+
+void X86CodeGenV2::emit_gc_satb_barrier(int object_reg, int64_t offset) {
+    std::string skip_label = generate_unique_label("gc_satb_skip");
+    uint32_t disp = static_cast<uint32_t>(offset);
+    
+    // Fast path: one byte test while no collection is marking
+    instruction_builder->mov(X86Reg::R11, reinterpret_cast<int64_t>(&gc_marking_active));
+    instruction_builder->emit_bytes({0x41, 0x80, 0x3B, 0x00});               // cmp byte [r11], 0
+    instruction_builder->jcc(0x84, skip_label);                              // je skip
+    
+    // Slow path: the store site keeps values in any register, so save all caller-saved ones
+    static const X86Reg saved[] = {X86Reg::RAX, X86Reg::RCX, X86Reg::RDX, X86Reg::RSI, X86Reg::RDI,
+                                   X86Reg::R8, X86Reg::R9, X86Reg::R10, X86Reg::R11};
+    for (X86Reg reg : saved) {
+        instruction_builder->push(reg);
+    }
+    instruction_builder->mov(X86Reg::RDI, get_register_for_int(object_reg));
+    instruction_builder->emit_bytes({0x48, 0x8B, 0xBF, uint8_t(disp), uint8_t(disp >> 8),
+                                     uint8_t(disp >> 16), uint8_t(disp >> 24)});  // mov rdi, [rdi+disp32]
+    instruction_builder->push(X86Reg::RBP);
+    instruction_builder->emit_bytes({0x48, 0x89, 0xE5});                     // mov rbp, rsp
+    instruction_builder->emit_bytes({0x48, 0x83, 0xE4, 0xF0});               // and rsp, -16
+    instruction_builder->mov(X86Reg::RAX, reinterpret_cast<int64_t>(__gc_satb_enqueue));
+    instruction_builder->call(X86Reg::RAX);
+    instruction_builder->emit_bytes({0x48, 0x89, 0xEC});                     // mov rsp, rbp
+    instruction_builder->pop(X86Reg::RBP);
+    for (size_t i = sizeof(saved) / sizeof(saved[0]); i-- > 0;) {
+        instruction_builder->pop(saved[i]);
+    }
+    
+    emit_label(skip_label);
+}
+
+bool X86CodeGenV2::gc_scope_chain_displacement(int32_t& disp) const {
+    int64_t offset = GCHeap::tlab_tls_offset() + static_cast<int64_t>(offsetof(GCThreadLocalBuffer, scope_chain));
+    if (offset < INT32_MIN || offset > INT32_MAX) {
+        return false;
+    }
+    disp = static_cast<int32_t>(offset);
+    return true;
+}
+
+void X86CodeGenV2::emit_scope_alloc(size_t scope_size) {
+    size_t size = GC_SCOPE_HEADER_SIZE + scope_size;
+    std::string slow_label = generate_unique_label("scope_alloc_slow");
+    std::string done_label = generate_unique_label("scope_alloc_done");
+    
+    // The pool's own fast paths, inline: pop the thread's free list for this
+    // size class, else bump the slab cursor. Refills and threads without a
+    // cache yet call out.
+    int64_t cache_offset = ClosurePool::cache_tls_offset();
+    bool inline_fast_path = size <= ClosurePool::MAX_POOLED_SIZE && cache_offset >= INT32_MIN && cache_offset <= INT32_MAX;
+    if (inline_fast_path) {
+        size_t size_class = ClosurePool::size_class_of(size);
+        auto emit_with_disp = [&](std::vector<uint8_t> bytes, int64_t disp) {
+            uint32_t v = static_cast<uint32_t>(disp);
+            bytes.insert(bytes.end(), {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)});
+            instruction_builder->emit_bytes(bytes);
+        };
+        std::string bump_label = generate_unique_label("scope_alloc_bump");
+        std::string count_label = generate_unique_label("scope_alloc_count");
+        
+        emit_with_disp({0x64, 0x4C, 0x8B, 0x1C, 0x25}, cache_offset);          // mov r11, fs:[cache]
+        instruction_builder->emit_bytes({0x4D, 0x85, 0xDB});                    // test r11, r11
+        instruction_builder->jcc(0x84, slow_label);
+        
+        emit_with_disp({0x49, 0x8B, 0x83}, ClosurePool::free_list_offset(size_class));  // mov rax, [r11+free_list]
+        instruction_builder->emit_bytes({0x48, 0x85, 0xC0});                    // test rax, rax
+        instruction_builder->jcc(0x84, bump_label);
+        instruction_builder->emit_bytes({0x48, 0x8B, 0x10});                    // mov rdx, [rax] (next)
+        emit_with_disp({0x49, 0x89, 0x93}, ClosurePool::free_list_offset(size_class));  // mov [r11+free_list], rdx
+        instruction_builder->jmp(count_label);
+        
+        emit_label(bump_label);
+        emit_with_disp({0x49, 0x8B, 0x83}, ClosurePool::bump_offset(size_class));       // mov rax, [r11+bump]
+        instruction_builder->emit_bytes({0x48, 0x85, 0xC0});                    // test rax, rax
+        instruction_builder->jcc(0x84, slow_label);
+        emit_with_disp({0x48, 0x8D, 0x90}, ClosurePool::block_size_of(size_class));     // lea rdx, [rax+block]
+        emit_with_disp({0x49, 0x3B, 0x93}, ClosurePool::bump_end_offset(size_class));   // cmp rdx, [r11+bump_end]
+        instruction_builder->jcc(0x87, slow_label);                             // ja slow
+        emit_with_disp({0x49, 0x89, 0x93}, ClosurePool::bump_offset(size_class));       // mov [r11+bump], rdx
+        
+        // Only the owning thread writes its counter
+        emit_label(count_label);
+        emit_with_disp({0x49, 0xFF, 0x83}, ClosurePool::allocations_offset());          // inc qword [r11+allocations]
+        instruction_builder->jmp(done_label);
+    }
+    
+    emit_label(slow_label);
+    emit_mov_reg_imm(7, size);   // RDI = size, GC header included
+    emit_call("__closure_pool_alloc");
+    emit_label(done_label);
+    instruction_builder->emit_bytes({0x4C, 0x89, 0x78, 0x10});               // mov [rax+16], r15 (header.enclosing)
+    instruction_builder->emit_bytes({0x48, 0x83, 0xC0, static_cast<uint8_t>(GC_SCOPE_HEADER_SIZE)});  // add rax, 24
+    emit_mov_reg_reg(15, 0);
+}
+
+void X86CodeGenV2::emit_scope_free(bool restore_enclosing) {
+    emit_gc_scope_unlink();
+    instruction_builder->emit_bytes({0x49, 0x8D, 0x7F, 0xE8});               // lea rdi, [r15-24]
+    if (restore_enclosing) {
+        instruction_builder->emit_bytes({0x4D, 0x8B, 0x7F, 0xF8});           // mov r15, [r15-8]
+    }
+    emit_call("__closure_pool_free");
+}
+
+void X86CodeGenV2::emit_gc_scope_link(const GCStackMap* map) {
+    if (!open_frame_records.empty()) {
+        frame_unwind_records[open_frame_records.back()].allocates_scopes = true;
+    }
+    int32_t chain;
+    bool linked = !map->slots.empty() && gc_scope_chain_displacement(chain);
+    gc_frame_scopes.push_back(linked);
+    if (!linked) {
+        // Nothing in it for the collector: the header's chain words stay unset
+        return;
+    }
+    uint32_t v = static_cast<uint32_t>(chain);
+    
+    // Header first, then publish: a collector stopping us in between sees
+    // the chain without this scope, which holds nothing yet
+    instruction_builder->emit_bytes({0x64, 0x4C, 0x8B, 0x1C, 0x25, uint8_t(v), uint8_t(v >> 8),
+                                     uint8_t(v >> 16), uint8_t(v >> 24)});   // mov r11, fs:[chain]
+    instruction_builder->emit_bytes({0x4D, 0x89, 0x5F, 0xE8});               // mov [r15-24], r11
+    instruction_builder->mov(X86Reg::R11, reinterpret_cast<int64_t>(map));
+    instruction_builder->emit_bytes({0x4D, 0x89, 0x5F, 0xF0});               // mov [r15-16], r11
+    instruction_builder->emit_bytes({0x64, 0x4C, 0x89, 0x3C, 0x25, uint8_t(v), uint8_t(v >> 8),
+                                     uint8_t(v >> 16), uint8_t(v >> 24)});   // mov fs:[chain], r15
+}
+
+void X86CodeGenV2::emit_gc_scope_unlink() {
+    bool linked = !gc_frame_scopes.empty() && gc_frame_scopes.back();
+    if (!gc_frame_scopes.empty()) {
+        gc_frame_scopes.pop_back();
+    }
+    int32_t chain;
+    if (!linked || !gc_scope_chain_displacement(chain)) {
+        return;
+    }
+    uint32_t v = static_cast<uint32_t>(chain);
+    instruction_builder->emit_bytes({0x4D, 0x8B, 0x5F, 0xE8});               // mov r11, [r15-24]
+    instruction_builder->emit_bytes({0x64, 0x4C, 0x89, 0x1C, 0x25, uint8_t(v), uint8_t(v >> 8),
+                                     uint8_t(v >> 16), uint8_t(v >> 24)});   // mov fs:[chain], r11
+}
+
+// A return from inside nested scopes skips their exits: put back the chain
+// as it was before the outermost linked scope of this frame, reached through
+// the enclosing words. Keeps rax.
+void X86CodeGenV2::emit_gc_frame_scopes_exit() {
+    auto outermost = std::find(gc_frame_scopes.begin(), gc_frame_scopes.end(), true);
+    int32_t chain;
+    if (outermost == gc_frame_scopes.end() || !gc_scope_chain_displacement(chain)) {
+        return;
+    }
+    uint32_t v = static_cast<uint32_t>(chain);
+    instruction_builder->mov(X86Reg::R11, X86Reg::R15);
+    for (auto it = outermost + 1; it != gc_frame_scopes.end(); ++it) {
+        instruction_builder->emit_bytes({0x4D, 0x8B, 0x5B, 0xF8});           // mov r11, [r11-8]
+    }
+    instruction_builder->emit_bytes({0x4D, 0x8B, 0x5B, 0xE8});               // mov r11, [r11-24]
+    instruction_builder->emit_bytes({0x64, 0x4C, 0x89, 0x1C, 0x25, uint8_t(v), uint8_t(v >> 8),
+                                     uint8_t(v >> 16), uint8_t(v >> 24)});   // mov fs:[chain], r11
+}
+
 // Function instance patching system for high-performance function calls
 void X86CodeGenV2::register_function_instance_for_patching(void* instance_ptr, const std::string& function_name, size_t code_addr_offset) {
     std::cout << "[FUNCTION_PATCH] Registering function instance at " << instance_ptr 
@@ -1605,8 +2164,8 @@ void X86CodeGenV2::emit_function_instance_creation(struct FunctionDecl* child_fu
               << " bytes for " << num_captured_scopes << " captured scopes" << std::endl;
     
     // Allocate memory for the function instance
-    emit_mov_reg_imm(7, function_instance_size);   // RDI = size for malloc
-    emit_call("malloc");                           // RAX = allocated function instance
+    emit_mov_reg_imm(7, function_instance_size);   // RDI = size
+    emit_call("__closure_pool_alloc");             // RAX = allocated function instance
     emit_mov_reg_reg(11, 0);                      // R11 = function instance pointer
     
     // Initialize function instance header
@@ -1697,6 +2256,8 @@ void X86CodeGenV2::emit_function_prologue(struct FunctionDecl* function) {
     
     // Standard function prologue using pattern builder
     std::vector<X86Reg> saved_regs = {X86Reg::R12, X86Reg::R13, X86Reg::R14, X86Reg::R15};  // Scope registers
+    record_frame_layout(code_buffer.size(), saved_regs,
+                        function->lexical_scope ? function->lexical_scope->total_scope_frame_size : 8);
     pattern_builder->emit_function_prologue(
         function->lexical_scope ? function->lexical_scope->total_scope_frame_size : 8,
         saved_regs
@@ -1712,9 +2273,7 @@ void X86CodeGenV2::emit_function_prologue(struct FunctionDecl* function) {
     std::cout << "[FUNCTION_PROLOGUE] Allocating " << local_scope_size 
               << " bytes for local lexical scope" << std::endl;
     
-    emit_mov_reg_imm(7, local_scope_size); // RDI = size
-    emit_call("malloc");                   // RAX = allocated memory
-    emit_mov_reg_reg(15, 0);              // R15 = local scope address (FUNCTION.md requirement)
+    emit_scope_alloc(local_scope_size);   // R15 = local scope address (FUNCTION.md requirement)
     
     // Initialize local scope memory to zeros (simplified version)
     for (size_t i = 0; i < local_scope_size; i += 8) {
@@ -1722,6 +2281,12 @@ void X86CodeGenV2::emit_function_prologue(struct FunctionDecl* function) {
         emit_mov_reg_offset_reg(15, i, 0);    // [R15 + i] = 0
     }
     
+    // Publish the scope and its stack map to the collector
+    gc_frame_scopes_saved.push_back(std::move(gc_frame_scopes));
+    gc_frame_scopes.clear();
+    emit_gc_scope_link(function->lexical_scope ? gc_stack_map_for_scope(function->lexical_scope.get())
+                                               : GCStackMapRegistry::instance().intern(local_scope_size, {}));
+    
     // FUNCTION.md Step 3: Load parent scope addresses from hidden parameters
     if (function->lexical_scope && !function->lexical_scope->priority_sorted_parent_scopes.empty()) {
         const auto& needed_scopes = function->lexical_scope->priority_sorted_parent_scopes;
@@ -1771,8 +2336,15 @@ void X86CodeGenV2::emit_function_epilogue(struct FunctionDecl* function) {
               << "' with FUNCTION.md specification" << std::endl;
     
     // FUNCTION.md Step 1: Free the local scope memory (allocated in prologue)
-    emit_mov_reg_reg(7, 15);  // RDI = local scope address (R15)
-    emit_call("free");        // Free heap-allocated local scope
+    emit_scope_free(false);  // Return the local scope to its pool; the epilogue restores R15
+    if (!gc_frame_scopes_saved.empty()) {
+        gc_frame_scopes = std::move(gc_frame_scopes_saved.back());
+        gc_frame_scopes_saved.pop_back();
+    }
+    if (!open_frame_sizes.empty()) {
+        open_frame_sizes.pop_back();
+        open_frame_records.pop_back();
+    }
     std::cout << "[FUNCTION_EPILOGUE] Freed local scope memory" << std::endl;
     
     // Use pattern builder for standard epilogue
@@ -61,6 +61,49 @@ private:
     };
     std::vector<FunctionInstancePatchInfo> function_instances_to_patch;
     
+    // Zero-cost exception tables (offsets relative to the code buffer start)
+public:
+    struct ExceptionRegionRecord {
+        size_t start_offset;
+        size_t end_offset;
+        std::string landing_pad_label;
+        size_t scope_depth;                   // Scopes of the frame live at the landing pad
+    };
+    struct FrameUnwindRecord {
+        size_t start_offset;                  // Offset of "push rbp"
+        std::vector<X86Reg> saved_registers;  // Pushed right after rbp, in order
+        int64_t frame_size;                   // rbp - rsp in the function body
+        bool allocates_scopes;                // Enters lexical scopes the unwinder must free
+    };
+private:
+    std::vector<ExceptionRegionRecord> exception_regions;
+    std::vector<ExceptionRegionRecord> open_exception_regions;
+    std::vector<FrameUnwindRecord> frame_unwind_records;
+    // Frame size and record index of each function whose body is being
+    // emitted, innermost last, and the frame size each landing pad belongs to
+    std::vector<int64_t> open_frame_sizes;
+    std::vector<size_t> open_frame_records;
+    std::unordered_map<std::string, int64_t> landing_pad_frame_sizes;
+    void record_frame_layout(size_t start_offset, const std::vector<X86Reg>& saved_regs, size_t local_stack_size);
+    
+    // Scopes the function being emitted has entered at the current point of
+    // its body, outermost first, and whether each is on the scope chain;
+    // saved across FunctionDecls emitted inside another function
+    std::vector<bool> gc_frame_scopes;
+    std::vector<std::vector<bool>> gc_frame_scopes_saved;
+    bool gc_scope_chain_displacement(int32_t& disp) const;
+    // Jumps to shared_label unless obj is biased to the running thread
+    bool emit_ref_count_owner_check(X86Reg obj, const std::string& shared_label);
+    void emit_gc_frame_scopes_exit();
+    
+    // Switch lowering helpers (cases sorted by key)
+    size_t switch_dispatch_counter = 0;
+    void emit_switch_range(X86Reg value, const std::vector<std::pair<int64_t, std::string>>& cases,
+                           size_t begin, size_t end, const std::string& default_label);
+    void emit_jump_table(X86Reg value, const std::vector<std::pair<int64_t, std::string>>& cases,
+                         size_t begin, size_t end, const std::string& default_label);
+    void emit_compare_imm(X86Reg value, int64_t key);
+    
     // Scope management - merged from ScopeAwareCodeGen
     struct ScopeRegisterState {
         int current_scope_depth = 0;
@@ -245,7 +288,6 @@ public:
     // Additional ultra-fast reference counting operations for specific use cases
     void emit_ref_count_increment_simple(int object_reg);
     void emit_ref_count_decrement_simple(int object_reg);
-    void emit_ref_count_check_zero_and_free(int object_reg, const std::string& free_label);
     
     // CodeGenerator interface getters
     std::vector<uint8_t> get_code() const override { return code_buffer; }
@@ -293,6 +335,40 @@ public:
     // INLINE HEAP ALLOCATION FOR LEXICAL SCOPES (ultra-fast malloc alternative)
     void emit_inline_heap_alloc(size_t size, int result_reg);  // Allocate heap memory inline, result in result_reg
     
+    // GC object allocation: bumps the thread's run for the size class through %fs,
+    // calling __gc_alloc only on refill. Clobbers caller-saved registers.
+    // No AST node uses it yet: program values are not GC heap objects (gc_heap.h).
+    void emit_gc_alloc_inline(size_t size, uint32_t type_id, int result_reg);
+    
+    // After a runtime call that returns nullptr at the GC heap's hard limit
+    // (__gc_alloc, __object_create, __string_concat): a null RAX throws the
+    // catchable out-of-memory error. Clobbers RDI when it throws.
+    void emit_out_of_memory_check();
+    
+    // Card-marking write barrier for a reference just stored at [object_reg + offset].
+    // Addresses outside the GC heap are filtered by one range check. Clobbers r10, r11.
+    void emit_gc_write_barrier(int object_reg, int64_t offset);
+    
+    // Snapshot-at-the-beginning barrier, emitted before a reference store to
+    // [object_reg + offset]: while the collector marks, logs the value about to
+    // be overwritten. Clobbers r11 only.
+    void emit_gc_satb_barrier(int object_reg, int64_t offset);
+    
+    // Lexical scope objects: alloc makes r15 a new scope with scope_size
+    // bytes of (unzeroed) variables behind its GC header, recording the old
+    // r15 as the enclosing scope; free unlinks and frees r15's scope and, for
+    // block scopes, puts the enclosing one back in r15.
+    void emit_scope_alloc(size_t scope_size);
+    void emit_scope_free(bool restore_enclosing);
+    
+    // JIT scope chain (gc_stack_maps.h). Link expects r15 to hold a new
+    // scope whose header has its enclosing word set and whose variables are
+    // zeroed; it fills in the rest of the header and publishes the scope.
+    // Unlink publishes the scope entered before r15's. Both clobber r11 only,
+    // and emit nothing for a scope whose map has no reference slots.
+    void emit_gc_scope_link(const struct GCStackMap* map);
+    void emit_gc_scope_unlink();
+    
     // HIGH-PERFORMANCE LEXICAL SCOPE REGISTER MANAGEMENT
     void emit_scope_register_setup(int scope_level);
     void emit_scope_register_save(int reg_id);
@@ -309,6 +385,20 @@ public:
     
     // Runtime function call resolution (required by base interface)
     void resolve_runtime_function_calls() override;
+    
+    // Switch lowering: jump tables for dense key ranges, binary decision tree otherwise
+    void emit_switch_dispatch(int value_reg, bool value_is_float64,
+                              const std::vector<std::pair<int64_t, std::string>>& cases,
+                              const std::string& default_label) override;
+    
+    // Zero-cost exception handling tables
+    void begin_exception_region(const std::string& landing_pad_label) override;
+    void end_exception_region() override;
+    void emit_landing_pad(const std::string& label) override;
+    void emit_save_pending_exception() override;
+    void emit_throw_pending_exception() override;
+    const std::vector<ExceptionRegionRecord>& get_exception_regions() const { return exception_regions; }
+    const std::vector<FrameUnwindRecord>& get_frame_unwind_records() const { return frame_unwind_records; }
     void add_saved_register(X86Reg reg) { stack_frame.saved_registers.push_back(reg); }
     
     // Direct access to builders for advanced usage
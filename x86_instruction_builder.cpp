@@ -144,7 +144,7 @@ void X86InstructionBuilder::mov(X86Reg dst, const ImmediateOperand& imm) {
     if (imm.size == OpSize::QWORD && 
         imm.value >= -2147483648LL && imm.value <= 2147483647LL) {
         // Use 32-bit immediate that gets sign-extended
-        emit_rex_if_needed(dst, X86Reg::NONE, OpSize::QWORD);
+        emit_rex_if_needed(X86Reg::NONE, dst, OpSize::QWORD);  // dst is ModRM.rm: REX.B
         code_buffer.push_back(0xC7);  // MOV r/m64, imm32
         code_buffer.push_back(0xC0 | (static_cast<uint8_t>(dst) & 7));
         emit_immediate(ImmediateOperand(static_cast<int32_t>(imm.value)));
@@ -169,7 +169,7 @@ X86InstructionBuilder::PatchInfo X86InstructionBuilder::mov_with_patch_info(X86R
     if (imm.size == OpSize::QWORD && 
         imm.value >= -2147483648LL && imm.value <= 2147483647LL) {
         // Use 32-bit immediate that gets sign-extended
-        emit_rex_if_needed(dst, X86Reg::NONE, OpSize::QWORD);
+        emit_rex_if_needed(X86Reg::NONE, dst, OpSize::QWORD);  // dst is ModRM.rm: REX.B
         code_buffer.push_back(0xC7);  // MOV r/m64, imm32
         code_buffer.push_back(0xC0 | (static_cast<uint8_t>(dst) & 7));
         
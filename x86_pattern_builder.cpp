@@ -179,11 +179,11 @@ void X86PatternBuilder::emit_function_prologue(size_t local_stack_size, const st
 void X86PatternBuilder::emit_function_epilogue(size_t local_stack_size, const std::vector<X86Reg>& saved_regs) {
     std::cout << "[PATTERN_EPILOGUE_DEBUG] emit_function_epilogue called with stack_size=" << local_stack_size << ", saved_regs=" << saved_regs.size() << std::endl;
     
-    // Deallocate local stack space
-    if (local_stack_size > 0) {
-        size_t aligned_size = (local_stack_size + 15) & ~15;
-        std::cout << "[PATTERN_EPILOGUE_DEBUG] Deallocating " << aligned_size << " bytes of stack space" << std::endl;
-        builder.add(X86Reg::RSP, ImmediateOperand(static_cast<int64_t>(aligned_size)));
+    // Deallocate local stack space. A return from a finally body leaves rsp
+    // below the steady state, so point it at the saved registers from rbp.
+    if (local_stack_size > 0 || !saved_regs.empty()) {
+        std::cout << "[PATTERN_EPILOGUE_DEBUG] Deallocating stack space down to " << saved_regs.size() << " saved registers" << std::endl;
+        builder.lea(X86Reg::RSP, MemoryOperand(X86Reg::RBP, -static_cast<int32_t>(saved_regs.size() * 8)));
     }
     
     // Restore callee-saved registers (in reverse order)